@@ -0,0 +1,310 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "effectloader.h"
+#include "output.h"
+#include "platform.h"
+#include "renderloop.h"
+#include "scene.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KConfigGroup>
+#include <KWayland/Client/subsurface.h>
+#include <KWayland/Client/surface.h>
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+
+using namespace std::chrono_literals;
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_compositing_benchmark-0");
+
+/**
+ * The compositing benchmark spawns a number of xdg-shell clients, optionally with a
+ * tree of sub-surfaces, and measures how much time each phase of Compositor::composite()
+ * takes while the clients produce a given damage pattern.
+ *
+ * The benchmark can be tuned with the following environment variables:
+ *
+ * - KWIN_BENCHMARK_CLIENTS overrides the number of clients
+ * - KWIN_BENCHMARK_FRAMES overrides the number of measured frames
+ * - KWIN_BENCHMARK_OUTPUT specifies a file to which the results are appended, one JSON
+ *   object per line. If it is not set, the results are printed to the standard output.
+ */
+class CompositingBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class DamagePattern {
+        Idle,
+        SingleRect,
+        AllClients,
+        FullRepaint,
+    };
+    Q_ENUM(DamagePattern)
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void benchmarkComposite_data();
+    void benchmarkComposite();
+
+private:
+    struct Client
+    {
+        std::unique_ptr<KWayland::Client::Surface> surface;
+        std::unique_ptr<Test::XdgToplevel> shellSurface;
+        std::vector<std::unique_ptr<KWayland::Client::Surface>> childSurfaces;
+        std::vector<std::unique_ptr<KWayland::Client::SubSurface>> subSurfaces;
+        Window *window = nullptr;
+    };
+
+    bool createClient(Client *client, int index, int subSurfaceCount);
+    bool produceDamage(std::vector<Client> &clients, DamagePattern pattern, int frame);
+    void reportResults(const QJsonObject &results);
+};
+
+static int environmentOverride(const char *name, int defaultValue)
+{
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok && value > 0 ? value : defaultValue;
+}
+
+static QJsonObject percentiles(std::vector<std::chrono::nanoseconds> samples)
+{
+    QJsonObject object;
+    if (samples.empty()) {
+        return object;
+    }
+    std::sort(samples.begin(), samples.end());
+    const auto at = [&samples](double percentile) {
+        const size_t index = std::min(samples.size() - 1, size_t(percentile * (samples.size() - 1) + 0.5));
+        return double(samples[index].count()) / 1000.0;
+    };
+    object[QStringLiteral("p50_us")] = at(0.5);
+    object[QStringLiteral("p99_us")] = at(0.99);
+    object[QStringLiteral("max_us")] = at(1.0);
+    return object;
+}
+
+void CompositingBenchmark::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    qRegisterMetaType<KWin::CompositeTimings>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1920, 1080));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    // disable all effects - we want to measure the bare compositing path
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(Compositor::self());
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void CompositingBenchmark::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void CompositingBenchmark::cleanup()
+{
+    Test::destroyWaylandConnection();
+}
+
+bool CompositingBenchmark::createClient(Client *client, int index, int subSurfaceCount)
+{
+    client->surface = Test::createSurface();
+    if (!client->surface) {
+        return false;
+    }
+    client->shellSurface.reset(Test::createXdgToplevelSurface(client->surface.get()));
+    if (!client->shellSurface) {
+        return false;
+    }
+
+    // Build a chain of sub-surfaces, each one is stacked above and nested in the previous one.
+    KWayland::Client::Surface *parent = client->surface.get();
+    for (int i = 0; i < subSurfaceCount; ++i) {
+        auto childSurface = Test::createSurface();
+        std::unique_ptr<KWayland::Client::SubSurface> subSurface(Test::createSubSurface(childSurface.get(), parent));
+        if (!subSurface) {
+            return false;
+        }
+        subSurface->setPosition(QPoint(10, 10));
+        Test::render(childSurface.get(), QSize(200 - 20 * (i + 1), 150 - 15 * (i + 1)), QColor::fromHsv((index * 40 + i * 10) % 360, 255, 255));
+        parent = childSurface.get();
+        client->childSurfaces.push_back(std::move(childSurface));
+        client->subSurfaces.push_back(std::move(subSurface));
+    }
+
+    client->window = Test::renderAndWaitForShown(client->surface.get(), QSize(200, 150), QColor::fromHsv((index * 40) % 360, 255, 255));
+    if (!client->window) {
+        return false;
+    }
+    client->window->move(QPoint((index * 37) % 1700, (index * 23) % 900));
+    return true;
+}
+
+bool CompositingBenchmark::produceDamage(std::vector<Client> &clients, DamagePattern pattern, int frame)
+{
+    const QColor color = (frame % 2) ? Qt::red : Qt::blue;
+
+    switch (pattern) {
+    case DamagePattern::Idle:
+        workspace()->outputs().constFirst()->renderLoop()->scheduleRepaint();
+        return true;
+    case DamagePattern::FullRepaint:
+        Compositor::self()->scene()->addRepaintFull();
+        return true;
+    case DamagePattern::SingleRect: {
+        Client &client = clients[frame % clients.size()];
+        QSignalSpy damagedSpy(client.window, &Window::damaged);
+        QImage image(QSize(200, 150), QImage::Format_ARGB32_Premultiplied);
+        image.fill(color);
+        client.surface->attachBuffer(Test::waylandShmPool()->createBuffer(image));
+        client.surface->damage(QRect(16, 16, 32, 32));
+        client.surface->commit(KWayland::Client::Surface::CommitFlag::None);
+        Test::flushWaylandConnection();
+        return damagedSpy.wait();
+    }
+    case DamagePattern::AllClients: {
+        QSignalSpy damagedSpy(clients.back().window, &Window::damaged);
+        for (Client &client : clients) {
+            Test::render(client.surface.get(), QSize(200, 150), color);
+        }
+        Test::flushWaylandConnection();
+        return damagedSpy.wait();
+    }
+    default:
+        Q_UNREACHABLE();
+    }
+}
+
+void CompositingBenchmark::reportResults(const QJsonObject &results)
+{
+    const QByteArray line = QJsonDocument(results).toJson(QJsonDocument::Compact) + '\n';
+
+    const QString fileName = qEnvironmentVariable("KWIN_BENCHMARK_OUTPUT");
+    if (fileName.isEmpty()) {
+        fputs(line.constData(), stdout);
+        return;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Failed to open benchmark output" << fileName << file.errorString();
+        return;
+    }
+    file.write(line);
+}
+
+void CompositingBenchmark::benchmarkComposite_data()
+{
+    QTest::addColumn<int>("clientCount");
+    QTest::addColumn<int>("subSurfaceCount");
+    QTest::addColumn<DamagePattern>("pattern");
+
+    QTest::addRow("idle/10x0") << 10 << 0 << DamagePattern::Idle;
+    QTest::addRow("single-rect/10x0") << 10 << 0 << DamagePattern::SingleRect;
+    QTest::addRow("single-rect/10x3") << 10 << 3 << DamagePattern::SingleRect;
+    QTest::addRow("all-clients/10x0") << 10 << 0 << DamagePattern::AllClients;
+    QTest::addRow("all-clients/10x3") << 10 << 3 << DamagePattern::AllClients;
+    QTest::addRow("full-repaint/40x0") << 40 << 0 << DamagePattern::FullRepaint;
+    QTest::addRow("full-repaint/40x3") << 40 << 3 << DamagePattern::FullRepaint;
+}
+
+void CompositingBenchmark::benchmarkComposite()
+{
+    QFETCH(int, clientCount);
+    QFETCH(int, subSurfaceCount);
+    QFETCH(DamagePattern, pattern);
+
+    clientCount = environmentOverride("KWIN_BENCHMARK_CLIENTS", clientCount);
+    const int frameCount = environmentOverride("KWIN_BENCHMARK_FRAMES", 120);
+    const int warmupFrameCount = 10;
+
+    std::vector<Client> clients(clientCount);
+    for (int i = 0; i < clientCount; ++i) {
+        QVERIFY(createClient(&clients[i], i, subSurfaceCount));
+    }
+
+    std::vector<std::chrono::nanoseconds> prePaint;
+    std::vector<std::chrono::nanoseconds> preparePaint;
+    std::vector<std::chrono::nanoseconds> paint;
+    std::vector<std::chrono::nanoseconds> present;
+    std::vector<std::chrono::nanoseconds> total;
+
+    QSignalSpy frameCompositedSpy(Compositor::self(), &Compositor::frameComposited);
+    QVERIFY(frameCompositedSpy.isValid());
+
+    for (int frame = 0; frame < warmupFrameCount + frameCount; ++frame) {
+        frameCompositedSpy.clear();
+        QVERIFY(produceDamage(clients, pattern, frame));
+        QVERIFY(frameCompositedSpy.wait());
+
+        if (frame < warmupFrameCount) {
+            continue;
+        }
+        for (const QList<QVariant> &arguments : std::as_const(frameCompositedSpy)) {
+            const auto timings = arguments.at(1).value<CompositeTimings>();
+            prePaint.push_back(timings.prePaint);
+            preparePaint.push_back(timings.preparePaint);
+            paint.push_back(timings.paint);
+            present.push_back(timings.present);
+            total.push_back(timings.prePaint + timings.preparePaint + timings.paint + timings.present);
+        }
+    }
+
+    QJsonObject results;
+    results[QStringLiteral("benchmark")] = QString::fromUtf8(QTest::currentDataTag());
+    results[QStringLiteral("clients")] = clientCount;
+    results[QStringLiteral("subsurfaces")] = subSurfaceCount;
+    results[QStringLiteral("frames")] = int(total.size());
+    results[QStringLiteral("prePaintPass")] = percentiles(prePaint);
+    results[QStringLiteral("preparePaintPass")] = percentiles(preparePaint);
+    results[QStringLiteral("paintPass")] = percentiles(paint);
+    results[QStringLiteral("present")] = percentiles(present);
+    results[QStringLiteral("total")] = percentiles(total);
+    reportResults(results);
+
+    std::sort(total.begin(), total.end());
+    QVERIFY(!total.empty());
+    QTest::setBenchmarkResult(total[total.size() / 2].count(), QTest::WalltimeNanoseconds);
+}
+
+} // namespace KWin
+
+WAYLANDTEST_MAIN(KWin::CompositingBenchmark)
+#include "compositing_benchmark.moc"
@@ -0,0 +1,179 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KConfigGroup>
+#include <KWayland/Client/surface.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_effects_window_interest-0");
+
+class InterestEffect : public Effect
+{
+    Q_OBJECT
+
+public:
+    bool isActive() const override
+    {
+        return true;
+    }
+
+    bool isInterestedInWindow(const EffectWindow *w) const override
+    {
+        return w == m_window;
+    }
+
+    void setInterestingWindow(EffectWindow *w)
+    {
+        m_window = w;
+        effects->windowInterestChanged();
+    }
+
+    void prePaintWindow(EffectWindow *w, WindowPrePaintData &data, std::chrono::milliseconds presentTime) override
+    {
+        m_prePaintedWindows.insert(w);
+        effects->prePaintWindow(w, data, presentTime);
+    }
+
+    void paintWindow(EffectWindow *w, int mask, QRegion region, WindowPaintData &data) override
+    {
+        m_paintedWindows.insert(w);
+        effects->paintWindow(w, mask, region, data);
+    }
+
+    void postPaintScreen() override
+    {
+        effects->postPaintScreen();
+        Q_EMIT framePainted();
+    }
+
+    QSet<EffectWindow *> m_prePaintedWindows;
+    QSet<EffectWindow *> m_paintedWindows;
+
+Q_SIGNALS:
+    void framePainted();
+
+private:
+    EffectWindow *m_window = nullptr;
+};
+
+class WindowInterestTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testUninterestedEffectsAreSkipped();
+};
+
+void WindowInterestTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    qRegisterMetaType<KWin::Effect *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    // disable all effects, only the test effect should be in the chain
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(Compositor::self());
+}
+
+void WindowInterestTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void WindowInterestTest::cleanup()
+{
+    auto effectsImpl = static_cast<EffectsHandlerImpl *>(effects);
+    effectsImpl->unloadAllEffects();
+    QVERIFY(effectsImpl->loadedEffects().isEmpty());
+
+    Test::destroyWaylandConnection();
+}
+
+void WindowInterestTest::testUninterestedEffectsAreSkipped()
+{
+    // This test verifies that the window hooks of an effect are only called for
+    // the windows that the effect is interested in.
+
+    InterestEffect *effect = new InterestEffect;
+    const auto children = effects->children();
+    for (auto it = children.begin(); it != children.end(); ++it) {
+        if (qstrcmp((*it)->metaObject()->className(), "KWin::EffectLoader") != 0) {
+            continue;
+        }
+        QVERIFY(QMetaObject::invokeMethod(*it, "effectLoaded", Q_ARG(KWin::Effect *, effect), Q_ARG(QString, QStringLiteral("interest"))));
+        break;
+    }
+    QVERIFY(static_cast<EffectsHandlerImpl *>(effects)->isEffectLoaded(QStringLiteral("interest")));
+    QSignalSpy framePaintedSpy(effect, &InterestEffect::framePainted);
+    QVERIFY(framePaintedSpy.isValid());
+
+    std::unique_ptr<KWayland::Client::Surface> surface1(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface1(Test::createXdgToplevelSurface(surface1.get()));
+    Window *window1 = Test::renderAndWaitForShown(surface1.get(), QSize(200, 100), Qt::red);
+    QVERIFY(window1);
+    std::unique_ptr<KWayland::Client::Surface> surface2(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface2(Test::createXdgToplevelSurface(surface2.get()));
+    Window *window2 = Test::renderAndWaitForShown(surface2.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window2);
+
+    // the effect is interested in the first window only
+    effect->setInterestingWindow(window1->effectWindow());
+    effect->m_prePaintedWindows.clear();
+    effect->m_paintedWindows.clear();
+    Compositor::self()->scene()->addRepaintFull();
+    QVERIFY(framePaintedSpy.wait());
+    QVERIFY(effect->m_prePaintedWindows.contains(window1->effectWindow()));
+    QVERIFY(effect->m_paintedWindows.contains(window1->effectWindow()));
+    QVERIFY(!effect->m_prePaintedWindows.contains(window2->effectWindow()));
+    QVERIFY(!effect->m_paintedWindows.contains(window2->effectWindow()));
+
+    // switch the interest to the second window, the change takes effect in the next frame
+    effect->setInterestingWindow(window2->effectWindow());
+    framePaintedSpy.clear();
+    effect->m_prePaintedWindows.clear();
+    effect->m_paintedWindows.clear();
+    Compositor::self()->scene()->addRepaintFull();
+    QVERIFY(framePaintedSpy.wait());
+    QVERIFY(!effect->m_prePaintedWindows.contains(window1->effectWindow()));
+    QVERIFY(!effect->m_paintedWindows.contains(window1->effectWindow()));
+    QVERIFY(effect->m_prePaintedWindows.contains(window2->effectWindow()));
+    QVERIFY(effect->m_paintedWindows.contains(window2->effectWindow()));
+}
+
+WAYLANDTEST_MAIN(WindowInterestTest)
+#include "window_interest_test.moc"
@@ -16,16 +16,20 @@ class Window : public QRasterWindow
 {
     Q_OBJECT
 public:
-    explicit Window();
+    explicit Window(const QString &text);
     ~Window() override;
 
 protected:
     void paintEvent(QPaintEvent *event) override;
     void focusInEvent(QFocusEvent *event) override;
+
+private:
+    QString m_text;
 };
 
-Window::Window()
+Window::Window(const QString &text)
     : QRasterWindow()
+    , m_text(text)
 {
 }
 
@@ -42,15 +46,18 @@ void Window::focusInEvent(QFocusEvent *event)
 {
     QRasterWindow::focusInEvent(event);
     // TODO: make it work without singleshot
-    QTimer::singleShot(100, [] {
-        qApp->clipboard()->setText(QStringLiteral("test"));
+    QTimer::singleShot(100, [this] {
+        qApp->clipboard()->setText(m_text);
     });
 }
 
 int main(int argc, char *argv[])
 {
     QGuiApplication app(argc, argv);
-    std::unique_ptr<Window> w(new Window);
+    // an optional argument specifies the size of the copied text in bytes
+    const QStringList arguments = app.arguments();
+    const QString text = arguments.count() > 1 ? QString(arguments.at(1).toInt(), QLatin1Char('x')) : QStringLiteral("test");
+    std::unique_ptr<Window> w(new Window(text));
     w->setGeometry(QRect(0, 0, 100, 200));
     w->show();
 
@@ -40,9 +40,12 @@ void Window::paintEvent(QPaintEvent *event)
 int main(int argc, char *argv[])
 {
     QGuiApplication app(argc, argv);
+    // an optional argument specifies the size of the expected text in bytes
+    const QStringList arguments = app.arguments();
+    const QString text = arguments.count() > 1 ? QString(arguments.at(1).toInt(), QLatin1Char('x')) : QStringLiteral("test");
     QObject::connect(app.clipboard(), &QClipboard::changed, &app,
-                     [] {
-                         if (qApp->clipboard()->text() == QLatin1String("test")) {
+                     [text] {
+                         if (qApp->clipboard()->text() == text) {
                              QTimer::singleShot(100, qApp, &QCoreApplication::quit);
                          }
                      });
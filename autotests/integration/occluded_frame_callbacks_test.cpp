@@ -0,0 +1,192 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "options.h"
+#include "platform.h"
+#include "scene.h"
+#include "scripting/windowthumbnailitem.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KWayland/Client/compositor.h>
+#include <KWayland/Client/region.h>
+#include <KWayland/Client/surface.h>
+
+#include <QElapsedTimer>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_occluded_frame_callbacks-0");
+
+class OccludedFrameCallbacksTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testOccludedWindowIsThrottled();
+    void testThumbnailedWindowIsNotThrottled();
+};
+
+void OccludedFrameCallbacksTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(Compositor::self());
+}
+
+void OccludedFrameCallbacksTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void OccludedFrameCallbacksTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+}
+
+void OccludedFrameCallbacksTest::testOccludedWindowIsThrottled()
+{
+    // This test verifies that a window that is completely covered by an opaque window
+    // receives frame callbacks at the reduced rate, while the window above it doesn't.
+
+    const int interval = 500;
+    options->setOccludedFrameCallbackInterval(interval);
+
+    std::unique_ptr<KWayland::Client::Surface> bottomSurface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> bottomShellSurface(Test::createXdgToplevelSurface(bottomSurface.get()));
+    Window *bottom = Test::renderAndWaitForShown(bottomSurface.get(), QSize(100, 50), Qt::red);
+    QVERIFY(bottom);
+    bottom->move(QPoint(100, 100));
+
+    // the top window covers the whole output and is fully opaque
+    std::unique_ptr<KWayland::Client::Surface> topSurface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> topShellSurface(Test::createXdgToplevelSurface(topSurface.get()));
+    std::unique_ptr<KWayland::Client::Region> opaqueRegion(Test::waylandCompositor()->createRegion(QRegion(0, 0, 1280, 1024)));
+    topSurface->setOpaqueRegion(opaqueRegion.get());
+    Window *top = Test::renderAndWaitForShown(topSurface.get(), QSize(1280, 1024), Qt::blue, QImage::Format_RGB32);
+    QVERIFY(top);
+    top->move(QPoint(0, 0));
+    QCOMPARE(workspace()->stackingOrder().last(), top);
+
+    // the occlusion is determined when the windows are painted
+    QSignalSpy frameRenderedSpy(Compositor::self()->scene(), &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    Compositor::self()->scene()->addRepaintFull();
+    QVERIFY(frameRenderedSpy.wait());
+    QCOMPARE(bottom->occlusion(), WindowOcclusion::Occluded);
+    QCOMPARE(top->occlusion(), WindowOcclusion::Visible);
+    QVERIFY(bottom->frameCallbacksThrottled());
+    QVERIFY(!top->frameCallbacksThrottled());
+
+    // let the throttling timer started by the previous frames run out
+    QTest::qWait(interval * 2);
+
+    // both windows request a frame callback, only the visible one gets it with the next frame
+    QSignalSpy bottomFrameSpy(bottomSurface.get(), &KWayland::Client::Surface::frameRendered);
+    QVERIFY(bottomFrameSpy.isValid());
+    QSignalSpy topFrameSpy(topSurface.get(), &KWayland::Client::Surface::frameRendered);
+    QVERIFY(topFrameSpy.isValid());
+    QElapsedTimer timer;
+    timer.start();
+    bottomSurface->commit(KWayland::Client::Surface::CommitFlag::FrameCallback);
+    topSurface->commit(KWayland::Client::Surface::CommitFlag::FrameCallback);
+    Compositor::self()->scene()->addRepaintFull();
+    QVERIFY(topFrameSpy.wait());
+    QVERIFY(bottomFrameSpy.isEmpty());
+
+    // the occluded window gets its frame callback once the throttling interval has passed
+    QVERIFY(bottomFrameSpy.wait(interval * 4));
+    QVERIFY(timer.elapsed() >= interval / 2);
+
+    // once the window is uncovered, it gets frame callbacks with every frame again
+    topShellSurface.reset();
+    topSurface.reset();
+    QVERIFY(Test::waitForWindowDestroyed(top));
+    frameRenderedSpy.clear();
+    Compositor::self()->scene()->addRepaintFull();
+    QVERIFY(frameRenderedSpy.wait());
+    QCOMPARE(bottom->occlusion(), WindowOcclusion::Visible);
+    bottomFrameSpy.clear();
+    timer.restart();
+    bottomSurface->commit(KWayland::Client::Surface::CommitFlag::FrameCallback);
+    Compositor::self()->scene()->addRepaintFull();
+    QVERIFY(bottomFrameSpy.wait());
+    QVERIFY(timer.elapsed() < interval);
+
+    options->setOccludedFrameCallbackInterval(Options::defaultOccludedFrameCallbackInterval());
+}
+
+void OccludedFrameCallbacksTest::testThumbnailedWindowIsNotThrottled()
+{
+    // This test verifies that an occluded window that is shown in a thumbnail keeps
+    // receiving frame callbacks with every frame.
+
+    const int interval = 500;
+    options->setOccludedFrameCallbackInterval(interval);
+
+    std::unique_ptr<KWayland::Client::Surface> bottomSurface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> bottomShellSurface(Test::createXdgToplevelSurface(bottomSurface.get()));
+    Window *bottom = Test::renderAndWaitForShown(bottomSurface.get(), QSize(100, 50), Qt::red);
+    QVERIFY(bottom);
+    bottom->move(QPoint(100, 100));
+
+    std::unique_ptr<KWayland::Client::Surface> topSurface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> topShellSurface(Test::createXdgToplevelSurface(topSurface.get()));
+    std::unique_ptr<KWayland::Client::Region> opaqueRegion(Test::waylandCompositor()->createRegion(QRegion(0, 0, 1280, 1024)));
+    topSurface->setOpaqueRegion(opaqueRegion.get());
+    Window *top = Test::renderAndWaitForShown(topSurface.get(), QSize(1280, 1024), Qt::blue, QImage::Format_RGB32);
+    QVERIFY(top);
+    top->move(QPoint(0, 0));
+
+    QSignalSpy frameRenderedSpy(Compositor::self()->scene(), &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    Compositor::self()->scene()->addRepaintFull();
+    QVERIFY(frameRenderedSpy.wait());
+    QCOMPARE(bottom->occlusion(), WindowOcclusion::Occluded);
+    QVERIFY(bottom->frameCallbacksThrottled());
+
+    // the occluded window gets frame callbacks with every frame while it's shown in a thumbnail
+    auto thumbnail = std::make_unique<WindowThumbnailItem>();
+    thumbnail->setClient(bottom);
+    QVERIFY(bottom->isOffscreenRendering());
+    QVERIFY(!bottom->frameCallbacksThrottled());
+
+    QTest::qWait(interval * 2);
+    QSignalSpy bottomFrameSpy(bottomSurface.get(), &KWayland::Client::Surface::frameRendered);
+    QVERIFY(bottomFrameSpy.isValid());
+    QElapsedTimer timer;
+    timer.start();
+    bottomSurface->commit(KWayland::Client::Surface::CommitFlag::FrameCallback);
+    Compositor::self()->scene()->addRepaintFull();
+    QVERIFY(bottomFrameSpy.wait());
+    QVERIFY(timer.elapsed() < interval);
+
+    // the window is throttled again once the thumbnail is gone
+    thumbnail.reset();
+    QVERIFY(!bottom->isOffscreenRendering());
+    QVERIFY(bottom->frameCallbacksThrottled());
+
+    options->setOccludedFrameCallbackInterval(Options::defaultOccludedFrameCallbackInterval());
+}
+
+WAYLANDTEST_MAIN(OccludedFrameCallbacksTest)
+#include "occluded_frame_callbacks_test.moc"
@@ -0,0 +1,210 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "platform.h"
+#include "rules.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KConfigGroup>
+#include <KWayland/Client/surface.h>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_window_rules_benchmark-0");
+
+/**
+ * The window rules benchmark loads a rule book with a few hundred rules, most of which
+ * don't match the test window, and measures how long it takes to find the rules for the
+ * window and to check whether a caption change affects the matched rules.
+ */
+class WindowRulesBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void benchmarkFind_data();
+    void benchmarkFind();
+    void benchmarkTitleChanged_data();
+    void benchmarkTitleChanged();
+
+private:
+    void writeRules(int count);
+    Window *createWindow();
+
+    KSharedConfig::Ptr m_config;
+    std::unique_ptr<KWayland::Client::Surface> m_surface;
+    std::unique_ptr<Test::XdgToplevel> m_shellSurface;
+};
+
+void WindowRulesBenchmark::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+
+    m_config = KSharedConfig::openConfig(QStringLiteral("kwinrulesrc"), KConfig::SimpleConfig);
+    workspace()->rulebook()->setConfig(m_config);
+}
+
+void WindowRulesBenchmark::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void WindowRulesBenchmark::cleanup()
+{
+    m_shellSurface.reset();
+    m_surface.reset();
+    Test::destroyWaylandConnection();
+
+    for (const QString &group : m_config->groupList()) {
+        m_config->deleteGroup(group);
+    }
+    workspace()->slotReconfigure();
+}
+
+void WindowRulesBenchmark::writeRules(int count)
+{
+    for (int i = 0; i < count; ++i) {
+        KConfigGroup group = m_config->group(QString::number(i + 1));
+        group.writeEntry("above", true);
+        group.writeEntry("aboverule", int(Rules::Force));
+
+        // Mix the kinds of rules that people usually have, only a handful match the test window.
+        switch (i % 4) {
+        case 0:
+            group.writeEntry("wmclass", QStringLiteral("org.kde.app%1").arg(i));
+            group.writeEntry("wmclassmatch", int(Rules::ExactMatch));
+            break;
+        case 1:
+            group.writeEntry("wmclass", QStringLiteral("app%1 org.kde.app%1").arg(i));
+            group.writeEntry("wmclasscomplete", true);
+            group.writeEntry("wmclassmatch", int(Rules::ExactMatch));
+            break;
+        case 2:
+            group.writeEntry("wmclass", QStringLiteral("^org\\.kde\\.(app|tool)%1$").arg(i));
+            group.writeEntry("wmclassmatch", int(Rules::RegExpMatch));
+            group.writeEntry("title", QStringLiteral("^Document %1 - .*$").arg(i));
+            group.writeEntry("titlematch", int(Rules::RegExpMatch));
+            break;
+        case 3:
+            group.writeEntry("wmclass", QStringLiteral("app%1").arg(i));
+            group.writeEntry("wmclassmatch", int(Rules::SubstringMatch));
+            group.writeEntry("title", QStringLiteral("Untitled %1").arg(i));
+            group.writeEntry("titlematch", int(Rules::SubstringMatch));
+            break;
+        }
+    }
+
+    // A couple of rules for the test window at the end of the rule book.
+    KConfigGroup classRule = m_config->group(QString::number(count + 1));
+    classRule.writeEntry("wmclass", "org.kde.foo");
+    classRule.writeEntry("wmclassmatch", int(Rules::ExactMatch));
+    classRule.writeEntry("above", true);
+    classRule.writeEntry("aboverule", int(Rules::Force));
+
+    KConfigGroup titleRule = m_config->group(QString::number(count + 2));
+    titleRule.writeEntry("wmclass", "org.kde.foo");
+    titleRule.writeEntry("wmclassmatch", int(Rules::ExactMatch));
+    titleRule.writeEntry("title", "^Document [0-9]+$");
+    titleRule.writeEntry("titlematch", int(Rules::RegExpMatch));
+    titleRule.writeEntry("skiptaskbar", true);
+    titleRule.writeEntry("skiptaskbarrule", int(Rules::Force));
+
+    m_config->group("General").writeEntry("count", count + 2);
+    m_config->sync();
+
+    workspace()->slotReconfigure();
+}
+
+Window *WindowRulesBenchmark::createWindow()
+{
+    m_surface = Test::createSurface();
+    m_shellSurface.reset(Test::createXdgToplevelSurface(m_surface.get(), Test::CreationSetup::CreateOnly, m_surface.get()));
+    m_shellSurface->set_app_id(QStringLiteral("org.kde.foo"));
+    m_shellSurface->set_title(QStringLiteral("Document 1"));
+
+    QSignalSpy surfaceConfigureRequestedSpy(m_shellSurface->xdgSurface(), &Test::XdgSurface::configureRequested);
+    m_surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    if (!surfaceConfigureRequestedSpy.wait()) {
+        return nullptr;
+    }
+    m_shellSurface->xdgSurface()->ack_configure(surfaceConfigureRequestedSpy.last().at(0).value<quint32>());
+
+    return Test::renderAndWaitForShown(m_surface.get(), QSize(100, 50), Qt::blue);
+}
+
+void WindowRulesBenchmark::benchmarkFind_data()
+{
+    QTest::addColumn<int>("ruleCount");
+
+    QTest::addRow("10 rules") << 10;
+    QTest::addRow("100 rules") << 100;
+    QTest::addRow("500 rules") << 500;
+}
+
+void WindowRulesBenchmark::benchmarkFind()
+{
+    QFETCH(int, ruleCount);
+
+    writeRules(ruleCount);
+    Window *window = createWindow();
+    QVERIFY(window);
+    QVERIFY(window->keepAbove());
+    QVERIFY(window->skipTaskbar());
+
+    QBENCHMARK {
+        workspace()->rulebook()->find(window, false);
+    }
+}
+
+void WindowRulesBenchmark::benchmarkTitleChanged_data()
+{
+    benchmarkFind_data();
+}
+
+void WindowRulesBenchmark::benchmarkTitleChanged()
+{
+    QFETCH(int, ruleCount);
+
+    writeRules(ruleCount);
+    Window *window = createWindow();
+    QVERIFY(window);
+    QVERIFY(!workspace()->rulebook()->titleRulesChanged(window));
+
+    QBENCHMARK {
+        workspace()->rulebook()->titleRulesChanged(window);
+    }
+
+    // A caption that no longer matches the title rule has to trigger the re-evaluation.
+    QSignalSpy captionChangedSpy(window, &Window::captionChanged);
+    m_shellSurface->set_title(QStringLiteral("Untitled"));
+    m_surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(captionChangedSpy.wait());
+    QTRY_VERIFY(!window->skipTaskbar());
+    QVERIFY(window->keepAbove());
+}
+
+} // namespace KWin
+
+WAYLANDTEST_MAIN(KWin::WindowRulesBenchmark)
+#include "window_rules_benchmark.moc"
@@ -0,0 +1,379 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "deleted.h"
+#include "platform.h"
+#include "virtualdesktops.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "windowspatialindex.h"
+#include "workspace.h"
+
+#if KWIN_BUILD_ACTIVITIES
+#include "activities.h"
+
+#include <KActivities/Controller>
+#endif
+
+#include <KWayland/Client/surface.h>
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCall>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_windowspatialindex-0");
+
+class WindowSpatialIndexTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void testStackingOrder();
+    void testRaiseLower();
+    void testRestack_data();
+    void testRestack();
+    void testDesktop();
+    void testActivity();
+    void testMinimize();
+    void testHide();
+    void testMove();
+    void testClosed();
+
+private:
+    Window *createWindow(const QPoint &position, const QSize &size = QSize(100, 50));
+
+    std::vector<std::unique_ptr<KWayland::Client::Surface>> m_surfaces;
+    std::vector<std::unique_ptr<Test::XdgToplevel>> m_shellSurfaces;
+};
+
+// Returns the given windows ordered from the topmost to the bottommost window.
+static QVector<Window *> topmostFirst(QVector<Window *> windows)
+{
+    const QList<Window *> stackingOrder = workspace()->stackingOrder();
+    std::sort(windows.begin(), windows.end(), [&stackingOrder](Window *a, Window *b) {
+        return stackingOrder.indexOf(a) > stackingOrder.indexOf(b);
+    });
+    return windows;
+}
+
+void WindowSpatialIndexTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    qRegisterMetaType<KWin::Deleted *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+#if KWIN_BUILD_ACTIVITIES
+    kwinApp()->setUseKActivities(true);
+#endif
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+}
+
+void WindowSpatialIndexTest::cleanupTestCase()
+{
+#if KWIN_BUILD_ACTIVITIES
+    // terminate any still running kactivitymanagerd
+    QDBusConnection::sessionBus().asyncCall(QDBusMessage::createMethodCall(
+        QStringLiteral("org.kde.ActivityManager"),
+        QStringLiteral("/ActivityManager"),
+        QStringLiteral("org.qtproject.Qt.QCoreApplication"),
+        QStringLiteral("quit")));
+#endif
+}
+
+void WindowSpatialIndexTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void WindowSpatialIndexTest::cleanup()
+{
+    m_shellSurfaces.clear();
+    m_surfaces.clear();
+    Test::destroyWaylandConnection();
+    QTRY_VERIFY(workspace()->stackingOrder().isEmpty());
+}
+
+Window *WindowSpatialIndexTest::createWindow(const QPoint &position, const QSize &size)
+{
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), size, Qt::red);
+    if (window) {
+        window->move(position);
+    }
+    m_surfaces.push_back(std::move(surface));
+    m_shellSurfaces.push_back(std::move(shellSurface));
+    return window;
+}
+
+void WindowSpatialIndexTest::testStackingOrder()
+{
+    // This test verifies that the windows are returned from the topmost to the bottommost one,
+    // both for the windows that exist when the index is created and the ones mapped later.
+    Window *a = createWindow(QPoint(10, 10));
+    QVERIFY(a);
+    Window *b = createWindow(QPoint(20, 20));
+    QVERIFY(b);
+
+    WindowSpatialIndex index;
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{b, a}));
+
+    Window *c = createWindow(QPoint(30, 30));
+    QVERIFY(c);
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{c, b, a}));
+
+    // a cell without windows
+    QVERIFY(index.windowsAt(QPointF(1000, 1000)).isEmpty());
+}
+
+void WindowSpatialIndexTest::testRaiseLower()
+{
+    WindowSpatialIndex index;
+    Window *a = createWindow(QPoint(10, 10));
+    QVERIFY(a);
+    Window *b = createWindow(QPoint(20, 20));
+    QVERIFY(b);
+    Window *c = createWindow(QPoint(30, 30));
+    QVERIFY(c);
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{c, b, a}));
+
+    workspace()->raiseWindow(a);
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{a, c, b}));
+
+    workspace()->lowerWindow(c);
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{a, b, c}));
+
+    workspace()->raiseWindow(b);
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{b, a, c}));
+}
+
+void WindowSpatialIndexTest::testRestack_data()
+{
+    QTest::addColumn<QVector<int>>("raised");
+
+    QTest::newRow("reverse") << QVector<int>{3, 2, 1, 0};
+    QTest::newRow("rotate") << QVector<int>{0};
+    QTest::newRow("swap") << QVector<int>{1, 3};
+    QTest::newRow("shuffle") << QVector<int>{2, 0, 4, 1};
+    QTest::newRow("unchanged") << QVector<int>{0, 1, 2, 3, 4};
+}
+
+void WindowSpatialIndexTest::testRestack()
+{
+    // This test verifies that the order of the windows in the cells stays correct when
+    // several windows are restacked at once.
+    QFETCH(QVector<int>, raised);
+
+    WindowSpatialIndex index;
+    QVector<Window *> windows;
+    for (int i = 0; i < 5; ++i) {
+        // every other window also covers the next cell
+        Window *window = createWindow(QPoint(10 * i, 10), QSize(i % 2 ? 400 : 100, 50));
+        QVERIFY(window);
+        windows.append(window);
+    }
+    QCOMPARE(index.windowsAt(QPointF(100, 50)), topmostFirst(windows));
+
+    {
+        StackingUpdatesBlocker blocker(workspace());
+        for (int i : raised) {
+            workspace()->raiseWindow(windows[i]);
+        }
+    }
+    QCOMPARE(index.windowsAt(QPointF(100, 50)), topmostFirst(windows));
+    QCOMPARE(index.windowsAt(QPointF(300, 50)), topmostFirst({windows[1], windows[3]}));
+}
+
+void WindowSpatialIndexTest::testDesktop()
+{
+    VirtualDesktopManager::self()->setCount(2);
+    QCOMPARE(VirtualDesktopManager::self()->count(), 2u);
+    VirtualDesktopManager::self()->setCurrent(1);
+
+    WindowSpatialIndex index;
+    Window *a = createWindow(QPoint(10, 10));
+    QVERIFY(a);
+    Window *b = createWindow(QPoint(20, 20));
+    QVERIFY(b);
+    Window *c = createWindow(QPoint(30, 30));
+    QVERIFY(c);
+
+    // windows on other desktops are not indexed
+    workspace()->sendWindowToDesktop(b, 2, true);
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{c, a}));
+
+    VirtualDesktopManager::self()->setCurrent(2);
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{b}));
+
+    VirtualDesktopManager::self()->setCurrent(1);
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{c, a}));
+
+    b->setOnAllDesktops(true);
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), topmostFirst({a, b, c}));
+
+    VirtualDesktopManager::self()->setCount(1);
+}
+
+void WindowSpatialIndexTest::testActivity()
+{
+#if KWIN_BUILD_ACTIVITIES
+    Activities *activities = workspace()->activities();
+    QVERIFY(activities);
+    QTRY_VERIFY(activities->serviceStatus() != KActivities::Controller::Unknown);
+    if (activities->serviceStatus() != KActivities::Controller::Running) {
+        QSKIP("The activity manager is not running");
+    }
+    QTRY_VERIFY(!activities->current().isEmpty());
+    const QString initial = activities->current();
+
+    KActivities::Controller controller;
+    QFuture<QString> added = controller.addActivity(QStringLiteral("testActivity"));
+    QTRY_VERIFY(added.isFinished());
+    const QString other = added.result();
+    QTRY_VERIFY(activities->all().contains(other));
+
+    WindowSpatialIndex index;
+    Window *a = createWindow(QPoint(10, 10));
+    QVERIFY(a);
+    Window *b = createWindow(QPoint(20, 20));
+    QVERIFY(b);
+
+    // windows on other activities are not indexed
+    b->setOnActivities(QStringList{other});
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{a}));
+
+    activities->setCurrent(other);
+    QTRY_COMPARE(activities->current(), other);
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{b}));
+
+    activities->setCurrent(initial);
+    QTRY_COMPARE(activities->current(), initial);
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{a}));
+
+    b->setOnAllActivities(true);
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), topmostFirst({a, b}));
+
+    controller.removeActivity(other);
+    QTRY_VERIFY(!activities->all().contains(other));
+#else
+    QSKIP("KWin is built without activities");
+#endif
+}
+
+void WindowSpatialIndexTest::testMinimize()
+{
+    WindowSpatialIndex index;
+    Window *a = createWindow(QPoint(10, 10));
+    QVERIFY(a);
+    Window *b = createWindow(QPoint(20, 20));
+    QVERIFY(b);
+
+    b->minimize();
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{a}));
+
+    b->unminimize();
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), topmostFirst({a, b}));
+}
+
+void WindowSpatialIndexTest::testHide()
+{
+    WindowSpatialIndex index;
+    Window *a = createWindow(QPoint(10, 10));
+    QVERIFY(a);
+    Window *b = createWindow(QPoint(20, 20));
+    QVERIFY(b);
+
+    b->hideClient();
+    QVERIFY(b->isHiddenInternal());
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{a}));
+
+    b->showClient();
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{b, a}));
+}
+
+void WindowSpatialIndexTest::testMove()
+{
+    // This test verifies that windows are moved to other cells when they cross cell boundaries.
+    WindowSpatialIndex index;
+    Window *a = createWindow(QPoint(10, 10));
+    QVERIFY(a);
+    Window *b = createWindow(QPoint(20, 20));
+    QVERIFY(b);
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{b, a}));
+
+    // straddle the boundary between two cells
+    b->move(QPoint(200, 20));
+    QCOMPARE(index.windowsAt(QPointF(210, 50)), (QVector<Window *>{b, a}));
+    QCOMPARE(index.windowsAt(QPointF(290, 50)), (QVector<Window *>{b}));
+
+    // leave the first cell
+    b->move(QPoint(600, 600));
+    QCOMPARE(index.windowsAt(QPointF(210, 50)), (QVector<Window *>{a}));
+    QVERIFY(index.windowsAt(QPointF(290, 50)).isEmpty());
+    QCOMPARE(index.windowsAt(QPointF(650, 650)), (QVector<Window *>{b}));
+
+    // the parts outside the workspace are not indexed
+    a->move(QPoint(-50, -20));
+    QCOMPARE(index.windowsAt(QPointF(10, 10)), (QVector<Window *>{a}));
+    QVERIFY(index.windowsAt(QPointF(-10, -10)).isEmpty());
+
+    // and come back to the first cell, the stacking order is preserved
+    b->move(QPoint(0, 0));
+    QCOMPARE(index.windowsAt(QPointF(10, 10)), (QVector<Window *>{b, a}));
+}
+
+void WindowSpatialIndexTest::testClosed()
+{
+    // This test verifies that closed windows are removed from the index, both while they
+    // are still around as deleted windows and once they have been destroyed.
+    WindowSpatialIndex index;
+    Window *a = createWindow(QPoint(10, 10));
+    QVERIFY(a);
+    Window *b = createWindow(QPoint(20, 20));
+    QVERIFY(b);
+
+    QSignalSpy windowDeletedSpy(workspace(), &Workspace::deletedRemoved);
+    QVERIFY(windowDeletedSpy.isValid());
+    QSignalSpy windowClosedSpy(b, &Window::windowClosed);
+    QVERIFY(windowClosedSpy.isValid());
+    m_shellSurfaces.back().reset();
+    m_surfaces.back().reset();
+    QVERIFY(windowClosedSpy.wait());
+
+    const QVector<Window *> windows = index.windowsAt(QPointF(50, 50));
+    QCOMPARE(windows, (QVector<Window *>{a}));
+
+    // deleted windows don't show up in the index either
+    Deleted *deleted = windowClosedSpy.first().at(1).value<Deleted *>();
+    QVERIFY(deleted);
+    QVERIFY(!index.windowsAt(QPointF(50, 50)).contains(deleted));
+
+    QVERIFY(windowDeletedSpy.count() || windowDeletedSpy.wait());
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{a}));
+
+    // a window that is mapped again afterwards is indexed as usual
+    Window *c = createWindow(QPoint(30, 30));
+    QVERIFY(c);
+    QCOMPARE(index.windowsAt(QPointF(50, 50)), (QVector<Window *>{c, a}));
+}
+
+WAYLANDTEST_MAIN(WindowSpatialIndexTest)
+#include "windowspatialindex_test.moc"
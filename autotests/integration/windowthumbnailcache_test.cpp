@@ -0,0 +1,122 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "effectloader.h"
+#include "platform.h"
+#include "renderbackend.h"
+#include "scene.h"
+#include "scripting/windowthumbnailcache.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <kwingltexture.h>
+
+#include <KConfigGroup>
+#include <KWayland/Client/surface.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_windowthumbnailcache-0");
+
+class WindowThumbnailCacheTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testBucketSharing();
+};
+
+void WindowThumbnailCacheTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    // disable all effects, they shouldn't render thumbnails on their own
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(Compositor::self());
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void WindowThumbnailCacheTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void WindowThumbnailCacheTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+}
+
+void WindowThumbnailCacheTest::testBucketSharing()
+{
+    // This test verifies that thumbnails of similar sizes share a texture, and that
+    // thumbnails with different device pixel ratios don't replace each other.
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(400, 200), Qt::red);
+    QVERIFY(window);
+    const QSize fullSize = window->visibleGeometry().toAlignedRect().size();
+
+    Scene *scene = Compositor::self()->scene();
+    QVERIFY(scene->makeOpenGLContextCurrent());
+    WindowThumbnailCache *cache = WindowThumbnailCache::self();
+
+    // thumbnails up to half of the window size are rendered in the same bucket
+    const std::shared_ptr<GLTexture> half = cache->acquire(window, fullSize / 2, 1);
+    QVERIFY(half);
+    QCOMPARE(half->size(), fullSize / 2);
+    QCOMPARE(cache->acquire(window, fullSize / 2 - QSize(10, 10), 1), half);
+
+    // the thumbnail items sample the texture with mipmap filtering only if it has mipmaps
+    QCOMPARE(WindowThumbnailCache::hasMipmaps(half.get()), half->filter() == GL_LINEAR_MIPMAP_LINEAR);
+
+    // larger thumbnails need the full size
+    const std::shared_ptr<GLTexture> full = cache->acquire(window, fullSize, 1);
+    QVERIFY(full);
+    QVERIFY(full != half);
+    QCOMPARE(full->size(), fullSize);
+
+    // the same thumbnail on an output with a different scale gets its own texture
+    const std::shared_ptr<GLTexture> scaledHalf = cache->acquire(window, fullSize / 2, 2);
+    QVERIFY(scaledHalf);
+    QVERIFY(scaledHalf != half);
+    QCOMPARE(scaledHalf->size(), fullSize);
+
+    // and both are still cached
+    QCOMPARE(cache->acquire(window, fullSize / 2, 1), half);
+    QCOMPARE(cache->acquire(window, fullSize / 2, 2), scaledHalf);
+
+    scene->doneOpenGLContextCurrent();
+}
+
+WAYLANDTEST_MAIN(WindowThumbnailCacheTest)
+#include "windowthumbnailcache_test.moc"
@@ -0,0 +1,146 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "platform.h"
+#include "wayland/seat_interface.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QProcessEnvironment>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_xwayland_selections_benchmark-0");
+
+struct ProcessKillBeforeDeleter
+{
+    void operator()(QProcess *pointer)
+    {
+        if (pointer) {
+            pointer->kill();
+        }
+        delete pointer;
+    }
+};
+
+/**
+ * The Xwayland selections benchmark copies a large text with the copy helper and measures
+ * how long it takes until the paste helper has received it, from the moment the paste
+ * window is activated. The clipboard is transferred incrementally between Xwayland and
+ * the Wayland clients. The measured time includes the short delay before the paste helper
+ * quits, so the results are only meaningful for large texts.
+ */
+class XwaylandSelectionsBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkTransfer_data();
+    void benchmarkTransfer();
+
+private:
+    std::unique_ptr<QProcess, ProcessKillBeforeDeleter> startHelper(const QString &name, const QString &platform, int size);
+};
+
+void XwaylandSelectionsBenchmark::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    qRegisterMetaType<QProcess::ExitStatus>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+}
+
+std::unique_ptr<QProcess, ProcessKillBeforeDeleter> XwaylandSelectionsBenchmark::startHelper(const QString &name, const QString &platform, int size)
+{
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert(QStringLiteral("QT_QPA_PLATFORM"), platform);
+    environment.insert(QStringLiteral("WAYLAND_DISPLAY"), s_socketName);
+
+    std::unique_ptr<QProcess, ProcessKillBeforeDeleter> process(new QProcess());
+    process->setProcessEnvironment(environment);
+    process->setProcessChannelMode(QProcess::ForwardedChannels);
+    process->setProgram(QFINDTESTDATA(name));
+    process->setArguments({QString::number(size)});
+    process->start();
+    return process;
+}
+
+void XwaylandSelectionsBenchmark::benchmarkTransfer_data()
+{
+    QTest::addColumn<QString>("copyPlatform");
+    QTest::addColumn<QString>("pastePlatform");
+    QTest::addColumn<int>("size");
+
+    const int sizeOverride = qEnvironmentVariableIntValue("KWIN_BENCHMARK_SELECTION_SIZE");
+    const QVector<int> sizes = sizeOverride > 0 ? QVector<int>{sizeOverride} : QVector<int>{1 << 20, 16 << 20, 64 << 20};
+    for (int size : sizes) {
+        QTest::addRow("x11->wayland, %d bytes", size) << QStringLiteral("xcb") << QStringLiteral("wayland") << size;
+        QTest::addRow("wayland->x11, %d bytes", size) << QStringLiteral("wayland") << QStringLiteral("xcb") << size;
+    }
+}
+
+void XwaylandSelectionsBenchmark::benchmarkTransfer()
+{
+    QFETCH(QString, copyPlatform);
+    QFETCH(QString, pastePlatform);
+    QFETCH(int, size);
+
+    QSignalSpy windowAddedSpy(workspace(), &Workspace::windowAdded);
+    QVERIFY(windowAddedSpy.isValid());
+    QSignalSpy clipboardChangedSpy(waylandServer()->seat(), &KWaylandServer::SeatInterface::selectionChanged);
+    QVERIFY(clipboardChangedSpy.isValid());
+
+    // start the copy process
+    auto copyProcess = startHelper(QStringLiteral("copy"), copyPlatform, size);
+    QVERIFY(copyProcess->waitForStarted());
+    QVERIFY(windowAddedSpy.wait());
+    Window *copyWindow = windowAddedSpy.last().first().value<Window *>();
+    QVERIFY(copyWindow);
+    if (workspace()->activeWindow() != copyWindow) {
+        workspace()->activateWindow(copyWindow);
+    }
+    QVERIFY(clipboardChangedSpy.wait());
+
+    // start the paste process, it requests the clipboard once it is activated
+    windowAddedSpy.clear();
+    auto pasteProcess = startHelper(QStringLiteral("paste"), pastePlatform, size);
+    QSignalSpy finishedSpy(pasteProcess.get(), static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished));
+    QVERIFY(finishedSpy.isValid());
+    QVERIFY(pasteProcess->waitForStarted());
+    QVERIFY(windowAddedSpy.wait());
+    Window *pasteWindow = windowAddedSpy.last().first().value<Window *>();
+    QVERIFY(pasteWindow);
+
+    QElapsedTimer timer;
+    timer.start();
+    if (workspace()->activeWindow() != pasteWindow) {
+        workspace()->activateWindow(pasteWindow);
+    }
+    QVERIFY(finishedSpy.wait(60000));
+    const qint64 elapsed = timer.nsecsElapsed();
+    QCOMPARE(finishedSpy.first().first().toInt(), 0);
+
+    QTest::setBenchmarkResult(size * 1e9 / elapsed, QTest::BytesPerSecond);
+}
+
+} // namespace KWin
+
+WAYLANDTEST_MAIN(KWin::XwaylandSelectionsBenchmark)
+#include "xwayland_selections_benchmark.moc"
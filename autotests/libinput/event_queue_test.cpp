@@ -0,0 +1,165 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "mock_libinput.h"
+
+#include "backends/libinput/device.h"
+#include "backends/libinput/eventqueue.h"
+#include "backends/libinput/events.h"
+
+#include <QtTest>
+
+#include <thread>
+
+using namespace KWin::LibInput;
+
+class TestLibinputEventQueue : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testCapacity();
+    void testPushPop();
+    void testFull();
+    void testDestroyPending();
+    void testConcurrent();
+
+private:
+    bool push(EventQueue &queue, quint32 time);
+
+    libinput_device *m_nativeDevice = nullptr;
+    Device *m_device = nullptr;
+};
+
+void TestLibinputEventQueue::init()
+{
+    m_nativeDevice = new libinput_device;
+    m_nativeDevice->pointer = true;
+    m_device = new Device(m_nativeDevice);
+}
+
+void TestLibinputEventQueue::cleanup()
+{
+    delete m_device;
+    m_device = nullptr;
+
+    delete m_nativeDevice;
+    m_nativeDevice = nullptr;
+}
+
+bool TestLibinputEventQueue::push(EventQueue &queue, quint32 time)
+{
+    EventStorage *storage = queue.reserve();
+    if (!storage) {
+        return false;
+    }
+    libinput_event_pointer *pointerEvent = new libinput_event_pointer;
+    pointerEvent->type = LIBINPUT_EVENT_POINTER_MOTION;
+    pointerEvent->device = m_nativeDevice;
+    pointerEvent->time = time;
+    queue.commit(Event::create(pointerEvent, storage));
+    return true;
+}
+
+void TestLibinputEventQueue::testCapacity()
+{
+    QCOMPARE(EventQueue(0).capacity(), 2u);
+    QCOMPARE(EventQueue(5).capacity(), 8u);
+    QCOMPARE(EventQueue(16).capacity(), 16u);
+}
+
+void TestLibinputEventQueue::testPushPop()
+{
+    EventQueue queue(4);
+    QVERIFY(queue.isEmpty());
+    QVERIFY(!queue.peek());
+
+    QVERIFY(push(queue, 1));
+    QVERIFY(push(queue, 2));
+    QVERIFY(!queue.isEmpty());
+
+    Event *first = queue.peek();
+    QVERIFY(first);
+    QCOMPARE(first->type(), LIBINPUT_EVENT_POINTER_MOTION);
+    QCOMPARE(first->device(), m_device);
+    QVERIFY(dynamic_cast<PointerEvent *>(first));
+    QCOMPARE(static_cast<PointerEvent *>(first)->time(), 1u);
+    QCOMPARE(static_cast<PointerEvent *>(queue.peek(1))->time(), 2u);
+    QVERIFY(!queue.peek(2));
+
+    queue.pop();
+    QCOMPARE(static_cast<PointerEvent *>(queue.peek())->time(), 2u);
+    queue.pop();
+    QVERIFY(queue.isEmpty());
+}
+
+void TestLibinputEventQueue::testFull()
+{
+    EventQueue queue(4);
+    for (quint32 i = 0; i < queue.capacity(); ++i) {
+        QVERIFY(push(queue, i));
+    }
+    QVERIFY(!queue.reserve());
+
+    queue.pop();
+    QVERIFY(push(queue, 4));
+    QVERIFY(!queue.reserve());
+
+    for (quint32 i = 1; i <= 4; ++i) {
+        QCOMPARE(static_cast<PointerEvent *>(queue.peek())->time(), i);
+        queue.pop();
+    }
+    QVERIFY(queue.isEmpty());
+}
+
+void TestLibinputEventQueue::testDestroyPending()
+{
+    // the queue must destroy the events that have not been popped, this is checked by asan
+    EventQueue queue(4);
+    QVERIFY(push(queue, 1));
+    QVERIFY(push(queue, 2));
+}
+
+void TestLibinputEventQueue::testConcurrent()
+{
+    // this test verifies that the events arrive in order when the producer and the consumer
+    // run in different threads and the queue wraps around many times
+    EventQueue queue(8);
+    const quint32 count = 100000;
+
+    std::thread producer([this, &queue, count]() {
+        for (quint32 i = 0; i < count;) {
+            if (push(queue, i)) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    bool inOrder = true;
+    for (quint32 expected = 0; expected < count;) {
+        Event *event = queue.peek();
+        if (!event) {
+            std::this_thread::yield();
+            continue;
+        }
+        inOrder &= static_cast<PointerEvent *>(event)->time() == expected;
+        queue.pop();
+        ++expected;
+    }
+
+    producer.join();
+    QVERIFY(inOrder);
+    QVERIFY(queue.isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestLibinputEventQueue)
+#include "event_queue_test.moc"
@@ -0,0 +1,196 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <kwinpixelconversion_p.h>
+
+#include <QRandomGenerator>
+#include <QtTest>
+
+using namespace KWin;
+
+Q_DECLARE_METATYPE(QImage::Format)
+
+class PixelConversionTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testConvert_data();
+    void testConvert();
+    void testIdentity();
+    void testUnsupported();
+    void benchmarkPixelConversion_data();
+    void benchmarkPixelConversion();
+    void benchmarkImageConversion_data();
+    void benchmarkImageConversion();
+};
+
+static QImage createImage(const QSize &size, QImage::Format format)
+{
+    QImage image(size, QImage::Format_ARGB32);
+    QRandomGenerator generator(size.width() * size.height());
+    for (int y = 0; y < image.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            line[x] = generator.generate();
+        }
+    }
+    return image.convertToFormat(format);
+}
+
+static bool fuzzyCompare(QRgb a, QRgb b)
+{
+    return qAbs(qRed(a) - qRed(b)) <= 1
+        && qAbs(qGreen(a) - qGreen(b)) <= 1
+        && qAbs(qBlue(a) - qBlue(b)) <= 1
+        && qAbs(qAlpha(a) - qAlpha(b)) <= 1;
+}
+
+static void addFormatRows()
+{
+    QTest::addColumn<QImage::Format>("source");
+    QTest::addColumn<QImage::Format>("destination");
+
+    const QList<QPair<const char *, QImage::Format>> sources{
+        {"ARGB32_Premultiplied", QImage::Format_ARGB32_Premultiplied},
+        {"RGB32", QImage::Format_RGB32},
+        {"A2RGB30_Premultiplied", QImage::Format_A2RGB30_Premultiplied},
+        {"RGB30", QImage::Format_RGB30},
+        {"A2BGR30_Premultiplied", QImage::Format_A2BGR30_Premultiplied},
+        {"BGR30", QImage::Format_BGR30},
+        {"RGBA64_Premultiplied", QImage::Format_RGBA64_Premultiplied},
+        {"RGBX64", QImage::Format_RGBX64},
+    };
+    const QList<QPair<const char *, QImage::Format>> destinations{
+        {"ARGB32_Premultiplied", QImage::Format_ARGB32_Premultiplied},
+        {"RGBA8888_Premultiplied", QImage::Format_RGBA8888_Premultiplied},
+    };
+
+    for (const auto &[sourceName, source] : sources) {
+        for (const auto &[destinationName, destination] : destinations) {
+            if (source != destination) {
+                QTest::addRow("%s->%s", sourceName, destinationName) << source << destination;
+            }
+        }
+    }
+}
+
+void PixelConversionTest::initTestCase()
+{
+    qDebug() << "Using" << PixelConversion::instructionSet() << "conversion kernels";
+}
+
+void PixelConversionTest::testConvert_data()
+{
+    addFormatRows();
+}
+
+void PixelConversionTest::testConvert()
+{
+    QFETCH(QImage::Format, source);
+    QFETCH(QImage::Format, destination);
+
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    QSKIP("The conversion kernels support only little endian systems");
+#endif
+
+    QVERIFY(PixelConversion::canConvert(source, destination));
+
+    // Use an odd width and an offset so both the vector and the scalar code paths are covered.
+    const QImage image = createImage(QSize(77, 13), source);
+    const QRect rect(3, 2, 67, 9);
+
+    QImage converted(rect.size(), destination);
+    converted.fill(Qt::transparent);
+    QVERIFY(PixelConversion::convert(image, rect, destination, converted.bits(), converted.bytesPerLine()));
+
+    const QImage expected = image.copy(rect).convertToFormat(destination);
+    for (int y = 0; y < rect.height(); ++y) {
+        for (int x = 0; x < rect.width(); ++x) {
+            const QRgb actualPixel = converted.pixel(x, y);
+            const QRgb expectedPixel = expected.pixel(x, y);
+            if (!fuzzyCompare(actualPixel, expectedPixel)) {
+                QFAIL(qPrintable(QStringLiteral("pixel at %1,%2 is %3, expected %4")
+                                     .arg(x)
+                                     .arg(y)
+                                     .arg(actualPixel, 8, 16, QLatin1Char('0'))
+                                     .arg(expectedPixel, 8, 16, QLatin1Char('0'))));
+            }
+        }
+    }
+}
+
+void PixelConversionTest::testIdentity()
+{
+    const QImage image = createImage(QSize(31, 7), QImage::Format_RGBA8888_Premultiplied);
+    const QRect rect(1, 1, 29, 5);
+    QVERIFY(PixelConversion::canConvert(image.format(), image.format()));
+
+    QImage converted(rect.size(), image.format());
+    QVERIFY(PixelConversion::convert(image, rect, image.format(), converted.bits(), converted.bytesPerLine()));
+    QCOMPARE(converted, image.copy(rect));
+}
+
+void PixelConversionTest::testUnsupported()
+{
+    QVERIFY(!PixelConversion::canConvert(QImage::Format_Indexed8, QImage::Format_ARGB32_Premultiplied));
+    QVERIFY(!PixelConversion::canConvert(QImage::Format_ARGB32_Premultiplied, QImage::Format_RGB888));
+
+    const QImage image = createImage(QSize(16, 16), QImage::Format_ARGB32_Premultiplied);
+    QImage converted(QSize(16, 16), QImage::Format_RGB888);
+    QVERIFY(!PixelConversion::convert(image, image.rect(), converted.format(), converted.bits(), converted.bytesPerLine()));
+
+    // The source rect must be inside the image.
+    QImage destination(QSize(16, 16), QImage::Format_RGBA8888_Premultiplied);
+    QVERIFY(!PixelConversion::convert(image, QRect(8, 8, 16, 16), destination.format(), destination.bits(), destination.bytesPerLine()));
+}
+
+void PixelConversionTest::benchmarkPixelConversion_data()
+{
+    addFormatRows();
+}
+
+void PixelConversionTest::benchmarkPixelConversion()
+{
+    QFETCH(QImage::Format, source);
+    QFETCH(QImage::Format, destination);
+
+    const QImage image = createImage(QSize(1920, 1080), source);
+    const QRect rect(0, 0, 1280, 720);
+    QImage converted(rect.size(), destination);
+
+    QBENCHMARK {
+        PixelConversion::convert(image, rect, destination, converted.bits(), converted.bytesPerLine());
+    }
+}
+
+void PixelConversionTest::benchmarkImageConversion_data()
+{
+    addFormatRows();
+}
+
+void PixelConversionTest::benchmarkImageConversion()
+{
+    QFETCH(QImage::Format, source);
+    QFETCH(QImage::Format, destination);
+
+    const QImage image = createImage(QSize(1920, 1080), source);
+    const QRect rect(0, 0, 1280, 720);
+
+    // This is what GLTexture::update() used to do to upload a sub-rect in a foreign format.
+    QBENCHMARK {
+        QImage converted = image.copy(rect);
+        converted.convertTo(destination);
+    }
+}
+
+QTEST_MAIN(PixelConversionTest)
+
+#include "pixelconversiontest.moc"
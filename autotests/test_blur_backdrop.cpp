@@ -0,0 +1,127 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "effects/blur/blurbackdrop.h"
+
+#include <QtTest>
+
+using namespace KWin;
+
+class TestBlurBackdrop : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testNoDamage_data();
+    void testNoDamage();
+    void testDockDamageUnderneath();
+    void testWindowDamageUnderneath();
+    void testSkippedFrame();
+    void testMoved();
+    void testInvalidateArea_data();
+    void testInvalidateArea();
+    void testInvalidate();
+};
+
+static const QRect s_panelArea(0, 0, 1000, 40);
+static const QRect s_panelGeometry = s_panelArea.adjusted(-10, -10, 10, 10);
+
+// Returns a backdrop of a panel that has been fully blurred in the frame 1.
+static BackdropRegion cachedPanel()
+{
+    BackdropRegion backdrop;
+    backdrop.update(1, s_panelGeometry, s_panelArea, QRegion(), true, 10);
+    backdrop.valid = s_panelArea;
+    return backdrop;
+}
+
+void TestBlurBackdrop::testNoDamage_data()
+{
+    QTest::addColumn<bool>("isDock");
+
+    QTest::newRow("window") << false;
+    QTest::newRow("dock") << true;
+}
+
+void TestBlurBackdrop::testNoDamage()
+{
+    // The damage of the window itself, e.g. a ticking clock in a panel, is not passed
+    // as damage underneath, so the whole cached backdrop has to stay valid.
+    QFETCH(bool, isDock);
+
+    BackdropRegion backdrop = cachedPanel();
+    QVERIFY(backdrop.update(2, s_panelGeometry, s_panelArea, QRegion(), isDock, 10).isEmpty());
+    QCOMPARE(backdrop.valid, QRegion(s_panelArea));
+}
+
+void TestBlurBackdrop::testDockDamageUnderneath()
+{
+    // The blur of docks can't be updated piecewise.
+    BackdropRegion backdrop = cachedPanel();
+    QCOMPARE(backdrop.update(2, s_panelGeometry, s_panelArea, QRegion(500, 0, 10, 10), true, 10), QRegion(s_panelArea));
+    QVERIFY(backdrop.valid.isEmpty());
+}
+
+void TestBlurBackdrop::testWindowDamageUnderneath()
+{
+    const QRect blurArea(0, 0, 1000, 1000);
+    BackdropRegion backdrop;
+    backdrop.update(1, blurArea, blurArea, QRegion(), false, 10);
+    backdrop.valid = blurArea;
+
+    const QRegion stale = backdrop.update(2, blurArea, blurArea, QRegion(500, 500, 10, 10), false, 10);
+    QCOMPARE(stale, QRegion(490, 490, 30, 30));
+    QCOMPARE(backdrop.valid, QRegion(blurArea) - QRegion(490, 490, 30, 30));
+}
+
+void TestBlurBackdrop::testSkippedFrame()
+{
+    // The changes underneath a window that hasn't been painted went unnoticed.
+    BackdropRegion backdrop = cachedPanel();
+    QCOMPARE(backdrop.update(3, s_panelGeometry, s_panelArea, QRegion(), true, 10), QRegion(s_panelArea));
+}
+
+void TestBlurBackdrop::testMoved()
+{
+    BackdropRegion backdrop = cachedPanel();
+    const QRect area = s_panelArea.translated(0, 100);
+    QCOMPARE(backdrop.update(2, s_panelGeometry.translated(0, 100), area, QRegion(), true, 10), QRegion(area));
+}
+
+void TestBlurBackdrop::testInvalidateArea_data()
+{
+    QTest::addColumn<QRect>("area");
+    QTest::addColumn<bool>("valid");
+
+    // e.g. a window that has been closed, minimized or hidden
+    QTest::newRow("underneath") << QRect(100, 0, 400, 400) << false;
+    QTest::newRow("within the margin") << QRect(100, 45, 400, 400) << false;
+    QTest::newRow("elsewhere") << QRect(100, 100, 400, 400) << true;
+}
+
+void TestBlurBackdrop::testInvalidateArea()
+{
+    QFETCH(QRect, area);
+    QFETCH(bool, valid);
+
+    BackdropRegion backdrop = cachedPanel();
+    backdrop.invalidate(area);
+    QCOMPARE(backdrop.update(2, s_panelGeometry, s_panelArea, QRegion(), true, 10).isEmpty(), valid);
+}
+
+void TestBlurBackdrop::testInvalidate()
+{
+    // e.g. the stacking order has changed
+    BackdropRegion backdrop = cachedPanel();
+    backdrop.invalidate();
+    QCOMPARE(backdrop.update(2, s_panelGeometry, s_panelArea, QRegion(), true, 10), QRegion(s_panelArea));
+}
+
+QTEST_GUILESS_MAIN(TestBlurBackdrop)
+#include "test_blur_backdrop.moc"
@@ -0,0 +1,186 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "colors/colordevice.h"
+#include "colors/colorpipelinestage.h"
+#include "colors/colortransformation.h"
+#include "output.h"
+
+#include <QtTest>
+
+#include <lcms2.h>
+
+using namespace KWin;
+
+class FakeOutput : public Output
+{
+public:
+    RenderLoop *renderLoop() const override
+    {
+        return nullptr;
+    }
+
+    void setColorTransformation(const std::shared_ptr<ColorTransformation> &transformation) override
+    {
+        m_transformation = transformation;
+    }
+
+    std::shared_ptr<ColorTransformation> m_transformation;
+};
+
+class TestColorTransformation : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testBlend();
+    void testEquivalence();
+    void testBlendedTemperature();
+    void testEndpointCache();
+};
+
+// Creates a transformation that scales all channels so that 0xffff is mapped to @p max.
+static std::shared_ptr<ColorTransformation> scaleTransformation(uint16_t max)
+{
+    const uint16_t table[] = {0, max};
+    cmsToneCurve *curve = cmsBuildTabulatedToneCurve16(nullptr, 2, table);
+    cmsToneCurve *curves[] = {curve, curve, curve};
+    auto stage = std::make_unique<ColorPipelineStage>(cmsStageAllocToneCurves(nullptr, 3, curves));
+    cmsFreeToneCurve(curve);
+
+    std::vector<std::unique_ptr<ColorPipelineStage>> stages;
+    stages.push_back(std::move(stage));
+    return std::make_shared<ColorTransformation>(std::move(stages));
+}
+
+void TestColorTransformation::testBlend()
+{
+    const auto from = scaleTransformation(0xffff);
+    const auto to = scaleTransformation(0x8000);
+    QVERIFY(from->valid());
+    QVERIFY(to->valid());
+
+    // a quarter of the way from the identity to the halving transformation
+    const ColorTransformation blended(from, to, 0.25);
+    QVERIFY(blended.valid());
+
+    for (uint32_t value = 0; value <= 0xffff; value += 0x1111) {
+        const uint16_t expected = std::round(value * (0.75 + 0.25 * 0x8000 / 0xffff));
+        const auto [r, g, b] = blended.transform(value, value, value);
+        QVERIFY(std::abs(r - expected) <= 1);
+        QVERIFY(std::abs(g - expected) <= 1);
+        QVERIFY(std::abs(b - expected) <= 1);
+    }
+
+    const size_t size = 256;
+    const QVector<uint16_t> lut = blended.lut(size);
+    QCOMPARE(lut.size(), int(3 * size));
+    for (size_t i = 0; i < size; i++) {
+        const uint16_t index = (i * 0xffff) / size;
+        const auto [r, g, b] = blended.transform(index, index, index);
+        QCOMPARE(lut[i], r);
+        QCOMPARE(lut[size + i], g);
+        QCOMPARE(lut[2 * size + i], b);
+    }
+}
+
+void TestColorTransformation::testEquivalence()
+{
+    const auto from = scaleTransformation(0xffff);
+    const auto to = scaleTransformation(0x8000);
+    const auto other = scaleTransformation(0x4000);
+
+    QVERIFY(from->isEquivalent(*from));
+    QVERIFY(!from->isEquivalent(*to));
+    QVERIFY(!from->isEquivalent(*scaleTransformation(0xffff)));
+
+    const ColorTransformation half(from, to, 0.5);
+    QVERIFY(half.isEquivalent(ColorTransformation(from, to, 0.5)));
+    // the blend factor is rounded, so tiny differences don't produce a different table
+    QVERIFY(half.isEquivalent(ColorTransformation(from, to, 0.5 + 1e-5)));
+    QVERIFY(!half.isEquivalent(ColorTransformation(from, to, 0.25)));
+    QVERIFY(!half.isEquivalent(ColorTransformation(from, other, 0.5)));
+    QVERIFY(!half.isEquivalent(ColorTransformation(to, from, 0.5)));
+    QVERIFY(!half.isEquivalent(*from));
+}
+
+void TestColorTransformation::testBlendedTemperature()
+{
+    FakeOutput output;
+    ColorDevice device(&output);
+
+    device.setTemperature(4500);
+    device.update();
+    const auto lower = output.m_transformation;
+    QVERIFY(lower);
+    device.setTemperature(4600);
+    device.update();
+    const auto upper = output.m_transformation;
+    QVERIFY(upper);
+    device.setTemperature(4550);
+    device.update();
+    const auto blended = output.m_transformation;
+    QVERIFY(blended);
+
+    // the temperatures in between the endpoints are blended from them
+    QVERIFY(!blended->isEquivalent(*lower));
+    QVERIFY(!blended->isEquivalent(*upper));
+    QVERIFY(blended->isEquivalent(ColorTransformation(lower, upper, 0.5)));
+
+    const size_t size = 256;
+    const QVector<uint16_t> lowerLut = lower->lut(size);
+    const QVector<uint16_t> upperLut = upper->lut(size);
+    const QVector<uint16_t> blendedLut = blended->lut(size);
+    for (size_t i = 0; i < 3 * size; i++) {
+        QVERIFY(blendedLut[i] >= std::min(lowerLut[i], upperLut[i]));
+        QVERIFY(blendedLut[i] <= std::max(lowerLut[i], upperLut[i]));
+    }
+}
+
+void TestColorTransformation::testEndpointCache()
+{
+    FakeOutput output;
+    ColorDevice device(&output);
+
+    // the endpoints are reused, so is the transformation of a multiple of 100K
+    device.setTemperature(4500);
+    device.update();
+    const auto endpoint = output.m_transformation;
+    QVERIFY(endpoint);
+    device.setTemperature(4510);
+    device.update();
+    device.setTemperature(4500);
+    device.update();
+    QCOMPARE(output.m_transformation, endpoint);
+
+    // a blended transformation is created again, but it's equivalent to the previous one
+    device.setTemperature(4550);
+    device.update();
+    const auto first = output.m_transformation;
+    QVERIFY(first);
+    device.setTemperature(4560);
+    device.update();
+    QVERIFY(!output.m_transformation->isEquivalent(*first));
+    device.setTemperature(4550);
+    device.update();
+    QVERIFY(output.m_transformation != first);
+    QVERIFY(output.m_transformation->isEquivalent(*first));
+
+    // only a few endpoints are kept, the farthest ones are dropped
+    for (uint temperature : {3000, 2000, 1000, 1500}) {
+        device.setTemperature(temperature);
+        device.update();
+    }
+    device.setTemperature(4550);
+    device.update();
+    QVERIFY(!output.m_transformation->isEquivalent(*first));
+}
+
+QTEST_GUILESS_MAIN(TestColorTransformation)
+#include "test_colortransformation.moc"
@@ -0,0 +1,166 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "scenes/opengl/shelfallocator.h"
+
+#include <QtTest>
+
+using namespace KWin;
+
+class TestShelfAllocator : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testShelves();
+    void testTooLarge_data();
+    void testTooLarge();
+    void testPageFull();
+    void testRelease();
+    void testMerge();
+    void testReleaseEndOfShelf();
+    void testReuseShelf();
+    void testReusePage();
+};
+
+static const QSize s_pageSize(1000, 100);
+
+// Returns a null rect if the slot can't be allocated.
+static QRect allocate(ShelfAllocator &allocator, const QSize &size)
+{
+    return allocator.allocate(size).value_or(QRect());
+}
+
+void TestShelfAllocator::testShelves()
+{
+    ShelfAllocator allocator(s_pageSize);
+    QVERIFY(allocator.isEmpty());
+
+    QCOMPARE(allocate(allocator, QSize(100, 20)), QRect(0, 0, 100, 20));
+    QCOMPARE(allocate(allocator, QSize(200, 20)), QRect(100, 0, 200, 20));
+    QVERIFY(!allocator.isEmpty());
+
+    // Taller slots need a shelf of their own.
+    QCOMPARE(allocate(allocator, QSize(100, 25)), QRect(0, 20, 100, 25));
+
+    // Much shorter slots don't waste a tall shelf either.
+    QCOMPARE(allocate(allocator, QSize(100, 10)), QRect(0, 45, 100, 10));
+
+    // Slightly shorter slots share a shelf, they get the height of the shelf.
+    QCOMPARE(allocate(allocator, QSize(100, 18)), QRect(300, 0, 100, 20));
+
+    // Slots that don't fit in a shelf anymore go to another shelf that is tall enough.
+    QCOMPARE(allocate(allocator, QSize(700, 20)), QRect(100, 20, 700, 25));
+}
+
+void TestShelfAllocator::testTooLarge_data()
+{
+    QTest::addColumn<QSize>("size");
+
+    QTest::newRow("too wide") << QSize(1001, 10);
+    QTest::newRow("too tall") << QSize(10, 101);
+}
+
+void TestShelfAllocator::testTooLarge()
+{
+    QFETCH(QSize, size);
+
+    ShelfAllocator allocator(s_pageSize);
+    QVERIFY(!allocator.allocate(size));
+    QVERIFY(allocator.isEmpty());
+}
+
+void TestShelfAllocator::testPageFull()
+{
+    ShelfAllocator allocator(s_pageSize);
+    for (int y = 0; y < s_pageSize.height(); y += 20) {
+        QCOMPARE(allocate(allocator, QSize(1000, 20)), QRect(0, y, 1000, 20));
+    }
+    QVERIFY(!allocator.allocate(QSize(10, 20)));
+    QVERIFY(!allocator.allocate(QSize(10, 10)));
+}
+
+void TestShelfAllocator::testRelease()
+{
+    ShelfAllocator allocator(s_pageSize);
+    allocate(allocator, QSize(100, 20));
+    const QRect rect = allocate(allocator, QSize(100, 20));
+    allocate(allocator, QSize(100, 20));
+
+    allocator.release(rect);
+    QCOMPARE(allocate(allocator, QSize(100, 20)), rect);
+
+    // The free slot is too small for a wider slot.
+    allocator.release(rect);
+    QCOMPARE(allocate(allocator, QSize(150, 20)), QRect(300, 0, 150, 20));
+
+    // Narrower slots take a part of the free slot.
+    QCOMPARE(allocate(allocator, QSize(60, 20)), QRect(100, 0, 60, 20));
+    QCOMPARE(allocate(allocator, QSize(40, 20)), QRect(160, 0, 40, 20));
+    QCOMPARE(allocate(allocator, QSize(40, 20)), QRect(450, 0, 40, 20));
+}
+
+void TestShelfAllocator::testMerge()
+{
+    ShelfAllocator allocator(s_pageSize);
+    QVector<QRect> rects;
+    for (int i = 0; i < 4; ++i) {
+        rects.append(allocate(allocator, QSize(100, 20)));
+    }
+
+    // Adjacent free slots are merged, no matter in which order they are released.
+    allocator.release(rects[2]);
+    allocator.release(rects[1]);
+    QCOMPARE(allocate(allocator, QSize(200, 20)), QRect(100, 0, 200, 20));
+}
+
+void TestShelfAllocator::testReleaseEndOfShelf()
+{
+    ShelfAllocator allocator(s_pageSize);
+    allocate(allocator, QSize(100, 20));
+    const QRect second = allocate(allocator, QSize(100, 20));
+    const QRect third = allocate(allocator, QSize(100, 20));
+
+    // The free space at the end of the shelf is given back, including the free slots
+    // that are merged with it.
+    allocator.release(second);
+    allocator.release(third);
+    QCOMPARE(allocate(allocator, QSize(900, 20)), QRect(100, 0, 900, 20));
+}
+
+void TestShelfAllocator::testReuseShelf()
+{
+    ShelfAllocator allocator(s_pageSize);
+    allocate(allocator, QSize(100, 20));
+    const QRect rect = allocate(allocator, QSize(100, 30));
+
+    // An empty shelf at the bottom of the page can be used for slots of another height.
+    allocator.release(rect);
+    QCOMPARE(allocate(allocator, QSize(100, 80)), QRect(0, 20, 100, 80));
+}
+
+void TestShelfAllocator::testReusePage()
+{
+    ShelfAllocator allocator(s_pageSize);
+    const QRect first = allocate(allocator, QSize(100, 20));
+    const QRect second = allocate(allocator, QSize(300, 50));
+    const QRect third = allocate(allocator, QSize(200, 20));
+
+    allocator.release(second);
+    allocator.release(first);
+    QVERIFY(!allocator.isEmpty());
+    allocator.release(third);
+    QVERIFY(allocator.isEmpty());
+
+    // The whole page is available again.
+    QCOMPARE(allocate(allocator, s_pageSize), QRect(QPoint(0, 0), s_pageSize));
+}
+
+QTEST_GUILESS_MAIN(TestShelfAllocator)
+#include "test_shelf_allocator.moc"
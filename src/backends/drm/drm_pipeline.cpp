@@ -523,7 +523,8 @@ DrmCrtc *DrmPipeline::currentCrtc() const
 }
 
 DrmGammaRamp::DrmGammaRamp(DrmCrtc *crtc, const std::shared_ptr<ColorTransformation> &transformation)
-    : m_gpu(crtc->gpu())
+    : m_crtc(crtc)
+    , m_gpu(crtc->gpu())
     , m_lut(transformation, crtc->gammaRampSize())
 {
     if (crtc->gpu()->atomicModeSetting()) {
@@ -556,6 +557,36 @@ const ColorLUT &DrmGammaRamp::lut() const
     return m_lut;
 }
 
+DrmCrtc *DrmGammaRamp::crtc() const
+{
+    return m_crtc;
+}
+
+std::shared_ptr<DrmGammaRamp> DrmPipeline::gammaRamp(DrmCrtc *crtc, const std::shared_ptr<ColorTransformation> &transformation)
+{
+    static const size_t maxGammaRampCount = 3;
+
+    // Night color creates a new blended transformation for every step, so the ramps are
+    // matched by the endpoints and the blend factor rather than by the transformation.
+    const auto it = std::find_if(m_gammaRamps.begin(), m_gammaRamps.end(), [crtc, &transformation](const auto &ramp) {
+        return ramp->crtc() == crtc && ramp->lut().transformation()->isEquivalent(*transformation);
+    });
+    if (it != m_gammaRamps.end()) {
+        const auto ramp = *it;
+        m_gammaRamps.erase(it);
+        m_gammaRamps.push_front(ramp);
+        return ramp;
+    }
+
+    const auto ramp = std::make_shared<DrmGammaRamp>(crtc, transformation);
+    m_gammaRamps.push_front(ramp);
+    // the blobs of evicted ramps are destroyed as soon as no state refers to them anymore
+    while (m_gammaRamps.size() > maxGammaRampCount) {
+        m_gammaRamps.pop_back();
+    }
+    return ramp;
+}
+
 void DrmPipeline::printFlags(uint32_t flags)
 {
     if (flags == 0) {
@@ -647,7 +678,7 @@ Output::RgbRange DrmPipeline::rgbRange() const
 void DrmPipeline::setCrtc(DrmCrtc *crtc)
 {
     if (crtc && m_pending.crtc && crtc->gammaRampSize() != m_pending.crtc->gammaRampSize() && m_pending.colorTransformation) {
-        m_pending.gamma = std::make_shared<DrmGammaRamp>(crtc, m_pending.colorTransformation);
+        m_pending.gamma = gammaRamp(crtc, m_pending.colorTransformation);
     }
     m_pending.crtc = crtc;
     if (crtc) {
@@ -706,6 +737,6 @@ void DrmPipeline::setRgbRange(Output::RgbRange range)
 void DrmPipeline::setColorTransformation(const std::shared_ptr<ColorTransformation> &transformation)
 {
     m_pending.colorTransformation = transformation;
-    m_pending.gamma = std::make_shared<DrmGammaRamp>(m_pending.crtc, transformation);
+    m_pending.gamma = gammaRamp(m_pending.crtc, transformation);
 }
 }
@@ -14,6 +14,7 @@
 #include <QVector>
 
 #include <chrono>
+#include <deque>
 #include <xf86drmMode.h>
 
 #include "colorlut.h"
@@ -40,8 +41,10 @@ public:
 
     const ColorLUT &lut() const;
     uint32_t blobId() const;
+    DrmCrtc *crtc() const;
 
 private:
+    DrmCrtc *const m_crtc;
     DrmGpu *m_gpu;
     const ColorLUT m_lut;
     uint32_t m_blobId = 0;
@@ -165,12 +168,18 @@ private:
     };
     static void printFlags(uint32_t flags);
 
+    std::shared_ptr<DrmGammaRamp> gammaRamp(DrmCrtc *crtc, const std::shared_ptr<ColorTransformation> &transformation);
+
     DrmOutput *m_output = nullptr;
     DrmConnector *m_connector = nullptr;
 
     bool m_pageflipPending = false;
     bool m_modesetPresentPending = false;
 
+    // the most recently used gamma ramps, so that going back to a color transformation
+    // doesn't create another blob
+    std::deque<std::shared_ptr<DrmGammaRamp>> m_gammaRamps;
+
     struct State
     {
         DrmCrtc *crtc = nullptr;
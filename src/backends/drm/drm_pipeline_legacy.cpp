@@ -114,9 +114,15 @@ DrmPipeline::Error DrmPipeline::applyPendingChangesLegacy()
                 return err;
             }
         }
-        if (m_pending.gamma && drmModeCrtcSetGamma(gpu()->fd(), m_pending.crtc->id(), m_pending.gamma->lut().size(), m_pending.gamma->lut().red(), m_pending.gamma->lut().green(), m_pending.gamma->lut().blue()) != 0) {
-            qCWarning(KWIN_DRM) << "Setting gamma failed!" << strerror(errno);
-            return errnoToError();
+        if (m_pending.gamma) {
+            // drmModeCrtcSetGamma() takes mutable tables, the lookup table may be shared
+            const ColorLUT &lut = m_pending.gamma->lut();
+            QVector<uint16_t> data(lut.red(), lut.red() + 3 * lut.size());
+            uint16_t *red = data.data();
+            if (drmModeCrtcSetGamma(gpu()->fd(), m_pending.crtc->id(), lut.size(), red, red + lut.size(), red + 2 * lut.size()) != 0) {
+                qCWarning(KWIN_DRM) << "Setting gamma failed!" << strerror(errno);
+                return errnoToError();
+            }
         }
         setCursorLegacy();
         moveCursorLegacy();
@@ -152,10 +152,11 @@ std::optional<OutputLayerBeginFrameInfo> DrmVirtualQPainterLayer::beginFrame()
 {
     if (m_image.isNull() || m_image.size() != m_output->pixelSize()) {
         m_image = QImage(m_output->pixelSize(), QImage::Format_RGB32);
+        m_bufferAge = 0;
     }
     return OutputLayerBeginFrameInfo{
         .renderTarget = RenderTarget(&m_image),
-        .repaint = QRegion(),
+        .repaint = m_damageJournal.accumulate(m_bufferAge, infiniteRegion()),
     };
 }
 
@@ -163,6 +164,8 @@ bool DrmVirtualQPainterLayer::endFrame(const QRegion &renderedRegion, const QReg
 {
     Q_UNUSED(renderedRegion)
     m_currentDamage = damagedRegion;
+    m_damageJournal.add(damagedRegion);
+    m_bufferAge = 1;
     return true;
 }
 
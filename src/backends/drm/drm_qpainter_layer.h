@@ -8,6 +8,7 @@
 */
 #pragma once
 #include "drm_layer.h"
+#include "utils/damagejournal.h"
 
 #include <QImage>
 
@@ -73,6 +74,8 @@ public:
 private:
     QImage m_image;
     QRegion m_currentDamage;
+    DamageJournal m_damageJournal;
+    int m_bufferAge = 0;
     DrmVirtualOutput *const m_output;
 };
 }
@@ -151,17 +151,37 @@ void Connection::deactivate()
 
 void Connection::handleEvent()
 {
-    QMutexLocker locker(&m_mutex);
-    const bool wasEmpty = m_eventQueue.empty();
+    // libinput is not thread-safe, so the lock is held while calling into it. It's released
+    // in between, so the main thread can destroy the events that it has handled meanwhile.
+    bool queued = false;
     do {
-        m_input->dispatch();
-        std::unique_ptr<Event> event = m_input->event();
+        {
+            QMutexLocker locker(&m_mutex);
+            m_input->dispatch();
+        }
+        EventStorage *storage = m_eventQueue.reserve();
+        if (!storage) {
+            // The queue is full, processEvents() will read the remaining events once it has
+            // made some room in the queue. Check again in case it has drained the queue
+            // before the flag has been raised.
+            m_eventQueueFull = true;
+            storage = m_eventQueue.reserve();
+            if (!storage) {
+                break;
+            }
+        }
+        Event *event;
+        {
+            QMutexLocker locker(&m_mutex);
+            event = m_input->event(storage);
+        }
         if (!event) {
             break;
         }
-        m_eventQueue.push_back(std::move(event));
+        m_eventQueue.commit(event);
+        queued = true;
     } while (true);
-    if (wasEmpty && !m_eventQueue.empty()) {
+    if (queued && !m_eventsPending.exchange(true)) {
         Q_EMIT eventsRead();
     }
 }
@@ -253,43 +273,54 @@ KWin::TabletToolId createTabletId(libinput_tablet_tool *tool, void *userData)
 
 void Connection::processEvents()
 {
-    QMutexLocker locker(&m_mutex);
-    while (m_eventQueue.size() != 0) {
-        std::unique_ptr<Event> event = std::move(m_eventQueue.front());
-        m_eventQueue.pop_front();
+    m_eventsPending = false;
+    // Reading the data of a queued event doesn't call into the libinput context, so the lock
+    // is only held to configure devices and to destroy events. The input signals are emitted
+    // with the lock released, so they don't block the reader thread.
+    while (Event *event = m_eventQueue.peek()) {
         switch (event->type()) {
         case LIBINPUT_EVENT_DEVICE_ADDED: {
-            auto device = new Device(event->nativeDevice());
-            device->moveToThread(thread());
-            m_devices << device;
-
-            applyDeviceConfig(device);
-            applyScreenToDevice(device);
+            Device *device;
+            {
+                QMutexLocker locker(&m_mutex);
+                device = new Device(event->nativeDevice());
+                device->moveToThread(thread());
+                m_devices << device;
+
+                applyDeviceConfig(device);
+                applyScreenToDevice(device);
+            }
 
             Q_EMIT deviceAdded(device);
             break;
         }
         case LIBINPUT_EVENT_DEVICE_REMOVED: {
-            auto it = std::find_if(m_devices.begin(), m_devices.end(), [&event](Device *d) {
-                return event->device() == d;
-            });
-            if (it == m_devices.end()) {
+            Device *device = nullptr;
+            {
+                QMutexLocker locker(&m_mutex);
+                auto it = std::find_if(m_devices.begin(), m_devices.end(), [&event](Device *d) {
+                    return event->device() == d;
+                });
+                if (it != m_devices.end()) {
+                    device = *it;
+                    m_devices.erase(it);
+                }
+            }
+            if (!device) {
                 // we don't know this device
                 break;
             }
-            auto device = *it;
-            m_devices.erase(it);
             Q_EMIT deviceRemoved(device);
             device->deleteLater();
             break;
         }
         case LIBINPUT_EVENT_KEYBOARD_KEY: {
-            KeyEvent *ke = static_cast<KeyEvent *>(event.get());
+            KeyEvent *ke = static_cast<KeyEvent *>(event);
             Q_EMIT ke->device()->keyChanged(ke->key(), ke->state(), ke->time(), ke->device());
             break;
         }
         case LIBINPUT_EVENT_POINTER_AXIS: {
-            PointerEvent *pe = static_cast<PointerEvent *>(event.get());
+            PointerEvent *pe = static_cast<PointerEvent *>(event);
             const auto axes = pe->axis();
             for (const InputRedirection::PointerAxis &axis : axes) {
                 Q_EMIT pe->device()->pointerAxisChanged(axis, pe->axisValue(axis), pe->discreteAxisValue(axis),
@@ -298,40 +329,43 @@ void Connection::processEvents()
             break;
         }
         case LIBINPUT_EVENT_POINTER_BUTTON: {
-            PointerEvent *pe = static_cast<PointerEvent *>(event.get());
+            PointerEvent *pe = static_cast<PointerEvent *>(event);
             Q_EMIT pe->device()->pointerButtonChanged(pe->button(), pe->buttonState(), pe->time(), pe->device());
             break;
         }
         case LIBINPUT_EVENT_POINTER_MOTION: {
-            PointerEvent *pe = static_cast<PointerEvent *>(event.get());
+            PointerEvent *pe = static_cast<PointerEvent *>(event);
+            Device *device = pe->device();
             auto delta = pe->delta();
             auto deltaNonAccel = pe->deltaUnaccelerated();
             quint32 latestTime = pe->time();
             quint64 latestTimeUsec = pe->timeMicroseconds();
-            auto it = m_eventQueue.begin();
-            while (it != m_eventQueue.end()) {
-                if ((*it)->type() == LIBINPUT_EVENT_POINTER_MOTION) {
-                    std::unique_ptr<PointerEvent> p{static_cast<PointerEvent *>(it->release())};
-                    delta += p->delta();
-                    deltaNonAccel += p->deltaUnaccelerated();
-                    latestTime = p->time();
-                    latestTimeUsec = p->timeMicroseconds();
-                    it = m_eventQueue.erase(it);
-                } else {
+            // If we have fallen behind, merge the consecutive motion events of the same device.
+            // The last merged event stays at the front of the queue and is popped below.
+            QMutexLocker locker(&m_mutex);
+            while (Event *next = m_eventQueue.peek(1)) {
+                if (next->type() != LIBINPUT_EVENT_POINTER_MOTION || next->device() != device) {
                     break;
                 }
+                PointerEvent *p = static_cast<PointerEvent *>(next);
+                delta += p->delta();
+                deltaNonAccel += p->deltaUnaccelerated();
+                latestTime = p->time();
+                latestTimeUsec = p->timeMicroseconds();
+                m_eventQueue.pop();
             }
-            Q_EMIT pe->device()->pointerMotion(delta, deltaNonAccel, latestTime, latestTimeUsec, pe->device());
+            locker.unlock();
+            Q_EMIT device->pointerMotion(delta, deltaNonAccel, latestTime, latestTimeUsec, device);
             break;
         }
         case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE: {
-            PointerEvent *pe = static_cast<PointerEvent *>(event.get());
+            PointerEvent *pe = static_cast<PointerEvent *>(event);
             Q_EMIT pe->device()->pointerMotionAbsolute(pe->absolutePos(workspace()->geometry().size()), pe->time(), pe->device());
             break;
         }
         case LIBINPUT_EVENT_TOUCH_DOWN: {
 #ifndef KWIN_BUILD_TESTING
-            TouchEvent *te = static_cast<TouchEvent *>(event.get());
+            TouchEvent *te = static_cast<TouchEvent *>(event);
             const auto *output = te->device()->output();
             const QPointF globalPos = devicePointToGlobalPosition(te->absolutePos(output->modeSize()), output);
             Q_EMIT te->device()->touchDown(te->id(), globalPos, te->time(), te->device());
@@ -339,13 +373,13 @@ void Connection::processEvents()
 #endif
         }
         case LIBINPUT_EVENT_TOUCH_UP: {
-            TouchEvent *te = static_cast<TouchEvent *>(event.get());
+            TouchEvent *te = static_cast<TouchEvent *>(event);
             Q_EMIT te->device()->touchUp(te->id(), te->time(), te->device());
             break;
         }
         case LIBINPUT_EVENT_TOUCH_MOTION: {
 #ifndef KWIN_BUILD_TESTING
-            TouchEvent *te = static_cast<TouchEvent *>(event.get());
+            TouchEvent *te = static_cast<TouchEvent *>(event);
             const auto *output = te->device()->output();
             const QPointF globalPos = devicePointToGlobalPosition(te->absolutePos(output->modeSize()), output);
             Q_EMIT te->device()->touchMotion(te->id(), globalPos, te->time(), te->device());
@@ -361,17 +395,17 @@ void Connection::processEvents()
             break;
         }
         case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN: {
-            PinchGestureEvent *pe = static_cast<PinchGestureEvent *>(event.get());
+            PinchGestureEvent *pe = static_cast<PinchGestureEvent *>(event);
             Q_EMIT pe->device()->pinchGestureBegin(pe->fingerCount(), pe->time(), pe->device());
             break;
         }
         case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE: {
-            PinchGestureEvent *pe = static_cast<PinchGestureEvent *>(event.get());
+            PinchGestureEvent *pe = static_cast<PinchGestureEvent *>(event);
             Q_EMIT pe->device()->pinchGestureUpdate(pe->scale(), pe->angleDelta(), pe->delta(), pe->time(), pe->device());
             break;
         }
         case LIBINPUT_EVENT_GESTURE_PINCH_END: {
-            PinchGestureEvent *pe = static_cast<PinchGestureEvent *>(event.get());
+            PinchGestureEvent *pe = static_cast<PinchGestureEvent *>(event);
             if (pe->isCancelled()) {
                 Q_EMIT pe->device()->pinchGestureCancelled(pe->time(), pe->device());
             } else {
@@ -380,17 +414,17 @@ void Connection::processEvents()
             break;
         }
         case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN: {
-            SwipeGestureEvent *se = static_cast<SwipeGestureEvent *>(event.get());
+            SwipeGestureEvent *se = static_cast<SwipeGestureEvent *>(event);
             Q_EMIT se->device()->swipeGestureBegin(se->fingerCount(), se->time(), se->device());
             break;
         }
         case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE: {
-            SwipeGestureEvent *se = static_cast<SwipeGestureEvent *>(event.get());
+            SwipeGestureEvent *se = static_cast<SwipeGestureEvent *>(event);
             Q_EMIT se->device()->swipeGestureUpdate(se->delta(), se->time(), se->device());
             break;
         }
         case LIBINPUT_EVENT_GESTURE_SWIPE_END: {
-            SwipeGestureEvent *se = static_cast<SwipeGestureEvent *>(event.get());
+            SwipeGestureEvent *se = static_cast<SwipeGestureEvent *>(event);
             if (se->isCancelled()) {
                 Q_EMIT se->device()->swipeGestureCancelled(se->time(), se->device());
             } else {
@@ -399,12 +433,12 @@ void Connection::processEvents()
             break;
         }
         case LIBINPUT_EVENT_GESTURE_HOLD_BEGIN: {
-            HoldGestureEvent *he = static_cast<HoldGestureEvent *>(event.get());
+            HoldGestureEvent *he = static_cast<HoldGestureEvent *>(event);
             Q_EMIT he->device()->holdGestureBegin(he->fingerCount(), he->time(), he->device());
             break;
         }
         case LIBINPUT_EVENT_GESTURE_HOLD_END: {
-            HoldGestureEvent *he = static_cast<HoldGestureEvent *>(event.get());
+            HoldGestureEvent *he = static_cast<HoldGestureEvent *>(event);
             if (he->isCancelled()) {
                 Q_EMIT he->device()->holdGestureCancelled(he->time(), he->device());
             } else {
@@ -413,7 +447,7 @@ void Connection::processEvents()
             break;
         }
         case LIBINPUT_EVENT_SWITCH_TOGGLE: {
-            SwitchEvent *se = static_cast<SwitchEvent *>(event.get());
+            SwitchEvent *se = static_cast<SwitchEvent *>(event);
             switch (se->state()) {
             case SwitchEvent::State::Off:
                 Q_EMIT se->device()->switchToggledOff(se->time(), se->timeMicroseconds(), se->device());
@@ -429,7 +463,7 @@ void Connection::processEvents()
         case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
         case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
         case LIBINPUT_EVENT_TABLET_TOOL_TIP: {
-            auto *tte = static_cast<TabletToolEvent *>(event.get());
+            auto *tte = static_cast<TabletToolEvent *>(event);
 
             KWin::InputRedirection::TabletEventType tabletEventType;
             switch (event->type()) {
@@ -468,21 +502,21 @@ void Connection::processEvents()
             break;
         }
         case LIBINPUT_EVENT_TABLET_TOOL_BUTTON: {
-            auto *tabletEvent = static_cast<TabletToolButtonEvent *>(event.get());
+            auto *tabletEvent = static_cast<TabletToolButtonEvent *>(event);
             Q_EMIT event->device()->tabletToolButtonEvent(tabletEvent->buttonId(),
                                                           tabletEvent->isButtonPressed(),
                                                           createTabletId(tabletEvent->tool(), event->device()->groupUserData()));
             break;
         }
         case LIBINPUT_EVENT_TABLET_PAD_BUTTON: {
-            auto *tabletEvent = static_cast<TabletPadButtonEvent *>(event.get());
+            auto *tabletEvent = static_cast<TabletPadButtonEvent *>(event);
             Q_EMIT event->device()->tabletPadButtonEvent(tabletEvent->buttonId(),
                                                          tabletEvent->isButtonPressed(),
                                                          {event->device()->groupUserData()});
             break;
         }
         case LIBINPUT_EVENT_TABLET_PAD_RING: {
-            auto *tabletEvent = static_cast<TabletPadRingEvent *>(event.get());
+            auto *tabletEvent = static_cast<TabletPadRingEvent *>(event);
             tabletEvent->position();
             Q_EMIT event->device()->tabletPadRingEvent(tabletEvent->number(),
                                                        tabletEvent->position(),
@@ -491,7 +525,7 @@ void Connection::processEvents()
             break;
         }
         case LIBINPUT_EVENT_TABLET_PAD_STRIP: {
-            auto *tabletEvent = static_cast<TabletPadStripEvent *>(event.get());
+            auto *tabletEvent = static_cast<TabletPadStripEvent *>(event);
             Q_EMIT event->device()->tabletPadStripEvent(tabletEvent->number(),
                                                         tabletEvent->position(),
                                                         tabletEvent->source() == LIBINPUT_TABLET_PAD_STRIP_SOURCE_FINGER,
@@ -502,6 +536,12 @@ void Connection::processEvents()
             // nothing
             break;
         }
+        QMutexLocker locker(&m_mutex);
+        m_eventQueue.pop();
+    }
+
+    if (m_eventQueueFull.exchange(false)) {
+        QMetaObject::invokeMethod(this, &Connection::handleEvent, Qt::QueuedConnection);
     }
 }
 
@@ -9,6 +9,8 @@
 #ifndef KWIN_LIBINPUT_CONNECTION_H
 #define KWIN_LIBINPUT_CONNECTION_H
 
+#include "eventqueue.h"
+
 #include <kwinglobals.h>
 
 #include <KSharedConfig>
@@ -19,7 +21,8 @@
 #include <QSize>
 #include <QStringList>
 #include <QVector>
-#include <deque>
+
+#include <atomic>
 
 class QSocketNotifier;
 class QThread;
@@ -76,7 +79,9 @@ private:
     void applyScreenToDevice(Device *device);
     QSocketNotifier *m_notifier;
     QRecursiveMutex m_mutex;
-    std::deque<std::unique_ptr<Event>> m_eventQueue;
+    EventQueue m_eventQueue;
+    std::atomic<bool> m_eventsPending = false;
+    std::atomic<bool> m_eventQueueFull = false;
     QVector<Device *> m_devices;
     KSharedConfigPtr m_config;
     std::unique_ptr<ConnectionAdaptor> m_connectionAdaptor;
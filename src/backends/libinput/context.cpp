@@ -151,9 +151,9 @@ void Context::closeRestricted(int fd)
     m_session->closeRestricted(fd);
 }
 
-std::unique_ptr<Event> Context::event()
+Event *Context::event(EventStorage *storage)
 {
-    return Event::create(libinput_get_event(m_libinput));
+    return Event::create(libinput_get_event(m_libinput), storage);
 }
 
 void Context::suspend()
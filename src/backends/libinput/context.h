@@ -22,6 +22,7 @@ namespace LibInput
 {
 
 class Event;
+struct EventStorage;
 
 class Context
 {
@@ -54,9 +55,10 @@ public:
     }
 
     /**
-     * Gets the next event, if there is no new event @c nullptr is returned
+     * Gets the next event and constructs it in the given @a storage, if there is no new
+     * event @c nullptr is returned
      */
-    std::unique_ptr<Event> event();
+    Event *event(EventStorage *storage);
 
     static int openRestrictedCallback(const char *path, int flags, void *user_data);
     static void closeRestrictedCallBack(int fd, void *user_data);
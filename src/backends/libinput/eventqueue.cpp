@@ -0,0 +1,81 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "eventqueue.h"
+
+#include <QtGlobal>
+
+#include <bit>
+
+namespace KWin
+{
+namespace LibInput
+{
+
+EventQueue::EventQueue(uint capacity)
+    : m_slots(std::make_unique<Slot[]>(std::bit_ceil(std::max(capacity, 2u))))
+    , m_mask(std::bit_ceil(std::max(capacity, 2u)) - 1)
+{
+}
+
+EventQueue::~EventQueue()
+{
+    while (!isEmpty()) {
+        pop();
+    }
+}
+
+uint EventQueue::capacity() const
+{
+    return m_mask + 1;
+}
+
+bool EventQueue::isEmpty() const
+{
+    return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_relaxed);
+}
+
+EventStorage *EventQueue::reserve()
+{
+    const uint head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) > m_mask) {
+        return nullptr;
+    }
+    return &m_slots[head & m_mask].storage;
+}
+
+void EventQueue::commit(Event *event)
+{
+    const uint head = m_head.load(std::memory_order_relaxed);
+    Slot &slot = m_slots[head & m_mask];
+    Q_ASSERT(static_cast<void *>(event) == static_cast<void *>(slot.storage.data));
+    slot.event = event;
+    m_head.store(head + 1, std::memory_order_release);
+}
+
+Event *EventQueue::peek(uint offset) const
+{
+    const uint tail = m_tail.load(std::memory_order_relaxed);
+    if (m_head.load(std::memory_order_acquire) - tail <= offset) {
+        return nullptr;
+    }
+    return m_slots[(tail + offset) & m_mask].event;
+}
+
+void EventQueue::pop()
+{
+    const uint tail = m_tail.load(std::memory_order_relaxed);
+    Q_ASSERT(m_head.load(std::memory_order_acquire) != tail);
+    Slot &slot = m_slots[tail & m_mask];
+    slot.event->~Event();
+    slot.event = nullptr;
+    m_tail.store(tail + 1, std::memory_order_release);
+}
+
+} // namespace LibInput
+} // namespace KWin
@@ -0,0 +1,84 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "events.h"
+
+#include <kwinglobals.h>
+
+#include <atomic>
+#include <memory>
+
+namespace KWin
+{
+namespace LibInput
+{
+
+/**
+ * The EventQueue class is a bounded single-producer single-consumer queue of libinput events.
+ *
+ * The events are constructed in preallocated slots, so passing an event from the thread that
+ * reads libinput to the main thread involves neither heap allocations nor locking.
+ *
+ * Only one thread may call reserve() and commit(), and only one thread may call peek() and pop().
+ */
+class KWIN_EXPORT EventQueue
+{
+public:
+    /**
+     * Constructs an EventQueue that can hold up to @a capacity events. The capacity is
+     * rounded up to the next power of two.
+     */
+    explicit EventQueue(uint capacity = 1024);
+    ~EventQueue();
+
+    uint capacity() const;
+    bool isEmpty() const;
+
+    /**
+     * Returns the storage in which the next event has to be constructed, or @c nullptr
+     * if the queue is full.
+     */
+    EventStorage *reserve();
+
+    /**
+     * Makes the @a event that has been constructed in the storage returned by reserve()
+     * visible to the consumer.
+     */
+    void commit(Event *event);
+
+    /**
+     * Returns the event at the given @a offset from the front of the queue, or @c nullptr
+     * if the queue contains fewer events.
+     */
+    Event *peek(uint offset = 0) const;
+
+    /**
+     * Destroys the event at the front of the queue and releases its slot.
+     *
+     * Destroying an event calls into libinput, so the caller must hold the lock that
+     * serializes access to the libinput context.
+     */
+    void pop();
+
+private:
+    struct Slot
+    {
+        EventStorage storage;
+        Event *event = nullptr;
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    uint m_mask;
+    alignas(64) std::atomic<uint> m_head = 0;
+    alignas(64) std::atomic<uint> m_tail = 0;
+};
+
+} // namespace LibInput
+} // namespace KWin
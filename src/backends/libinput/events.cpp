@@ -11,63 +11,87 @@
 
 #include <QSize>
 
+#include <new>
+#include <type_traits>
+
 namespace KWin
 {
 namespace LibInput
 {
 
-std::unique_ptr<Event> Event::create(libinput_event *event)
+template<typename Construct>
+static auto constructEvent(libinput_event *event, Construct construct)
 {
-    if (!event) {
-        return nullptr;
-    }
     const auto t = libinput_event_get_type(event);
     // TODO: add touch events
     // TODO: add device notify events
     switch (t) {
     case LIBINPUT_EVENT_KEYBOARD_KEY:
-        return std::make_unique<KeyEvent>(event);
+        return construct(std::type_identity<KeyEvent>(), event, t);
     case LIBINPUT_EVENT_POINTER_AXIS:
     case LIBINPUT_EVENT_POINTER_BUTTON:
     case LIBINPUT_EVENT_POINTER_MOTION:
     case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
-        return std::make_unique<PointerEvent>(event, t);
+        return construct(std::type_identity<PointerEvent>(), event, t);
     case LIBINPUT_EVENT_TOUCH_DOWN:
     case LIBINPUT_EVENT_TOUCH_UP:
     case LIBINPUT_EVENT_TOUCH_MOTION:
     case LIBINPUT_EVENT_TOUCH_CANCEL:
     case LIBINPUT_EVENT_TOUCH_FRAME:
-        return std::make_unique<TouchEvent>(event, t);
+        return construct(std::type_identity<TouchEvent>(), event, t);
     case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
     case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
     case LIBINPUT_EVENT_GESTURE_SWIPE_END:
-        return std::make_unique<SwipeGestureEvent>(event, t);
+        return construct(std::type_identity<SwipeGestureEvent>(), event, t);
     case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
     case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
     case LIBINPUT_EVENT_GESTURE_PINCH_END:
-        return std::make_unique<PinchGestureEvent>(event, t);
+        return construct(std::type_identity<PinchGestureEvent>(), event, t);
     case LIBINPUT_EVENT_GESTURE_HOLD_BEGIN:
     case LIBINPUT_EVENT_GESTURE_HOLD_END:
-        return std::make_unique<HoldGestureEvent>(event, t);
+        return construct(std::type_identity<HoldGestureEvent>(), event, t);
     case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
     case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
     case LIBINPUT_EVENT_TABLET_TOOL_TIP:
-        return std::make_unique<TabletToolEvent>(event, t);
+        return construct(std::type_identity<TabletToolEvent>(), event, t);
     case LIBINPUT_EVENT_TABLET_TOOL_BUTTON:
-        return std::make_unique<TabletToolButtonEvent>(event, t);
+        return construct(std::type_identity<TabletToolButtonEvent>(), event, t);
     case LIBINPUT_EVENT_TABLET_PAD_RING:
-        return std::make_unique<TabletPadRingEvent>(event, t);
+        return construct(std::type_identity<TabletPadRingEvent>(), event, t);
     case LIBINPUT_EVENT_TABLET_PAD_STRIP:
-        return std::make_unique<TabletPadStripEvent>(event, t);
+        return construct(std::type_identity<TabletPadStripEvent>(), event, t);
     case LIBINPUT_EVENT_TABLET_PAD_BUTTON:
-        return std::make_unique<TabletPadButtonEvent>(event, t);
+        return construct(std::type_identity<TabletPadButtonEvent>(), event, t);
     case LIBINPUT_EVENT_SWITCH_TOGGLE:
-        return std::make_unique<SwitchEvent>(event, t);
+        return construct(std::type_identity<SwitchEvent>(), event, t);
     default:
-        return std::unique_ptr<Event>{new Event(event, t)};
+        return construct(std::type_identity<Event>(), event, t);
     }
 }
 
+std::unique_ptr<Event> Event::create(libinput_event *event)
+{
+    if (!event) {
+        return nullptr;
+    }
+    return constructEvent(event, [](auto tag, libinput_event *event, libinput_event_type type) {
+        using T = typename decltype(tag)::type;
+        return std::unique_ptr<Event>(new T(event, type));
+    });
+}
+
+Event *Event::create(libinput_event *event, EventStorage *storage)
+{
+    if (!event) {
+        return nullptr;
+    }
+    return constructEvent(event, [storage](auto tag, libinput_event *event, libinput_event_type type) -> Event * {
+        using T = typename decltype(tag)::type;
+        static_assert(sizeof(T) <= sizeof(EventStorage::data));
+        return new (storage->data) T(event, type);
+    });
+}
+
 Event::Event(libinput_event *event, libinput_event_type type)
     : m_event(event)
     , m_type(type)
@@ -96,8 +120,8 @@ libinput_device *Event::nativeDevice() const
     return libinput_event_get_device(m_event);
 }
 
-KeyEvent::KeyEvent(libinput_event *event)
-    : Event(event, LIBINPUT_EVENT_KEYBOARD_KEY)
+KeyEvent::KeyEvent(libinput_event *event, libinput_event_type type)
+    : Event(event, type)
     , m_keyboardEvent(libinput_event_get_keyboard_event(event))
 {
 }
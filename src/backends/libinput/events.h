@@ -13,12 +13,16 @@
 
 #include <libinput.h>
 
+#include <algorithm>
+#include <cstddef>
+
 namespace KWin
 {
 namespace LibInput
 {
 
 class Device;
+struct EventStorage;
 
 class Event
 {
@@ -40,6 +44,12 @@ public:
 
     static std::unique_ptr<Event> create(libinput_event *event);
 
+    /**
+     * Constructs the Event for the given native @a event in the preallocated @a storage
+     * rather than on the heap. The returned Event must be destroyed by calling its destructor.
+     */
+    static Event *create(libinput_event *event, EventStorage *storage);
+
 protected:
     Event(libinput_event *event, libinput_event_type type);
 
@@ -52,7 +62,7 @@ private:
 class KeyEvent : public Event
 {
 public:
-    KeyEvent(libinput_event *event);
+    KeyEvent(libinput_event *event, libinput_event_type type);
     ~KeyEvent() override;
 
     uint32_t key() const;
@@ -406,6 +416,26 @@ private:
     libinput_event_tablet_pad *m_tabletPadEvent;
 };
 
+/**
+ * The EventStorage struct provides memory that is large enough to hold any Event.
+ */
+struct EventStorage
+{
+    alignas(std::max_align_t) std::byte data[std::max({sizeof(Event),
+                                                       sizeof(KeyEvent),
+                                                       sizeof(PointerEvent),
+                                                       sizeof(TouchEvent),
+                                                       sizeof(SwipeGestureEvent),
+                                                       sizeof(PinchGestureEvent),
+                                                       sizeof(HoldGestureEvent),
+                                                       sizeof(SwitchEvent),
+                                                       sizeof(TabletToolEvent),
+                                                       sizeof(TabletToolButtonEvent),
+                                                       sizeof(TabletPadRingEvent),
+                                                       sizeof(TabletPadStripEvent),
+                                                       sizeof(TabletPadButtonEvent)})];
+};
+
 inline libinput_event_type Event::type() const
 {
     return m_type;
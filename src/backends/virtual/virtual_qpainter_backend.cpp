@@ -18,23 +18,27 @@ namespace KWin
 
 VirtualQPainterLayer::VirtualQPainterLayer(Output *output)
     : m_output(output)
-    , m_image(output->pixelSize(), QImage::Format_RGB32)
 {
-    m_image.fill(Qt::black);
 }
 
 std::optional<OutputLayerBeginFrameInfo> VirtualQPainterLayer::beginFrame()
 {
+    if (m_image.size() != m_output->pixelSize()) {
+        m_image = QImage(m_output->pixelSize(), QImage::Format_RGB32);
+        m_image.fill(Qt::black);
+        m_bufferAge = 0;
+    }
     return OutputLayerBeginFrameInfo{
         .renderTarget = RenderTarget(&m_image),
-        .repaint = m_output->rect(),
+        .repaint = m_damageJournal.accumulate(m_bufferAge, infiniteRegion()),
     };
 }
 
 bool VirtualQPainterLayer::endFrame(const QRegion &renderedRegion, const QRegion &damagedRegion)
 {
     Q_UNUSED(renderedRegion)
-    Q_UNUSED(damagedRegion)
+    m_damageJournal.add(damagedRegion);
+    m_bufferAge = 1;
     return true;
 }
 
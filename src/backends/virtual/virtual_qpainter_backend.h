@@ -10,6 +10,7 @@
 
 #include "outputlayer.h"
 #include "qpainterbackend.h"
+#include "utils/damagejournal.h"
 
 #include <QMap>
 #include <QObject>
@@ -33,6 +34,8 @@ public:
 private:
     Output *const m_output;
     QImage m_image;
+    DamageJournal m_damageJournal;
+    int m_bufferAge = 0;
 };
 
 class VirtualQPainterBackend : public QPainterBackend
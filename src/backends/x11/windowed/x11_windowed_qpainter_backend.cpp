@@ -27,6 +27,7 @@ void X11WindowedQPainterOutput::ensureBuffer()
     if (buffer.size() != nativeSize) {
         buffer = QImage(nativeSize, QImage::Format_RGB32);
         buffer.fill(Qt::black);
+        m_bufferAge = 0;
     }
 }
 
@@ -34,7 +35,7 @@ std::optional<OutputLayerBeginFrameInfo> X11WindowedQPainterOutput::beginFrame()
 {
     ensureBuffer();
 
-    QRegion repaint = m_output->exposedArea() + m_output->rect();
+    QRegion repaint = m_output->exposedArea() + m_damageJournal.accumulate(m_bufferAge, infiniteRegion());
     m_output->clearExposedArea();
 
     return OutputLayerBeginFrameInfo{
@@ -46,7 +47,8 @@ std::optional<OutputLayerBeginFrameInfo> X11WindowedQPainterOutput::beginFrame()
 bool X11WindowedQPainterOutput::endFrame(const QRegion &renderedRegion, const QRegion &damagedRegion)
 {
     Q_UNUSED(renderedRegion)
-    Q_UNUSED(damagedRegion)
+    m_damageJournal.add(damagedRegion);
+    m_bufferAge = 1;
     return true;
 }
 
@@ -10,6 +10,7 @@
 
 #include "outputlayer.h"
 #include "qpainterbackend.h"
+#include "utils/damagejournal.h"
 
 #include <QImage>
 #include <QObject>
@@ -38,6 +39,8 @@ public:
     xcb_window_t window;
     QImage buffer;
     X11WindowedOutput *const m_output;
+    DamageJournal m_damageJournal;
+    int m_bufferAge = 0;
 };
 
 class X11WindowedQPainterBackend : public QPainterBackend
@@ -16,6 +16,9 @@
 
 #include <lcms2.h>
 
+#include <algorithm>
+#include <map>
+
 namespace KWin
 {
 
@@ -34,15 +37,15 @@ class ColorDevicePrivate
 {
 public:
     enum DirtyToneCurveBit {
-        DirtyTemperatureToneCurve = 0x1,
         DirtyBrightnessToneCurve = 0x2,
         DirtyCalibrationToneCurve = 0x4,
     };
     Q_DECLARE_FLAGS(DirtyToneCurves, DirtyToneCurveBit)
 
     void rebuildPipeline();
+    std::shared_ptr<ColorTransformation> endpointTransformation(uint temperature);
 
-    void updateTemperatureToneCurves();
+    std::unique_ptr<ColorPipelineStage> createTemperatureStage(uint temperature) const;
     void updateBrightnessToneCurves();
     void updateCalibrationToneCurves();
 
@@ -53,53 +56,96 @@ public:
     uint brightness = 100;
     uint temperature = 6500;
 
-    std::unique_ptr<ColorPipelineStage> temperatureStage;
     std::unique_ptr<ColorPipelineStage> brightnessStage;
     std::unique_ptr<ColorPipelineStage> calibrationStage;
 
+    // The transformations for multiples of 100K, the temperatures in between are blended
+    // from them. They're kept around so the lookup tables are computed only once during
+    // a night color transition.
+    std::map<uint, std::shared_ptr<ColorTransformation>> endpoints;
+
     std::shared_ptr<ColorTransformation> transformation;
 };
 
+static const uint s_temperatureStep = 100;
+static const size_t s_maxEndpointCount = 4;
+
 void ColorDevicePrivate::rebuildPipeline()
 {
+    if (dirtyCurves & (DirtyCalibrationToneCurve | DirtyBrightnessToneCurve)) {
+        endpoints.clear();
+    }
     if (dirtyCurves & DirtyCalibrationToneCurve) {
         updateCalibrationToneCurves();
     }
     if (dirtyCurves & DirtyBrightnessToneCurve) {
         updateBrightnessToneCurves();
     }
-    if (dirtyCurves & DirtyTemperatureToneCurve) {
-        updateTemperatureToneCurves();
-    }
     dirtyCurves = DirtyToneCurves();
 
+    // The temperature tone curves scale the channels by a white point that is linearly
+    // interpolated between the steps of the black body table, so blending the endpoints
+    // gives the same result as evaluating the curves for the exact temperature.
+    const uint lower = temperature - temperature % s_temperatureStep;
+    const qreal blendFactor = (temperature % s_temperatureStep) / qreal(s_temperatureStep);
+
+    const auto from = endpointTransformation(lower);
+    if (!from) {
+        return;
+    }
+    if (!blendFactor) {
+        transformation = from;
+        return;
+    }
+    const auto to = endpointTransformation(lower + s_temperatureStep);
+    if (!to) {
+        return;
+    }
+    transformation = std::make_shared<ColorTransformation>(from, to, blendFactor);
+}
+
+std::shared_ptr<ColorTransformation> ColorDevicePrivate::endpointTransformation(uint temperature)
+{
+    if (auto it = endpoints.find(temperature); it != endpoints.end()) {
+        return it->second;
+    }
+
     std::vector<std::unique_ptr<ColorPipelineStage>> stages;
     if (calibrationStage) {
         if (auto s = calibrationStage->dup()) {
             stages.push_back(std::move(s));
         } else {
-            return;
+            return nullptr;
         }
     }
     if (brightnessStage) {
         if (auto s = brightnessStage->dup()) {
             stages.push_back(std::move(s));
         } else {
-            return;
+            return nullptr;
         }
     }
-    if (temperatureStage) {
-        if (auto s = temperatureStage->dup()) {
-            stages.push_back(std::move(s));
-        } else {
-            return;
-        }
+    if (auto temperatureStage = createTemperatureStage(temperature)) {
+        stages.push_back(std::move(temperatureStage));
     }
 
     const auto tmp = std::make_shared<ColorTransformation>(std::move(stages));
-    if (tmp->valid()) {
-        transformation = tmp;
+    if (!tmp->valid()) {
+        return nullptr;
+    }
+
+    // Drop the endpoints that are farthest away from the current temperature.
+    while (endpoints.size() >= s_maxEndpointCount) {
+        const auto distance = [this](uint endpoint) {
+            return std::abs(int(endpoint) - int(this->temperature));
+        };
+        auto farthest = std::max_element(endpoints.begin(), endpoints.end(), [&distance](const auto &a, const auto &b) {
+            return distance(a.first) < distance(b.first);
+        });
+        endpoints.erase(farthest);
     }
+    endpoints[temperature] = tmp;
+    return tmp;
 }
 
 static qreal interpolate(qreal a, qreal b, qreal blendFactor)
@@ -112,12 +158,10 @@ QString ColorDevice::profile() const
     return d->profile;
 }
 
-void ColorDevicePrivate::updateTemperatureToneCurves()
+std::unique_ptr<ColorPipelineStage> ColorDevicePrivate::createTemperatureStage(uint temperature) const
 {
-    temperatureStage.reset();
-
     if (temperature == 6500) {
-        return;
+        return nullptr;
     }
 
     // Note that cmsWhitePointFromTemp() returns a slightly green-ish white point.
@@ -141,26 +185,27 @@ void ColorDevicePrivate::updateTemperatureToneCurves()
     UniqueToneCurvePtr redCurve(cmsBuildParametricToneCurve(nullptr, 2, redCurveParams));
     if (!redCurve) {
         qCWarning(KWIN_CORE) << "Failed to build the temperature tone curve for the red channel";
-        return;
+        return nullptr;
     }
     UniqueToneCurvePtr greenCurve(cmsBuildParametricToneCurve(nullptr, 2, greenCurveParams));
     if (!greenCurve) {
         qCWarning(KWIN_CORE) << "Failed to build the temperature tone curve for the green channel";
-        return;
+        return nullptr;
     }
     UniqueToneCurvePtr blueCurve(cmsBuildParametricToneCurve(nullptr, 2, blueCurveParams));
     if (!blueCurve) {
         qCWarning(KWIN_CORE) << "Failed to build the temperature tone curve for the blue channel";
-        return;
+        return nullptr;
     }
 
     // The ownership of the tone curves will be moved to the pipeline stage.
     cmsToneCurve *toneCurves[] = {redCurve.release(), greenCurve.release(), blueCurve.release()};
 
-    temperatureStage = std::make_unique<ColorPipelineStage>(cmsStageAllocToneCurves(nullptr, 3, toneCurves));
+    auto temperatureStage = std::make_unique<ColorPipelineStage>(cmsStageAllocToneCurves(nullptr, 3, toneCurves));
     if (!temperatureStage) {
         qCWarning(KWIN_CORE) << "Failed to create the color temperature pipeline stage";
     }
+    return temperatureStage;
 }
 
 void ColorDevicePrivate::updateBrightnessToneCurves()
@@ -286,7 +331,6 @@ void ColorDevice::setTemperature(uint temperature)
         return;
     }
     d->temperature = temperature;
-    d->dirtyCurves |= ColorDevicePrivate::DirtyTemperatureToneCurve;
     scheduleUpdate();
     Q_EMIT temperatureChanged();
 }
@@ -14,28 +14,24 @@ namespace KWin
 {
 
 ColorLUT::ColorLUT(const std::shared_ptr<ColorTransformation> &transformation, size_t size)
-    : m_transformation(transformation)
+    : m_data(transformation->lut(size))
+    , m_transformation(transformation)
 {
-    m_data.fill(0, 3 * size);
-    for (uint64_t i = 0; i < size; i++) {
-        const uint16_t index = (i * 0xFFFF) / size;
-        std::tie(m_data[i], m_data[size + i], m_data[size * 2 + i]) = transformation->transform(index, index, index);
-    }
 }
 
-uint16_t *ColorLUT::red() const
+const uint16_t *ColorLUT::red() const
 {
-    return const_cast<uint16_t *>(m_data.constData());
+    return m_data.constData();
 }
 
-uint16_t *ColorLUT::green() const
+const uint16_t *ColorLUT::green() const
 {
-    return const_cast<uint16_t *>(m_data.constData() + size());
+    return m_data.constData() + size();
 }
 
-uint16_t *ColorLUT::blue() const
+const uint16_t *ColorLUT::blue() const
 {
-    return const_cast<uint16_t *>(m_data.constData() + 2 * size());
+    return m_data.constData() + 2 * size();
 }
 
 size_t ColorLUT::size() const
@@ -23,9 +23,9 @@ class KWIN_EXPORT ColorLUT
 public:
     ColorLUT(const std::shared_ptr<ColorTransformation> &transformation, size_t size);
 
-    uint16_t *red() const;
-    uint16_t *green() const;
-    uint16_t *blue() const;
+    const uint16_t *red() const;
+    const uint16_t *green() const;
+    const uint16_t *blue() const;
     size_t size() const;
     std::shared_ptr<ColorTransformation> transformation() const;
 
@@ -10,6 +10,9 @@
 
 #include <lcms2.h>
 
+#include <algorithm>
+#include <cmath>
+
 #include "colorpipelinestage.h"
 #include "utils/common.h"
 
@@ -34,6 +37,18 @@ ColorTransformation::ColorTransformation(std::vector<std::unique_ptr<ColorPipeli
     }
 }
 
+// The number of distinct blend factors, finer steps wouldn't make a visible difference.
+static const uint32_t s_blendSteps = 1024;
+
+ColorTransformation::ColorTransformation(const std::shared_ptr<ColorTransformation> &from, const std::shared_ptr<ColorTransformation> &to, qreal factor)
+    : m_pipeline(nullptr)
+    , m_from(from)
+    , m_to(to)
+    , m_factor(std::round(std::clamp(factor, 0.0, 1.0) * s_blendSteps) * (65536 / s_blendSteps))
+{
+    m_valid = m_from && m_from->valid() && m_to && m_to->valid();
+}
+
 ColorTransformation::~ColorTransformation()
 {
     if (m_pipeline) {
@@ -50,12 +65,63 @@ bool ColorTransformation::valid() const
     return m_valid;
 }
 
+bool ColorTransformation::isEquivalent(const ColorTransformation &other) const
+{
+    if (this == &other) {
+        return true;
+    }
+    if (m_pipeline || other.m_pipeline) {
+        return false;
+    }
+    return m_from == other.m_from && m_to == other.m_to && m_factor == other.m_factor;
+}
+
+static uint16_t blend(uint16_t from, uint16_t to, uint32_t factor)
+{
+    return (uint32_t(from) * (65536 - factor) + uint32_t(to) * factor + 32768) >> 16;
+}
+
 std::tuple<uint16_t, uint16_t, uint16_t> ColorTransformation::transform(uint16_t r, uint16_t g, uint16_t b) const
 {
+    if (!m_pipeline) {
+        const auto [fromR, fromG, fromB] = m_from->transform(r, g, b);
+        const auto [toR, toG, toB] = m_to->transform(r, g, b);
+        return {blend(fromR, toR, m_factor), blend(fromG, toG, m_factor), blend(fromB, toB, m_factor)};
+    }
     const uint16_t in[3] = {r, g, b};
     uint16_t out[3] = {0, 0, 0};
     cmsPipelineEval16(in, out, m_pipeline);
     return {out[0], out[1], out[2]};
 }
 
+QVector<uint16_t> ColorTransformation::lut(size_t size) const
+{
+    auto it = m_luts.find(size);
+    if (it != m_luts.end()) {
+        return it->second;
+    }
+
+    QVector<uint16_t> data(3 * size);
+    if (!m_pipeline) {
+        // Blending the tables of the two transformations is exact as long as the outputs are
+        // linear in the blended parameter, which is the case for the color temperature.
+        const QVector<uint16_t> from = m_from->lut(size);
+        const QVector<uint16_t> to = m_to->lut(size);
+        const uint16_t *fromData = from.constData();
+        const uint16_t *toData = to.constData();
+        uint16_t *out = data.data();
+        for (size_t i = 0; i < 3 * size; i++) {
+            out[i] = blend(fromData[i], toData[i], m_factor);
+        }
+    } else {
+        for (uint64_t i = 0; i < size; i++) {
+            const uint16_t index = (i * 0xFFFF) / size;
+            std::tie(data[i], data[size + i], data[size * 2 + i]) = transform(index, index, index);
+        }
+    }
+
+    m_luts[size] = data;
+    return data;
+}
+
 }
@@ -9,6 +9,7 @@
 #pragma once
 
 #include <QVector>
+#include <map>
 #include <memory>
 #include <stdint.h>
 #include <tuple>
@@ -26,15 +27,37 @@ class KWIN_EXPORT ColorTransformation
 {
 public:
     ColorTransformation(std::vector<std::unique_ptr<ColorPipelineStage>> &&stages);
+    /**
+     * Creates a transformation that blends the results of @p from and @p to, @p factor
+     * is the weight of @p to. This is much cheaper than evaluating another pipeline if
+     * both transformations have already been evaluated. The factor is rounded to 1/1024.
+     */
+    ColorTransformation(const std::shared_ptr<ColorTransformation> &from, const std::shared_ptr<ColorTransformation> &to, qreal factor);
     ~ColorTransformation();
 
     bool valid() const;
 
     std::tuple<uint16_t, uint16_t, uint16_t> transform(uint16_t r, uint16_t g, uint16_t b) const;
 
+    /**
+     * Returns @c true if this transformation gives the same results as @p other, which is
+     * also the case for different blended transformations of the same endpoints and factor.
+     */
+    bool isEquivalent(const ColorTransformation &other) const;
+
+    /**
+     * Returns the lookup table with @p size entries per channel, the red entries are followed
+     * by the green and the blue entries. The table is computed only once for every size.
+     */
+    QVector<uint16_t> lut(size_t size) const;
+
 private:
     cmsPipeline *const m_pipeline;
     const std::vector<std::unique_ptr<ColorPipelineStage>> m_stages;
+    const std::shared_ptr<ColorTransformation> m_from;
+    const std::shared_ptr<ColorTransformation> m_to;
+    const uint32_t m_factor = 0; // the weight of m_to, in 1/65536 units
+    mutable std::map<size_t, QVector<uint16_t>> m_luts;
     bool m_valid = true;
 };
 
@@ -622,12 +622,21 @@ void Compositor::composite(RenderLoop *renderLoop)
     OutputLayer *outputLayer = m_backend->primaryLayer(output);
     fTraceDuration("Paint (", output->name(), ")");
 
+    CompositeTimings timings;
+    auto phaseStart = std::chrono::steady_clock::now();
+    const auto finishPhase = [&phaseStart](std::chrono::nanoseconds *phase) {
+        const auto now = std::chrono::steady_clock::now();
+        *phase += now - phaseStart;
+        phaseStart = now;
+    };
+
     RenderLayer *superLayer = m_superlayers[renderLoop];
     prePaintPass(superLayer);
     superLayer->setOutputLayer(outputLayer);
 
     SurfaceItem *scanoutCandidate = superLayer->delegate()->scanoutCandidate();
     renderLoop->setFullscreenSurface(scanoutCandidate);
+    finishPhase(&timings.prePaint);
 
     renderLoop->beginFrame();
     bool directScanout = false;
@@ -644,7 +653,9 @@ void Compositor::composite(RenderLoop *renderLoop)
     if (!directScanout) {
         QRegion surfaceDamage = outputLayer->repaints();
         outputLayer->resetRepaints();
-        preparePaintPass(superLayer, &surfaceDamage);
+        QRegion occlusion;
+        preparePaintPass(superLayer, &surfaceDamage, &occlusion);
+        finishPhase(&timings.preparePaint);
 
         if (auto beginInfo = outputLayer->beginFrame()) {
             auto &[renderTarget, repaint] = beginInfo.value();
@@ -660,8 +671,10 @@ void Compositor::composite(RenderLoop *renderLoop)
     renderLoop->endFrame();
 
     postPaintPass(superLayer);
+    finishPhase(&timings.paint);
 
     m_backend->present(output);
+    finishPhase(&timings.present);
 
     // TODO: Put it inside the cursor layer once the cursor layer can be backed by a real output layer.
     if (waylandServer()) {
@@ -675,6 +688,8 @@ void Compositor::composite(RenderLoop *renderLoop)
             }
         }
     }
+
+    Q_EMIT frameComposited(output, timings);
 }
 
 void Compositor::prePaintPass(RenderLayer *layer)
@@ -695,17 +710,24 @@ void Compositor::postPaintPass(RenderLayer *layer)
     }
 }
 
-void Compositor::preparePaintPass(RenderLayer *layer, QRegion *repaint)
+void Compositor::preparePaintPass(RenderLayer *layer, QRegion *repaint, QRegion *occlusion)
 {
-    // TODO: Cull opaque region.
-    *repaint += layer->mapToGlobal(layer->repaints() + layer->delegate()->repaints());
-    layer->resetRepaints();
+    // Sublayers are stacked above their superlayer, so visit them from top to bottom and
+    // drop the damage that is hidden behind opaque layers.
     const auto sublayers = layer->sublayers();
-    for (RenderLayer *sublayer : sublayers) {
-        if (sublayer->isVisible()) {
-            preparePaintPass(sublayer, repaint);
+    for (auto it = sublayers.crbegin(); it != sublayers.crend(); ++it) {
+        if ((*it)->isVisible()) {
+            preparePaintPass(*it, repaint, occlusion);
         }
     }
+
+    *repaint += layer->mapToGlobal(layer->repaints() + layer->delegate()->repaints()) - *occlusion;
+    layer->resetRepaints();
+
+    const QRegion opaque = layer->delegate()->opaque() & layer->rect();
+    if (!opaque.isEmpty()) {
+        *occlusion += layer->mapToGlobal(opaque);
+    }
 }
 
 void Compositor::paintPass(RenderLayer *layer, RenderTarget *target, const QRegion &region)
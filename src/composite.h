@@ -14,6 +14,7 @@
 #include <QObject>
 #include <QRegion>
 #include <QTimer>
+#include <chrono>
 #include <memory>
 
 namespace KWin
@@ -31,6 +32,18 @@ class Window;
 class X11Window;
 class X11SyncManager;
 
+/**
+ * The CompositeTimings struct describes how much time has been spent in each phase
+ * of a single compositing cycle.
+ */
+struct CompositeTimings
+{
+    std::chrono::nanoseconds prePaint = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds preparePaint = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds paint = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds present = std::chrono::nanoseconds::zero();
+};
+
 class KWIN_EXPORT Compositor : public QObject
 {
     Q_OBJECT
@@ -97,6 +110,11 @@ Q_SIGNALS:
     void aboutToDestroy();
     void aboutToToggleCompositing();
     void sceneCreated();
+    /**
+     * This signal is emitted when a compositing cycle for the given @a output has been
+     * completed. The @a timings describe how much time each phase of the cycle took.
+     */
+    void frameComposited(Output *output, const CompositeTimings &timings);
 
 protected:
     explicit Compositor(QObject *parent = nullptr);
@@ -145,7 +163,7 @@ private:
 
     void prePaintPass(RenderLayer *layer);
     void postPaintPass(RenderLayer *layer);
-    void preparePaintPass(RenderLayer *layer, QRegion *repaint);
+    void preparePaintPass(RenderLayer *layer, QRegion *repaint, QRegion *occlusion);
     void paintPass(RenderLayer *layer, RenderTarget *target, const QRegion &region);
 
     State m_state = State::Off;
@@ -260,3 +278,5 @@ private:
 };
 
 }
+
+Q_DECLARE_METATYPE(KWin::CompositeTimings)
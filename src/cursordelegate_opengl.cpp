@@ -23,6 +23,15 @@ CursorDelegateOpenGL::~CursorDelegateOpenGL()
 {
 }
 
+QRegion CursorDelegateOpenGL::opaque() const
+{
+    const QImage image = Cursors::self()->currentCursor()->image();
+    if (image.isNull() || image.hasAlphaChannel()) {
+        return QRegion();
+    }
+    return layer()->rect();
+}
+
 void CursorDelegateOpenGL::paint(RenderTarget *renderTarget, const QRegion &region)
 {
     if (!region.intersects(layer()->mapToGlobal(layer()->rect()))) {
@@ -19,6 +19,15 @@ CursorDelegateQPainter::CursorDelegateQPainter(QObject *parent)
 {
 }
 
+QRegion CursorDelegateQPainter::opaque() const
+{
+    const QImage image = Cursors::self()->currentCursor()->image();
+    if (image.isNull() || image.hasAlphaChannel()) {
+        return QRegion();
+    }
+    return layer()->rect();
+}
+
 void CursorDelegateQPainter::paint(RenderTarget *renderTarget, const QRegion &region)
 {
     if (!region.intersects(layer()->mapToGlobal(layer()->rect()))) {
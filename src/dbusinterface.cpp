@@ -24,6 +24,7 @@
 #include "platform.h"
 #include "pluginmanager.h"
 #include "renderbackend.h"
+#include "renderloop.h"
 #include "unmanaged.h"
 #include "virtualdesktops.h"
 #include "window.h"
@@ -35,6 +36,8 @@
 // Qt
 #include <QOpenGLContext>
 
+#include <numeric>
+
 namespace KWin
 {
 
@@ -351,6 +354,31 @@ void CompositorDBusInterface::reinitialize()
     m_compositor->reinitialize();
 }
 
+QVariantMap CompositorDBusInterface::wakeupJitter() const
+{
+    const auto toMicroseconds = [](std::chrono::nanoseconds duration) {
+        return std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(duration).count();
+    };
+
+    QVariantMap jitter;
+    const auto outputs = workspace()->outputs();
+    for (Output *output : outputs) {
+        QVector<std::chrono::nanoseconds> latencies = output->renderLoop()->wakeupLatencies();
+        QVariantMap statistics;
+        statistics[QStringLiteral("samples")] = latencies.count();
+        if (!latencies.isEmpty()) {
+            statistics[QStringLiteral("last")] = toMicroseconds(latencies.constLast());
+            const auto total = std::accumulate(latencies.cbegin(), latencies.cend(), std::chrono::nanoseconds::zero());
+            statistics[QStringLiteral("average")] = toMicroseconds(total / latencies.count());
+            std::sort(latencies.begin(), latencies.end());
+            statistics[QStringLiteral("p99")] = toMicroseconds(latencies[(latencies.count() - 1) * 99 / 100]);
+            statistics[QStringLiteral("max")] = toMicroseconds(latencies.constLast());
+        }
+        jitter[output->name()] = statistics;
+    }
+    return jitter;
+}
+
 QStringList CompositorDBusInterface::supportedOpenGLPlatformInterfaces() const
 {
     QStringList interfaces;
@@ -201,6 +201,15 @@ public Q_SLOTS:
      */
     void reinitialize();
 
+    /**
+     * @brief Returns how late the recent compositing cycles have been started, per output.
+     *
+     * The map is keyed by the output name. Each value is a map with the number of measured
+     * cycles ("samples") and the last, average, 99th percentile and maximum wakeup latency
+     * in microseconds ("last", "average", "p99", "max").
+     */
+    QVariantMap wakeupJitter() const;
+
 Q_SIGNALS:
     void compositingToggled(bool active);
 
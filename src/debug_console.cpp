@@ -7,7 +7,10 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 #include "debug_console.h"
+#include "abstract_egl_backend.h"
 #include "composite.h"
+#include "effects.h"
+#include "egl_dmabuf.h"
 #include "input_event.h"
 #include "inputdevice.h"
 #include "internalwindow.h"
@@ -624,10 +627,16 @@ DebugConsole::DebugConsole()
             m_inputFilter.reset(new DebugConsoleFilter(m_ui->inputTextEdit));
             input()->installInputEventSpy(m_inputFilter.get());
         }
+        if (index == 4) {
+            updateDmabufCacheStatistics();
+        }
         if (index == 5) {
             updateKeyboardTab();
             connect(input(), &InputRedirection::keyStateChanged, this, &DebugConsole::updateKeyboardTab);
         }
+        // only refresh the effect costs while they are shown
+        auto proxyEffectsModel = static_cast<QSortFilterProxyModel *>(m_ui->effectsView->model());
+        static_cast<EffectProfileModel *>(proxyEffectsModel->sourceModel())->setActive(index == 7);
         if (index == 6) {
             static_cast<DataSourceModel *>(m_ui->clipboardContent->model())->setSource(waylandServer()->seat()->selection());
             m_ui->clipboardSource->setText(sourceString(waylandServer()->seat()->selection()));
@@ -648,10 +657,33 @@ DebugConsole::DebugConsole()
     setWindowFlags(Qt::X11BypassWindowManagerHint);
 
     initGLTab();
+    initEffectsTab();
 }
 
 DebugConsole::~DebugConsole() = default;
 
+void DebugConsole::initEffectsTab()
+{
+    QSortFilterProxyModel *proxyEffectsModel = new QSortFilterProxyModel(this);
+    proxyEffectsModel->setSourceModel(new EffectProfileModel(this));
+    proxyEffectsModel->setSortRole(Qt::UserRole);
+    m_ui->effectsView->setModel(proxyEffectsModel);
+    m_ui->effectsView->sortByColumn(2, Qt::DescendingOrder);
+
+    auto effectsHandler = static_cast<EffectsHandlerImpl *>(effects);
+    if (!effectsHandler || !effectsHandler->isOpenGLCompositing() || !GLTimerQuery::supported()) {
+        m_ui->gpuProfilingCheckBox->setEnabled(false);
+        return;
+    }
+    m_ui->gpuProfilingCheckBox->setChecked(effectsHandler->isGpuProfilingEnabled());
+    connect(m_ui->gpuProfilingCheckBox, &QCheckBox::toggled, this, [](bool checked) {
+        auto effectsHandler = static_cast<EffectsHandlerImpl *>(effects);
+        if (effectsHandler) {
+            effectsHandler->setGpuProfilingEnabled(checked);
+        }
+    });
+}
+
 void DebugConsole::initGLTab()
 {
     if (!effects || !effects->isOpenGLCompositing()) {
@@ -682,6 +714,22 @@ void DebugConsole::initGLTab()
 
     m_ui->platformExtensionsLabel->setText(extensionsString(Compositor::self()->scene()->openGLPlatformInterfaceExtensions()));
     m_ui->openGLExtensionsLabel->setText(extensionsString(openGLExtensions()));
+
+    updateDmabufCacheStatistics();
+}
+
+void DebugConsole::updateDmabufCacheStatistics()
+{
+    auto eglBackend = qobject_cast<AbstractEglBackend *>(Compositor::self()->backend());
+    EglDmabuf *dmabuf = eglBackend ? eglBackend->dmabuf() : nullptr;
+    m_ui->dmabufCacheBox->setVisible(dmabuf);
+    if (!dmabuf) {
+        return;
+    }
+    const EglDmabuf::ImportCacheStatistics statistics = dmabuf->importCacheStatistics();
+    m_ui->dmabufCacheTexturesLabel->setText(QString::number(statistics.textures));
+    m_ui->dmabufCacheHitsLabel->setText(QString::number(statistics.hits));
+    m_ui->dmabufCacheMissesLabel->setText(QString::number(statistics.misses));
 }
 
 template<typename T>
@@ -1178,6 +1226,8 @@ QVariant DebugConsoleModel::propertyData(QObject *object, const QModelIndex &ind
             }
         } else if (qstrcmp(property.name(), "layer") == 0) {
             return QMetaEnum::fromType<Layer>().valueToKey(value.value<Layer>());
+        } else if (qstrcmp(property.name(), "occlusion") == 0) {
+            return QMetaEnum::fromType<WindowOcclusion>().valueToKey(int(value.value<WindowOcclusion>()));
         }
         return value;
     }
@@ -1646,6 +1696,99 @@ QVariant DataSourceModel::data(const QModelIndex &index, int role) const
     return QVariant();
 }
 
+EffectProfileModel::EffectProfileModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+    m_timer.setInterval(1000);
+    connect(&m_timer, &QTimer::timeout, this, &EffectProfileModel::refresh);
+}
+
+void EffectProfileModel::setActive(bool active)
+{
+    if (active) {
+        refresh();
+        m_timer.start();
+    } else {
+        m_timer.stop();
+    }
+}
+
+void EffectProfileModel::refresh()
+{
+    beginResetModel();
+    auto effectsHandler = static_cast<EffectsHandlerImpl *>(effects);
+    m_statistics = effectsHandler ? effectsHandler->profiler()->statistics() : QVector<EffectProfiler::Statistics>();
+    endResetModel();
+}
+
+int EffectProfileModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_statistics.count();
+}
+
+int EffectProfileModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 7;
+}
+
+QVariant EffectProfileModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return QVariant();
+    }
+    switch (section) {
+    case 0:
+        return i18nc("@title:column", "Effect");
+    case 1:
+        return i18nc("@title:column", "Hook");
+    case 2:
+        return i18nc("@title:column", "Average CPU time (µs)");
+    case 3:
+        return i18nc("@title:column", "Maximum CPU time (µs)");
+    case 4:
+        return i18nc("@title:column", "Average GPU time (µs)");
+    case 5:
+        return i18nc("@title:column", "Maximum GPU time (µs)");
+    case 6:
+        return i18nc("@title:column", "Calls per frame");
+    default:
+        return QVariant();
+    }
+}
+
+QVariant EffectProfileModel::data(const QModelIndex &index, int role) const
+{
+    if (!checkIndex(index, CheckIndexOption::ParentIsInvalid | CheckIndexOption::IndexIsValid)) {
+        return QVariant();
+    }
+    if (role != Qt::DisplayRole && role != Qt::UserRole) {
+        return QVariant();
+    }
+
+    const EffectProfiler::Statistics &entry = m_statistics.at(index.row());
+    const auto toMicroseconds = [](std::chrono::nanoseconds duration) {
+        return std::chrono::duration<qreal, std::micro>(duration).count();
+    };
+    switch (index.column()) {
+    case 0:
+        return entry.effect;
+    case 1:
+        return EffectProfiler::hookName(entry.hook);
+    case 2:
+        return role == Qt::UserRole ? toMicroseconds(entry.averageCpuTime) : QVariant(QString::number(toMicroseconds(entry.averageCpuTime), 'f', 1));
+    case 3:
+        return role == Qt::UserRole ? toMicroseconds(entry.maximumCpuTime) : QVariant(QString::number(toMicroseconds(entry.maximumCpuTime), 'f', 1));
+    case 4:
+        return role == Qt::UserRole ? toMicroseconds(entry.averageGpuTime) : QVariant(QString::number(toMicroseconds(entry.averageGpuTime), 'f', 1));
+    case 5:
+        return role == Qt::UserRole ? toMicroseconds(entry.maximumGpuTime) : QVariant(QString::number(toMicroseconds(entry.maximumGpuTime), 'f', 1));
+    case 6:
+        return role == Qt::UserRole ? entry.calls : QVariant(QString::number(entry.calls, 'f', 1));
+    default:
+        return QVariant();
+    }
+}
+
 static QByteArray readData(int fd)
 {
     pollfd pfd;
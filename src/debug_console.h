@@ -9,13 +9,16 @@
 #ifndef KWIN_DEBUG_CONSOLE_H
 #define KWIN_DEBUG_CONSOLE_H
 
+#include "effectprofiler.h"
 #include "input.h"
 #include "input_event_spy.h"
 #include <config-kwin.h>
 #include <kwin_export.h>
 
 #include <QAbstractItemModel>
+#include <QAbstractTableModel>
 #include <QStyledItemDelegate>
+#include <QTimer>
 #include <QVector>
 #include <functional>
 #include <memory>
@@ -107,7 +110,9 @@ protected:
 
 private:
     void initGLTab();
+    void initEffectsTab();
     void updateKeyboardTab();
+    void updateDmabufCacheStatistics();
 
     std::unique_ptr<Ui::DebugConsole> m_ui;
     std::unique_ptr<DebugConsoleFilter> m_inputFilter;
@@ -204,6 +209,29 @@ private:
     KWaylandServer::AbstractDataSource *m_source = nullptr;
     QVector<QByteArray> m_data;
 };
+
+class EffectProfileModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    explicit EffectProfileModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent) const override;
+    int columnCount(const QModelIndex &parent) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    /**
+     * Periodically refreshes the costs while @p active is @c true.
+     */
+    void setActive(bool active);
+
+private:
+    void refresh();
+
+    QVector<EffectProfiler::Statistics> m_statistics;
+    QTimer m_timer;
+};
 }
 
 #endif
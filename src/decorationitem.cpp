@@ -87,6 +87,19 @@ void DecorationRenderer::setDevicePixelRatio(qreal dpr)
     }
 }
 
+QPoint DecorationRenderer::textureOffset() const
+{
+    return m_textureOffset;
+}
+
+void DecorationRenderer::setTextureOffset(const QPoint &offset)
+{
+    if (m_textureOffset != offset) {
+        m_textureOffset = offset;
+        Q_EMIT textureOffsetChanged();
+    }
+}
+
 QImage DecorationRenderer::renderToImage(const QRect &geo)
 {
     Q_ASSERT(m_client);
@@ -142,6 +155,8 @@ DecorationItem::DecorationItem(KDecoration2::Decoration *decoration, Window *win
 
     connect(renderer(), &DecorationRenderer::damaged,
             this, qOverload<const QRegion &>(&Item::scheduleRepaint));
+    connect(renderer(), &DecorationRenderer::textureOffsetChanged,
+            this, &DecorationItem::discardQuads);
 
     // this toSize is to match that DecoratedWindow also rounds
     setSize(window->size().toSize());
@@ -268,10 +283,10 @@ WindowQuadList DecorationItem::buildQuads() const
     const int bottomHeight = std::ceil(bottom.height() * devicePixelRatio);
     const int leftWidth = std::ceil(left.width() * devicePixelRatio);
 
-    const QPoint topPosition(0, 0);
-    const QPoint bottomPosition(0, topPosition.y() + topHeight + (2 * texturePad));
-    const QPoint leftPosition(0, bottomPosition.y() + bottomHeight + (2 * texturePad));
-    const QPoint rightPosition(0, leftPosition.y() + leftWidth + (2 * texturePad));
+    const QPoint topPosition = m_renderer->textureOffset();
+    const QPoint bottomPosition(topPosition.x(), topPosition.y() + topHeight + (2 * texturePad));
+    const QPoint leftPosition(topPosition.x(), bottomPosition.y() + bottomHeight + (2 * texturePad));
+    const QPoint rightPosition(topPosition.x(), leftPosition.y() + leftWidth + (2 * texturePad));
 
     WindowQuadList list;
     if (left.isValid()) {
@@ -44,8 +44,15 @@ public:
     // Reserve some space for padding. We pad decoration parts to avoid texture bleeding.
     static const int TexturePad = 1;
 
+    /**
+     * Returns the position of the decoration in the texture that it is rendered into, which
+     * can be shared with other decorations.
+     */
+    QPoint textureOffset() const;
+
 Q_SIGNALS:
     void damaged(const QRegion &region);
+    void textureOffsetChanged();
 
 protected:
     explicit DecorationRenderer(Decoration::DecoratedClientImpl *client);
@@ -62,10 +69,12 @@ protected:
     }
     QImage renderToImage(const QRect &geo);
     void renderToPainter(QPainter *painter, const QRect &rect);
+    void setTextureOffset(const QPoint &offset);
 
 private:
     QPointer<Decoration::DecoratedClientImpl> m_client;
     QRegion m_damage;
+    QPoint m_textureOffset;
     qreal m_devicePixelRatio = 1;
     bool m_imageSizesDirty;
 };
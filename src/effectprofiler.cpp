@@ -0,0 +1,326 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "effectprofiler.h"
+
+#include <kwinglplatform.h>
+#include <kwinglutils.h>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+// GPU results that haven't arrived after that many frames are discarded.
+static const int s_maxPendingGpuFrames = 4;
+
+static void queryTimestamp(GLuint query)
+{
+    if (GLPlatform::instance()->isGLES()) {
+        glQueryCounterEXT(query, GL_TIMESTAMP_EXT);
+    } else {
+        glQueryCounter(query, GL_TIMESTAMP);
+    }
+}
+
+static bool isQueryAvailable(GLuint query)
+{
+    GLint available = 0;
+    if (GLPlatform::instance()->isGLES()) {
+        glGetQueryObjectivEXT(query, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+    } else {
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    }
+    return available;
+}
+
+static std::chrono::nanoseconds queryResult(GLuint query)
+{
+    GLuint64 result = 0;
+    if (GLPlatform::instance()->isGLES()) {
+        glGetQueryObjectui64vEXT(query, GL_QUERY_RESULT_EXT, &result);
+    } else {
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &result);
+    }
+    return std::chrono::nanoseconds(result);
+}
+
+EffectProfiler::EffectProfiler()
+{
+}
+
+EffectProfiler::~EffectProfiler()
+{
+    releaseQueries();
+}
+
+QString EffectProfiler::hookName(Hook hook)
+{
+    switch (hook) {
+    case Hook::PrePaintScreen:
+        return QStringLiteral("prePaintScreen");
+    case Hook::PaintScreen:
+        return QStringLiteral("paintScreen");
+    case Hook::PaintWindow:
+        return QStringLiteral("paintWindow");
+    case Hook::DrawWindow:
+        return QStringLiteral("drawWindow");
+    default:
+        Q_UNREACHABLE();
+    }
+}
+
+void EffectProfiler::addEffect(Effect *effect, const QString &name)
+{
+    auto data = std::make_unique<EffectData>();
+    data->name = name;
+    m_effects.insert(effect, data.get());
+    m_effectData.push_back(std::move(data));
+}
+
+void EffectProfiler::removeEffect(Effect *effect)
+{
+    EffectData *data = m_effects.take(effect);
+    if (!data) {
+        return;
+    }
+    forgetGpuCalls(data);
+    m_effectData.erase(std::remove_if(m_effectData.begin(), m_effectData.end(), [data](const auto &entry) {
+                           return entry.get() == data;
+                       }),
+                       m_effectData.end());
+}
+
+void EffectProfiler::forgetGpuCalls(EffectData *data)
+{
+    // The queries of the calls are still in flight, they are released once the frame resolves.
+    auto forget = [data](GpuFrame &frame) {
+        for (GpuCall &call : frame.calls) {
+            if (call.data == data) {
+                call.data = nullptr;
+            }
+        }
+    };
+    forget(m_gpuFrame);
+    for (GpuFrame &frame : m_pendingGpuFrames) {
+        forget(frame);
+    }
+}
+
+void EffectProfiler::beginFrame()
+{
+    Q_ASSERT(m_stack.empty());
+    if (m_gpuProfilingEnabled) {
+        if (!m_gpuFrame.calls.empty()) {
+            m_pendingGpuFrames.push_back(std::move(m_gpuFrame));
+        }
+        resolveGpuFrames();
+    }
+    m_gpuFrame = GpuFrame{.frame = ++m_frame};
+}
+
+void EffectProfiler::enter(Effect *effect, Hook hook)
+{
+    EffectData *data = m_effects.value(effect);
+    Call call{
+        .data = data,
+        .hook = hook,
+        .start = std::chrono::steady_clock::now(),
+    };
+    if (m_gpuProfilingEnabled) {
+        call.gpuCall = m_gpuFrame.calls.size();
+        m_gpuFrame.calls.push_back(GpuCall{
+            .data = data,
+            .hook = hook,
+            .parent = m_stack.empty() ? -1 : m_stack.back().gpuCall,
+            .beginQuery = acquireQuery(),
+        });
+        queryTimestamp(m_gpuFrame.calls.back().beginQuery);
+    }
+    m_stack.push_back(call);
+}
+
+bool EffectProfiler::enterScene()
+{
+    if (m_stack.empty()) {
+        return false;
+    }
+    enter(nullptr, m_stack.back().hook);
+    return true;
+}
+
+void EffectProfiler::leave()
+{
+    Q_ASSERT(!m_stack.empty());
+    const Call call = m_stack.back();
+    m_stack.pop_back();
+
+    if (call.gpuCall != -1) {
+        GpuCall &gpuCall = m_gpuFrame.calls[call.gpuCall];
+        gpuCall.endQuery = acquireQuery();
+        queryTimestamp(gpuCall.endQuery);
+        m_gpuFrame.lastQuery = gpuCall.endQuery;
+    }
+
+    const std::chrono::nanoseconds duration = std::chrono::steady_clock::now() - call.start;
+    if (!m_stack.empty()) {
+        m_stack.back().children += duration;
+    }
+    if (call.data) {
+        Sample &sample = this->sample(call.data, call.hook, m_frame);
+        sample.calls++;
+        sample.cpuTime += duration - call.children;
+    }
+}
+
+EffectProfiler::Sample &EffectProfiler::sample(EffectData *data, Hook hook, quint64 frame)
+{
+    Sample &sample = data->samples[int(hook)][frame % s_frameCount];
+    if (sample.frame != frame) {
+        sample = Sample{.frame = frame};
+    }
+    return sample;
+}
+
+uint EffectProfiler::acquireQuery()
+{
+    if (m_freeQueries.empty()) {
+        std::array<GLuint, 64> queries;
+        if (GLPlatform::instance()->isGLES()) {
+            glGenQueriesEXT(queries.size(), queries.data());
+        } else {
+            glGenQueries(queries.size(), queries.data());
+        }
+        m_queries.insert(m_queries.end(), queries.begin(), queries.end());
+        m_freeQueries.insert(m_freeQueries.end(), queries.begin(), queries.end());
+    }
+    const uint query = m_freeQueries.back();
+    m_freeQueries.pop_back();
+    return query;
+}
+
+void EffectProfiler::resolveGpuFrames()
+{
+    while (!m_pendingGpuFrames.empty()) {
+        GpuFrame &frame = m_pendingGpuFrames.front();
+        const bool expired = m_pendingGpuFrames.size() > s_maxPendingGpuFrames;
+        if (!expired && !isQueryAvailable(frame.lastQuery)) {
+            break;
+        }
+
+        bool valid = !expired;
+        if (valid && GLPlatform::instance()->isGLES()) {
+            // The results are meaningless if e.g. the GPU frequency has changed meanwhile.
+            GLint disjoint = 0;
+            glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+            valid = !disjoint;
+        }
+
+        if (valid) {
+            std::vector<std::chrono::nanoseconds> durations(frame.calls.size());
+            std::vector<std::chrono::nanoseconds> children(frame.calls.size());
+            for (size_t i = 0; i < frame.calls.size(); ++i) {
+                const GpuCall &call = frame.calls[i];
+                durations[i] = queryResult(call.endQuery) - queryResult(call.beginQuery);
+            }
+            // Children are always recorded after their parents.
+            for (size_t i = frame.calls.size(); i-- > 0;) {
+                const GpuCall &call = frame.calls[i];
+                if (call.parent != -1) {
+                    children[call.parent] += durations[i];
+                }
+                if (call.data) {
+                    Sample &sample = call.data->samples[int(call.hook)][frame.frame % s_frameCount];
+                    if (sample.frame == frame.frame) {
+                        sample.gpuTime += durations[i] - children[i];
+                        sample.hasGpuTime = true;
+                    }
+                }
+            }
+        }
+
+        for (const GpuCall &call : frame.calls) {
+            m_freeQueries.push_back(call.beginQuery);
+            m_freeQueries.push_back(call.endQuery);
+        }
+        m_pendingGpuFrames.pop_front();
+    }
+}
+
+void EffectProfiler::releaseQueries()
+{
+    if (!m_queries.empty()) {
+        if (GLPlatform::instance()->isGLES()) {
+            glDeleteQueriesEXT(m_queries.size(), m_queries.data());
+        } else {
+            glDeleteQueries(m_queries.size(), m_queries.data());
+        }
+    }
+    m_queries.clear();
+    m_freeQueries.clear();
+    m_pendingGpuFrames.clear();
+    m_gpuFrame.calls.clear();
+}
+
+bool EffectProfiler::isGpuProfilingEnabled() const
+{
+    return m_gpuProfilingEnabled;
+}
+
+void EffectProfiler::setGpuProfilingEnabled(bool enabled)
+{
+    Q_ASSERT(m_stack.empty());
+    enabled = enabled && GLTimerQuery::supported();
+    if (m_gpuProfilingEnabled == enabled) {
+        return;
+    }
+    m_gpuProfilingEnabled = enabled;
+    if (!enabled) {
+        releaseQueries();
+    }
+}
+
+QVector<EffectProfiler::Statistics> EffectProfiler::statistics() const
+{
+    QVector<Statistics> statistics;
+    for (const auto &data : m_effectData) {
+        for (int hook = 0; hook < int(Hook::Count); ++hook) {
+            Statistics entry{
+                .effect = data->name,
+                .hook = Hook(hook),
+            };
+            int calls = 0;
+            int gpuFrames = 0;
+            for (const Sample &sample : data->samples[hook]) {
+                // Skip the frame that is being painted and the samples that are too old.
+                if (sample.frame >= m_frame || m_frame - sample.frame >= s_frameCount) {
+                    continue;
+                }
+                entry.frames++;
+                calls += sample.calls;
+                entry.averageCpuTime += sample.cpuTime;
+                entry.maximumCpuTime = std::max(entry.maximumCpuTime, sample.cpuTime);
+                if (sample.hasGpuTime) {
+                    gpuFrames++;
+                    entry.averageGpuTime += sample.gpuTime;
+                    entry.maximumGpuTime = std::max(entry.maximumGpuTime, sample.gpuTime);
+                }
+            }
+            if (!entry.frames) {
+                continue;
+            }
+            entry.calls = qreal(calls) / entry.frames;
+            entry.averageCpuTime /= entry.frames;
+            if (gpuFrames) {
+                entry.averageGpuTime /= gpuFrames;
+            }
+            statistics.append(entry);
+        }
+    }
+    return statistics;
+}
+
+} // namespace KWin
@@ -0,0 +1,158 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwinglobals.h>
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace KWin
+{
+
+class Effect;
+
+/**
+ * The EffectProfiler class measures how much time every effect spends in its paint hooks.
+ *
+ * The CPU time is always recorded, the GPU time is recorded using timestamp queries only if
+ * GPU profiling is enabled because the results have to be read back from the GPU. The times
+ * are exclusive, i.e. the time spent in the next effects in the chain and in the scene is not
+ * attributed to an effect.
+ *
+ * Painting happens on the main thread only, so the samples are kept in plain ring buffers
+ * that hold the costs of the last frames.
+ */
+class KWIN_EXPORT EffectProfiler
+{
+public:
+    enum class Hook {
+        PrePaintScreen,
+        PaintScreen,
+        PaintWindow,
+        DrawWindow,
+        Count,
+    };
+
+    struct Statistics
+    {
+        QString effect;
+        Hook hook;
+        int frames = 0; // the number of recent frames in which the hook was called
+        qreal calls = 0; // the average number of calls in these frames
+        std::chrono::nanoseconds averageCpuTime = std::chrono::nanoseconds::zero();
+        std::chrono::nanoseconds maximumCpuTime = std::chrono::nanoseconds::zero();
+        std::chrono::nanoseconds averageGpuTime = std::chrono::nanoseconds::zero();
+        std::chrono::nanoseconds maximumGpuTime = std::chrono::nanoseconds::zero();
+    };
+
+    EffectProfiler();
+    ~EffectProfiler();
+
+    static QString hookName(Hook hook);
+
+    void addEffect(Effect *effect, const QString &name);
+    void removeEffect(Effect *effect);
+
+    /**
+     * Starts a new frame, it must be called before the effects are invoked to paint a screen.
+     */
+    void beginFrame();
+
+    /**
+     * Starts measuring a call to the @p hook of the @p effect. Calls can be nested.
+     */
+    void enter(Effect *effect, Hook hook);
+    /**
+     * Starts measuring the work done by the scene at the end of the effect chain, it is
+     * subtracted from the effect that called into the scene. Returns @c false if no
+     * effect is being measured, leave() must not be called in that case.
+     */
+    bool enterScene();
+    /**
+     * Finishes measuring the innermost call.
+     */
+    void leave();
+
+    bool isGpuProfilingEnabled() const;
+    void setGpuProfilingEnabled(bool enabled);
+
+    /**
+     * Returns the aggregated costs of the recent frames, for every effect and hook that
+     * has been called in them.
+     */
+    QVector<Statistics> statistics() const;
+
+private:
+    static constexpr int s_frameCount = 120;
+
+    struct Sample
+    {
+        quint64 frame = 0;
+        int calls = 0;
+        std::chrono::nanoseconds cpuTime = std::chrono::nanoseconds::zero();
+        std::chrono::nanoseconds gpuTime = std::chrono::nanoseconds::zero();
+        bool hasGpuTime = false;
+    };
+
+    struct EffectData
+    {
+        QString name;
+        std::array<std::array<Sample, s_frameCount>, int(Hook::Count)> samples;
+    };
+
+    struct Call
+    {
+        EffectData *data; // nullptr for the scene
+        Hook hook;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::nanoseconds children = std::chrono::nanoseconds::zero();
+        int gpuCall = -1;
+    };
+
+    struct GpuCall
+    {
+        EffectData *data; // nullptr for the scene and for the effects that have been removed
+        Hook hook;
+        int parent;
+        uint beginQuery;
+        uint endQuery = 0;
+    };
+
+    struct GpuFrame
+    {
+        quint64 frame;
+        std::vector<GpuCall> calls;
+        uint lastQuery = 0; // timestamps complete in order, so this one becomes available last
+    };
+
+    Sample &sample(EffectData *data, Hook hook, quint64 frame);
+    void forgetGpuCalls(EffectData *data);
+    uint acquireQuery();
+    void resolveGpuFrames();
+    void releaseQueries();
+
+    QHash<Effect *, EffectData *> m_effects;
+    std::vector<std::unique_ptr<EffectData>> m_effectData;
+    std::vector<Call> m_stack;
+    quint64 m_frame = 1;
+
+    bool m_gpuProfilingEnabled = false;
+    GpuFrame m_gpuFrame;
+    std::deque<GpuFrame> m_pendingGpuFrames;
+    std::vector<uint> m_freeQueries;
+    std::vector<uint> m_queries;
+};
+
+} // namespace KWin
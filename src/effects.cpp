@@ -13,6 +13,7 @@
 #include <config-kwin.h>
 
 #include "effectloader.h"
+#include "effectprofiler.h"
 #include "effectsadaptor.h"
 #include "output.h"
 #if KWIN_BUILD_ACTIVITIES
@@ -54,6 +55,7 @@
 #include <KDecoration2/Decoration>
 #include <KDecoration2/DecorationSettings>
 
+#include <QDBusMetaType>
 #include <QDebug>
 #include <QMouseEvent>
 #include <QQmlEngine>
@@ -124,13 +126,16 @@ EffectsHandlerImpl::EffectsHandlerImpl(Compositor *compositor, Scene *scene)
     , m_compositor(compositor)
     , m_scene(scene)
     , m_effectLoader(new EffectLoader(this))
+    , m_profiler(std::make_unique<EffectProfiler>())
     , m_trackingCursorChanges(0)
 {
     qRegisterMetaType<QVector<KWin::EffectWindow *>>();
+    qDBusRegisterMetaType<QList<QVariantMap>>();
     qRegisterMetaType<KWin::SessionState>();
     connect(m_effectLoader, &AbstractEffectLoader::effectLoaded, this, [this](Effect *effect, const QString &name) {
         effect_order.insert(effect->requestedEffectChainPosition(), EffectPair(name, effect));
         loaded_effects << EffectPair(name, effect);
+        m_profiler->addEffect(effect, name);
         effectsChanged();
     });
     m_effectLoader->setConfig(kwinApp()->config());
@@ -274,6 +279,10 @@ EffectsHandlerImpl::EffectsHandlerImpl(Compositor *compositor, Scene *scene)
 EffectsHandlerImpl::~EffectsHandlerImpl()
 {
     unloadAllEffects();
+
+    // The profiler may hold GPU timestamp queries.
+    makeOpenGLContextCurrent();
+    m_profiler.reset();
 }
 
 void EffectsHandlerImpl::unloadAllEffects()
@@ -368,8 +377,10 @@ void EffectsHandlerImpl::reconfigure()
 void EffectsHandlerImpl::prePaintScreen(ScreenPrePaintData &data, std::chrono::milliseconds presentTime)
 {
     if (m_currentPaintScreenIterator != m_activeEffects.constEnd()) {
+        m_profiler->enter(*m_currentPaintScreenIterator, EffectProfiler::Hook::PrePaintScreen);
         (*m_currentPaintScreenIterator++)->prePaintScreen(data, presentTime);
         --m_currentPaintScreenIterator;
+        m_profiler->leave();
     }
     // no special final code
 }
@@ -377,10 +388,16 @@ void EffectsHandlerImpl::prePaintScreen(ScreenPrePaintData &data, std::chrono::m
 void EffectsHandlerImpl::paintScreen(int mask, const QRegion &region, ScreenPaintData &data)
 {
     if (m_currentPaintScreenIterator != m_activeEffects.constEnd()) {
+        m_profiler->enter(*m_currentPaintScreenIterator, EffectProfiler::Hook::PaintScreen);
         (*m_currentPaintScreenIterator++)->paintScreen(mask, region, data);
         --m_currentPaintScreenIterator;
+        m_profiler->leave();
     } else {
+        const bool profiled = m_profiler->enterScene();
         m_scene->finalPaintScreen(mask, region, data);
+        if (profiled) {
+            m_profiler->leave();
+        }
     }
 }
 
@@ -393,30 +410,66 @@ void EffectsHandlerImpl::postPaintScreen()
     // no special final code
 }
 
+EffectsHandlerImpl::EffectsIterator EffectsHandlerImpl::nextInterestedEffect(EffectsIterator it, EffectWindow *w) const
+{
+    EffectWindowImpl *window = static_cast<EffectWindowImpl *>(w);
+    if (window->interestedEffectsSerial() != m_windowInterestSerial) {
+        QBitArray interested(m_activeEffects.size());
+        for (int i = 0; i < m_activeEffects.size(); ++i) {
+            if (m_activeEffects[i]->isInterestedInWindow(w)) {
+                interested.setBit(i);
+            }
+        }
+        window->setInterestedEffects(interested, m_windowInterestSerial);
+    }
+
+    const QBitArray &interested = window->interestedEffects();
+    const auto end = m_activeEffects.constEnd();
+    while (it != end && !interested.testBit(it - m_activeEffects.constBegin())) {
+        ++it;
+    }
+    return it;
+}
+
 void EffectsHandlerImpl::prePaintWindow(EffectWindow *w, WindowPrePaintData &data, std::chrono::milliseconds presentTime)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->prePaintWindow(w, data, presentTime);
-        --m_currentPaintWindowIterator;
+    const EffectsIterator current = m_currentPaintWindowIterator;
+    const EffectsIterator next = nextInterestedEffect(current, w);
+    if (next != m_activeEffects.constEnd()) {
+        m_currentPaintWindowIterator = next + 1;
+        (*next)->prePaintWindow(w, data, presentTime);
+        m_currentPaintWindowIterator = current;
     }
     // no special final code
 }
 
 void EffectsHandlerImpl::paintWindow(EffectWindow *w, int mask, const QRegion &region, WindowPaintData &data)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->paintWindow(w, mask, region, data);
-        --m_currentPaintWindowIterator;
+    const EffectsIterator current = m_currentPaintWindowIterator;
+    const EffectsIterator next = nextInterestedEffect(current, w);
+    if (next != m_activeEffects.constEnd()) {
+        m_currentPaintWindowIterator = next + 1;
+        m_profiler->enter(*next, EffectProfiler::Hook::PaintWindow);
+        (*next)->paintWindow(w, mask, region, data);
+        m_profiler->leave();
+        m_currentPaintWindowIterator = current;
     } else {
+        const bool profiled = m_profiler->enterScene();
         m_scene->finalPaintWindow(static_cast<EffectWindowImpl *>(w), mask, region, data);
+        if (profiled) {
+            m_profiler->leave();
+        }
     }
 }
 
 void EffectsHandlerImpl::postPaintWindow(EffectWindow *w)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->postPaintWindow(w);
-        --m_currentPaintWindowIterator;
+    const EffectsIterator current = m_currentPaintWindowIterator;
+    const EffectsIterator next = nextInterestedEffect(current, w);
+    if (next != m_activeEffects.constEnd()) {
+        m_currentPaintWindowIterator = next + 1;
+        (*next)->postPaintWindow(w);
+        m_currentPaintWindowIterator = current;
     }
     // no special final code
 }
@@ -433,11 +486,20 @@ Effect *EffectsHandlerImpl::provides(Effect::Feature ef)
 
 void EffectsHandlerImpl::drawWindow(EffectWindow *w, int mask, const QRegion &region, WindowPaintData &data)
 {
-    if (m_currentDrawWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentDrawWindowIterator++)->drawWindow(w, mask, region, data);
-        --m_currentDrawWindowIterator;
+    const EffectsIterator current = m_currentDrawWindowIterator;
+    const EffectsIterator next = nextInterestedEffect(current, w);
+    if (next != m_activeEffects.constEnd()) {
+        m_currentDrawWindowIterator = next + 1;
+        m_profiler->enter(*next, EffectProfiler::Hook::DrawWindow);
+        (*next)->drawWindow(w, mask, region, data);
+        m_profiler->leave();
+        m_currentDrawWindowIterator = current;
     } else {
+        const bool profiled = m_profiler->enterScene();
         m_scene->finalDrawWindow(static_cast<EffectWindowImpl *>(w), mask, region, data);
+        if (profiled) {
+            m_profiler->leave();
+        }
     }
 }
 
@@ -454,6 +516,7 @@ bool EffectsHandlerImpl::decorationsHaveAlpha() const
 // start another painting pass
 void EffectsHandlerImpl::startPaint()
 {
+    const EffectsList previousActiveEffects = m_activeEffects;
     m_activeEffects.clear();
     m_activeEffects.reserve(loaded_effects.count());
     for (QVector<KWin::EffectPair>::const_iterator it = loaded_effects.constBegin(); it != loaded_effects.constEnd(); ++it) {
@@ -461,9 +524,16 @@ void EffectsHandlerImpl::startPaint()
             m_activeEffects << it->second;
         }
     }
+    // The effects interested in a window are cached until the active effects or their
+    // interests change, so windows that no effect cares about skip the chain entirely.
+    if (m_windowInterestDirty || m_activeEffects != previousActiveEffects) {
+        m_windowInterestDirty = false;
+        ++m_windowInterestSerial;
+    }
     m_currentDrawWindowIterator = m_activeEffects.constBegin();
     m_currentPaintWindowIterator = m_activeEffects.constBegin();
     m_currentPaintScreenIterator = m_activeEffects.constBegin();
+    m_profiler->beginFrame();
 }
 
 void EffectsHandlerImpl::slotClientMaximized(Window *window, MaximizeMode maxMode)
@@ -1479,6 +1549,7 @@ void EffectsHandlerImpl::destroyEffect(Effect *effect)
         removeSupportProperty(property, effect);
     }
 
+    m_profiler->removeEffect(effect);
     delete effect;
 }
 
@@ -1553,6 +1624,7 @@ void EffectsHandlerImpl::effectsChanged()
               std::back_inserter(loaded_effects));
 
     m_activeEffects.reserve(loaded_effects.count());
+    m_windowInterestDirty = true;
 }
 
 QStringList EffectsHandlerImpl::activeEffects() const
@@ -1568,6 +1640,11 @@ QStringList EffectsHandlerImpl::activeEffects() const
     return ret;
 }
 
+void EffectsHandlerImpl::windowInterestChanged()
+{
+    m_windowInterestDirty = true;
+}
+
 bool EffectsHandlerImpl::blocksDirectScanout() const
 {
     return std::any_of(m_activeEffects.constBegin(), m_activeEffects.constEnd(), [](const Effect *effect) {
@@ -1648,6 +1725,51 @@ QString EffectsHandlerImpl::debug(const QString &name, const QString &parameter)
     return QString();
 }
 
+QList<QVariantMap> EffectsHandlerImpl::effectProfile() const
+{
+    const auto toMicroseconds = [](std::chrono::nanoseconds duration) {
+        return qulonglong(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    };
+
+    QList<QVariantMap> profile;
+    const QVector<EffectProfiler::Statistics> statistics = m_profiler->statistics();
+    for (const EffectProfiler::Statistics &entry : statistics) {
+        QVariantMap map{
+            {QStringLiteral("effect"), entry.effect},
+            {QStringLiteral("hook"), EffectProfiler::hookName(entry.hook)},
+            {QStringLiteral("frames"), entry.frames},
+            {QStringLiteral("callsPerFrame"), entry.calls},
+            {QStringLiteral("averageCpuTime"), toMicroseconds(entry.averageCpuTime)},
+            {QStringLiteral("maximumCpuTime"), toMicroseconds(entry.maximumCpuTime)},
+        };
+        if (m_profiler->isGpuProfilingEnabled()) {
+            map.insert(QStringLiteral("averageGpuTime"), toMicroseconds(entry.averageGpuTime));
+            map.insert(QStringLiteral("maximumGpuTime"), toMicroseconds(entry.maximumGpuTime));
+        }
+        profile.append(map);
+    }
+    return profile;
+}
+
+bool EffectsHandlerImpl::isGpuProfilingEnabled() const
+{
+    return m_profiler->isGpuProfilingEnabled();
+}
+
+void EffectsHandlerImpl::setGpuProfilingEnabled(bool enabled)
+{
+    if (enabled && compositingType() != OpenGLCompositing) {
+        return;
+    }
+    makeOpenGLContextCurrent();
+    m_profiler->setGpuProfilingEnabled(enabled);
+}
+
+EffectProfiler *EffectsHandlerImpl::profiler() const
+{
+    return m_profiler.get();
+}
+
 bool EffectsHandlerImpl::makeOpenGLContextCurrent()
 {
     return m_scene->makeOpenGLContextCurrent();
@@ -2226,6 +2348,22 @@ QVariant EffectWindowImpl::data(int role) const
     return dataMap.value(role);
 }
 
+const QBitArray &EffectWindowImpl::interestedEffects() const
+{
+    return m_interestedEffects;
+}
+
+quint64 EffectWindowImpl::interestedEffectsSerial() const
+{
+    return m_interestedEffectsSerial;
+}
+
+void EffectWindowImpl::setInterestedEffects(const QBitArray &effects, quint64 serial)
+{
+    m_interestedEffects = effects;
+    m_interestedEffectsSerial = serial;
+}
+
 void EffectWindowImpl::elevate(bool elevate)
 {
     effects->setElevatedWindow(this, elevate);
@@ -2512,8 +2650,8 @@ EffectFrameImpl::EffectFrameImpl(EffectFrameStyle style, bool staticSize, QPoint
     , EffectFrame()
     , m_view(new EffectFrameQuickScene(style, staticSize, position, alignment, nullptr))
 {
-    connect(m_view, &OffscreenQuickScene::repaintNeeded, this, [this] {
-        effects->addRepaint(geometry());
+    connect(m_view, &OffscreenQuickScene::repaintNeeded, this, [this](const QRegion &damage) {
+        effects->addRepaint(damage.translated(m_view->geometry().topLeft()));
     });
     connect(m_view, &OffscreenQuickScene::geometryChanged, this, [this](const QRect &oldGeometry, const QRect &newGeometry) {
         effects->addRepaint(oldGeometry);
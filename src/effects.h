@@ -17,6 +17,7 @@
 #include "scene.h"
 
 #include <QFont>
+#include <QBitArray>
 #include <QHash>
 
 #include <memory>
@@ -38,6 +39,7 @@ class Window;
 class Compositor;
 class Deleted;
 class EffectLoader;
+class EffectProfiler;
 class Group;
 class Unmanaged;
 class WindowPropertyNotifyX11Filter;
@@ -52,6 +54,7 @@ class KWIN_EXPORT EffectsHandlerImpl : public EffectsHandler
     Q_PROPERTY(QStringList activeEffects READ activeEffects)
     Q_PROPERTY(QStringList loadedEffects READ loadedEffects)
     Q_PROPERTY(QStringList listOfEffects READ listOfEffects)
+    Q_PROPERTY(bool gpuProfilingEnabled READ isGpuProfilingEnabled WRITE setGpuProfilingEnabled)
 public:
     EffectsHandlerImpl(Compositor *compositor, Scene *scene);
     ~EffectsHandlerImpl() override;
@@ -197,6 +200,8 @@ public:
      */
     bool blocksDirectScanout() const;
 
+    void windowInterestChanged() override;
+
     KWaylandServer::Display *waylandDisplay() const override;
 
     bool animationsSupported() const override;
@@ -263,6 +268,14 @@ public:
     KWin::EffectWindow *inputPanel() const override;
     bool isInputPanelOverlay() const override;
 
+    /**
+     * Whether the GPU time of the effects is measured in addition to the CPU time. It's
+     * only supported with the OpenGL compositor if the driver has timestamp queries.
+     */
+    bool isGpuProfilingEnabled() const;
+    void setGpuProfilingEnabled(bool enabled);
+    EffectProfiler *profiler() const;
+
 public Q_SLOTS:
     void slotCurrentTabAboutToChange(EffectWindow *from, EffectWindow *to);
     void slotTabAdded(EffectWindow *from, EffectWindow *to);
@@ -278,6 +291,11 @@ public Q_SLOTS:
     Q_SCRIPTABLE QList<bool> areEffectsSupported(const QStringList &names);
     Q_SCRIPTABLE QString supportInformation(const QString &name) const;
     Q_SCRIPTABLE QString debug(const QString &name, const QString &parameter = QString()) const;
+    /**
+     * Returns the average and the maximum cost of every hook of the loaded effects in the
+     * recent frames, in microseconds.
+     */
+    Q_SCRIPTABLE QList<QVariantMap> effectProfile() const;
 
 protected Q_SLOTS:
     void slotWindowShown(KWin::Window *);
@@ -335,7 +353,16 @@ private:
 
     typedef QVector<Effect *> EffectsList;
     typedef EffectsList::const_iterator EffectsIterator;
+
+    /**
+     * Returns the first effect starting at @p it that is interested in the window @p w.
+     */
+    EffectsIterator nextInterestedEffect(EffectsIterator it, EffectWindow *w) const;
+
     EffectsList m_activeEffects;
+    // Incremented whenever the effects interested in the windows have to be determined again
+    quint64 m_windowInterestSerial = 1;
+    bool m_windowInterestDirty = false;
     EffectsIterator m_currentDrawWindowIterator;
     EffectsIterator m_currentPaintWindowIterator;
     EffectsIterator m_currentPaintScreenIterator;
@@ -346,6 +373,7 @@ private:
     Scene *m_scene;
     QList<Effect *> m_grabbedMouseEffects;
     EffectLoader *m_effectLoader;
+    std::unique_ptr<EffectProfiler> m_profiler;
     int m_trackingCursorChanges;
     std::unique_ptr<WindowPropertyNotifyX11Filter> m_x11WindowPropertyNotify;
     QList<EffectScreen *> m_effectScreens;
@@ -504,6 +532,11 @@ public:
     void setData(int role, const QVariant &data) override;
     QVariant data(int role) const override;
 
+    // internal, bit i is set if the i-th active effect is interested in the window
+    const QBitArray &interestedEffects() const;
+    quint64 interestedEffectsSerial() const;
+    void setInterestedEffects(const QBitArray &effects, quint64 serial);
+
 private:
     void refVisible(const EffectWindowVisibleRef *holder) override;
     void unrefVisible(const EffectWindowVisibleRef *holder) override;
@@ -514,6 +547,8 @@ private:
     bool managed = false;
     bool m_waylandWindow;
     bool m_x11Window;
+    QBitArray m_interestedEffects;
+    quint64 m_interestedEffectsSerial = 0;
 };
 
 class EffectWindowGroupImpl
@@ -21,6 +21,7 @@
 #include <QTime>
 #include <QTimer>
 #include <QWindow>
+#include <algorithm>
 #include <cmath> // for ceil()
 #include <cstdlib>
 
@@ -72,6 +73,13 @@ BlurEffect::BlurEffect()
     connect(effects, &EffectsHandler::windowDecorationChanged, this, &BlurEffect::setupDecorationConnections);
     connect(effects, &EffectsHandler::propertyNotify, this, &BlurEffect::slotPropertyNotify);
     connect(effects, &EffectsHandler::virtualScreenGeometryChanged, this, &BlurEffect::slotScreenGeometryChanged);
+    connect(effects, &EffectsHandler::screenRemoved, this, &BlurEffect::slotScreenRemoved);
+    // Restacking, closing or hiding windows changes what is underneath the blurred windows,
+    // but only the scene repaints it, so the cached backdrops don't see it.
+    connect(effects, &EffectsHandler::stackingOrderChanged, this, &BlurEffect::invalidateBackdrops);
+    connect(effects, &EffectsHandler::windowClosed, this, &BlurEffect::invalidateBackdropsUnder);
+    connect(effects, &EffectsHandler::windowMinimized, this, &BlurEffect::invalidateBackdropsUnder);
+    connect(effects, &EffectsHandler::windowHidden, this, &BlurEffect::invalidateBackdropsUnder);
     connect(effects, &EffectsHandler::xcbConnectionChanged, this, [this]() {
         if (m_shader && m_shader->isValid() && m_renderTargetsValid) {
             net_wm_blur_region = effects->announceSupportProperty(s_blurAtomName, this);
@@ -91,7 +99,6 @@ BlurEffect::~BlurEffect()
     if (s_blurManager) {
         s_blurManagerRemoveTimer->start(1000);
     }
-    deleteFBOs();
 }
 
 void BlurEffect::slotScreenGeometryChanged()
@@ -107,34 +114,29 @@ void BlurEffect::slotScreenGeometryChanged()
     effects->doneOpenGLContextCurrent();
 }
 
-bool BlurEffect::renderTargetsValid() const
+void BlurEffect::slotScreenRemoved(EffectScreen *screen)
 {
-    return !m_renderTargets.isEmpty() && std::find_if(m_renderTargets.cbegin(), m_renderTargets.cend(), [](const GLFramebuffer *target) {
-                                             return !target->valid();
-                                         })
-        == m_renderTargets.cend();
-}
-
-void BlurEffect::deleteFBOs()
-{
-    qDeleteAll(m_renderTargets);
-    qDeleteAll(m_renderTextures);
-
-    m_renderTargets.clear();
-    m_renderTextures.clear();
+    effects->makeOpenGLContextCurrent();
+    for (auto &[window, caches] : m_backdropCaches) {
+        caches.erase(screen);
+    }
+    m_screenFrames.erase(screen);
+    if (auto it = m_renderData.find(screen); it != m_renderData.end()) {
+        if (m_currentRenderData == &it->second) {
+            m_currentRenderData = nullptr;
+        }
+        m_renderData.erase(it);
+    }
+    effects->doneOpenGLContextCurrent();
 }
 
 void BlurEffect::updateTexture()
 {
-    deleteFBOs();
+    m_renderData.clear();
+    m_currentRenderData = nullptr;
 
-    /* Reserve memory for:
-     *  - The original sized texture (1)
-     *  - The downsized textures (m_downSampleIterations)
-     *  - The helper texture (1)
-     */
-    m_renderTargets.reserve(m_downSampleIterations + 2);
-    m_renderTextures.reserve(m_downSampleIterations + 2);
+    // The cached backdrops depend on the blur strength and the layout of the render targets.
+    m_backdropCaches.clear();
 
     GLenum textureFormat = GL_RGBA8;
 
@@ -161,42 +163,84 @@ void BlurEffect::updateTexture()
         }
     }
 
+    m_renderTextureFormat = textureFormat;
+
+    // Allocate the render targets of the current screens up front to find out whether blurring works at all,
+    // the render targets of screens that are added later are allocated when the screen is painted.
+    m_renderTargetsValid = true;
+    if (effects->waylandDisplay()) {
+        const auto screens = effects->screens();
+        for (EffectScreen *screen : screens) {
+            m_renderTargetsValid &= ensureRenderData(screen, screen->geometry().size())->valid;
+        }
+    } else {
+        m_renderTargetsValid = ensureRenderData(nullptr, effects->virtualScreenSize())->valid;
+    }
+
+    // Generate the noise helper texture
+    generateNoiseTexture();
+}
+
+BlurEffect::BlurRenderData *BlurEffect::ensureRenderData(EffectScreen *screen, const QSize &size)
+{
+    BlurRenderData &renderData = m_renderData[screen];
+    if (!renderData.textures.empty() && renderData.textures.front()->size() == size) {
+        return &renderData;
+    }
+
+    renderData.stack.clear();
+    renderData.framebuffers.clear();
+    renderData.textures.clear();
+
+    /* Reserve memory for:
+     *  - The original sized texture (1)
+     *  - The downsized textures (m_downSampleIterations)
+     *  - The helper texture (1)
+     */
+    renderData.framebuffers.reserve(m_downSampleIterations + 2);
+    renderData.textures.reserve(m_downSampleIterations + 2);
+
     for (int i = 0; i <= m_downSampleIterations; i++) {
-        m_renderTextures.append(new GLTexture(textureFormat, effects->virtualScreenSize() / (1 << i)));
-        m_renderTextures.constLast()->setFilter(GL_LINEAR);
-        m_renderTextures.constLast()->setWrapMode(GL_CLAMP_TO_EDGE);
+        renderData.textures.push_back(std::make_unique<GLTexture>(m_renderTextureFormat, size / (1 << i)));
+        renderData.textures.back()->setFilter(GL_LINEAR);
+        renderData.textures.back()->setWrapMode(GL_CLAMP_TO_EDGE);
 
-        m_renderTargets.append(new GLFramebuffer(m_renderTextures.constLast()));
+        renderData.framebuffers.push_back(std::make_unique<GLFramebuffer>(renderData.textures.back().get()));
     }
 
     // This last set is used as a temporary helper texture
-    m_renderTextures.append(new GLTexture(textureFormat, effects->virtualScreenSize()));
-    m_renderTextures.constLast()->setFilter(GL_LINEAR);
-    m_renderTextures.constLast()->setWrapMode(GL_CLAMP_TO_EDGE);
+    renderData.textures.push_back(std::make_unique<GLTexture>(m_renderTextureFormat, size));
+    renderData.textures.back()->setFilter(GL_LINEAR);
+    renderData.textures.back()->setWrapMode(GL_CLAMP_TO_EDGE);
 
-    m_renderTargets.append(new GLFramebuffer(m_renderTextures.constLast()));
+    renderData.framebuffers.push_back(std::make_unique<GLFramebuffer>(renderData.textures.back().get()));
 
-    m_renderTargetsValid = renderTargetsValid();
+    renderData.valid = std::all_of(renderData.framebuffers.cbegin(), renderData.framebuffers.cend(), [](const auto &framebuffer) {
+        return framebuffer->valid();
+    });
 
     // Prepare the stack for the rendering
-    m_renderTargetStack.clear();
-    m_renderTargetStack.reserve(m_downSampleIterations * 2);
+    renderData.stack.reserve(m_downSampleIterations * 2);
 
     // Upsample
     for (int i = 1; i < m_downSampleIterations; i++) {
-        m_renderTargetStack.push(m_renderTargets[i]);
+        renderData.stack.push(renderData.framebuffers[i].get());
     }
 
     // Downsample
     for (int i = m_downSampleIterations; i > 0; i--) {
-        m_renderTargetStack.push(m_renderTargets[i]);
+        renderData.stack.push(renderData.framebuffers[i].get());
     }
 
     // Copysample
-    m_renderTargetStack.push(m_renderTargets[0]);
+    renderData.stack.push(renderData.framebuffers[0].get());
 
-    // Generate the noise helper texture
-    generateNoiseTexture();
+    // The cached backdrops were taken from the old render targets.
+    for (auto &[window, caches] : m_backdropCaches) {
+        caches.erase(screen);
+    }
+
+    return &renderData;
 }
 
 void BlurEffect::initBlurStrengthValues()
@@ -342,8 +386,34 @@ void BlurEffect::slotWindowAdded(EffectWindow *w)
     updateBlurRegion(w);
 }
 
+void BlurEffect::invalidateBackdrops()
+{
+    for (auto &[window, caches] : m_backdropCaches) {
+        for (auto &[screen, cache] : caches) {
+            cache.invalidate();
+        }
+    }
+}
+
+void BlurEffect::invalidateBackdropsUnder(EffectWindow *w)
+{
+    const QRect area = w->expandedGeometry().toAlignedRect();
+    for (auto &[window, caches] : m_backdropCaches) {
+        for (auto &[screen, cache] : caches) {
+            cache.invalidate(area);
+        }
+    }
+}
+
 void BlurEffect::slotWindowDeleted(EffectWindow *w)
 {
+    invalidateBackdropsUnder(w);
+    if (auto cacheIt = m_backdropCaches.find(w); cacheIt != m_backdropCaches.end()) {
+        effects->makeOpenGLContextCurrent();
+        m_backdropCaches.erase(cacheIt);
+        effects->doneOpenGLContextCurrent();
+    }
+
     auto it = windowBlurChangedConnections.find(w);
     if (it == windowBlurChangedConnections.end()) {
         return;
@@ -409,9 +479,20 @@ bool BlurEffect::supported()
         int maxTexSize;
         glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTexSize);
 
-        const QSize screenSize = effects->virtualScreenSize();
-        if (screenSize.width() > maxTexSize || screenSize.height() > maxTexSize) {
-            supported = false;
+        // The render targets are as large as a screen on Wayland, but cover the whole virtual screen on X11.
+        QVector<QSize> screenSizes;
+        if (effects->waylandDisplay()) {
+            const auto screens = effects->screens();
+            for (const EffectScreen *screen : screens) {
+                screenSizes.append(screen->geometry().size());
+            }
+        } else {
+            screenSizes.append(effects->virtualScreenSize());
+        }
+        for (const QSize &screenSize : std::as_const(screenSizes)) {
+            if (screenSize.width() > maxTexSize || screenSize.height() > maxTexSize) {
+                supported = false;
+            }
         }
     }
     return supported;
@@ -525,10 +606,87 @@ void BlurEffect::prePaintScreen(ScreenPrePaintData &data, std::chrono::milliseco
 {
     m_paintedArea = QRegion();
     m_currentBlur = QRegion();
+    m_currentScreen = effects->waylandDisplay() ? data.screen : nullptr;
+    m_currentFrame = ++m_screenFrames[m_currentScreen];
+    m_currentRenderData = ensureRenderData(m_currentScreen, effects->renderTargetRect().size());
 
     effects->prePaintScreen(data, presentTime);
 }
 
+int BlurEffect::backdropMargin() const
+{
+    // The final upsample pass reads a few pixels around every blurred pixel.
+    return m_offset + 2;
+}
+
+BlurEffect::BackdropCache &BlurEffect::backdropCache(EffectWindow *w)
+{
+    return m_backdropCaches[w][m_currentScreen];
+}
+
+QRegion BlurEffect::updateBackdropCache(EffectWindow *w, const QRegion &blurArea, const QRegion &expandedBlur)
+{
+    if (blurArea.isEmpty()) {
+        return QRegion();
+    }
+
+    const int margin = backdropMargin();
+    const QRect geometry = blurArea.boundingRect().adjusted(-margin, -margin, margin, margin);
+
+    // At this point m_paintedArea holds only what has been painted underneath the window.
+    return backdropCache(w).update(m_currentFrame, geometry, blurArea, m_paintedArea & expandedBlur, w->isDock(), m_expandSize);
+}
+
+static QRect downscaledRect(const QRect &rect, int divisionRatio)
+{
+    const int left = std::floor(rect.x() / qreal(divisionRatio));
+    const int top = std::floor(rect.y() / qreal(divisionRatio));
+    const int right = std::ceil((rect.x() + rect.width()) / qreal(divisionRatio));
+    const int bottom = std::ceil((rect.y() + rect.height()) / qreal(divisionRatio));
+    return QRect(left, top, right - left, bottom - top);
+}
+
+bool BlurEffect::ensureBackdropTexture(BackdropCache *cache, const QPoint &translation)
+{
+    const QRect textureRect = downscaledRect(cache->geometry.translated(translation), 2);
+    if (!cache->texture || cache->textureRect != textureRect) {
+        cache->framebuffer.reset();
+        cache->texture.reset(new GLTexture(m_renderTextureFormat, textureRect.size()));
+        cache->texture->setFilter(GL_NEAREST);
+        cache->texture->setWrapMode(GL_CLAMP_TO_EDGE);
+        cache->framebuffer.reset(new GLFramebuffer(cache->texture.get()));
+        cache->textureRect = textureRect;
+        cache->valid = QRegion();
+    }
+    return cache->framebuffer->valid();
+}
+
+void BlurEffect::saveBackdrop(const BlurRenderData &renderData, BackdropCache *cache, const QRegion &region, const QPoint &translation)
+{
+    const int margin = backdropMargin();
+
+    GLFramebuffer::pushFramebuffer(renderData.framebuffers[1].get());
+    for (const QRect &rect : region) {
+        const QRect source = downscaledRect(rect.adjusted(-margin, -margin, margin, margin).translated(translation), 2) & cache->textureRect;
+        if (!source.isEmpty()) {
+            cache->framebuffer->blitFromFramebuffer(source, source.translated(-cache->textureRect.topLeft()), GL_NEAREST);
+        }
+    }
+    GLFramebuffer::popFramebuffer();
+}
+
+void BlurEffect::restoreBackdrop(const BlurRenderData &renderData, BackdropCache *cache, const QRegion &region, const QPoint &translation)
+{
+    GLFramebuffer::pushFramebuffer(cache->framebuffer.get());
+    for (const QRect &rect : region) {
+        const QRect destination = downscaledRect(rect.translated(translation), 2) & cache->textureRect;
+        if (!destination.isEmpty()) {
+            renderData.framebuffers[1]->blitFromFramebuffer(destination.translated(-cache->textureRect.topLeft()), destination, GL_NEAREST);
+        }
+    }
+    GLFramebuffer::popFramebuffer();
+}
+
 void BlurEffect::prePaintWindow(EffectWindow *w, WindowPrePaintData &data, std::chrono::milliseconds presentTime)
 {
     // this effect relies on prePaintWindow being called in the bottom to top order
@@ -563,18 +721,23 @@ void BlurEffect::prePaintWindow(EffectWindow *w, WindowPrePaintData &data, std::
     const QRegion blurArea = blurRegion(w).translated(w->pos().toPoint()) & screen;
     const QRegion expandedBlur = (w->isDock() ? blurArea : expand(blurArea)) & screen;
 
+    // the parts of the blurred area whose cached backdrop is outdated have to be blurred
+    // again, which needs everything around them to be repainted
+    const QRegion staleBlur = updateBackdropCache(w, blurArea, expandedBlur);
+    const QRegion staleExpandedBlur = (w->isDock() ? staleBlur : expand(staleBlur)) & screen;
+
     // if this window or a window underneath the blurred area is painted again we have to
-    // blur everything
-    if (m_paintedArea.intersects(expandedBlur) || data.paint.intersects(blurArea)) {
-        data.paint |= expandedBlur;
+    // blur everything that is not cached
+    if (!staleBlur.isEmpty() && (m_paintedArea.intersects(expandedBlur) || data.paint.intersects(blurArea))) {
+        data.paint |= staleExpandedBlur;
         // we have to check again whether we do not damage a blurred area
         // of a window
-        if (expandedBlur.intersects(m_currentBlur)) {
+        if (staleExpandedBlur.intersects(m_currentBlur)) {
             data.paint |= m_currentBlur;
         }
     }
 
-    m_currentBlur |= expandedBlur;
+    m_currentBlur |= staleExpandedBlur;
 
     m_paintedArea -= data.opaque;
     m_paintedArea |= data.paint;
@@ -582,7 +745,7 @@ void BlurEffect::prePaintWindow(EffectWindow *w, WindowPrePaintData &data, std::
 
 bool BlurEffect::shouldBlur(const EffectWindow *w, int mask, const WindowPaintData &data) const
 {
-    if (!m_renderTargetsValid || !m_shader || !m_shader->isValid()) {
+    if (!m_currentRenderData || !m_currentRenderData->valid || !m_shader || !m_shader->isValid()) {
         return false;
     }
 
@@ -640,8 +803,19 @@ void BlurEffect::drawWindow(EffectWindow *w, int mask, const QRegion &region, Wi
         EffectWindow *modal = w->transientFor();
         const bool transientForIsDock = (modal ? modal->isDock() : false);
 
+        // The cached backdrop is only valid for the blurred area at its place on the screen.
+        BackdropCache *cache = nullptr;
+        if (!scaled && !translated) {
+            if (auto it = m_backdropCaches.find(w); it != m_backdropCaches.end()) {
+                auto cacheIt = it->second.find(m_currentScreen);
+                if (cacheIt != it->second.end() && cacheIt->second.frame == m_currentFrame) {
+                    cache = &cacheIt->second;
+                }
+            }
+        }
+
         if (!shape.isEmpty()) {
-            doBlur(shape, screen, data.opacity(), data.screenProjectionMatrix(), w->isDock() || transientForIsDock, w->frameGeometry().toRect());
+            doBlur(*m_currentRenderData, shape, screen, data.opacity(), data.screenProjectionMatrix(), w->isDock() || transientForIsDock, w->frameGeometry().toRect(), cache);
         }
     }
 
@@ -676,16 +850,22 @@ void BlurEffect::generateNoiseTexture()
     m_noiseTexture->setWrapMode(GL_REPEAT);
 }
 
-void BlurEffect::doBlur(const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect)
+void BlurEffect::doBlur(BlurRenderData &renderData, const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect, BackdropCache *cache)
 {
-    // Blur would not render correctly on a secondary monitor because of wrong coordinates
-    // BUG: 393723
+    // The render targets cover only the screen that is being painted
     const int xTranslate = -screen.x();
-    const int yTranslate = effects->virtualScreenSize().height() - screen.height() - screen.y();
+    const int yTranslate = renderData.textures.front()->height() - screen.height() - screen.y();
+    const QPoint translation(xTranslate, yTranslate);
 
-    const QRegion expandedBlurRegion = expand(shape) & expand(screen);
+    if (cache && !ensureBackdropTexture(cache, translation)) {
+        cache = nullptr;
+    }
 
-    const bool useSRGB = m_renderTextures.constFirst()->internalFormat() == GL_SRGB8_ALPHA8;
+    // Only the parts without an up to date cached backdrop have to go through the down and upsample passes
+    const QRegion freshShape = cache ? shape - cache->valid : shape;
+    const QRegion expandedBlurRegion = freshShape.isEmpty() ? QRegion() : expand(freshShape) & expand(screen);
+
+    const bool useSRGB = renderData.textures.front()->internalFormat() == GL_SRGB8_ALPHA8;
 
     // Upload geometry for the down and upsample iterations
     GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
@@ -694,43 +874,69 @@ void BlurEffect::doBlur(const QRegion &shape, const QRect &screen, const float o
     uploadGeometry(vbo, expandedBlurRegion.translated(xTranslate, yTranslate), shape);
     vbo->bindArrays();
 
-    const QRect sourceRect = expandedBlurRegion.boundingRect() & screen;
-    const QRect destRect = sourceRect.translated(xTranslate, yTranslate);
     int blurRectCount = expandedBlurRegion.rectCount() * 6;
 
-    /*
-     * If the window is a dock or panel we avoid the "extended blur" effect.
-     * Extended blur is when windows that are not under the blurred area affect
-     * the final blur result.
-     * We want to avoid this on panels, because it looks really weird and ugly
-     * when maximized windows or windows near the panel affect the dock blur.
-     */
-    if (isDock) {
-        m_renderTargets.last()->blitFromFramebuffer(effects->mapToRenderTarget(sourceRect), destRect);
-        GLFramebuffer::pushFramebuffers(m_renderTargetStack);
+    if (!freshShape.isEmpty()) {
+        const QRect sourceRect = expandedBlurRegion.boundingRect() & screen;
+        const QRect destRect = sourceRect.translated(xTranslate, yTranslate);
+
+        /*
+         * If the window is a dock or panel we avoid the "extended blur" effect.
+         * Extended blur is when windows that are not under the blurred area affect
+         * the final blur result.
+         * We want to avoid this on panels, because it looks really weird and ugly
+         * when maximized windows or windows near the panel affect the dock blur.
+         */
+        if (isDock) {
+            renderData.framebuffers.back()->blitFromFramebuffer(effects->mapToRenderTarget(sourceRect), destRect);
+            GLFramebuffer::pushFramebuffers(renderData.stack);
+
+            if (useSRGB) {
+                glEnable(GL_FRAMEBUFFER_SRGB);
+            }
 
-        if (useSRGB) {
-            glEnable(GL_FRAMEBUFFER_SRGB);
+            const QSize targetSize = renderData.textures.front()->size();
+            QMatrix4x4 mvp;
+            mvp.ortho(0, targetSize.width(), targetSize.height(), 0, 0, 65535);
+            copyScreenSampleTexture(renderData, vbo, blurRectCount, freshShape.translated(xTranslate, yTranslate), mvp);
+        } else {
+            renderData.framebuffers.front()->blitFromFramebuffer(effects->mapToRenderTarget(sourceRect), destRect);
+            GLFramebuffer::pushFramebuffers(renderData.stack);
+
+            if (useSRGB) {
+                glEnable(GL_FRAMEBUFFER_SRGB);
+            }
+
+            // Remove the first render target from the top of the stack that we will not use
+            GLFramebuffer::popFramebuffer();
         }
 
-        const QRect screenRect = effects->virtualScreenGeometry();
-        QMatrix4x4 mvp;
-        mvp.ortho(0, screenRect.width(), screenRect.height(), 0, 0, 65535);
-        copyScreenSampleTexture(vbo, blurRectCount, shape.translated(xTranslate, yTranslate), mvp);
-    } else {
-        m_renderTargets.first()->blitFromFramebuffer(effects->mapToRenderTarget(sourceRect), destRect);
-        GLFramebuffer::pushFramebuffers(m_renderTargetStack);
+        downSampleTexture(renderData, vbo, blurRectCount);
+        upSampleTexture(renderData, vbo, blurRectCount);
 
         if (useSRGB) {
-            glEnable(GL_FRAMEBUFFER_SRGB);
+            glDisable(GL_FRAMEBUFFER_SRGB);
         }
+    }
 
-        // Remove the m_renderTargets[0] from the top of the stack that we will not use
-        GLFramebuffer::popFramebuffer();
+    if (cache) {
+        // Keep the freshly blurred backdrop, and put the cached backdrop back into the render
+        // target for the parts of the window that didn't have to be blurred again.
+        if (!freshShape.isEmpty()) {
+            saveBackdrop(renderData, cache, freshShape, translation);
+            cache->valid |= freshShape;
+        }
+        const int margin = backdropMargin();
+        QRegion cachedShape;
+        for (const QRect &rect : shape - freshShape) {
+            cachedShape += rect.adjusted(-margin, -margin, margin, margin);
+        }
+        restoreBackdrop(renderData, cache, (cachedShape & cache->geometry) - freshShape, translation);
     }
 
-    downSampleTexture(vbo, blurRectCount);
-    upSampleTexture(vbo, blurRectCount);
+    if (useSRGB) {
+        glEnable(GL_FRAMEBUFFER_SRGB);
+    }
 
     // Modulate the blurred texture with the window opacity if the window isn't opaque
     if (opacity < 1.0) {
@@ -746,7 +952,7 @@ void BlurEffect::doBlur(const QRegion &shape, const QRect &screen, const float o
         glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
     }
 
-    upscaleRenderToScreen(vbo, blurRectCount * (m_downSampleIterations + 1), shape.rectCount() * 6, screenProjection, windowRect.topLeft());
+    upscaleRenderToScreen(renderData, vbo, blurRectCount * (m_downSampleIterations + 1), shape.rectCount() * 6, screenProjection, windowRect.topLeft());
 
     if (useSRGB) {
         glDisable(GL_FRAMEBUFFER_SRGB);
@@ -773,21 +979,21 @@ void BlurEffect::doBlur(const QRegion &shape, const QRect &screen, const float o
             // Add the shader's output directly to the pixels in framebuffer.
             glBlendFunc(GL_ONE, GL_ONE);
         }
-        applyNoise(vbo, blurRectCount * (m_downSampleIterations + 1), shape.rectCount() * 6, screenProjection, windowRect.topLeft());
+        applyNoise(renderData, vbo, blurRectCount * (m_downSampleIterations + 1), shape.rectCount() * 6, screenProjection, windowRect.topLeft());
         glDisable(GL_BLEND);
     }
 
     vbo->unbindArrays();
 }
 
-void BlurEffect::upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int blurRectCount, const QMatrix4x4 &screenProjection, QPoint windowPosition)
+void BlurEffect::upscaleRenderToScreen(const BlurRenderData &renderData, GLVertexBuffer *vbo, int vboStart, int blurRectCount, const QMatrix4x4 &screenProjection, QPoint windowPosition)
 {
     Q_UNUSED(windowPosition)
 
-    m_renderTextures[1]->bind();
+    renderData.textures[1]->bind();
 
     m_shader->bind(BlurShader::UpSampleType);
-    m_shader->setTargetTextureSize(m_renderTextures[0]->size() * effects->renderTargetScale());
+    m_shader->setTargetTextureSize(renderData.textures[0]->size() * effects->renderTargetScale());
 
     m_shader->setOffset(m_offset);
     m_shader->setModelViewProjectionMatrix(screenProjection);
@@ -797,10 +1003,10 @@ void BlurEffect::upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int bl
     m_shader->unbind();
 }
 
-void BlurEffect::applyNoise(GLVertexBuffer *vbo, int vboStart, int blurRectCount, const QMatrix4x4 &screenProjection, QPoint windowPosition)
+void BlurEffect::applyNoise(const BlurRenderData &renderData, GLVertexBuffer *vbo, int vboStart, int blurRectCount, const QMatrix4x4 &screenProjection, QPoint windowPosition)
 {
     m_shader->bind(BlurShader::NoiseSampleType);
-    m_shader->setTargetTextureSize(m_renderTextures[0]->size() * effects->renderTargetScale());
+    m_shader->setTargetTextureSize(renderData.textures[0]->size() * effects->renderTargetScale());
     m_shader->setNoiseTextureSize(m_noiseTexture->size() * effects->renderTargetScale());
     m_shader->setTexturePosition(windowPosition * effects->renderTargetScale());
 
@@ -813,7 +1019,7 @@ void BlurEffect::applyNoise(GLVertexBuffer *vbo, int vboStart, int blurRectCount
     m_shader->unbind();
 }
 
-void BlurEffect::downSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
+void BlurEffect::downSampleTexture(const BlurRenderData &renderData, GLVertexBuffer *vbo, int blurRectCount)
 {
     QMatrix4x4 modelViewProjectionMatrix;
 
@@ -822,13 +1028,13 @@ void BlurEffect::downSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
 
     for (int i = 1; i <= m_downSampleIterations; i++) {
         modelViewProjectionMatrix.setToIdentity();
-        modelViewProjectionMatrix.ortho(0, m_renderTextures[i]->width(), m_renderTextures[i]->height(), 0, 0, 65535);
+        modelViewProjectionMatrix.ortho(0, renderData.textures[i]->width(), renderData.textures[i]->height(), 0, 0, 65535);
 
         m_shader->setModelViewProjectionMatrix(modelViewProjectionMatrix);
-        m_shader->setTargetTextureSize(m_renderTextures[i]->size());
+        m_shader->setTargetTextureSize(renderData.textures[i]->size());
 
         // Copy the image from this texture
-        m_renderTextures[i - 1]->bind();
+        renderData.textures[i - 1]->bind();
 
         vbo->draw(GL_TRIANGLES, blurRectCount * i, blurRectCount);
         GLFramebuffer::popFramebuffer();
@@ -837,7 +1043,7 @@ void BlurEffect::downSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
     m_shader->unbind();
 }
 
-void BlurEffect::upSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
+void BlurEffect::upSampleTexture(const BlurRenderData &renderData, GLVertexBuffer *vbo, int blurRectCount)
 {
     QMatrix4x4 modelViewProjectionMatrix;
 
@@ -846,13 +1052,13 @@ void BlurEffect::upSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
 
     for (int i = m_downSampleIterations - 1; i >= 1; i--) {
         modelViewProjectionMatrix.setToIdentity();
-        modelViewProjectionMatrix.ortho(0, m_renderTextures[i]->width(), m_renderTextures[i]->height(), 0, 0, 65535);
+        modelViewProjectionMatrix.ortho(0, renderData.textures[i]->width(), renderData.textures[i]->height(), 0, 0, 65535);
 
         m_shader->setModelViewProjectionMatrix(modelViewProjectionMatrix);
-        m_shader->setTargetTextureSize(m_renderTextures[i]->size());
+        m_shader->setTargetTextureSize(renderData.textures[i]->size());
 
         // Copy the image from this texture
-        m_renderTextures[i + 1]->bind();
+        renderData.textures[i + 1]->bind();
 
         vbo->draw(GL_TRIANGLES, blurRectCount * i, blurRectCount);
         GLFramebuffer::popFramebuffer();
@@ -861,19 +1067,21 @@ void BlurEffect::upSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
     m_shader->unbind();
 }
 
-void BlurEffect::copyScreenSampleTexture(GLVertexBuffer *vbo, int blurRectCount, QRegion blurShape, const QMatrix4x4 &screenProjection)
+void BlurEffect::copyScreenSampleTexture(const BlurRenderData &renderData, GLVertexBuffer *vbo, int blurRectCount, QRegion blurShape, const QMatrix4x4 &screenProjection)
 {
+    const QSize targetSize = renderData.textures.front()->size();
+
     m_shader->bind(BlurShader::CopySampleType);
 
     m_shader->setModelViewProjectionMatrix(screenProjection);
-    m_shader->setTargetTextureSize(effects->virtualScreenSize());
+    m_shader->setTargetTextureSize(targetSize);
 
     /*
      * This '1' sized adjustment is necessary do avoid windows affecting the blur that are
      * right next to this window.
      */
-    m_shader->setBlurRect(blurShape.boundingRect().adjusted(1, 1, -1, -1), effects->virtualScreenSize());
-    m_renderTextures.last()->bind();
+    m_shader->setBlurRect(blurShape.boundingRect().adjusted(1, 1, -1, -1), targetSize);
+    renderData.textures.back()->bind();
 
     vbo->draw(GL_TRIANGLES, 0, blurRectCount);
     GLFramebuffer::popFramebuffer();
@@ -8,6 +8,8 @@
 #ifndef BLUR_H
 #define BLUR_H
 
+#include "blurbackdrop.h"
+
 #include <kwineffects.h>
 #include <kwinglplatform.h>
 #include <kwinglutils.h>
@@ -16,6 +18,8 @@
 #include <QVector2D>
 #include <QVector>
 
+#include <map>
+
 namespace KWaylandServer
 {
 class BlurManagerInterface;
@@ -61,36 +65,68 @@ public Q_SLOTS:
     void slotWindowDeleted(KWin::EffectWindow *w);
     void slotPropertyNotify(KWin::EffectWindow *w, long atom);
     void slotScreenGeometryChanged();
+    void slotScreenRemoved(KWin::EffectScreen *screen);
     void setupDecorationConnections(EffectWindow *w);
 
 private:
+    /**
+     * The render targets for the down and upsample passes of one screen. They're as large as
+     * the screen rather than the whole virtual screen because every screen is painted separately.
+     */
+    struct BlurRenderData
+    {
+        std::vector<std::unique_ptr<GLTexture>> textures;
+        std::vector<std::unique_ptr<GLFramebuffer>> framebuffers;
+        QStack<GLFramebuffer *> stack;
+        bool valid = false;
+    };
+
+    /**
+     * The blurred backdrop of a window, i.e. the contents of the second blur render target
+     * for the blurred area of the window. As long as nothing underneath the window changes,
+     * the backdrop can be reused instead of running all the down and upsample passes again.
+     */
+    struct BackdropCache : BackdropRegion
+    {
+        std::unique_ptr<GLTexture> texture;
+        std::unique_ptr<GLFramebuffer> framebuffer;
+        QRect textureRect; // the area in the render target that the texture corresponds to
+    };
+
     QRect expand(const QRect &rect) const;
     QRegion expand(const QRegion &region) const;
-    bool renderTargetsValid() const;
-    void deleteFBOs();
     void initBlurStrengthValues();
     void updateTexture();
+    BlurRenderData *ensureRenderData(EffectScreen *screen, const QSize &size);
     QRegion blurRegion(const EffectWindow *w) const;
     QRegion decorationBlurRegion(const EffectWindow *w) const;
     bool decorationSupportsBlurBehind(const EffectWindow *w) const;
     bool shouldBlur(const EffectWindow *w, int mask, const WindowPaintData &data) const;
     void updateBlurRegion(EffectWindow *w) const;
-    void doBlur(const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect);
+    int backdropMargin() const;
+    BackdropCache &backdropCache(EffectWindow *w);
+    void invalidateBackdrops();
+    void invalidateBackdropsUnder(EffectWindow *w);
+    QRegion updateBackdropCache(EffectWindow *w, const QRegion &blurArea, const QRegion &expandedBlur);
+    bool ensureBackdropTexture(BackdropCache *cache, const QPoint &translation);
+    void saveBackdrop(const BlurRenderData &renderData, BackdropCache *cache, const QRegion &region, const QPoint &translation);
+    void restoreBackdrop(const BlurRenderData &renderData, BackdropCache *cache, const QRegion &region, const QPoint &translation);
+    void doBlur(BlurRenderData &renderData, const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect, BackdropCache *cache);
     void uploadRegion(QVector2D *&map, const QRegion &region, const int downSampleIterations);
     void uploadGeometry(GLVertexBuffer *vbo, const QRegion &blurRegion, const QRegion &windowRegion);
     void generateNoiseTexture();
 
-    void upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int blurRectCount, const QMatrix4x4 &screenProjection, QPoint windowPosition);
-    void applyNoise(GLVertexBuffer *vbo, int vboStart, int blurRectCount, const QMatrix4x4 &screenProjection, QPoint windowPosition);
-    void downSampleTexture(GLVertexBuffer *vbo, int blurRectCount);
-    void upSampleTexture(GLVertexBuffer *vbo, int blurRectCount);
-    void copyScreenSampleTexture(GLVertexBuffer *vbo, int blurRectCount, QRegion blurShape, const QMatrix4x4 &screenProjection);
+    void upscaleRenderToScreen(const BlurRenderData &renderData, GLVertexBuffer *vbo, int vboStart, int blurRectCount, const QMatrix4x4 &screenProjection, QPoint windowPosition);
+    void applyNoise(const BlurRenderData &renderData, GLVertexBuffer *vbo, int vboStart, int blurRectCount, const QMatrix4x4 &screenProjection, QPoint windowPosition);
+    void downSampleTexture(const BlurRenderData &renderData, GLVertexBuffer *vbo, int blurRectCount);
+    void upSampleTexture(const BlurRenderData &renderData, GLVertexBuffer *vbo, int blurRectCount);
+    void copyScreenSampleTexture(const BlurRenderData &renderData, GLVertexBuffer *vbo, int blurRectCount, QRegion blurShape, const QMatrix4x4 &screenProjection);
 
 private:
     BlurShader *m_shader;
-    QVector<GLFramebuffer *> m_renderTargets;
-    QVector<GLTexture *> m_renderTextures;
-    QStack<GLFramebuffer *> m_renderTargetStack;
+    std::map<EffectScreen *, BlurRenderData> m_renderData;
+    BlurRenderData *m_currentRenderData = nullptr;
+    GLenum m_renderTextureFormat = GL_RGBA8;
 
     std::unique_ptr<GLTexture> m_noiseTexture;
 
@@ -99,6 +135,11 @@ private:
     QRegion m_paintedArea; // keeps track of all painted areas (from bottom to top)
     QRegion m_currentBlur; // keeps track of the currently blured area of the windows(from bottom to top)
 
+    EffectScreen *m_currentScreen = nullptr;
+    quint64 m_currentFrame = 0;
+    std::map<EffectScreen *, quint64> m_screenFrames;
+    std::map<EffectWindow *, std::map<EffectScreen *, BackdropCache>> m_backdropCaches;
+
     int m_downSampleIterations; // number of times the texture will be downsized to half size
     int m_offset;
     int m_expandSize;
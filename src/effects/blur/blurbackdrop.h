@@ -0,0 +1,80 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QRegion>
+
+namespace KWin
+{
+
+/**
+ * The BackdropRegion class keeps track of the parts of the cached blurred backdrop of a window
+ * that are still up to date.
+ */
+class BackdropRegion
+{
+public:
+    /**
+     * Starts the frame @p frame and returns the parts of @p blurArea that have to be blurred
+     * again. The @p geometry is the area of the screen that is cached.
+     *
+     * Only what has been painted underneath the blurred window may be passed as the damage.
+     * The window itself and the windows above it are drawn on top of the backdrop, so their
+     * damage doesn't change it.
+     */
+    QRegion update(quint64 frame, const QRect &geometry, const QRegion &blurArea, const QRegion &damageUnderneath, bool isDock, int expandSize)
+    {
+        // If the window has not been painted in the previous frame, the changes underneath it
+        // went unnoticed and the cached backdrop can't be trusted.
+        if (this->geometry != geometry || this->frame + 1 != frame) {
+            this->geometry = geometry;
+            valid = QRegion();
+        }
+        this->frame = frame;
+
+        // Something that is painted underneath the window affects the blurred pixels around it.
+        if (!damageUnderneath.isEmpty()) {
+            if (isDock) {
+                valid -= damageUnderneath;
+            } else {
+                for (const QRect &rect : damageUnderneath) {
+                    valid -= rect.adjusted(-expandSize, -expandSize, expandSize, expandSize);
+                }
+            }
+        }
+        valid &= blurArea;
+
+        // The blur of docks is clamped to the blurred area, so it can't be updated piecewise.
+        if (isDock && valid != blurArea) {
+            valid = QRegion();
+        }
+
+        return blurArea - valid;
+    }
+
+    /**
+     * Drops the cached backdrop if it overlaps @p area. It's used for the changes underneath
+     * the window that are not painted by a window, e.g. a window that has been closed.
+     */
+    void invalidate(const QRect &area)
+    {
+        if (geometry.intersects(area)) {
+            valid = QRegion();
+        }
+    }
+
+    void invalidate()
+    {
+        valid = QRegion();
+    }
+
+    QRect geometry; // the area of the screen that is cached
+    QRegion valid; // the parts of the blurred area that have an up to date backdrop
+    quint64 frame = 0;
+};
+
+} // namespace KWin
@@ -77,8 +77,8 @@ void OutputLocatorEffect::show()
         QRectF geometry(0, 0, scene->rootItem()->implicitWidth(), scene->rootItem()->implicitHeight());
         geometry.moveCenter(screen->geometry().center());
         scene->setGeometry(geometry.toRect());
-        connect(scene, &OffscreenQuickView::repaintNeeded, this, [scene] {
-            effects->addRepaint(scene->geometry());
+        connect(scene, &OffscreenQuickView::repaintNeeded, this, [scene](const QRegion &damage) {
+            effects->addRepaint(damage.translated(scene->geometry().topLeft()));
         });
         m_scenesByScreens.insert(screen, scene);
     }
@@ -48,6 +48,7 @@
 #include "wayland/surface_interface.h"
 #include "wayland/tablet_v2_interface.h"
 #include "wayland_server.h"
+#include "windowspatialindex.h"
 #include "workspace.h"
 #include "xwayland/xwayland_interface.h"
 
@@ -2644,6 +2645,8 @@ void InputRedirection::init()
 
 void InputRedirection::setupWorkspace()
 {
+    m_windowIndex = new WindowSpatialIndex(this);
+
     if (waylandServer()) {
         m_keyboard->init();
         m_pointer->init();
@@ -3237,25 +3240,14 @@ Window *InputRedirection::findToplevel(const QPointF &pos)
 
 Window *InputRedirection::findManagedToplevel(const QPointF &pos)
 {
-    if (!Workspace::self()) {
+    if (!Workspace::self() || !m_windowIndex) {
         return nullptr;
     }
     const bool isScreenLocked = waylandServer() && waylandServer()->isScreenLocked();
-    const QList<Window *> &stacking = Workspace::self()->stackingOrder();
-    if (stacking.isEmpty()) {
-        return nullptr;
-    }
-    auto it = stacking.end();
-    do {
-        --it;
-        Window *window = (*it);
-        if (window->isDeleted()) {
-            // a deleted window doesn't get mouse events
-            continue;
-        }
-        if (!window->isOnCurrentActivity() || !window->isOnCurrentDesktop() || window->isMinimized() || window->isHiddenInternal()) {
-            continue;
-        }
+    // The index only contains the windows on the current desktop and activity that are
+    // neither minimized nor hidden, ordered from the topmost to the bottommost one.
+    const QVector<Window *> windows = m_windowIndex->windowsAt(pos);
+    for (Window *window : windows) {
         if (!window->readyForPainting()) {
             continue;
         }
@@ -3267,7 +3259,7 @@ Window *InputRedirection::findManagedToplevel(const QPointF &pos)
         if (window->hitTest(pos)) {
             return window;
         }
-    } while (it != stacking.begin());
+    }
     return nullptr;
 }
 
@@ -42,6 +42,7 @@ class PointerInputRedirection;
 class TabletInputRedirection;
 class TouchInputRedirection;
 class WindowSelectorFilter;
+class WindowSpatialIndex;
 class SwitchEvent;
 class TabletEvent;
 class TabletToolId;
@@ -337,6 +338,7 @@ private:
     QList<IdleDetector *> m_idleDetectors;
     QList<Window *> m_idleInhibitors;
     WindowSelectorFilter *m_windowSelector = nullptr;
+    WindowSpatialIndex *m_windowIndex = nullptr;
 
     QVector<InputEventFilter *> m_filters;
     QVector<InputEventSpy *> m_spies;
@@ -337,7 +337,10 @@ WindowQuadList Item::buildQuads() const
 
 void Item::discardQuads()
 {
-    m_quads.reset();
+    if (m_quads.has_value()) {
+        m_quads.reset();
+        Q_EMIT quadsChanged();
+    }
 }
 
 WindowQuadList Item::quads() const
@@ -121,6 +121,11 @@ Q_SIGNALS:
      * has changed.
      */
     void boundingRectChanged();
+    /**
+     * This signal is emitted when the previously built quads of this item have been
+     * discarded, e.g. because the size or the shape of the item has changed.
+     */
+    void quadsChanged();
 
 protected:
     virtual WindowQuadList buildQuads() const;
@@ -82,6 +82,13 @@ bool AnimationEffect::isActive() const
     return !d->m_animations.isEmpty() && !effects->isScreenLocked();
 }
 
+bool AnimationEffect::isInterestedInWindow(const EffectWindow *w) const
+{
+    Q_D(const AnimationEffect);
+    // Only animated windows are affected by the window hooks.
+    return d->m_animations.contains(const_cast<EffectWindow *>(w));
+}
+
 #define RELATIVE_XY(_FIELD_) const bool relative[2] = {static_cast<bool>(metaData(Relative##_FIELD_##X, meta)), \
                                                        static_cast<bool>(metaData(Relative##_FIELD_##Y, meta))}
 
@@ -222,6 +229,7 @@ quint64 AnimationEffect::p_animate(EffectWindow *w, Attribute a, uint meta, int
     AniMap::iterator it = d->m_animations.find(w);
     if (it == d->m_animations.end()) {
         it = d->m_animations.insert(w, QPair<QList<AniData>, QRect>(QList<AniData>(), QRect()));
+        effects->windowInterestChanged();
     }
 
     FullScreenEffectLockPtr fullscreen;
@@ -415,6 +423,7 @@ bool AnimationEffect::cancel(quint64 animationId)
                 entry->first.erase(anim); // remove the animation
                 if (entry->first.isEmpty()) { // no other animations on the window, release it.
                     d->m_animations.erase(entry);
+                    effects->windowInterestChanged();
                 }
                 if (d->m_animations.isEmpty()) {
                     disconnectGeometryChanges();
@@ -700,6 +709,7 @@ void AnimationEffect::postPaintScreen()
         if (entry->first.isEmpty()) {
             effects->addRepaint(entry->second);
             entry = d->m_animations.erase(entry);
+            effects->windowInterestChanged();
         } else {
             if (invalidateLayerRect) {
                 *const_cast<QRect *>(&(entry->second)) = QRect(); // invalidate
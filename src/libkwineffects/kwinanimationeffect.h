@@ -294,6 +294,7 @@ public:
     ~AnimationEffect() override;
 
     bool isActive() const override;
+    bool isInterestedInWindow(const EffectWindow *w) const override;
 
     /**
      * Gets stored metadata.
@@ -665,6 +665,12 @@ bool Effect::blocksDirectScanout() const
     return true;
 }
 
+bool Effect::isInterestedInWindow(const EffectWindow *w) const
+{
+    Q_UNUSED(w)
+    return true;
+}
+
 //****************************************
 // EffectFactory
 //****************************************
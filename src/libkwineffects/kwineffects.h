@@ -158,7 +158,7 @@ typedef QList<KWin::EffectWindow *> EffectWindowList;
 
 #define KWIN_EFFECT_API_MAKE_VERSION(major, minor) ((major) << 8 | (minor))
 #define KWIN_EFFECT_API_VERSION_MAJOR 0
-#define KWIN_EFFECT_API_VERSION_MINOR 235
+#define KWIN_EFFECT_API_VERSION_MINOR 237
 #define KWIN_EFFECT_API_VERSION KWIN_EFFECT_API_MAKE_VERSION( \
     KWIN_EFFECT_API_VERSION_MAJOR, KWIN_EFFECT_API_VERSION_MINOR)
 
@@ -653,6 +653,19 @@ public:
      */
     virtual bool blocksDirectScanout() const;
 
+    /**
+     * Reimplement this method to return @c false for the windows that the effect doesn't change.
+     * The window hooks, i.e. prePaintWindow(), paintWindow(), drawWindow() and postPaintWindow(),
+     * of the effect are not called for such windows.
+     *
+     * The result is cached, call EffectsHandler::windowInterestChanged() whenever the set of
+     * windows the effect is interested in changes. The change takes effect in the next frame.
+     *
+     * The default implementation returns @c true.
+     * @since 5.26
+     */
+    virtual bool isInterestedInWindow(const EffectWindow *w) const;
+
 public Q_SLOTS:
     virtual bool borderActivated(ElectricBorder border);
 
@@ -1239,6 +1252,14 @@ public:
      */
     virtual bool isScreenLocked() const = 0;
 
+    /**
+     * Notifies that the windows that an effect is interested in have changed.
+     *
+     * @see Effect::isInterestedInWindow
+     * @since 5.26
+     */
+    virtual void windowInterestChanged() = 0;
+
     /**
      * @brief Makes the OpenGL compositing context current.
      *
@@ -13,6 +13,7 @@
 #include <QCoreApplication>
 #include <QImage>
 #include <QPoint>
+#include <QRegion>
 #include <QVariant>
 
 #include <kwin_export.h>
@@ -227,6 +228,22 @@ inline KWIN_EXPORT QRect infiniteRegion()
     return QRect(INT_MIN / 2, INT_MIN / 2, INT_MAX, INT_MAX);
 }
 
+/**
+ * Returns the @p region scaled by the given @p scale factor. Each rectangle is expanded to
+ * whole pixels, so the result covers at least the scaled area of the @p region.
+ */
+inline KWIN_EXPORT QRegion scaledRegion(const QRegion &region, qreal scale)
+{
+    if (scale == 1) {
+        return region;
+    }
+    QRegion scaled;
+    for (const QRect &rect : region) {
+        scaled += QRectF(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale).toAlignedRect();
+    }
+    return scaled;
+}
+
 } // namespace
 
 Q_DECLARE_METATYPE(std::chrono::nanoseconds)
@@ -0,0 +1,236 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwinglprogramcache_p.h"
+
+#include "kwinglplatform.h"
+#include "kwinglutils.h"
+#include "logging_p.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace KWin
+{
+
+// Every file starts with the magic followed by the binary format of the program.
+static const QByteArray s_magic = QByteArrayLiteral("KWP1");
+static const int s_headerSize = 4 + sizeof(GLenum);
+
+// The directories of other drivers are removed once there are more than s_maxDriverCount
+// directories or when they haven't been used for s_maxUnusedDays.
+static const QString s_stampFileName = QStringLiteral("last-used");
+static const size_t s_maxDriverCount = 4;
+static const int s_maxUnusedDays = 30;
+
+bool GLProgramCache::s_supported = false;
+bool GLProgramCache::s_useOES = false;
+QString GLProgramCache::s_directory;
+
+void GLProgramCache::initStatic()
+{
+    s_supported = false;
+    if (qEnvironmentVariableIsSet("KWIN_GL_NO_PROGRAM_CACHE")) {
+        return;
+    }
+
+    GLPlatform *platform = GLPlatform::instance();
+    if (platform->isGLES()) {
+        if (hasGLVersion(3, 0)) {
+            s_useOES = false;
+        } else if (hasGLExtension(QByteArrayLiteral("GL_OES_get_program_binary"))) {
+            s_useOES = true;
+        } else {
+            return;
+        }
+    } else if (hasGLVersion(4, 1) || hasGLExtension(QByteArrayLiteral("GL_ARB_get_program_binary"))) {
+        s_useOES = false;
+    } else {
+        return;
+    }
+
+    // Some drivers implement the extension without supporting any binary format.
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount <= 0) {
+        return;
+    }
+
+    const QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    if (cacheLocation.isEmpty()) {
+        return;
+    }
+
+    QCryptographicHash driverHash(QCryptographicHash::Sha1);
+    driverHash.addData(platform->glVendorString());
+    driverHash.addData(platform->glRendererString());
+    driverHash.addData(platform->glVersionString());
+    driverHash.addData(platform->glShadingLanguageVersionString());
+    const QString driver = QString::fromLatin1(driverHash.result().toHex());
+
+    const QString programsLocation = cacheLocation + QLatin1String("/kwin/glprograms");
+    s_directory = programsLocation + QLatin1Char('/') + driver;
+    if (!QDir().mkpath(s_directory)) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to create the program cache directory" << s_directory;
+        return;
+    }
+    markUsed();
+    removeStaleDirectories(driver);
+
+    s_supported = true;
+}
+
+void GLProgramCache::cleanup()
+{
+    s_supported = false;
+    s_directory.clear();
+}
+
+bool GLProgramCache::isSupported()
+{
+    return s_supported;
+}
+
+QByteArray GLProgramCache::key(const QByteArray &vertexSource, const QByteArray &fragmentSource, const QByteArray &bindings)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(vertexSource);
+    hash.addData(QByteArrayLiteral("\0"));
+    hash.addData(fragmentSource);
+    hash.addData(QByteArrayLiteral("\0"));
+    hash.addData(bindings);
+    return hash.result().toHex();
+}
+
+bool GLProgramCache::load(GLuint program, const QByteArray &key)
+{
+    QFile file(filePath(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    file.close();
+    if (data.size() <= s_headerSize || !data.startsWith(s_magic)) {
+        file.remove();
+        return false;
+    }
+
+    GLenum format;
+    std::memcpy(&format, data.constData() + s_magic.size(), sizeof(format));
+    if (s_useOES) {
+        glProgramBinaryOES(program, format, data.constData() + s_headerSize, data.size() - s_headerSize);
+    } else {
+        glProgramBinary(program, format, data.constData() + s_headerSize, data.size() - s_headerSize);
+    }
+
+    // The driver rejects binaries that it can't use anymore, e.g. after an update that
+    // doesn't change the version string. Drop them so they are replaced.
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (!status) {
+        qCDebug(LIBKWINGLUTILS) << "Discarding the cached program" << key;
+        file.remove();
+        return false;
+    }
+    return true;
+}
+
+void GLProgramCache::prepare(GLuint program)
+{
+    // The OES extension has no hint, the binaries are always retrievable there.
+    if (!s_useOES) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+void GLProgramCache::store(GLuint program, const QByteArray &key)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    QByteArray data(s_headerSize + length, Qt::Uninitialized);
+    GLenum format = 0;
+    GLsizei written = 0;
+    if (s_useOES) {
+        glGetProgramBinaryOES(program, length, &written, &format, data.data() + s_headerSize);
+    } else {
+        glGetProgramBinary(program, length, &written, &format, data.data() + s_headerSize);
+    }
+    if (written <= 0) {
+        return;
+    }
+    data.resize(s_headerSize + written);
+    std::memcpy(data.data(), s_magic.constData(), s_magic.size());
+    std::memcpy(data.data() + s_magic.size(), &format, sizeof(format));
+
+    // Other processes may store the same program, replace the file atomically.
+    QSaveFile file(filePath(key));
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to store the program" << key << file.errorString();
+    }
+}
+
+QString GLProgramCache::filePath(const QByteArray &key)
+{
+    return s_directory + QLatin1Char('/') + QString::fromLatin1(key);
+}
+
+QDateTime GLProgramCache::lastUsed(const QString &directory)
+{
+    const QFileInfo stamp(directory + QLatin1Char('/') + s_stampFileName);
+    if (stamp.exists()) {
+        return stamp.lastModified();
+    }
+    return QFileInfo(directory).lastModified();
+}
+
+void GLProgramCache::markUsed()
+{
+    QFile stamp(s_directory + QLatin1Char('/') + s_stampFileName);
+    if (!stamp.open(QIODevice::WriteOnly) || !stamp.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime)) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to update" << stamp.fileName() << stamp.errorString();
+    }
+}
+
+void GLProgramCache::removeStaleDirectories(const QString &current)
+{
+    // Several drivers can be in use, e.g. on hybrid graphics laptops or on systems where the
+    // user switches between drivers, so keep the binaries of the recently used ones.
+    QDir programsDirectory(QFileInfo(s_directory).path());
+    const QStringList entries = programsDirectory.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+
+    std::vector<std::pair<QDateTime, QString>> others;
+    for (const QString &entry : entries) {
+        if (entry != current) {
+            const QString path = programsDirectory.filePath(entry);
+            others.emplace_back(lastUsed(path), path);
+        }
+    }
+    std::sort(others.begin(), others.end(), [](const auto &a, const auto &b) {
+        return a.first > b.first;
+    });
+
+    const QDateTime expiry = QDateTime::currentDateTime().addDays(-s_maxUnusedDays);
+    for (size_t i = 0; i < others.size(); ++i) {
+        if (i + 1 >= s_maxDriverCount || others[i].first < expiry) {
+            QDir(others[i].second).removeRecursively();
+        }
+    }
+}
+
+} // namespace KWin
@@ -0,0 +1,65 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <epoxy/gl.h>
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QString>
+
+namespace KWin
+{
+
+/**
+ * The GLProgramCache class stores the binaries of linked programs on disk, so they don't
+ * have to be compiled again the next time they are created.
+ *
+ * The binaries are only valid for the driver that produced them. They are stored in a
+ * directory that is specific to the vendor, renderer and version of the driver. The
+ * directories of other drivers are kept for a while, in case they're used again, and
+ * removed once they're unused for long or there are too many of them.
+ *
+ * The cache can be disabled by setting the KWIN_GL_NO_PROGRAM_CACHE environment variable.
+ */
+class GLProgramCache
+{
+public:
+    static void initStatic();
+    static void cleanup();
+
+    static bool isSupported();
+
+    /**
+     * Returns the key of the program that is linked from the given sources, @p bindings
+     * must describe the attribute and fragment data locations bound before linking it.
+     */
+    static QByteArray key(const QByteArray &vertexSource, const QByteArray &fragmentSource, const QByteArray &bindings);
+
+    /**
+     * Loads the binary of the program @p key into @p program, returns @c false if it is
+     * not in the cache or the driver rejected it.
+     */
+    static bool load(GLuint program, const QByteArray &key);
+    /**
+     * Prepares @p program for being stored, it must be called before the program is linked.
+     */
+    static void prepare(GLuint program);
+    static void store(GLuint program, const QByteArray &key);
+
+private:
+    static QString filePath(const QByteArray &key);
+    static QDateTime lastUsed(const QString &directory);
+    static void markUsed();
+    static void removeStaleDirectories(const QString &current);
+
+    static bool s_supported;
+    static bool s_useOES;
+    static QString s_directory;
+};
+
+} // namespace KWin
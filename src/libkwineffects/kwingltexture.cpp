@@ -16,6 +16,7 @@
 #include "kwinglutils_funcs.h"
 
 #include "kwingltexture_p.h"
+#include "kwinpixelconversion_p.h"
 
 #include <QImage>
 #include <QPixmap>
@@ -364,6 +365,39 @@ void GLTexture::setSize(const QSize &size)
     d->updateMatrix();
 }
 
+static QImage::Format uploadParameters(QImage::Format format, GLenum *glFormat, GLenum *type)
+{
+    if (!GLPlatform::instance()->isGLES()) {
+        if (format < sizeof(formatTable) / sizeof(formatTable[0]) && formatTable[format].internalFormat
+            && !(formatTable[format].type == GL_UNSIGNED_SHORT && !GLTexturePrivate::s_supportsTexture16Bit)) {
+            *glFormat = formatTable[format].format;
+            *type = formatTable[format].type;
+            return format;
+        } else {
+            *glFormat = GL_BGRA;
+            *type = GL_UNSIGNED_INT_8_8_8_8_REV;
+            return QImage::Format_ARGB32_Premultiplied;
+        }
+    } else {
+        if (GLTexturePrivate::s_supportsARGB32) {
+            *glFormat = GL_BGRA_EXT;
+            *type = GL_UNSIGNED_BYTE;
+            return QImage::Format_ARGB32_Premultiplied;
+        } else {
+            *glFormat = GL_RGBA;
+            *type = GL_UNSIGNED_BYTE;
+            return QImage::Format_RGBA8888_Premultiplied;
+        }
+    }
+}
+
+QImage::Format GLTexture::uploadFormat(QImage::Format format)
+{
+    GLenum glFormat;
+    GLenum type;
+    return uploadParameters(format, &glFormat, &type);
+}
+
 void GLTexture::update(const QImage &image, const QPoint &offset, const QRect &src)
 {
     if (image.isNull() || isNull()) {
@@ -373,33 +407,21 @@ void GLTexture::update(const QImage &image, const QPoint &offset, const QRect &s
     Q_D(GLTexture);
     Q_ASSERT(!d->m_foreign);
 
-    GLenum glFormat;
-    GLenum type;
-    QImage::Format uploadFormat;
-    if (!GLPlatform::instance()->isGLES()) {
-        const QImage::Format index = image.format();
-
-        if (index < sizeof(formatTable) / sizeof(formatTable[0]) && formatTable[index].internalFormat
-            && !(formatTable[index].type == GL_UNSIGNED_SHORT && !d->s_supportsTexture16Bit)) {
-            glFormat = formatTable[index].format;
-            type = formatTable[index].type;
-            uploadFormat = index;
-        } else {
-            glFormat = GL_BGRA;
-            type = GL_UNSIGNED_INT_8_8_8_8_REV;
-            uploadFormat = QImage::Format_ARGB32_Premultiplied;
-        }
-    } else {
-        if (d->s_supportsARGB32) {
-            glFormat = GL_BGRA_EXT;
-            type = GL_UNSIGNED_BYTE;
-            uploadFormat = QImage::Format_ARGB32_Premultiplied;
-        } else {
-            glFormat = GL_RGBA;
-            type = GL_UNSIGNED_BYTE;
-            uploadFormat = QImage::Format_RGBA8888_Premultiplied;
+    // Damage mapped from the surface to the buffer can extend past the image, only the part
+    // of it that lies within the image is uploaded.
+    QRect rect = image.rect();
+    QPoint destination = offset;
+    if (!src.isNull()) {
+        rect = src & image.rect();
+        if (rect.isEmpty()) {
+            return;
         }
+        destination += rect.topLeft() - src.topLeft();
     }
+
+    GLenum glFormat;
+    GLenum type;
+    const QImage::Format uploadFormat = uploadParameters(image.format(), &glFormat, &type);
     bool useUnpack = d->s_supportsUnpack && image.format() == uploadFormat && !src.isNull();
 
     QImage im;
@@ -407,29 +429,29 @@ void GLTexture::update(const QImage &image, const QPoint &offset, const QRect &s
         im = image;
         Q_ASSERT(im.depth() % 8 == 0);
         glPixelStorei(GL_UNPACK_ROW_LENGTH, im.bytesPerLine() / (im.depth() / 8));
-        glPixelStorei(GL_UNPACK_SKIP_PIXELS, src.x());
-        glPixelStorei(GL_UNPACK_SKIP_ROWS, src.y());
-    } else {
-        if (src.isNull()) {
+        glPixelStorei(GL_UNPACK_SKIP_PIXELS, rect.x());
+        glPixelStorei(GL_UNPACK_SKIP_ROWS, rect.y());
+    } else if (image.format() != uploadFormat && PixelConversion::canConvert(image.format(), uploadFormat)) {
+        // Convert only the pixels that are going to be uploaded, without an intermediate copy.
+        im = QImage(rect.size(), uploadFormat);
+        if (!PixelConversion::convert(image, rect, uploadFormat, im.bits(), im.bytesPerLine())) {
+            im = QImage();
+        }
+    }
+    if (im.isNull()) {
+        if (rect == image.rect()) {
             im = image;
         } else {
-            im = image.copy(src);
+            im = image.copy(rect);
         }
         if (im.format() != uploadFormat) {
             im.convertTo(uploadFormat);
         }
     }
 
-    int width = image.width();
-    int height = image.height();
-    if (!src.isNull()) {
-        width = src.width();
-        height = src.height();
-    }
-
     bind();
 
-    glTexSubImage2D(d->m_target, 0, offset.x(), offset.y(), width, height, glFormat, type, im.constBits());
+    glTexSubImage2D(d->m_target, 0, destination.x(), destination.y(), rect.width(), rect.height(), glFormat, type, im.constBits());
 
     unbind();
 
@@ -440,6 +462,26 @@ void GLTexture::update(const QImage &image, const QPoint &offset, const QRect &s
     }
 }
 
+void GLTexture::update(const QRect &rect, QImage::Format format, intptr_t offset)
+{
+    if (isNull() || rect.isEmpty()) {
+        return;
+    }
+
+    Q_D(GLTexture);
+    Q_ASSERT(!d->m_foreign);
+
+    GLenum glFormat;
+    GLenum type;
+    const QImage::Format uploadFormat = uploadParameters(format, &glFormat, &type);
+    Q_ASSERT(uploadFormat == format);
+    Q_UNUSED(uploadFormat)
+
+    bind();
+    glTexSubImage2D(d->m_target, 0, rect.x(), rect.y(), rect.width(), rect.height(), glFormat, type, reinterpret_cast<const void *>(offset));
+    unbind();
+}
+
 void GLTexture::discard()
 {
     d_ptr = new GLTexturePrivate();
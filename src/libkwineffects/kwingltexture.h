@@ -99,6 +99,16 @@ public:
     QMatrix4x4 matrix(TextureCoordinateType type) const;
 
     void update(const QImage &image, const QPoint &offset = QPoint(0, 0), const QRect &src = QRect());
+    /**
+     * Updates the given @a rect of the texture with pixels from the buffer object that is
+     * currently bound to GL_PIXEL_UNPACK_BUFFER, starting at the given @a offset in the buffer.
+     *
+     * The pixels must be in the given @a format, which has to be a format returned by
+     * uploadFormat(). Rows must be tightly packed and aligned to 4 bytes.
+     *
+     * @see GLPixelUnpackBuffer
+     */
+    void update(const QRect &rect, QImage::Format format, intptr_t offset);
     virtual void discard();
     void bind();
     void unbind();
@@ -128,6 +138,12 @@ public:
 
     static bool framebufferObjectSupported();
 
+    /**
+     * Returns the format to which images in the given @a format are converted before
+     * they are uploaded to a texture.
+     */
+    static QImage::Format uploadFormat(QImage::Format format);
+
     /**
      * Returns true if texture swizzle is supported, and false otherwise
      *
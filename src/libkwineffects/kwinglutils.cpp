@@ -12,6 +12,7 @@
 
 // need to call GLTexturePrivate::initStatic()
 #include "kwingltexture_p.h"
+#include "kwinglprogramcache_p.h"
 
 #include "kwineffects.h"
 #include "kwinglplatform.h"
@@ -154,6 +155,9 @@ void initGL(const std::function<resolveFuncPtr(const char *)> &resolveFunction)
     GLTexturePrivate::initStatic();
     GLFramebuffer::initStatic();
     GLVertexBuffer::initStatic();
+    GLTimerQuery::initStatic();
+    GLPixelUnpackBuffer::initStatic();
+    GLProgramCache::initStatic();
 }
 
 void cleanupGL()
@@ -162,6 +166,9 @@ void cleanupGL()
     GLTexturePrivate::cleanup();
     GLFramebuffer::cleanup();
     GLVertexBuffer::cleanup();
+    GLTimerQuery::cleanup();
+    GLPixelUnpackBuffer::cleanup();
+    GLProgramCache::cleanup();
     GLPlatform::cleanup();
 
     glExtensions.clear();
@@ -801,14 +808,36 @@ std::unique_ptr<GLShader> ShaderManager::generateCustomShader(ShaderTraits trait
     qCDebug(LIBKWINGLUTILS) << "**************";
 #endif
 
+    return createShader(vertex, fragment, "position", "texcoord");
+}
+
+std::unique_ptr<GLShader> ShaderManager::createShader(const QByteArray &vertexSource, const QByteArray &fragmentSource,
+                                                      const char *positionName, const char *texCoordName) const
+{
     std::unique_ptr<GLShader> shader{new GLShader(GLShader::ExplicitLinking)};
-    shader->load(vertex, fragment);
 
-    shader->bindAttributeLocation("position", VA_Position);
-    shader->bindAttributeLocation("texcoord", VA_TexCoord);
+    const bool cached = GLProgramCache::isSupported();
+    QByteArray key;
+    if (cached) {
+        key = GLProgramCache::key(vertexSource, fragmentSource, QByteArray(positionName) + ' ' + texCoordName + " fragColor");
+        if (GLProgramCache::load(shader->mProgram, key)) {
+            shader->mValid = true;
+            return shader;
+        }
+    }
+
+    shader->load(vertexSource, fragmentSource);
+
+    shader->bindAttributeLocation(positionName, VA_Position);
+    shader->bindAttributeLocation(texCoordName, VA_TexCoord);
     shader->bindFragDataLocation("fragColor", 0);
 
-    shader->link();
+    if (cached) {
+        GLProgramCache::prepare(shader->mProgram);
+    }
+    if (shader->link() && cached) {
+        GLProgramCache::store(shader->mProgram, key);
+    }
     return shader;
 }
 
@@ -916,25 +945,9 @@ void ShaderManager::popShader()
     }
 }
 
-void ShaderManager::bindFragDataLocations(GLShader *shader)
-{
-    shader->bindFragDataLocation("fragColor", 0);
-}
-
-void ShaderManager::bindAttributeLocations(GLShader *shader) const
-{
-    shader->bindAttributeLocation("vertex", VA_Position);
-    shader->bindAttributeLocation("texCoord", VA_TexCoord);
-}
-
 std::unique_ptr<GLShader> ShaderManager::loadShaderFromCode(const QByteArray &vertexSource, const QByteArray &fragmentSource)
 {
-    std::unique_ptr<GLShader> shader{new GLShader(GLShader::ExplicitLinking)};
-    shader->load(vertexSource, fragmentSource);
-    bindAttributeLocations(shader.get());
-    bindFragDataLocations(shader.get());
-    shader->link();
-    return shader;
+    return createShader(vertexSource, fragmentSource, "vertex", "texCoord");
 }
 
 /***  GLFramebuffer  ***/
@@ -1160,6 +1173,322 @@ void GLFramebuffer::blitFromFramebuffer(const QRect &source, const QRect &destin
     GLFramebuffer::popFramebuffer();
 }
 
+/***  GLTimerQuery  ***/
+bool GLTimerQuery::s_supported = false;
+bool GLTimerQuery::s_extension = false;
+
+void GLTimerQuery::initStatic()
+{
+    if (GLPlatform::instance()->isGLES()) {
+        s_extension = hasGLExtension(QByteArrayLiteral("GL_EXT_disjoint_timer_query"));
+        s_supported = s_extension;
+    } else {
+        s_extension = false;
+        s_supported = hasGLVersion(3, 3) || hasGLExtension(QByteArrayLiteral("GL_ARB_timer_query"));
+    }
+}
+
+void GLTimerQuery::cleanup()
+{
+    s_supported = false;
+    s_extension = false;
+}
+
+bool GLTimerQuery::supported()
+{
+    return s_supported;
+}
+
+GLTimerQuery::GLTimerQuery()
+{
+    if (!s_supported) {
+        return;
+    }
+    if (s_extension) {
+        glGenQueriesEXT(2, m_queries);
+    } else {
+        glGenQueries(2, m_queries);
+    }
+}
+
+GLTimerQuery::~GLTimerQuery()
+{
+    if (!s_supported || !m_queries[0]) {
+        return;
+    }
+    if (s_extension) {
+        glDeleteQueriesEXT(2, m_queries);
+    } else {
+        glDeleteQueries(2, m_queries);
+    }
+}
+
+void GLTimerQuery::begin()
+{
+    if (!s_supported || m_pending) {
+        return;
+    }
+    if (s_extension) {
+        // Clear the disjoint flag, it's checked when the results are fetched.
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+        glGetInteger64vEXT(GL_TIMESTAMP_EXT, &m_reference);
+        glQueryCounterEXT(m_queries[0], GL_TIMESTAMP_EXT);
+    } else {
+        glGetInteger64v(GL_TIMESTAMP, &m_reference);
+        glQueryCounter(m_queries[0], GL_TIMESTAMP);
+    }
+    m_active = true;
+}
+
+void GLTimerQuery::end()
+{
+    if (!m_active) {
+        return;
+    }
+    if (s_extension) {
+        glQueryCounterEXT(m_queries[1], GL_TIMESTAMP_EXT);
+    } else {
+        glQueryCounter(m_queries[1], GL_TIMESTAMP);
+    }
+    m_active = false;
+    m_pending = true;
+}
+
+bool GLTimerQuery::isPending() const
+{
+    return m_pending;
+}
+
+bool GLTimerQuery::fetchResult()
+{
+    if (!m_pending) {
+        return false;
+    }
+
+    GLint available = 0;
+    if (s_extension) {
+        glGetQueryObjectivEXT(m_queries[1], GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+    } else {
+        glGetQueryObjectiv(m_queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    }
+    if (!available) {
+        return false;
+    }
+
+    GLuint64 start = 0;
+    GLuint64 end = 0;
+    if (s_extension) {
+        glGetQueryObjectui64vEXT(m_queries[0], GL_QUERY_RESULT_EXT, &start);
+        glGetQueryObjectui64vEXT(m_queries[1], GL_QUERY_RESULT_EXT, &end);
+
+        // The results are meaningless if a disjoint operation, e.g. a frequency change,
+        // has occurred while the queries were in flight.
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+        if (disjoint) {
+            m_pending = false;
+            return false;
+        }
+    } else {
+        glGetQueryObjectui64v(m_queries[0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(m_queries[1], GL_QUERY_RESULT, &end);
+    }
+
+    m_gpuTime = std::chrono::nanoseconds(end > start ? end - start : 0);
+    m_completionTime = std::chrono::nanoseconds(qint64(end) > m_reference ? qint64(end) - m_reference : 0);
+    m_pending = false;
+    return true;
+}
+
+std::chrono::nanoseconds GLTimerQuery::gpuTime() const
+{
+    return m_gpuTime;
+}
+
+std::chrono::nanoseconds GLTimerQuery::completionTime() const
+{
+    return m_completionTime;
+}
+
+/***  GLPixelUnpackBuffer  ***/
+bool GLPixelUnpackBuffer::s_supported = false;
+GLPixelUnpackBuffer *GLPixelUnpackBuffer::s_streamingBuffer = nullptr;
+
+void GLPixelUnpackBuffer::initStatic()
+{
+    bool haveBufferStorage;
+    bool haveSyncFences;
+    if (GLPlatform::instance()->isGLES()) {
+        haveBufferStorage = hasGLVersion(3, 0) && hasGLExtension(QByteArrayLiteral("GL_EXT_buffer_storage"));
+        haveSyncFences = hasGLVersion(3, 0);
+    } else {
+        haveBufferStorage = hasGLVersion(4, 4) || hasGLExtension(QByteArrayLiteral("GL_ARB_buffer_storage"));
+        haveSyncFences = hasGLVersion(3, 2) || hasGLExtension(QByteArrayLiteral("GL_ARB_sync"));
+    }
+    s_supported = haveBufferStorage && haveSyncFences && qgetenv("KWIN_PERSISTENT_PBO") != QByteArrayLiteral("0");
+}
+
+void GLPixelUnpackBuffer::cleanup()
+{
+    delete s_streamingBuffer;
+    s_streamingBuffer = nullptr;
+    s_supported = false;
+}
+
+bool GLPixelUnpackBuffer::supported()
+{
+    return s_supported;
+}
+
+GLPixelUnpackBuffer *GLPixelUnpackBuffer::streamingBuffer()
+{
+    if (!s_streamingBuffer && s_supported) {
+        s_streamingBuffer = new GLPixelUnpackBuffer(16 * 1024 * 1024);
+    }
+    return s_streamingBuffer;
+}
+
+GLPixelUnpackBuffer::GLPixelUnpackBuffer(size_t size)
+{
+    reallocate(size);
+}
+
+GLPixelUnpackBuffer::~GLPixelUnpackBuffer()
+{
+    for (const Fence &fence : m_fences) {
+        glDeleteSync(fence.sync);
+    }
+    if (m_buffer) {
+        glDeleteBuffers(1, &m_buffer);
+    }
+}
+
+bool GLPixelUnpackBuffer::reallocate(size_t size)
+{
+    for (const Fence &fence : m_fences) {
+        glDeleteSync(fence.sync);
+    }
+    m_fences.clear();
+    if (m_buffer) {
+        // The driver keeps the storage alive until the pending uploads have completed.
+        glDeleteBuffers(1, &m_buffer);
+    }
+
+    m_head = 0;
+    m_tail = 0;
+    m_fenced = 0;
+    m_map = nullptr;
+    m_size = 0;
+
+    const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, access);
+    m_map = static_cast<uint8_t *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, access));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (!m_map) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to map a pixel unpack buffer of size" << size;
+        glDeleteBuffers(1, &m_buffer);
+        m_buffer = 0;
+        return false;
+    }
+
+    m_size = size;
+    return true;
+}
+
+bool GLPixelUnpackBuffer::awaitFence()
+{
+    Q_ASSERT(!m_fences.empty());
+    const Fence &fence = m_fences.front();
+
+    const GLenum ret = glClientWaitSync(fence.sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    if (ret == GL_TIMEOUT_EXPIRED || ret == GL_WAIT_FAILED) {
+        qCCritical(LIBKWINGLUTILS) << "Wait failed";
+        return false;
+    }
+
+    glDeleteSync(fence.sync);
+    m_tail = fence.end;
+    m_fences.pop_front();
+    return true;
+}
+
+void *GLPixelUnpackBuffer::allocate(size_t size, intptr_t *offset)
+{
+    size = (size + 15) & ~size_t(15);
+
+    // Reclaim the memory that the GPU has finished reading from.
+    while (!m_fences.empty()) {
+        const Fence &fence = m_fences.front();
+        GLint status;
+        glGetSynciv(fence.sync, GL_SYNC_STATUS, 1, nullptr, &status);
+        if (status != GL_SIGNALED) {
+            break;
+        }
+        glDeleteSync(fence.sync);
+        m_tail = fence.end;
+        m_fences.pop_front();
+    }
+
+    if (unlikely(size > m_size)) {
+        if (!reallocate(qMax(size * 2, m_size * 2))) {
+            return nullptr;
+        }
+    }
+
+    // The positions grow monotonically, the allocations never wrap around the end of the buffer.
+    quint64 start = m_head;
+    if (start % m_size + size > m_size) {
+        start += m_size - start % m_size;
+    }
+    const quint64 end = start + size;
+
+    while (end - m_tail > m_size) {
+        if (m_tail == m_head) {
+            // The GPU has finished reading from the whole buffer.
+            m_tail = start;
+            break;
+        }
+        if (m_fenced < m_head) {
+            fence();
+        }
+        qCDebug(LIBKWINGLUTILS) << "Stalling on PBO fence";
+        if (!awaitFence()) {
+            return nullptr;
+        }
+    }
+
+    m_head = end;
+    *offset = start % m_size;
+    return m_map + *offset;
+}
+
+void GLPixelUnpackBuffer::fence()
+{
+    if (m_fenced == m_head) {
+        return;
+    }
+    Fence fence;
+    fence.sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    fence.end = m_head;
+    m_fences.push_back(fence);
+    m_fenced = m_head;
+}
+
+void GLPixelUnpackBuffer::bind()
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+}
+
+void GLPixelUnpackBuffer::unbind()
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
 // ------------------------------------------------------------------
 
 static const uint16_t indices[] = {
@@ -20,6 +20,9 @@
 #include <QSize>
 #include <QStack>
 
+#include <chrono>
+#include <deque>
+
 /** @addtogroup kwineffects */
 /** @{ */
 
@@ -296,8 +299,8 @@ private:
     ShaderManager();
     ~ShaderManager();
 
-    void bindFragDataLocations(GLShader *shader);
-    void bindAttributeLocations(GLShader *shader) const;
+    std::unique_ptr<GLShader> createShader(const QByteArray &vertexSource, const QByteArray &fragmentSource,
+                                           const char *positionName, const char *texCoordName) const;
 
     QByteArray generateVertexSource(ShaderTraits traits) const;
     QByteArray generateFragmentSource(ShaderTraits traits) const;
@@ -488,6 +491,136 @@ private:
     bool mForeign = false;
 };
 
+/**
+ * @short Asynchronous GPU timer
+ *
+ * The GLTimerQuery class measures how long it takes for the GPU to execute the commands
+ * issued between begin() and end(). The results become available some time after end()
+ * has been called, use fetchResult() to poll them without stalling the pipeline.
+ *
+ * Timer queries require OpenGL 3.3, GL_ARB_timer_query or GL_EXT_disjoint_timer_query.
+ */
+class KWINGLUTILS_EXPORT GLTimerQuery
+{
+public:
+    GLTimerQuery();
+    ~GLTimerQuery();
+
+    /**
+     * Starts measuring the GPU time. This does nothing if a query is still pending.
+     */
+    void begin();
+    /**
+     * Finishes measuring the GPU time.
+     */
+    void end();
+
+    /**
+     * Returns @c true if the query has been issued and its result hasn't been fetched yet.
+     */
+    bool isPending() const;
+
+    /**
+     * Fetches the result of the query if it's available. Returns @c true on success;
+     * otherwise returns @c false, e.g. if the GPU hasn't finished executing the commands yet.
+     */
+    bool fetchResult();
+
+    /**
+     * Returns the time spent by the GPU executing the commands between begin() and end().
+     */
+    std::chrono::nanoseconds gpuTime() const;
+    /**
+     * Returns the time between the call to begin() and the moment when the GPU finished
+     * executing the commands issued before end().
+     */
+    std::chrono::nanoseconds completionTime() const;
+
+    static void initStatic();
+    static bool supported();
+
+private:
+    friend void KWin::cleanupGL();
+    static void cleanup();
+    static bool s_supported;
+    static bool s_extension;
+
+    GLuint m_queries[2] = {0, 0};
+    qint64 m_reference = 0;
+    std::chrono::nanoseconds m_gpuTime = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds m_completionTime = std::chrono::nanoseconds::zero();
+    bool m_pending = false;
+    bool m_active = false;
+};
+
+/**
+ * @short Persistently mapped ring buffer for streaming pixel data to textures
+ *
+ * The GLPixelUnpackBuffer class provides memory to which the CPU can write pixel data while
+ * the GPU is still reading from other parts of the buffer. A texture is updated from the
+ * buffer by binding it and calling GLTexture::update() with the offset of the pixel data,
+ * so glTexSubImage2D() returns without copying the pixels. Sync objects ensure that memory is
+ * not handed out again before the GPU has finished reading from it.
+ *
+ * Persistently mapped buffers require OpenGL 4.4, GL_ARB_buffer_storage or GL_EXT_buffer_storage.
+ */
+class KWINGLUTILS_EXPORT GLPixelUnpackBuffer
+{
+public:
+    explicit GLPixelUnpackBuffer(size_t size);
+    ~GLPixelUnpackBuffer();
+
+    /**
+     * Returns a pointer to @a size bytes of memory that the GPU is not reading from, or
+     * @c nullptr if an error has occurred. The offset of the memory from the start of the
+     * buffer is stored in @a offset. The memory is aligned to 16 bytes.
+     *
+     * This function may stall if the GPU is still reading from the whole buffer.
+     */
+    void *allocate(size_t size, intptr_t *offset);
+
+    /**
+     * Inserts a sync object after the commands that read from the memory returned by
+     * allocate(). It must be called after all the texture updates have been issued.
+     */
+    void fence();
+
+    void bind();
+    void unbind();
+
+    /**
+     * Returns a buffer shared by all textures that stream pixel data, or @c nullptr if
+     * persistently mapped pixel buffers are not supported.
+     */
+    static GLPixelUnpackBuffer *streamingBuffer();
+
+    static void initStatic();
+    static bool supported();
+
+private:
+    friend void KWin::cleanupGL();
+    static void cleanup();
+    bool reallocate(size_t size);
+    bool awaitFence();
+
+    struct Fence
+    {
+        GLsync sync;
+        quint64 end;
+    };
+
+    GLuint m_buffer = 0;
+    uint8_t *m_map = nullptr;
+    size_t m_size = 0;
+    quint64 m_head = 0;
+    quint64 m_tail = 0;
+    quint64 m_fenced = 0;
+    std::deque<Fence> m_fences;
+
+    static bool s_supported;
+    static GLPixelUnpackBuffer *s_streamingBuffer;
+};
+
 enum VertexAttributeType {
     VA_Position = 0,
     VA_TexCoord = 1,
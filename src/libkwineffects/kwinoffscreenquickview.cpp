@@ -25,7 +25,13 @@
 #include <QOffscreenSurface>
 #include <QOpenGLContext>
 #include <QOpenGLFramebufferObject>
+#include <QOpenGLShaderProgram>
 #include <QTimer>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 #include <QQuickOpenGLUtils>
 #include <QQuickRenderTarget>
@@ -71,16 +77,32 @@ public:
     QQuickRenderControl *m_renderControl;
     std::unique_ptr<QOffscreenSurface> m_offscreenSurface;
     std::unique_ptr<QOpenGLContext> m_glcontext;
+    // the last rendered frame, and the framebuffer that the next frame will be rendered into
     std::unique_ptr<QOpenGLFramebufferObject> m_fbo;
+    std::unique_ptr<QOpenGLFramebufferObject> m_backFbo;
+    // used to find the tiles that differ between two frames
+    std::unique_ptr<QOpenGLShaderProgram> m_compareProgram;
+    std::unique_ptr<QOpenGLFramebufferObject> m_compareMask;
+    bool m_compareFailed = false;
+    // the comparison mask is read back into a pixel pack buffer without waiting for the GPU
+    // when the view exports a texture, the fence tells when the copy has completed
+    GLuint m_maskBuffer = 0;
+    GLsync m_maskFence = nullptr;
+    QSize m_maskFrameSize;
+    QTimer *m_maskTimer;
 
     QTimer *m_repaintTimer;
     QImage m_image;
     std::unique_ptr<GLTexture> m_textureExport;
+    // the parts of m_image that haven't been uploaded to m_textureExport yet, in device pixels
+    QRegion m_textureDamage;
     // if we should capture a QImage after rendering into our BO.
     // Used for either software QtQuick rendering and nonGL kwin rendering
     bool m_useBlit = false;
     bool m_visible = true;
     bool m_automaticRepaint = true;
+    // whether the scene graph has to be synchronized with the items before it's rendered
+    bool m_sceneDirty = true;
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
     QList<QTouchEvent::TouchPoint> touchPoints;
@@ -95,6 +117,13 @@ public:
     Qt::MouseButton lastMousePressButton = Qt::NoButton;
 
     void releaseResources();
+    bool supportsAsyncReadback() const;
+    bool drawComparisonMask(QOpenGLFramebufferObject *current, QOpenGLFramebufferObject *previous);
+    QRegion readComparisonMask(const QSize &frameSize);
+    void startComparisonMaskReadback(const QSize &frameSize);
+    std::optional<QRegion> finishComparisonMaskReadback(bool force);
+    void releaseComparisonMaskReadback();
+    void readFramebuffer(const QRegion &region);
 
     void updateTouchState(Qt::TouchPointState state, qint32 id, const QPointF &pos);
 };
@@ -188,6 +217,23 @@ OffscreenQuickView::OffscreenQuickView(QObject *parent, QWindow *renderWindow, E
     d->m_repaintTimer->setInterval(10);
 
     connect(d->m_repaintTimer, &QTimer::timeout, this, &OffscreenQuickView::update);
+
+    d->m_maskTimer = new QTimer(this);
+    d->m_maskTimer->setInterval(1);
+    connect(d->m_maskTimer, &QTimer::timeout, this, [this]() {
+        if (!d->m_glcontext->makeCurrent(d->m_offscreenSurface.get())) {
+            d->m_maskTimer->stop();
+            return;
+        }
+        const std::optional<QRegion> nativeDamage = d->finishComparisonMaskReadback(false);
+        d->m_glcontext->doneCurrent();
+        if (nativeDamage) {
+            const QRegion damage = scaledRegion(*nativeDamage, 1 / d->m_view->effectiveDevicePixelRatio());
+            if (!damage.isEmpty()) {
+                Q_EMIT repaintNeeded(damage);
+            }
+        }
+    });
     connect(d->m_renderControl, &QQuickRenderControl::renderRequested, this, &OffscreenQuickView::handleRenderRequested);
     connect(d->m_renderControl, &QQuickRenderControl::sceneChanged, this, &OffscreenQuickView::handleSceneChanged);
 
@@ -206,6 +252,7 @@ OffscreenQuickView::~OffscreenQuickView()
     if (d->m_glcontext) {
         // close the view whilst we have an active GL context
         d->m_glcontext->makeCurrent(d->m_offscreenSurface.get());
+        d->releaseComparisonMaskReadback();
     }
 
     delete d->m_renderControl; // Always delete render control first.
@@ -234,6 +281,7 @@ void OffscreenQuickView::setAutomaticRepaint(bool set)
 
 void OffscreenQuickView::handleSceneChanged()
 {
+    d->m_sceneDirty = true;
     if (d->m_automaticRepaint) {
         d->m_repaintTimer->start();
     }
@@ -248,6 +296,104 @@ void OffscreenQuickView::handleRenderRequested()
     Q_EMIT renderRequested();
 }
 
+// The granularity at which the rendered frames are compared, in device pixels.
+static const int s_damageTileSize = 32;
+
+// Adds a row of tiles to the @p region, @p changed tells whether the tile in a column has changed.
+template<typename Changed>
+static void addChangedTiles(QRegion &region, int columns, int width, int top, int bottom, Changed changed)
+{
+    for (int column = 0; column < columns;) {
+        if (!changed(column)) {
+            ++column;
+            continue;
+        }
+        // Merge the adjacent tiles to keep the region simple.
+        const int first = column;
+        while (column < columns && changed(column)) {
+            ++column;
+        }
+        const int left = first * s_damageTileSize;
+        region += QRect(left, top, std::min(column * s_damageTileSize, width) - left, bottom - top);
+    }
+}
+
+static QRegion changedRegion(const QImage &previous, const QImage &current)
+{
+    if (current.isNull()) {
+        return QRegion();
+    }
+    if (previous.size() != current.size() || previous.format() != current.format() || current.depth() % 8 != 0) {
+        return current.rect();
+    }
+
+    const int bytesPerPixel = current.depth() / 8;
+    const int columns = (current.width() + s_damageTileSize - 1) / s_damageTileSize;
+    QVarLengthArray<bool, 128> changed(columns);
+    QRegion region;
+
+    for (int top = 0; top < current.height(); top += s_damageTileSize) {
+        const int bottom = std::min(top + s_damageTileSize, current.height());
+        std::fill(changed.begin(), changed.end(), false);
+        for (int y = top; y < bottom; ++y) {
+            const uchar *previousLine = previous.constScanLine(y);
+            const uchar *currentLine = current.constScanLine(y);
+            for (int column = 0; column < columns; ++column) {
+                if (changed[column]) {
+                    continue;
+                }
+                const int left = column * s_damageTileSize;
+                const int width = std::min(s_damageTileSize, current.width() - left);
+                changed[column] = std::memcmp(previousLine + left * bytesPerPixel, currentLine + left * bytesPerPixel, width * bytesPerPixel) != 0;
+            }
+        }
+        addChangedTiles(region, columns, current.width(), top, bottom, [&changed](int column) {
+            return changed[column];
+        });
+    }
+
+    return region;
+}
+
+static const char s_compareVertexShader[] = R"(
+attribute vec2 position;
+
+void main()
+{
+    gl_Position = vec4(position, 0.0, 1.0);
+}
+)";
+
+// Every fragment covers one tile of the frames, it's set if any pixel of the tile differs.
+static const char s_compareFragmentShader[] = R"(
+#ifdef GL_ES
+#ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#else
+precision mediump float;
+#endif
+#endif
+
+uniform sampler2D current;
+uniform sampler2D previous;
+uniform vec2 frameSize;
+
+void main()
+{
+    vec2 origin = floor(gl_FragCoord.xy) * float(TILE_SIZE);
+    for (int y = 0; y < TILE_SIZE; ++y) {
+        for (int x = 0; x < TILE_SIZE; ++x) {
+            vec2 texcoord = (min(origin + vec2(float(x), float(y)), frameSize - 1.0) + 0.5) / frameSize;
+            if (texture2D(current, texcoord) != texture2D(previous, texcoord)) {
+                gl_FragColor = vec4(1.0);
+                return;
+            }
+        }
+    }
+    gl_FragColor = vec4(0.0);
+}
+)";
+
 void OffscreenQuickView::update()
 {
     if (!d->m_visible) {
@@ -258,6 +404,8 @@ void OffscreenQuickView::update()
     }
 
     bool usingGl = d->m_glcontext != nullptr;
+    const qreal devicePixelRatio = d->m_view->effectiveDevicePixelRatio();
+    QRegion nativeDamage;
 
     if (usingGl) {
         if (!d->m_glcontext->makeCurrent(d->m_offscreenSurface.get())) {
@@ -265,44 +413,80 @@ void OffscreenQuickView::update()
             return;
         }
 
-        const QSize nativeSize = d->m_view->size() * d->m_view->effectiveDevicePixelRatio();
-        if (!d->m_fbo || d->m_fbo->size() != nativeSize) {
-            d->m_textureExport.reset(nullptr);
-            d->m_fbo.reset(new QOpenGLFramebufferObject(nativeSize, QOpenGLFramebufferObject::CombinedDepthStencil));
-            if (!d->m_fbo->isValid()) {
-                d->m_fbo.reset();
+        // The damage of the previous frame is reported before the next one is rendered. If the
+        // GPU hasn't finished comparing it yet, the whole frame is damaged rather than waiting.
+        if (const std::optional<QRegion> pendingDamage = d->finishComparisonMaskReadback(true)) {
+            const QRegion damage = scaledRegion(*pendingDamage, 1 / devicePixelRatio);
+            if (!damage.isEmpty()) {
+                Q_EMIT repaintNeeded(damage);
+            }
+        }
+
+        // Frames are rendered into two framebuffers in turn, so the new frame can be compared
+        // with the previous one on the GPU.
+        const QSize nativeSize = d->m_view->size() * devicePixelRatio;
+        if (!d->m_backFbo || d->m_backFbo->size() != nativeSize) {
+            d->m_backFbo.reset(new QOpenGLFramebufferObject(nativeSize, QOpenGLFramebufferObject::CombinedDepthStencil));
+            if (!d->m_backFbo->isValid()) {
+                d->m_backFbo.reset();
                 d->m_glcontext->doneCurrent();
                 return;
             }
         }
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-        d->m_view->setRenderTarget(d->m_fbo.get());
+        d->m_view->setRenderTarget(d->m_backFbo.get());
 #else
-        d->m_view->setRenderTarget(QQuickRenderTarget::fromOpenGLTexture(d->m_fbo->texture(), d->m_fbo->size()));
+        d->m_view->setRenderTarget(QQuickRenderTarget::fromOpenGLTexture(d->m_backFbo->texture(), d->m_backFbo->size()));
 #endif
-    }
 
-    d->m_renderControl->polishItems();
-    d->m_renderControl->sync();
+        // If only a render has been requested, e.g. by an animation that runs in the scene
+        // graph, the items haven't changed and synchronizing them can be skipped.
+        if (d->m_sceneDirty) {
+            d->m_renderControl->polishItems();
+            d->m_renderControl->sync();
+            d->m_sceneDirty = false;
+        }
 
-    d->m_renderControl->render();
-    if (usingGl) {
+        d->m_renderControl->render();
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
         d->m_view->resetOpenGLState();
 #else
         QQuickOpenGLUtils::resetOpenGLState();
 #endif
-    }
 
-    if (d->m_useBlit) {
-        d->m_image = d->m_renderControl->grab();
-    }
+        if (!d->drawComparisonMask(d->m_backFbo.get(), d->m_fbo.get())) {
+            nativeDamage = QRect(QPoint(0, 0), nativeSize);
+        } else if (d->m_useBlit || !d->supportsAsyncReadback()) {
+            // The changed tiles of the image have to be read back right away anyway.
+            nativeDamage = d->readComparisonMask(nativeSize);
+        } else {
+            // The exported texture is up to date already, the damage follows once the GPU
+            // has compared the frames.
+            d->startComparisonMaskReadback(nativeSize);
+        }
+        std::swap(d->m_fbo, d->m_backFbo);
+        if (d->m_useBlit) {
+            d->readFramebuffer(nativeDamage);
+        }
 
-    if (usingGl) {
         QOpenGLFramebufferObject::bindDefault();
         d->m_glcontext->doneCurrent();
+    } else {
+        // The software renderer of QtQuick can only paint into the image that grab() creates,
+        // grab() polishes, synchronizes and renders the scene itself.
+        const QImage image = d->m_renderControl->grab();
+        d->m_sceneDirty = false;
+        nativeDamage = changedRegion(d->m_image, image);
+        d->m_image = image;
+    }
+
+    if (d->m_useBlit) {
+        d->m_textureDamage += nativeDamage;
+    }
+    const QRegion damage = scaledRegion(nativeDamage, 1 / devicePixelRatio);
+    if (!damage.isEmpty()) {
+        Q_EMIT repaintNeeded(damage);
     }
-    Q_EMIT repaintNeeded();
 }
 
 void OffscreenQuickView::forwardMouseEvent(QEvent *e)
@@ -445,6 +629,7 @@ void OffscreenQuickView::setVisible(bool visible)
     d->m_visible = visible;
 
     if (visible) {
+        d->m_sceneDirty = true;
         Q_EMIT d->m_renderControl->renderRequested();
     } else {
         // deferred to not change GL context
@@ -475,12 +660,21 @@ GLTexture *OffscreenQuickView::bufferAsTexture()
         if (d->m_image.isNull()) {
             return nullptr;
         }
-        d->m_textureExport.reset(new GLTexture(d->m_image));
+        if (!d->m_textureExport || d->m_textureExport->size() != d->m_image.size()) {
+            d->m_textureExport.reset(new GLTexture(d->m_image));
+        } else {
+            // Upload only the parts that have changed since the texture was last requested.
+            for (const QRect &rect : std::as_const(d->m_textureDamage)) {
+                d->m_textureExport->update(d->m_image, rect.topLeft(), rect);
+            }
+        }
+        d->m_textureDamage = QRegion();
     } else {
         if (!d->m_fbo) {
             return nullptr;
         }
-        if (!d->m_textureExport) {
+        // The view renders into two framebuffers in turn.
+        if (!d->m_textureExport || d->m_textureExport->texture() != d->m_fbo->texture() || d->m_textureExport->size() != d->m_fbo->size()) {
             d->m_textureExport.reset(new GLTexture(d->m_fbo->texture(), d->m_fbo->format().internalTextureFormat(), d->m_fbo->size()));
         }
     }
@@ -515,6 +709,209 @@ void OffscreenQuickView::Private::releaseResources()
     }
 }
 
+bool OffscreenQuickView::Private::supportsAsyncReadback() const
+{
+    // Pixel pack buffers and glMapBufferRange() are core in OpenGL 3.0, fences in OpenGL 3.2.
+    // OpenGLES 3.0 has all of them.
+    const QSurfaceFormat format = m_glcontext->format();
+    if (format.renderableType() == QSurfaceFormat::OpenGLES) {
+        return format.version() >= qMakePair(3, 0);
+    }
+    return format.version() >= qMakePair(3, 2)
+        || (format.version() >= qMakePair(3, 0) && m_glcontext->hasExtension(QByteArrayLiteral("GL_ARB_sync")));
+}
+
+static QSize comparisonMaskSize(const QSize &frameSize)
+{
+    return QSize((frameSize.width() + s_damageTileSize - 1) / s_damageTileSize,
+                 (frameSize.height() + s_damageTileSize - 1) / s_damageTileSize);
+}
+
+// The mask has one RGBA pixel per tile, the rows start at the bottom of the frame.
+static QRegion comparisonMaskRegion(const uchar *mask, const QSize &frameSize)
+{
+    const QSize tiles = comparisonMaskSize(frameSize);
+    QRegion region;
+    for (int row = 0; row < tiles.height(); ++row) {
+        const uchar *line = mask + row * tiles.width() * 4;
+        const int bottom = frameSize.height() - row * s_damageTileSize;
+        const int top = std::max(bottom - s_damageTileSize, 0);
+        addChangedTiles(region, tiles.width(), frameSize.width(), top, bottom, [line](int column) {
+            return line[column * 4] != 0;
+        });
+    }
+    return region;
+}
+
+bool OffscreenQuickView::Private::drawComparisonMask(QOpenGLFramebufferObject *current, QOpenGLFramebufferObject *previous)
+{
+    const QSize frameSize = current->size();
+    if (!previous || previous->size() != frameSize || m_compareFailed) {
+        return false;
+    }
+
+    if (!m_compareProgram) {
+        const QByteArray tileSize = QByteArrayLiteral("#define TILE_SIZE ") + QByteArray::number(s_damageTileSize) + '\n';
+        m_compareProgram = std::make_unique<QOpenGLShaderProgram>();
+        if (!m_compareProgram->addShaderFromSourceCode(QOpenGLShader::Vertex, s_compareVertexShader)
+            || !m_compareProgram->addShaderFromSourceCode(QOpenGLShader::Fragment, tileSize + s_compareFragmentShader)
+            || !m_compareProgram->link()) {
+            qCWarning(LIBKWINEFFECTS) << "Failed to create the frame comparison shader, damage tracking is disabled:" << m_compareProgram->log();
+            m_compareProgram.reset();
+            m_compareFailed = true;
+            return false;
+        }
+    }
+
+    const QSize tiles = comparisonMaskSize(frameSize);
+    if (!m_compareMask || m_compareMask->size() != tiles) {
+        m_compareMask.reset(new QOpenGLFramebufferObject(tiles));
+        if (!m_compareMask->isValid()) {
+            m_compareMask.reset();
+            return false;
+        }
+    }
+
+    static const GLfloat vertices[] = {
+        -1.0, -1.0,
+        1.0, -1.0,
+        -1.0, 1.0,
+        1.0, 1.0,
+    };
+
+    m_compareMask->bind();
+    glViewport(0, 0, tiles.width(), tiles.height());
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, previous->texture());
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, current->texture());
+
+    m_compareProgram->bind();
+    m_compareProgram->setUniformValue("current", 0);
+    m_compareProgram->setUniformValue("previous", 1);
+    m_compareProgram->setUniformValue("frameSize", QSizeF(frameSize));
+    const int position = m_compareProgram->attributeLocation("position");
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_compareProgram->enableAttributeArray(position);
+    m_compareProgram->setAttributeArray(position, vertices, 2);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    m_compareProgram->disableAttributeArray(position);
+    m_compareProgram->release();
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_compareMask->release();
+
+    return true;
+}
+
+QRegion OffscreenQuickView::Private::readComparisonMask(const QSize &frameSize)
+{
+    const QSize tiles = m_compareMask->size();
+    QVector<uchar> mask(tiles.width() * tiles.height() * 4);
+
+    m_compareMask->bind();
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, tiles.width(), tiles.height(), GL_RGBA, GL_UNSIGNED_BYTE, mask.data());
+    m_compareMask->release();
+
+    return comparisonMaskRegion(mask.constData(), frameSize);
+}
+
+void OffscreenQuickView::Private::startComparisonMaskReadback(const QSize &frameSize)
+{
+    const QSize tiles = m_compareMask->size();
+    const GLsizeiptr size = tiles.width() * tiles.height() * 4;
+
+    if (!m_maskBuffer) {
+        glGenBuffers(1, &m_maskBuffer);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_maskBuffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+
+    m_compareMask->bind();
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, tiles.width(), tiles.height(), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    m_compareMask->release();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_maskFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+    m_maskFrameSize = frameSize;
+    m_maskTimer->start();
+}
+
+std::optional<QRegion> OffscreenQuickView::Private::finishComparisonMaskReadback(bool force)
+{
+    if (!m_maskFence) {
+        return std::nullopt;
+    }
+
+    const QRect frameRect(QPoint(0, 0), m_maskFrameSize);
+    const GLenum status = glClientWaitSync(m_maskFence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED && !force) {
+        return std::nullopt;
+    }
+
+    glDeleteSync(m_maskFence);
+    m_maskFence = nullptr;
+    m_maskTimer->stop();
+
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        return QRegion(frameRect);
+    }
+
+    const QSize tiles = comparisonMaskSize(m_maskFrameSize);
+    const GLsizeiptr size = tiles.width() * tiles.height() * 4;
+    QRegion region = frameRect;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_maskBuffer);
+    if (const void *mask = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT)) {
+        region = comparisonMaskRegion(static_cast<const uchar *>(mask), m_maskFrameSize);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return region;
+}
+
+void OffscreenQuickView::Private::releaseComparisonMaskReadback()
+{
+    m_maskTimer->stop();
+    if (m_maskFence) {
+        glDeleteSync(m_maskFence);
+        m_maskFence = nullptr;
+    }
+    if (m_maskBuffer) {
+        glDeleteBuffers(1, &m_maskBuffer);
+        m_maskBuffer = 0;
+    }
+}
+
+void OffscreenQuickView::Private::readFramebuffer(const QRegion &region)
+{
+    const QSize frameSize = m_fbo->size();
+    QRegion dirty = region;
+    if (m_image.size() != frameSize || m_image.format() != QImage::Format_RGBA8888_Premultiplied) {
+        m_image = QImage(frameSize, QImage::Format_RGBA8888_Premultiplied);
+        dirty = m_image.rect();
+    }
+    m_image.setDevicePixelRatio(m_view->effectiveDevicePixelRatio());
+
+    // Only the parts that have changed are read back, the rest of the image is still valid.
+    m_fbo->bind();
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    for (const QRect &rect : dirty) {
+        QImage part(rect.size(), QImage::Format_RGBA8888_Premultiplied);
+        glReadPixels(rect.x(), frameSize.height() - rect.y() - rect.height(), rect.width(), rect.height(), GL_RGBA, GL_UNSIGNED_BYTE, part.bits());
+        // The framebuffer starts at the bottom, the image at the top.
+        for (int y = 0; y < rect.height(); ++y) {
+            std::memcpy(m_image.scanLine(rect.y() + y) + rect.x() * 4, part.constScanLine(rect.height() - 1 - y), rect.width() * 4);
+        }
+    }
+    m_fbo->release();
+}
+
 void OffscreenQuickView::Private::updateTouchState(Qt::TouchPointState state, qint32 id, const QPointF &pos)
 {
     // Remove the points that were previously in a released state, since they
@@ -155,9 +155,14 @@ public:
 
 Q_SIGNALS:
     /**
-     * The frame buffer has changed, contents need re-rendering on screen
+     * The frame buffer has changed, contents need re-rendering on screen.
+     * The @p damage specifies the parts that have changed, in the local coordinates
+     * of the view. The signal is not emitted if the new frame is the same as before.
+     *
+     * When the view exports a texture, the frames are compared on the GPU and the signal
+     * may be emitted after update() has returned, once the comparison is done.
      */
-    void repaintNeeded();
+    void repaintNeeded(const QRegion &damage);
     void geometryChanged(const QRect &oldGeometry, const QRect &newGeometry);
     void renderRequested();
     void sceneChanged();
@@ -0,0 +1,522 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwinpixelconversion_p.h"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(Q_CC_GNU) || defined(Q_CC_CLANG))
+#include <immintrin.h>
+#define KWIN_PIXELCONVERSION_AVX2 1
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace KWin
+{
+namespace PixelConversion
+{
+
+/**
+ * Describes how to convert a pixel that is packed in 32 bits with 8 or 10 bits per color
+ * channel to a pixel with 8 bits per channel. The shifts move the 8 most significant bits
+ * of a channel to the least significant byte.
+ */
+struct Packed32Conversion
+{
+    int redShift;
+    int greenShift;
+    int blueShift;
+    int alphaBits; // 8, 2, or 0 if the source is opaque
+    int destinationRedShift;
+    int destinationBlueShift;
+};
+
+/**
+ * Describes how to convert a pixel with 16 bits per channel, stored in RGBA order, to a pixel
+ * with 8 bits per channel.
+ */
+struct Rgba64Conversion
+{
+    bool opaque;
+    bool swapRedBlue;
+};
+
+using Packed32Kernel = void (*)(const uchar *source, uchar *destination, int width, const Packed32Conversion &conversion);
+using Rgba64Kernel = void (*)(const uchar *source, uchar *destination, int width, const Rgba64Conversion &conversion);
+
+enum class InstructionSet {
+    Generic,
+    Sse2,
+    Avx2,
+    Neon,
+};
+
+// Generic kernels, also used to convert the pixels that don't fill a whole vector.
+
+static inline quint32 convertPacked32(quint32 pixel, const Packed32Conversion &conversion)
+{
+    const quint32 red = (pixel >> conversion.redShift) & 0xff;
+    const quint32 green = (pixel >> conversion.greenShift) & 0xff;
+    const quint32 blue = (pixel >> conversion.blueShift) & 0xff;
+    quint32 alpha;
+    switch (conversion.alphaBits) {
+    case 8:
+        alpha = pixel >> 24;
+        break;
+    case 2:
+        alpha = (pixel >> 30) * 0x55;
+        break;
+    default:
+        alpha = 0xff;
+        break;
+    }
+    return (alpha << 24) | (red << conversion.destinationRedShift) | (green << 8) | (blue << conversion.destinationBlueShift);
+}
+
+static void convertPacked32Generic(const uchar *source, uchar *destination, int width, const Packed32Conversion &conversion)
+{
+    for (int i = 0; i < width; ++i) {
+        quint32 pixel;
+        std::memcpy(&pixel, source + i * 4, 4);
+        pixel = convertPacked32(pixel, conversion);
+        std::memcpy(destination + i * 4, &pixel, 4);
+    }
+}
+
+static inline quint32 convertChannel16(quint32 value)
+{
+    // Same rounding as the 16 to 8 bit conversions in QImage.
+    return (value - (value >> 8) + 128) >> 8;
+}
+
+static void convertRgba64Generic(const uchar *source, uchar *destination, int width, const Rgba64Conversion &conversion)
+{
+    for (int i = 0; i < width; ++i) {
+        quint16 channels[4];
+        std::memcpy(channels, source + i * 8, 8);
+        const quint32 red = convertChannel16(channels[0]);
+        const quint32 green = convertChannel16(channels[1]);
+        const quint32 blue = convertChannel16(channels[2]);
+        const quint32 alpha = conversion.opaque ? 0xff : convertChannel16(channels[3]);
+        const quint32 pixel = conversion.swapRedBlue
+            ? (alpha << 24) | (red << 16) | (green << 8) | blue
+            : (alpha << 24) | (blue << 16) | (green << 8) | red;
+        std::memcpy(destination + i * 4, &pixel, 4);
+    }
+}
+
+#if defined(__SSE2__)
+static void convertPacked32Sse2(const uchar *source, uchar *destination, int width, const Packed32Conversion &conversion)
+{
+    const __m128i byteMask = _mm_set1_epi32(0xff);
+    const __m128i opaque = _mm_set1_epi32(0xff000000);
+    const __m128i redShift = _mm_cvtsi32_si128(conversion.redShift);
+    const __m128i greenShift = _mm_cvtsi32_si128(conversion.greenShift);
+    const __m128i blueShift = _mm_cvtsi32_si128(conversion.blueShift);
+    const __m128i destinationRedShift = _mm_cvtsi32_si128(conversion.destinationRedShift);
+    const __m128i destinationBlueShift = _mm_cvtsi32_si128(conversion.destinationBlueShift);
+
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * 4));
+        const __m128i red = _mm_and_si128(_mm_srl_epi32(pixels, redShift), byteMask);
+        const __m128i green = _mm_and_si128(_mm_srl_epi32(pixels, greenShift), byteMask);
+        const __m128i blue = _mm_and_si128(_mm_srl_epi32(pixels, blueShift), byteMask);
+
+        __m128i alpha;
+        if (conversion.alphaBits == 8) {
+            alpha = _mm_and_si128(pixels, opaque);
+        } else if (conversion.alphaBits == 2) {
+            alpha = _mm_srli_epi32(pixels, 30);
+            alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 2));
+            alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 4));
+            alpha = _mm_slli_epi32(alpha, 24);
+        } else {
+            alpha = opaque;
+        }
+
+        __m128i result = _mm_or_si128(alpha, _mm_slli_epi32(green, 8));
+        result = _mm_or_si128(result, _mm_sll_epi32(red, destinationRedShift));
+        result = _mm_or_si128(result, _mm_sll_epi32(blue, destinationBlueShift));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i * 4), result);
+    }
+    convertPacked32Generic(source + i * 4, destination + i * 4, width - i, conversion);
+}
+
+static inline __m128i convertChannels16Sse2(__m128i channels)
+{
+    channels = _mm_sub_epi16(channels, _mm_srli_epi16(channels, 8));
+    channels = _mm_add_epi16(channels, _mm_set1_epi16(128));
+    return _mm_srli_epi16(channels, 8);
+}
+
+static inline __m128i swapRedBlueSse2(__m128i pixels)
+{
+    const __m128i greenAlpha = _mm_and_si128(pixels, _mm_set1_epi32(0xff00ff00));
+    const __m128i redBlue = _mm_and_si128(pixels, _mm_set1_epi32(0x00ff00ff));
+    return _mm_or_si128(greenAlpha, _mm_or_si128(_mm_srli_epi32(redBlue, 16), _mm_slli_epi32(redBlue, 16)));
+}
+
+static void convertRgba64Sse2(const uchar *source, uchar *destination, int width, const Rgba64Conversion &conversion)
+{
+    const __m128i opaque = _mm_set1_epi32(conversion.opaque ? 0xff000000 : 0);
+
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * 8));
+        const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * 8 + 16));
+        __m128i result = _mm_packus_epi16(convertChannels16Sse2(first), convertChannels16Sse2(second));
+        if (conversion.swapRedBlue) {
+            result = swapRedBlueSse2(result);
+        }
+        result = _mm_or_si128(result, opaque);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i * 4), result);
+    }
+    convertRgba64Generic(source + i * 8, destination + i * 4, width - i, conversion);
+}
+#endif
+
+#if KWIN_PIXELCONVERSION_AVX2
+__attribute__((target("avx2"))) static void convertPacked32Avx2(const uchar *source, uchar *destination, int width, const Packed32Conversion &conversion)
+{
+    const __m256i byteMask = _mm256_set1_epi32(0xff);
+    const __m256i opaque = _mm256_set1_epi32(0xff000000);
+    const __m128i redShift = _mm_cvtsi32_si128(conversion.redShift);
+    const __m128i greenShift = _mm_cvtsi32_si128(conversion.greenShift);
+    const __m128i blueShift = _mm_cvtsi32_si128(conversion.blueShift);
+    const __m128i destinationRedShift = _mm_cvtsi32_si128(conversion.destinationRedShift);
+    const __m128i destinationBlueShift = _mm_cvtsi32_si128(conversion.destinationBlueShift);
+
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i * 4));
+        const __m256i red = _mm256_and_si256(_mm256_srl_epi32(pixels, redShift), byteMask);
+        const __m256i green = _mm256_and_si256(_mm256_srl_epi32(pixels, greenShift), byteMask);
+        const __m256i blue = _mm256_and_si256(_mm256_srl_epi32(pixels, blueShift), byteMask);
+
+        __m256i alpha;
+        if (conversion.alphaBits == 8) {
+            alpha = _mm256_and_si256(pixels, opaque);
+        } else if (conversion.alphaBits == 2) {
+            alpha = _mm256_srli_epi32(pixels, 30);
+            alpha = _mm256_or_si256(alpha, _mm256_slli_epi32(alpha, 2));
+            alpha = _mm256_or_si256(alpha, _mm256_slli_epi32(alpha, 4));
+            alpha = _mm256_slli_epi32(alpha, 24);
+        } else {
+            alpha = opaque;
+        }
+
+        __m256i result = _mm256_or_si256(alpha, _mm256_slli_epi32(green, 8));
+        result = _mm256_or_si256(result, _mm256_sll_epi32(red, destinationRedShift));
+        result = _mm256_or_si256(result, _mm256_sll_epi32(blue, destinationBlueShift));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i * 4), result);
+    }
+    convertPacked32Generic(source + i * 4, destination + i * 4, width - i, conversion);
+}
+
+__attribute__((target("avx2"))) static inline __m256i convertChannels16Avx2(__m256i channels)
+{
+    channels = _mm256_sub_epi16(channels, _mm256_srli_epi16(channels, 8));
+    channels = _mm256_add_epi16(channels, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(channels, 8);
+}
+
+__attribute__((target("avx2"))) static void convertRgba64Avx2(const uchar *source, uchar *destination, int width, const Rgba64Conversion &conversion)
+{
+    const __m256i opaque = _mm256_set1_epi32(conversion.opaque ? 0xff000000 : 0);
+    const __m256i greenAlphaMask = _mm256_set1_epi32(0xff00ff00);
+    const __m256i redBlueMask = _mm256_set1_epi32(0x00ff00ff);
+
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i * 8));
+        const __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i * 8 + 32));
+        // The pack instruction works within 128 bit lanes, put the pixels back in order.
+        __m256i result = _mm256_packus_epi16(convertChannels16Avx2(first), convertChannels16Avx2(second));
+        result = _mm256_permute4x64_epi64(result, _MM_SHUFFLE(3, 1, 2, 0));
+        if (conversion.swapRedBlue) {
+            const __m256i redBlue = _mm256_and_si256(result, redBlueMask);
+            result = _mm256_or_si256(_mm256_and_si256(result, greenAlphaMask),
+                                     _mm256_or_si256(_mm256_srli_epi32(redBlue, 16), _mm256_slli_epi32(redBlue, 16)));
+        }
+        result = _mm256_or_si256(result, opaque);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i * 4), result);
+    }
+    convertRgba64Generic(source + i * 8, destination + i * 4, width - i, conversion);
+}
+#endif
+
+#if defined(__ARM_NEON)
+static void convertPacked32Neon(const uchar *source, uchar *destination, int width, const Packed32Conversion &conversion)
+{
+    const uint32x4_t byteMask = vdupq_n_u32(0xff);
+    const uint32x4_t opaque = vdupq_n_u32(0xff000000);
+    // Shifting left by a negative amount shifts right.
+    const int32x4_t redShift = vdupq_n_s32(-conversion.redShift);
+    const int32x4_t greenShift = vdupq_n_s32(-conversion.greenShift);
+    const int32x4_t blueShift = vdupq_n_s32(-conversion.blueShift);
+    const int32x4_t destinationRedShift = vdupq_n_s32(conversion.destinationRedShift);
+    const int32x4_t destinationBlueShift = vdupq_n_s32(conversion.destinationBlueShift);
+
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        const uint32x4_t pixels = vreinterpretq_u32_u8(vld1q_u8(source + i * 4));
+        const uint32x4_t red = vandq_u32(vshlq_u32(pixels, redShift), byteMask);
+        const uint32x4_t green = vandq_u32(vshlq_u32(pixels, greenShift), byteMask);
+        const uint32x4_t blue = vandq_u32(vshlq_u32(pixels, blueShift), byteMask);
+
+        uint32x4_t alpha;
+        if (conversion.alphaBits == 8) {
+            alpha = vandq_u32(pixels, opaque);
+        } else if (conversion.alphaBits == 2) {
+            alpha = vshrq_n_u32(pixels, 30);
+            alpha = vorrq_u32(alpha, vshlq_n_u32(alpha, 2));
+            alpha = vorrq_u32(alpha, vshlq_n_u32(alpha, 4));
+            alpha = vshlq_n_u32(alpha, 24);
+        } else {
+            alpha = opaque;
+        }
+
+        uint32x4_t result = vorrq_u32(alpha, vshlq_n_u32(green, 8));
+        result = vorrq_u32(result, vshlq_u32(red, destinationRedShift));
+        result = vorrq_u32(result, vshlq_u32(blue, destinationBlueShift));
+        vst1q_u8(destination + i * 4, vreinterpretq_u8_u32(result));
+    }
+    convertPacked32Generic(source + i * 4, destination + i * 4, width - i, conversion);
+}
+
+static void convertRgba64Neon(const uchar *source, uchar *destination, int width, const Rgba64Conversion &conversion)
+{
+    const uint32x4_t opaque = vdupq_n_u32(conversion.opaque ? 0xff000000 : 0);
+    const uint16x8_t rounding = vdupq_n_u16(128);
+
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        uint16x8_t first = vreinterpretq_u16_u8(vld1q_u8(source + i * 8));
+        uint16x8_t second = vreinterpretq_u16_u8(vld1q_u8(source + i * 8 + 16));
+        first = vaddq_u16(vsubq_u16(first, vshrq_n_u16(first, 8)), rounding);
+        second = vaddq_u16(vsubq_u16(second, vshrq_n_u16(second, 8)), rounding);
+        uint32x4_t result = vreinterpretq_u32_u8(vcombine_u8(vshrn_n_u16(first, 8), vshrn_n_u16(second, 8)));
+        if (conversion.swapRedBlue) {
+            const uint32x4_t redBlue = vandq_u32(result, vdupq_n_u32(0x00ff00ff));
+            result = vorrq_u32(vandq_u32(result, vdupq_n_u32(0xff00ff00)),
+                               vorrq_u32(vshrq_n_u32(redBlue, 16), vshlq_n_u32(redBlue, 16)));
+        }
+        result = vorrq_u32(result, opaque);
+        vst1q_u8(destination + i * 4, vreinterpretq_u8_u32(result));
+    }
+    convertRgba64Generic(source + i * 8, destination + i * 4, width - i, conversion);
+}
+#endif
+
+static InstructionSet detectInstructionSet()
+{
+    if (qEnvironmentVariableIsSet("KWIN_PIXEL_CONVERSION_GENERIC")) {
+        return InstructionSet::Generic;
+    }
+#if KWIN_PIXELCONVERSION_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return InstructionSet::Avx2;
+    }
+#endif
+#if defined(__SSE2__)
+    return InstructionSet::Sse2;
+#elif defined(__ARM_NEON)
+    return InstructionSet::Neon;
+#else
+    return InstructionSet::Generic;
+#endif
+}
+
+static InstructionSet currentInstructionSet()
+{
+    static const InstructionSet instructionSet = detectInstructionSet();
+    return instructionSet;
+}
+
+static Packed32Kernel packed32Kernel()
+{
+    switch (currentInstructionSet()) {
+#if KWIN_PIXELCONVERSION_AVX2
+    case InstructionSet::Avx2:
+        return convertPacked32Avx2;
+#endif
+#if defined(__SSE2__)
+    case InstructionSet::Sse2:
+        return convertPacked32Sse2;
+#endif
+#if defined(__ARM_NEON)
+    case InstructionSet::Neon:
+        return convertPacked32Neon;
+#endif
+    default:
+        return convertPacked32Generic;
+    }
+}
+
+static Rgba64Kernel rgba64Kernel()
+{
+    switch (currentInstructionSet()) {
+#if KWIN_PIXELCONVERSION_AVX2
+    case InstructionSet::Avx2:
+        return convertRgba64Avx2;
+#endif
+#if defined(__SSE2__)
+    case InstructionSet::Sse2:
+        return convertRgba64Sse2;
+#endif
+#if defined(__ARM_NEON)
+    case InstructionSet::Neon:
+        return convertRgba64Neon;
+#endif
+    default:
+        return convertRgba64Generic;
+    }
+}
+
+static bool packed32Conversion(QImage::Format source, QImage::Format destination, Packed32Conversion *conversion)
+{
+    switch (destination) {
+    case QImage::Format_ARGB32_Premultiplied:
+        conversion->destinationRedShift = 16;
+        conversion->destinationBlueShift = 0;
+        break;
+    case QImage::Format_RGBA8888_Premultiplied:
+        conversion->destinationRedShift = 0;
+        conversion->destinationBlueShift = 16;
+        break;
+    default:
+        return false;
+    }
+
+    switch (source) {
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_RGB32:
+        conversion->redShift = 16;
+        conversion->greenShift = 8;
+        conversion->blueShift = 0;
+        conversion->alphaBits = source == QImage::Format_RGB32 ? 0 : 8;
+        return true;
+    case QImage::Format_A2RGB30_Premultiplied:
+    case QImage::Format_RGB30:
+        conversion->redShift = 22;
+        conversion->greenShift = 12;
+        conversion->blueShift = 2;
+        conversion->alphaBits = source == QImage::Format_RGB30 ? 0 : 2;
+        return true;
+    case QImage::Format_A2BGR30_Premultiplied:
+    case QImage::Format_BGR30:
+        conversion->redShift = 2;
+        conversion->greenShift = 12;
+        conversion->blueShift = 22;
+        conversion->alphaBits = source == QImage::Format_BGR30 ? 0 : 2;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool rgba64Conversion(QImage::Format source, QImage::Format destination, Rgba64Conversion *conversion)
+{
+    if (source != QImage::Format_RGBA64_Premultiplied && source != QImage::Format_RGBX64) {
+        return false;
+    }
+    switch (destination) {
+    case QImage::Format_ARGB32_Premultiplied:
+        conversion->swapRedBlue = true;
+        break;
+    case QImage::Format_RGBA8888_Premultiplied:
+        conversion->swapRedBlue = false;
+        break;
+    default:
+        return false;
+    }
+    conversion->opaque = source == QImage::Format_RGBX64;
+    return true;
+}
+
+bool canConvert(QImage::Format source, QImage::Format destination)
+{
+    if (source == destination) {
+        return QImage::toPixelFormat(source).bitsPerPixel() % 8 == 0;
+    }
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    Packed32Conversion packed32;
+    Rgba64Conversion rgba64;
+    return packed32Conversion(source, destination, &packed32) || rgba64Conversion(source, destination, &rgba64);
+#else
+    return false;
+#endif
+}
+
+bool convert(const QImage &source, const QRect &rect, QImage::Format format, uchar *destination, int stride)
+{
+    if (source.isNull() || !source.rect().contains(rect)) {
+        return false;
+    }
+
+    const int sourceBytesPerPixel = source.depth() / 8;
+    const uchar *sourceBits = source.constBits() + rect.y() * source.bytesPerLine() + rect.x() * sourceBytesPerPixel;
+
+    if (source.format() == format) {
+        if (source.depth() % 8 != 0) {
+            return false;
+        }
+        const int rowSize = rect.width() * sourceBytesPerPixel;
+        for (int y = 0; y < rect.height(); ++y) {
+            std::memcpy(destination + y * stride, sourceBits + y * source.bytesPerLine(), rowSize);
+        }
+        return true;
+    }
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    Packed32Conversion packed32;
+    if (packed32Conversion(source.format(), format, &packed32)) {
+        const Packed32Kernel kernel = packed32Kernel();
+        for (int y = 0; y < rect.height(); ++y) {
+            kernel(sourceBits + y * source.bytesPerLine(), destination + y * stride, rect.width(), packed32);
+        }
+        return true;
+    }
+
+    Rgba64Conversion rgba64;
+    if (rgba64Conversion(source.format(), format, &rgba64)) {
+        const Rgba64Kernel kernel = rgba64Kernel();
+        for (int y = 0; y < rect.height(); ++y) {
+            kernel(sourceBits + y * source.bytesPerLine(), destination + y * stride, rect.width(), rgba64);
+        }
+        return true;
+    }
+#endif
+
+    return false;
+}
+
+const char *instructionSet()
+{
+    switch (currentInstructionSet()) {
+    case InstructionSet::Sse2:
+        return "sse2";
+    case InstructionSet::Avx2:
+        return "avx2";
+    case InstructionSet::Neon:
+        return "neon";
+    case InstructionSet::Generic:
+    default:
+        return "generic";
+    }
+}
+
+} // namespace PixelConversion
+} // namespace KWin
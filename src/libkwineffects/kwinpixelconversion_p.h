@@ -0,0 +1,52 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwinglutils_export.h>
+
+#include <QImage>
+
+namespace KWin
+{
+
+/**
+ * The PixelConversion namespace provides vectorized conversions between the pixel formats of
+ * SHM client buffers and the formats in which GLTexture uploads pixels.
+ *
+ * Supported source formats are Format_ARGB32_Premultiplied, Format_RGB32,
+ * Format_A2RGB30_Premultiplied, Format_RGB30, Format_A2BGR30_Premultiplied, Format_BGR30,
+ * Format_RGBA64_Premultiplied and Format_RGBX64. They can be converted to
+ * Format_ARGB32_Premultiplied and Format_RGBA8888_Premultiplied, or copied without conversion.
+ *
+ * The kernel is picked at runtime based on the features of the CPU: AVX2 or SSE2 on x86,
+ * NEON on ARM, and a portable implementation otherwise.
+ */
+namespace PixelConversion
+{
+
+/**
+ * Returns @c true if pixels in the @a source format can be converted to the @a destination format.
+ */
+KWINGLUTILS_EXPORT bool canConvert(QImage::Format source, QImage::Format destination);
+
+/**
+ * Converts the pixels in the given @a rect of the @a source image to the @a format and writes
+ * them to @a destination, with consecutive rows @a stride bytes apart. Only the pixels inside
+ * the @a rect are read. Returns @c false if the conversion is not supported.
+ */
+KWINGLUTILS_EXPORT bool convert(const QImage &source, const QRect &rect, QImage::Format format, uchar *destination, int stride);
+
+/**
+ * Returns the name of the instruction set used by the conversion kernels, e.g. "avx2".
+ */
+KWINGLUTILS_EXPORT const char *instructionSet();
+
+} // namespace PixelConversion
+} // namespace KWin
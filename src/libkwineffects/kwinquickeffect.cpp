@@ -114,8 +114,21 @@ void QuickSceneView::resetDirty()
 
 void QuickSceneView::scheduleRepaint()
 {
+    if (isDirty()) {
+        return;
+    }
     markDirty();
-    effects->addRepaint(geometry());
+
+    // The view is rendered once control returns to the event loop, unless a compositing cycle
+    // comes first. Only the parts that have changed are repainted, see repaintNeeded().
+    QMetaObject::invokeMethod(
+        this, [this]() {
+            if (isDirty()) {
+                update();
+                resetDirty();
+            }
+        },
+        Qt::QueuedConnection);
 }
 
 QuickSceneEffect::QuickSceneEffect(QObject *parent)
@@ -377,8 +390,8 @@ void QuickSceneEffect::addScreen(EffectScreen *screen)
     }
     view->setAutomaticRepaint(false);
 
-    connect(view, &QuickSceneView::repaintNeeded, this, [view]() {
-        effects->addRepaint(view->geometry());
+    connect(view, &QuickSceneView::repaintNeeded, this, [view](const QRegion &damage) {
+        effects->addRepaint(damage.translated(view->geometry().topLeft()));
     });
     connect(view, &QuickSceneView::renderRequested, view, &QuickSceneView::scheduleRepaint);
     connect(view, &QuickSceneView::sceneChanged, view, &QuickSceneView::scheduleRepaint);
@@ -56,6 +56,9 @@ Options::Options(QObject *parent)
     , m_xwaylandMaxCrashCount(Options::defaultXwaylandMaxCrashCount())
     , m_latencyPolicy(Options::defaultLatencyPolicy())
     , m_renderTimeEstimator(Options::defaultRenderTimeEstimator())
+    , m_renderTimeTargetMissRate(Options::defaultRenderTimeTargetMissRate())
+    , m_occludedFrameCallbackInterval(Options::defaultOccludedFrameCallbackInterval())
+    , m_windowGeometryBroadcastInterval(Options::defaultWindowGeometryBroadcastInterval())
     , m_compositingMode(Options::defaultCompositingMode())
     , m_useCompositing(Options::defaultUseCompositing())
     , m_hiddenPreviews(Options::defaultHiddenPreviews())
@@ -643,6 +646,51 @@ void Options::setRenderTimeEstimator(RenderTimeEstimator estimator)
     Q_EMIT renderTimeEstimatorChanged();
 }
 
+qreal Options::renderTimeTargetMissRate() const
+{
+    return m_renderTimeTargetMissRate;
+}
+
+void Options::setRenderTimeTargetMissRate(qreal missRate)
+{
+    missRate = std::clamp(missRate, 0.0, 0.5);
+    if (m_renderTimeTargetMissRate == missRate) {
+        return;
+    }
+    m_renderTimeTargetMissRate = missRate;
+    Q_EMIT renderTimeTargetMissRateChanged();
+}
+
+int Options::occludedFrameCallbackInterval() const
+{
+    return m_occludedFrameCallbackInterval;
+}
+
+void Options::setOccludedFrameCallbackInterval(int interval)
+{
+    interval = std::max(interval, 0);
+    if (m_occludedFrameCallbackInterval == interval) {
+        return;
+    }
+    m_occludedFrameCallbackInterval = interval;
+    Q_EMIT occludedFrameCallbackIntervalChanged();
+}
+
+int Options::windowGeometryBroadcastInterval() const
+{
+    return m_windowGeometryBroadcastInterval;
+}
+
+void Options::setWindowGeometryBroadcastInterval(int interval)
+{
+    interval = std::max(interval, 0);
+    if (m_windowGeometryBroadcastInterval == interval) {
+        return;
+    }
+    m_windowGeometryBroadcastInterval = interval;
+    Q_EMIT windowGeometryBroadcastIntervalChanged();
+}
+
 void Options::setGlPlatformInterface(OpenGLPlatformInterface interface)
 {
     // check environment variable
@@ -782,6 +830,9 @@ void Options::syncFromKcfgc()
     setMoveMinimizedWindowsToEndOfTabBoxFocusChain(m_settings->moveMinimizedWindowsToEndOfTabBoxFocusChain());
     setLatencyPolicy(m_settings->latencyPolicy());
     setRenderTimeEstimator(m_settings->renderTimeEstimator());
+    setRenderTimeTargetMissRate(m_settings->renderTimeTargetMissRate());
+    setOccludedFrameCallbackInterval(m_settings->occludedFrameCallbackInterval());
+    setWindowGeometryBroadcastInterval(m_settings->windowGeometryBroadcastInterval());
 }
 
 bool Options::loadCompositingConfig(bool force)
@@ -60,6 +60,7 @@ enum RenderTimeEstimator {
     RenderTimeEstimatorMinimum,
     RenderTimeEstimatorMaximum,
     RenderTimeEstimatorAverage,
+    RenderTimeEstimatorAdaptive,
 };
 
 class Settings;
@@ -194,6 +195,21 @@ class KWIN_EXPORT Options : public QObject
     Q_PROPERTY(bool windowsBlockCompositing READ windowsBlockCompositing WRITE setWindowsBlockCompositing NOTIFY windowsBlockCompositingChanged)
     Q_PROPERTY(LatencyPolicy latencyPolicy READ latencyPolicy WRITE setLatencyPolicy NOTIFY latencyPolicyChanged)
     Q_PROPERTY(RenderTimeEstimator renderTimeEstimator READ renderTimeEstimator WRITE setRenderTimeEstimator NOTIFY renderTimeEstimatorChanged)
+    /**
+     * The fraction of frames that are allowed to miss their deadline when the adaptive
+     * render time estimator is used.
+     */
+    Q_PROPERTY(qreal renderTimeTargetMissRate READ renderTimeTargetMissRate WRITE setRenderTimeTargetMissRate NOTIFY renderTimeTargetMissRateChanged)
+    /**
+     * The interval in milliseconds at which windows that are completely covered by other
+     * windows receive frame callbacks. 0 means occluded windows are not throttled.
+     */
+    Q_PROPERTY(int occludedFrameCallbackInterval READ occludedFrameCallbackInterval WRITE setOccludedFrameCallbackInterval NOTIFY occludedFrameCallbackIntervalChanged)
+    /**
+     * The minimum interval in milliseconds between two geometry updates of a window that are
+     * sent to task managers and other shell clients. 0 means every change is sent.
+     */
+    Q_PROPERTY(int windowGeometryBroadcastInterval READ windowGeometryBroadcastInterval WRITE setWindowGeometryBroadcastInterval NOTIFY windowGeometryBroadcastIntervalChanged)
 public:
     explicit Options(QObject *parent = nullptr);
     ~Options() override;
@@ -673,6 +689,9 @@ public:
     QStringList modifierOnlyDBusShortcut(Qt::KeyboardModifier mod) const;
     LatencyPolicy latencyPolicy() const;
     RenderTimeEstimator renderTimeEstimator() const;
+    qreal renderTimeTargetMissRate() const;
+    int occludedFrameCallbackInterval() const;
+    int windowGeometryBroadcastInterval() const;
 
     // setters
     void setFocusPolicy(FocusPolicy focusPolicy);
@@ -731,6 +750,9 @@ public:
     void setMoveMinimizedWindowsToEndOfTabBoxFocusChain(bool set);
     void setLatencyPolicy(LatencyPolicy policy);
     void setRenderTimeEstimator(RenderTimeEstimator estimator);
+    void setRenderTimeTargetMissRate(qreal missRate);
+    void setOccludedFrameCallbackInterval(int interval);
+    void setWindowGeometryBroadcastInterval(int interval);
 
     // default values
     static WindowOperation defaultOperationTitlebarDblClick()
@@ -861,6 +883,18 @@ public:
     {
         return RenderTimeEstimatorMaximum;
     }
+    static qreal defaultRenderTimeTargetMissRate()
+    {
+        return 0.01;
+    }
+    static int defaultOccludedFrameCallbackInterval()
+    {
+        return 1000;
+    }
+    static int defaultWindowGeometryBroadcastInterval()
+    {
+        return 50;
+    }
     /**
      * Performs loading all settings except compositing related.
      */
@@ -932,6 +966,9 @@ Q_SIGNALS:
     void latencyPolicyChanged();
     void configChanged();
     void renderTimeEstimatorChanged();
+    void renderTimeTargetMissRateChanged();
+    void occludedFrameCallbackIntervalChanged();
+    void windowGeometryBroadcastIntervalChanged();
 
 private:
     void setElectricBorders(int borders);
@@ -962,6 +999,9 @@ private:
     int m_xwaylandMaxCrashCount;
     LatencyPolicy m_latencyPolicy;
     RenderTimeEstimator m_renderTimeEstimator;
+    qreal m_renderTimeTargetMissRate;
+    int m_occludedFrameCallbackInterval;
+    int m_windowGeometryBroadcastInterval;
 
     CompositingType m_compositingMode;
     bool m_useCompositing;
@@ -86,6 +86,9 @@ void AbstractEglBackend::teardown()
 void AbstractEglBackend::cleanup()
 {
     cleanupSurfaces();
+    if (m_dmaBuf) {
+        m_dmaBuf->releaseTextures();
+    }
     cleanupGL();
     doneCurrent();
     eglDestroyContext(m_display, m_context);
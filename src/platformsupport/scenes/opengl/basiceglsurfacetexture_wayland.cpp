@@ -8,12 +8,18 @@
 #include "egl_dmabuf.h"
 #include "kwineglext.h"
 #include "kwingltexture.h"
+#include "kwinglutils.h"
+#include "kwinpixelconversion_p.h"
 #include "surfaceitem_wayland.h"
 #include "utils/common.h"
 #include "wayland/drmclientbuffer.h"
 #include "wayland/linuxdmabufv1clientbuffer.h"
 #include "wayland/shmclientbuffer.h"
 
+#include <QtConcurrentMap>
+
+#include <cstring>
+
 namespace KWin
 {
 
@@ -97,11 +103,100 @@ void BasicEGLSurfaceTextureWayland::updateShmTexture(KWaylandServer::ShmClientBu
     }
 
     const QRegion damage = mapRegion(m_pixmap->item()->surfaceToBufferMatrix(), region);
+    if (GLPixelUnpackBuffer *unpackBuffer = GLPixelUnpackBuffer::streamingBuffer()) {
+        if (streamShmTexture(unpackBuffer, image, damage)) {
+            return;
+        }
+    }
     for (const QRect &rect : damage) {
         m_texture->update(image, rect.topLeft(), rect);
     }
 }
 
+bool BasicEGLSurfaceTextureWayland::streamShmTexture(GLPixelUnpackBuffer *unpackBuffer, const QImage &image, const QRegion &damage)
+{
+    const QImage::Format uploadFormat = GLTexture::uploadFormat(image.format());
+    const int bytesPerPixel = QImage::toPixelFormat(uploadFormat).bitsPerPixel() / 8;
+
+    struct Upload
+    {
+        QRect rect;
+        intptr_t offset;
+        int stride;
+    };
+
+    std::vector<Upload> uploads;
+    uploads.reserve(damage.rectCount());
+    size_t size = 0;
+    for (const QRect &rect : damage) {
+        const QRect clipped = rect.intersected(image.rect());
+        if (clipped.isEmpty()) {
+            continue;
+        }
+        const int stride = (clipped.width() * bytesPerPixel + 3) & ~3;
+        uploads.push_back(Upload{clipped, intptr_t(size), stride});
+        size += (size_t(stride) * clipped.height() + 15) & ~size_t(15);
+    }
+    if (uploads.empty()) {
+        return true;
+    }
+
+    intptr_t baseOffset;
+    auto data = static_cast<uint8_t *>(unpackBuffer->allocate(size, &baseOffset));
+    if (!data) {
+        return false;
+    }
+
+    if (PixelConversion::canConvert(image.format(), uploadFormat)) {
+        // The vectorized kernels are fast enough to convert the pixels while they are copied.
+        for (const Upload &upload : uploads) {
+            PixelConversion::convert(image, upload.rect, uploadFormat, data + upload.offset, upload.stride);
+        }
+    } else {
+        // The pixels are copied out of the client buffer on this thread because a SIGBUS
+        // caused by the client shrinking its pool can only be handled here. The conversion
+        // is the expensive part, so it is spread across the worker threads in strips.
+        struct Strip
+        {
+            QImage pixels;
+            uint8_t *destination;
+            int stride;
+        };
+
+        static constexpr int stripHeight = 64;
+        std::vector<Strip> strips;
+        qint64 pixelCount = 0;
+        for (const Upload &upload : uploads) {
+            for (int y = 0; y < upload.rect.height(); y += stripHeight) {
+                const QRect strip(upload.rect.x(), upload.rect.y() + y, upload.rect.width(), std::min(stripHeight, upload.rect.height() - y));
+                strips.push_back(Strip{image.copy(strip), data + upload.offset + y * upload.stride, upload.stride});
+                pixelCount += strip.width() * strip.height();
+            }
+        }
+
+        const auto convert = [uploadFormat, bytesPerPixel](const Strip &strip) {
+            const QImage converted = strip.pixels.convertToFormat(uploadFormat);
+            for (int y = 0; y < converted.height(); ++y) {
+                std::memcpy(strip.destination + y * strip.stride, converted.constScanLine(y), converted.width() * bytesPerPixel);
+            }
+        };
+        if (pixelCount >= 256 * 256) {
+            QtConcurrent::blockingMap(strips, convert);
+        } else {
+            std::for_each(strips.cbegin(), strips.cend(), convert);
+        }
+    }
+
+    unpackBuffer->bind();
+    for (const Upload &upload : uploads) {
+        m_texture->update(upload.rect, uploadFormat, baseOffset + upload.offset);
+    }
+    unpackBuffer->unbind();
+    unpackBuffer->fence();
+
+    return true;
+}
+
 bool BasicEGLSurfaceTextureWayland::loadEglTexture(KWaylandServer::DrmClientBuffer *buffer)
 {
     const AbstractEglBackendFunctions *funcs = backend()->functions();
@@ -155,21 +250,15 @@ void BasicEGLSurfaceTextureWayland::updateEglTexture(KWaylandServer::DrmClientBu
 
 bool BasicEGLSurfaceTextureWayland::loadDmabufTexture(KWaylandServer::LinuxDmaBufV1ClientBuffer *buffer)
 {
-    auto dmabuf = static_cast<EglDmabufBuffer *>(buffer);
-    if (Q_UNLIKELY(dmabuf->images().constFirst() == EGL_NO_IMAGE_KHR)) {
+    // The buffer keeps its texture, switching to a buffer that has been shown before
+    // doesn't need to bind its image again.
+    std::shared_ptr<GLTexture> texture = static_cast<EglDmabufBuffer *>(buffer)->texture();
+    if (Q_UNLIKELY(!texture)) {
         qCritical(KWIN_OPENGL) << "Invalid dmabuf-based wl_buffer";
         return false;
     }
 
-    m_texture.reset(new GLTexture(GL_TEXTURE_2D));
-    m_texture->setSize(dmabuf->size());
-    m_texture->create();
-    m_texture->setWrapMode(GL_CLAMP_TO_EDGE);
-    m_texture->setFilter(GL_NEAREST);
-    m_texture->bind();
-    glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, static_cast<GLeglImageOES>(dmabuf->images().constFirst()));
-    m_texture->unbind();
-    m_texture->setYInverted(dmabuf->origin() == KWaylandServer::ClientBuffer::Origin::TopLeft);
+    m_texture = texture;
     m_bufferType = BufferType::DmaBuf;
 
     return true;
@@ -183,13 +272,9 @@ void BasicEGLSurfaceTextureWayland::updateDmabufTexture(KWaylandServer::LinuxDma
         return;
     }
 
-    auto dmabuf = static_cast<EglDmabufBuffer *>(buffer);
-    m_texture->bind();
-    glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, static_cast<GLeglImageOES>(dmabuf->images().constFirst()));
-    m_texture->unbind();
-    // The origin in a dmabuf-buffer is at the upper-left corner, so the meaning
-    // of Y-inverted is the inverse of OpenGL.
-    m_texture->setYInverted(dmabuf->origin() == KWaylandServer::ClientBuffer::Origin::TopLeft);
+    if (std::shared_ptr<GLTexture> texture = static_cast<EglDmabufBuffer *>(buffer)->texture()) {
+        m_texture = texture;
+    }
 }
 
 EGLImageKHR BasicEGLSurfaceTextureWayland::attach(KWaylandServer::DrmClientBuffer *buffer)
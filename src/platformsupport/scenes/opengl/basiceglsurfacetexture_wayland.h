@@ -21,6 +21,7 @@ namespace KWin
 {
 
 class AbstractEglBackend;
+class GLPixelUnpackBuffer;
 
 class KWIN_EXPORT BasicEGLSurfaceTextureWayland : public OpenGLSurfaceTextureWayland
 {
@@ -36,6 +37,7 @@ public:
 private:
     bool loadShmTexture(KWaylandServer::ShmClientBuffer *buffer);
     void updateShmTexture(KWaylandServer::ShmClientBuffer *buffer, const QRegion &region);
+    bool streamShmTexture(GLPixelUnpackBuffer *unpackBuffer, const QImage &image, const QRegion &damage);
     bool loadEglTexture(KWaylandServer::DrmClientBuffer *buffer);
     void updateEglTexture(KWaylandServer::DrmClientBuffer *buffer);
     bool loadDmabufTexture(KWaylandServer::LinuxDmaBufV1ClientBuffer *buffer);
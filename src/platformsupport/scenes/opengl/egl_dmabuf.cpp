@@ -10,6 +10,8 @@
 #include "egl_dmabuf.h"
 #include "kwineglext.h"
 #include "kwineglutils_p.h"
+#include "kwingltexture.h"
+#include "kwinglutils.h"
 
 #include "utils/common.h"
 #include "wayland_server.h"
@@ -112,6 +114,11 @@ EglDmabufBuffer::EglDmabufBuffer(const QVector<EGLImage> &images,
 
 EglDmabufBuffer::~EglDmabufBuffer()
 {
+    if (m_texture && m_interfaceImpl) {
+        // the texture may be the last reference
+        m_interfaceImpl->m_backend->makeCurrent();
+        releaseTexture();
+    }
     removeImages();
 }
 
@@ -122,17 +129,58 @@ void EglDmabufBuffer::setInterfaceImplementation(EglDmabuf *interfaceImpl)
 
 void EglDmabufBuffer::setImages(const QVector<EGLImage> &images)
 {
+    releaseTexture();
     m_images = images;
 }
 
 void EglDmabufBuffer::removeImages()
 {
+    releaseTexture();
     for (auto image : qAsConst(m_images)) {
         eglDestroyImageKHR(m_interfaceImpl->m_backend->eglDisplay(), image);
     }
     m_images.clear();
 }
 
+std::shared_ptr<GLTexture> EglDmabufBuffer::texture()
+{
+    if (m_texture) {
+        m_interfaceImpl->m_importCacheStatistics.hits++;
+        return m_texture;
+    }
+    if (m_images.isEmpty() || m_images.constFirst() == EGL_NO_IMAGE_KHR) {
+        return nullptr;
+    }
+
+    m_texture = std::make_shared<GLTexture>(GL_TEXTURE_2D);
+    m_texture->setSize(size());
+    m_texture->create();
+    m_texture->setWrapMode(GL_CLAMP_TO_EDGE);
+    m_texture->setFilter(GL_NEAREST);
+    m_texture->bind();
+    glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, static_cast<GLeglImageOES>(m_images.constFirst()));
+    m_texture->unbind();
+    // The origin in a dmabuf-buffer is at the upper-left corner, so the meaning
+    // of Y-inverted is the inverse of OpenGL.
+    m_texture->setYInverted(origin() == KWaylandServer::ClientBuffer::Origin::TopLeft);
+
+    m_interfaceImpl->m_importCacheStatistics.misses++;
+    m_interfaceImpl->m_importCacheStatistics.textures++;
+    return m_texture;
+}
+
+void EglDmabufBuffer::releaseTexture()
+{
+    if (!m_texture) {
+        return;
+    }
+    // surface textures that still show the buffer keep the texture alive
+    m_texture.reset();
+    if (m_interfaceImpl) {
+        m_interfaceImpl->m_importCacheStatistics.textures--;
+    }
+}
+
 KWaylandServer::LinuxDmaBufV1ClientBuffer *EglDmabuf::importBuffer(DmaBufAttributes &&attrs, quint32 flags)
 {
     Q_ASSERT(attrs.planeCount > 0);
@@ -219,6 +267,14 @@ EglDmabuf::EglDmabuf(AbstractEglBackend *backend)
     setSupportedFormatsAndModifiers();
 }
 
+void EglDmabuf::releaseTextures()
+{
+    const auto buffers = waylandServer()->linuxDmabufBuffers();
+    for (auto *buffer : buffers) {
+        static_cast<EglDmabufBuffer *>(buffer)->releaseTexture();
+    }
+}
+
 EglDmabuf::~EglDmabuf()
 {
     auto curBuffers = waylandServer()->linuxDmabufBuffers();
@@ -15,9 +15,12 @@
 
 #include <QVector>
 
+#include <memory>
+
 namespace KWin
 {
 class EglDmabuf;
+class GLTexture;
 
 class EglDmabufBuffer : public LinuxDmaBufV1ClientBuffer
 {
@@ -48,8 +51,20 @@ public:
         return m_images;
     }
 
+    /**
+     * Returns the texture that the image of the buffer is bound to, or @c null if the buffer
+     * has no valid image. The texture is created the first time and kept until the buffer is
+     * destroyed or imported again, so clients cycling through a few buffers don't cause the
+     * image to be bound to a texture on every commit.
+     *
+     * The OpenGL context of the compositor must be current.
+     */
+    std::shared_ptr<GLTexture> texture();
+    void releaseTexture();
+
 private:
     QVector<EGLImage> m_images;
+    std::shared_ptr<GLTexture> m_texture;
     EglDmabuf *m_interfaceImpl;
     ImportType m_importType;
 };
@@ -69,6 +84,21 @@ public:
         return m_tranches;
     }
 
+    struct ImportCacheStatistics
+    {
+        quint64 hits = 0; // the buffer had a texture already
+        quint64 misses = 0; // a texture had to be created for the buffer
+        int textures = 0; // the number of buffers that currently have a texture
+    };
+    ImportCacheStatistics importCacheStatistics() const
+    {
+        return m_importCacheStatistics;
+    }
+    /**
+     * Releases the textures of all buffers, the OpenGL context must be current.
+     */
+    void releaseTextures();
+
 private:
     KWaylandServer::LinuxDmaBufV1ClientBuffer *yuvImport(DmaBufAttributes &&attrs, quint32 flags);
 
@@ -76,6 +106,7 @@ private:
 
     AbstractEglBackend *m_backend;
     QVector<KWaylandServer::LinuxDmaBufV1Feedback::Tranche> m_tranches;
+    ImportCacheStatistics m_importCacheStatistics;
 
     friend class EglDmabufBuffer;
 };
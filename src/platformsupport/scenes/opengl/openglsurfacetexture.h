@@ -30,7 +30,7 @@ public:
 
 protected:
     OpenGLBackend *m_backend;
-    std::unique_ptr<GLTexture> m_texture;
+    std::shared_ptr<GLTexture> m_texture;
 };
 
 } // namespace KWin
@@ -0,0 +1,85 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "pixelreadback.h"
+
+#include "kwinglplatform.h"
+#include "kwingltexture.h"
+#include "kwinglutils.h"
+
+#include <cstring>
+
+namespace KWin
+{
+
+PixelReadback::PixelReadback()
+{
+}
+
+PixelReadback::~PixelReadback()
+{
+    if (m_buffer) {
+        glDeleteBuffers(1, &m_buffer);
+    }
+}
+
+bool PixelReadback::isSupported()
+{
+    // Pixel pack buffers and glMapBufferRange() are core in both OpenGL 3.0 and OpenGLES 3.0.
+    return hasGLVersion(3, 0) || hasGLExtension(QByteArrayLiteral("GL_ARB_map_buffer_range"));
+}
+
+GLFramebuffer *PixelReadback::framebuffer(const QSize &size)
+{
+    if (!m_texture || m_texture->size() != size) {
+        m_framebuffer.reset();
+        m_texture.reset(new GLTexture(GL_RGBA8, size));
+        m_framebuffer.reset(new GLFramebuffer(m_texture.get()));
+    }
+    return m_framebuffer.get();
+}
+
+void PixelReadback::read(GLenum format, int bytesPerPixel)
+{
+    Q_ASSERT(m_framebuffer);
+    const QSize size = m_framebuffer->size();
+    const int stride = (size.width() * bytesPerPixel + 3) & ~3;
+    m_readSize = qsizetype(stride) * size.height();
+
+    if (!m_buffer) {
+        glGenBuffers(1, &m_buffer);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffer);
+    if (m_bufferSize < m_readSize) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, m_readSize, nullptr, GL_STREAM_READ);
+        m_bufferSize = m_readSize;
+    }
+
+    GLFramebuffer::pushFramebuffer(m_framebuffer.get());
+    glReadPixels(0, 0, size.width(), size.height(), format, GL_UNSIGNED_BYTE, nullptr);
+    GLFramebuffer::popFramebuffer();
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+bool PixelReadback::copyTo(void *data, qsizetype size)
+{
+    if (!m_buffer || !m_readSize) {
+        return false;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffer);
+    const void *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, m_readSize, GL_MAP_READ_BIT);
+    if (pixels) {
+        std::memcpy(data, pixels, std::min(size, m_readSize));
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    return pixels != nullptr;
+}
+
+} // namespace KWin
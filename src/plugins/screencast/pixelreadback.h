@@ -0,0 +1,64 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QSize>
+
+#include <epoxy/gl.h>
+
+#include <memory>
+
+namespace KWin
+{
+
+class GLFramebuffer;
+class GLTexture;
+
+/**
+ * The PixelReadback class copies the contents of an offscreen framebuffer to a pixel pack
+ * buffer without waiting for the GPU. Once the GPU has completed the copy, which can be
+ * detected with a fence, the pixels can be copied out with copyTo() without stalling.
+ */
+class PixelReadback
+{
+public:
+    PixelReadback();
+    ~PixelReadback();
+
+    /**
+     * Returns @c true if the OpenGL implementation supports pixel pack buffers that can be
+     * mapped for reading.
+     */
+    static bool isSupported();
+
+    /**
+     * Returns the framebuffer that the frame should be rendered into. The framebuffer is
+     * reallocated if its size doesn't match the given @a size.
+     */
+    GLFramebuffer *framebuffer(const QSize &size);
+
+    /**
+     * Starts copying the contents of the framebuffer to the pixel pack buffer. The rows are
+     * packed with 4 byte alignment.
+     */
+    void read(GLenum format, int bytesPerPixel);
+
+    /**
+     * Copies at most @a size bytes of the pixels read in the last read() call to @a data.
+     * The GPU must have completed the copy, otherwise this function will block.
+     */
+    bool copyTo(void *data, qsizetype size);
+
+private:
+    std::unique_ptr<GLTexture> m_texture;
+    std::unique_ptr<GLFramebuffer> m_framebuffer;
+    GLuint m_buffer = 0;
+    qsizetype m_bufferSize = 0;
+    qsizetype m_readSize = 0;
+};
+
+} // namespace KWin
@@ -19,6 +19,7 @@
 #include "screencaststream.h"
 #include "wayland/display.h"
 #include "wayland/output_interface.h"
+#include "wayland/surface_interface.h"
 #include "wayland_server.h"
 #include "window.h"
 #include "windowscreencastsource.h"
@@ -56,7 +57,7 @@ private:
         connect(Compositor::self()->scene(), &Scene::frameRendered, this, &WindowStream::bufferToStream);
 
         connect(m_window, &Window::damaged, this, &WindowStream::includeDamage);
-        m_damagedRegion = m_window->visibleGeometry().toAlignedRect();
+        m_damagedRegion = QRect(QPoint(), m_window->clientGeometry().size().toSize());
         m_window->output()->renderLoop()->scheduleRepaint();
     }
 
@@ -68,7 +69,16 @@ private:
     void includeDamage(Window *window, const QRegion &damage)
     {
         Q_ASSERT(m_window == window);
-        m_damagedRegion |= damage;
+        // The damage is relative to the surface that has been damaged, which is not known here.
+        // Only the main surface can be mapped to the stream, so repaint everything if there are
+        // sub-surfaces.
+        const KWaylandServer::SurfaceInterface *surface = window->surface();
+        if (surface && (!surface->below().isEmpty() || !surface->above().isEmpty())) {
+            m_damagedRegion = QRect(QPoint(), window->clientGeometry().size().toSize());
+            return;
+        }
+        const QPoint offset = (window->bufferGeometry().topLeft() - window->clientGeometry().topLeft()).toPoint();
+        m_damagedRegion |= damage.translated(offset);
     }
 
     void bufferToStream()
@@ -136,10 +146,14 @@ void ScreencastManager::streamOutput(KWaylandServer::ScreencastStreamV1Interface
     auto stream = new ScreenCastStream(new OutputScreenCastSource(streamOutput), this);
     stream->setObjectName(streamOutput->name());
     stream->setCursorMode(mode, streamOutput->scale(), streamOutput->geometry());
-    auto bufferToStream = [stream](const QRegion &damagedRegion) {
-        if (!damagedRegion.isEmpty()) {
-            stream->recordFrame(damagedRegion);
+    auto bufferToStream = [stream, streamOutput](const QRegion &damagedRegion) {
+        if (damagedRegion.isEmpty()) {
+            return;
         }
+        // Transformed outputs are not mapped to the stream pixel by pixel, repaint everything.
+        const QRect geometry = streamOutput->geometry();
+        const QRegion region = streamOutput->pixelSize() != streamOutput->modeSize() ? geometry : damagedRegion;
+        stream->recordFrame(scaledRegion(region.translated(-geometry.topLeft()), streamOutput->scale()));
     };
     connect(stream, &ScreenCastStream::startStreaming, waylandStream, [streamOutput, stream, bufferToStream] {
         Compositor::self()->scene()->addRepaint(streamOutput->geometry());
@@ -179,7 +193,7 @@ void ScreencastManager::streamRegion(KWaylandServer::ScreencastStreamV1Interface
                     const QRect streamRegion = source->region();
                     const QRegion region = output->pixelSize() != output->modeSize() ? output->geometry() : damagedRegion;
                     source->updateOutput(output);
-                    stream->recordFrame(region.translated(-streamRegion.topLeft()).intersected(streamRegion));
+                    stream->recordFrame(scaledRegion(region.intersected(streamRegion).translated(-streamRegion.topLeft()), source->scale()));
                 };
                 connect(output, &Output::outputChange, stream, bufferToStream);
             }
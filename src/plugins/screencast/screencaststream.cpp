@@ -18,6 +18,7 @@
 #include "kwinscreencast_logging.h"
 #include "main.h"
 #include "pipewirecore.h"
+#include "pixelreadback.h"
 #include "platform.h"
 #include "scene.h"
 #include "screencastsource.h"
@@ -76,6 +77,7 @@ void ScreenCastStream::onStreamStateChanged(void *data, pw_stream_state old, pw_
         }
         break;
     case PW_STREAM_STATE_STREAMING:
+        pw->m_fullDamage = true;
         Q_EMIT pw->startStreaming();
         break;
     case PW_STREAM_STATE_CONNECTING:
@@ -95,6 +97,7 @@ static const int videoDamageRegionCount = 16;
 void ScreenCastStream::newStreamParams()
 {
     qCDebug(KWIN_SCREENCAST) << "announcing stream params. with dmabuf:" << m_dmabufParams.has_value();
+    m_fullDamage = true;
     uint8_t paramsBuffer[1024];
     spa_pod_builder pod_builder = SPA_POD_BUILDER_INIT(paramsBuffer, sizeof(paramsBuffer));
     const int buffertypes = m_dmabufParams ? (1 << SPA_DATA_DmaBuf) : (1 << SPA_DATA_MemFd);
@@ -280,6 +283,12 @@ ScreenCastStream::~ScreenCastStream()
     if (pwStream) {
         pw_stream_destroy(pwStream);
     }
+    if (m_readback) {
+        if (auto scene = Compositor::self()->scene()) {
+            scene->makeOpenGLContextCurrent();
+        }
+        m_readback.reset();
+    }
 }
 
 bool ScreenCastStream::init()
@@ -343,6 +352,16 @@ bool ScreenCastStream::createStream()
     m_hasDmaBuf = kwinApp()->platform()->testCreateDmaBuf(m_resolution, drmFormat, {DRM_FORMAT_MOD_INVALID}).has_value();
     m_modifiers = querySupportedModifiers(kwinApp()->platform()->sceneEglDisplay(), drmFormat);
 
+    // If the frames are going to be copied to memfd buffers, read them back asynchronously so
+    // the compositor doesn't have to wait for the GPU. This requires native fences to know
+    // when the pixels can be copied out of the pixel pack buffer.
+    const bool asyncReadback = qEnvironmentVariableIntValue("KWIN_SCREENCAST_ASYNC_READBACK") != 0
+        || !qEnvironmentVariableIsSet("KWIN_SCREENCAST_ASYNC_READBACK");
+    if (asyncReadback && kwinApp()->platform()->supportsNativeFence() && PixelReadback::isSupported()
+        && (m_source->hasAlphaChannel() || !GLPlatform::instance()->isGLES())) {
+        m_readback = std::make_unique<PixelReadback>();
+    }
+
     char buffer[2048];
     QVector<const spa_pod *> params = buildFormats(false, buffer);
 
@@ -385,6 +404,10 @@ void ScreenCastStream::recordFrame(const QRegion &damagedRegion)
 {
     Q_ASSERT(!m_stopped);
 
+    // The damage of frames that can't be recorded now is carried over to the next one,
+    // otherwise the consumers would keep showing stale contents.
+    m_pendingDamage |= damagedRegion;
+
     if (m_pendingBuffer) {
         qCWarning(KWIN_SCREENCAST) << "Dropping a screencast frame because the compositor is slow";
         return;
@@ -422,6 +445,17 @@ void ScreenCastStream::recordFrame(const QRegion &damagedRegion)
     }
 
     const auto size = m_source->textureSize();
+    const QRect frameRect(QPoint(), size);
+
+    // The cursor is painted on top of the frame, so its previous position needs to be repainted too.
+    auto cursor = Cursors::self()->currentCursor();
+    const bool paintCursor = m_cursor.mode == KWaylandServer::ScreencastV1Interface::Embedded && m_cursor.viewport.contains(cursor->pos());
+    if (m_cursor.mode == KWaylandServer::ScreencastV1Interface::Embedded) {
+        m_pendingDamage |= m_cursor.lastRect;
+        m_cursor.lastRect = QRect();
+    }
+    const QRegion damage = m_fullDamage ? QRegion(frameRect) : m_pendingDamage.intersected(frameRect);
+
     spa_data->chunk->offset = 0;
     if (data || spa_data[0].type == SPA_DATA_MemFd) {
         const bool hasAlpha = m_source->hasAlphaChannel();
@@ -438,13 +472,25 @@ void ScreenCastStream::recordFrame(const QRegion &damagedRegion)
         spa_data->chunk->size = dest.sizeInBytes();
         spa_data->chunk->stride = dest.bytesPerLine();
 
-        m_source->render(&dest);
-
-        auto cursor = Cursors::self()->currentCursor();
-        if (m_cursor.mode == KWaylandServer::ScreencastV1Interface::Embedded && m_cursor.viewport.contains(cursor->pos())) {
-            QPainter painter(&dest);
-            const auto position = (cursor->pos() - m_cursor.viewport.topLeft() - cursor->hotspot()) * m_cursor.scale;
-            painter.drawImage(QRect{position, cursor->image().size()}, cursor->image());
+        if (m_readback) {
+            // The pixels are copied to the buffer in enqueue(), after the GPU is done.
+            GLFramebuffer *framebuffer = m_readback->framebuffer(size);
+            m_source->render(framebuffer);
+            if (paintCursor) {
+                renderCursor(framebuffer);
+            }
+            m_readback->read(hasAlpha ? GL_BGRA : GL_BGR, bpp);
+            m_pendingReadback = true;
+        } else {
+            m_source->render(&dest);
+
+            if (paintCursor) {
+                QPainter painter(&dest);
+                const auto position = (cursor->pos() - m_cursor.viewport.topLeft() - cursor->hotspot()) * m_cursor.scale;
+                const QRect cursorRect(position, cursor->image().size());
+                painter.drawImage(cursorRect, cursor->image());
+                m_cursor.lastRect = cursorRect;
+            }
         }
     } else {
         auto &buf = m_dmabufDataForPwBuffer[buffer];
@@ -460,36 +506,8 @@ void ScreenCastStream::recordFrame(const QRegion &damagedRegion)
 
         m_source->render(buf->framebuffer());
 
-        auto cursor = Cursors::self()->currentCursor();
-        if (m_cursor.mode == KWaylandServer::ScreencastV1Interface::Embedded && m_cursor.viewport.contains(cursor->pos())) {
-            GLFramebuffer::pushFramebuffer(buf->framebuffer());
-
-            QRect r(QPoint(), size);
-            auto shader = ShaderManager::instance()->pushShader(ShaderTrait::MapTexture);
-
-            QMatrix4x4 mvp;
-            mvp.ortho(r);
-            shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
-
-            if (!m_cursor.texture || m_cursor.lastKey != cursor->image().cacheKey()) {
-                m_cursor.texture.reset(new GLTexture(cursor->image()));
-            }
-
-            m_cursor.texture->setYInverted(false);
-            m_cursor.texture->bind();
-            const auto cursorRect = cursorGeometry(cursor);
-            mvp.translate(cursorRect.left(), r.height() - cursorRect.top() - cursor->image().height());
-            shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
-
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            m_cursor.texture->render(cursorRect);
-            glDisable(GL_BLEND);
-            m_cursor.texture->unbind();
-            m_cursor.lastRect = cursorRect;
-
-            ShaderManager::instance()->popShader();
-            GLFramebuffer::popFramebuffer();
+        if (paintCursor) {
+            renderCursor(buf->framebuffer());
         }
     }
 
@@ -498,11 +516,47 @@ void ScreenCastStream::recordFrame(const QRegion &damagedRegion)
                        (spa_meta_cursor *)spa_buffer_find_meta_data(spa_buffer, SPA_META_Cursor, sizeof(spa_meta_cursor)));
     }
 
-    addDamage(spa_buffer, damagedRegion | QRect({0, 0}, size));
+    m_pendingDamage = QRegion();
+    m_fullDamage = false;
+
+    addDamage(spa_buffer, damage | m_cursor.lastRect);
     addHeader(spa_buffer);
     tryEnqueue(buffer);
 }
 
+void ScreenCastStream::renderCursor(GLFramebuffer *framebuffer)
+{
+    auto cursor = Cursors::self()->currentCursor();
+    GLFramebuffer::pushFramebuffer(framebuffer);
+
+    QRect r(QPoint(), framebuffer->size());
+    auto shader = ShaderManager::instance()->pushShader(ShaderTrait::MapTexture);
+
+    QMatrix4x4 mvp;
+    mvp.ortho(r);
+    shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
+
+    if (!m_cursor.texture || m_cursor.lastKey != cursor->image().cacheKey()) {
+        m_cursor.texture.reset(new GLTexture(cursor->image()));
+    }
+
+    m_cursor.texture->setYInverted(false);
+    m_cursor.texture->bind();
+    const auto cursorRect = cursorGeometry(cursor);
+    mvp.translate(cursorRect.left(), r.height() - cursorRect.top() - cursor->image().height());
+    shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    m_cursor.texture->render(cursorRect);
+    glDisable(GL_BLEND);
+    m_cursor.texture->unbind();
+    m_cursor.lastRect = cursorRect;
+
+    ShaderManager::instance()->popShader();
+    GLFramebuffer::popFramebuffer();
+}
+
 void ScreenCastStream::addHeader(spa_buffer *spaBuffer)
 {
     spa_meta_header *spaHeader = (spa_meta_header *)spa_buffer_find_meta_data(spaBuffer, SPA_META_Header, sizeof(spaHeader));
@@ -618,6 +672,18 @@ void ScreenCastStream::enqueue()
     delete m_pendingFence;
     delete m_pendingNotifier;
 
+    if (m_pendingReadback) {
+        m_pendingReadback = false;
+        spa_data *spaData = m_pendingBuffer->buffer->datas;
+        if (auto scene = Compositor::self()->scene()) {
+            scene->makeOpenGLContextCurrent();
+        }
+        if (!m_readback->copyTo(spaData->data, spaData->chunk->size)) {
+            qCWarning(KWIN_SCREENCAST) << "Failed to read back a screencast frame";
+            spaData->chunk->size = 0;
+        }
+    }
+
     pw_stream_queue_buffer(pwStream, m_pendingBuffer);
 
     m_pendingBuffer = nullptr;
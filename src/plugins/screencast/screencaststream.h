@@ -32,8 +32,10 @@ namespace KWin
 
 class Cursor;
 class EGLNativeFence;
+class GLFramebuffer;
 class GLTexture;
 class PipeWireCore;
+class PixelReadback;
 class ScreenCastSource;
 
 class KWIN_EXPORT ScreenCastStream : public QObject
@@ -54,8 +56,9 @@ public:
     void stop();
 
     /**
-     * Renders @p frame into the current framebuffer into the stream
-     * @p timestamp
+     * Renders the current frame of the source into the stream. The @p damagedRegion is
+     * specified in the device pixels of the stream and is forwarded to the consumers.
+     * If the frame can't be recorded, its damage is added to the next frame.
      */
     void recordFrame(const QRegion &damagedRegion);
 
@@ -82,6 +85,7 @@ private:
     void sendCursorData(Cursor *cursor, spa_meta_cursor *spa_cursor);
     void addHeader(spa_buffer *spaBuffer);
     void addDamage(spa_buffer *spaBuffer, const QRegion &damagedRegion);
+    void renderCursor(GLFramebuffer *framebuffer);
     void newStreamParams();
     void tryEnqueue(pw_buffer *buffer);
     void enqueue();
@@ -123,6 +127,10 @@ private:
     pw_buffer *m_pendingBuffer = nullptr;
     QSocketNotifier *m_pendingNotifier = nullptr;
     EGLNativeFence *m_pendingFence = nullptr;
+    std::unique_ptr<PixelReadback> m_readback;
+    bool m_pendingReadback = false;
+    bool m_fullDamage = true;
+    QRegion m_pendingDamage;
     std::optional<std::chrono::nanoseconds> m_start;
     quint64 m_sequential = 0;
     bool m_hasDmaBuf = false;
@@ -27,6 +27,14 @@ WindowScreenCastSource::WindowScreenCastSource(Window *window, QObject *parent)
     , m_window(window)
 {
     connect(m_window, &Window::windowClosed, this, &ScreenCastSource::closed);
+    m_window->refOffscreenRendering();
+}
+
+WindowScreenCastSource::~WindowScreenCastSource()
+{
+    if (m_window) {
+        m_window->unrefOffscreenRendering();
+    }
 }
 
 bool WindowScreenCastSource::hasAlphaChannel() const
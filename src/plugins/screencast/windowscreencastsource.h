@@ -21,6 +21,7 @@ class WindowScreenCastSource : public ScreenCastSource
 
 public:
     explicit WindowScreenCastSource(Window *window, QObject *parent = nullptr);
+    ~WindowScreenCastSource() override;
 
     bool hasAlphaChannel() const override;
     QSize textureSize() const override;
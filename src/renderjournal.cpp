@@ -6,9 +6,54 @@
 
 #include "renderjournal.h"
 
+#include <cmath>
+
 namespace KWin
 {
 
+void RenderTimeHistogram::add(std::chrono::nanoseconds sample)
+{
+    const int bucket = std::clamp(int(sample / bucketWidth), 0, s_bucketCount - 1);
+
+    if (m_count == s_sampleCount) {
+        m_buckets[m_samples[m_head]]--;
+    } else {
+        m_count++;
+    }
+
+    m_samples[m_head] = bucket;
+    m_buckets[bucket]++;
+    m_head = (m_head + 1) % s_sampleCount;
+}
+
+std::chrono::nanoseconds RenderTimeHistogram::percentile(qreal percentile) const
+{
+    if (!m_count) {
+        return std::chrono::nanoseconds::zero();
+    }
+
+    const int threshold = std::max(1, int(std::ceil(std::clamp(percentile, 0.0, 1.0) * m_count)));
+    int accumulated = 0;
+    for (int i = 0; i < s_bucketCount; ++i) {
+        accumulated += m_buckets[i];
+        if (accumulated >= threshold) {
+            return bucketWidth * (i + 1);
+        }
+    }
+
+    return bucketWidth * s_bucketCount;
+}
+
+bool RenderTimeHistogram::isEmpty() const
+{
+    return m_count == 0;
+}
+
+int RenderTimeHistogram::sampleCount() const
+{
+    return m_count;
+}
+
 RenderJournal::RenderJournal()
 {
 }
@@ -25,6 +70,25 @@ void RenderJournal::endFrame()
         m_log.dequeue();
     }
     m_log.enqueue(duration);
+    m_cpuHistogram.add(duration);
+}
+
+void RenderJournal::addGpuCompletionTime(std::chrono::nanoseconds duration)
+{
+    m_gpuHistogram.add(duration);
+}
+
+void RenderJournal::addPresentation(bool missed)
+{
+    if (m_presentationCount == int(m_presentations.size())) {
+        m_missCount -= m_presentations[m_presentationHead];
+    } else {
+        m_presentationCount++;
+    }
+
+    m_presentations[m_presentationHead] = missed;
+    m_missCount += missed;
+    m_presentationHead = (m_presentationHead + 1) % m_presentations.size();
 }
 
 std::chrono::nanoseconds RenderJournal::minimum() const
@@ -53,4 +117,32 @@ std::chrono::nanoseconds RenderJournal::average() const
     return result / m_log.count();
 }
 
+std::chrono::nanoseconds RenderJournal::percentile(qreal percentile) const
+{
+    return std::max(cpuPercentile(percentile), gpuPercentile(percentile));
+}
+
+std::chrono::nanoseconds RenderJournal::cpuPercentile(qreal percentile) const
+{
+    return m_cpuHistogram.percentile(percentile);
+}
+
+std::chrono::nanoseconds RenderJournal::gpuPercentile(qreal percentile) const
+{
+    return m_gpuHistogram.percentile(percentile);
+}
+
+int RenderJournal::sampleCount() const
+{
+    return m_cpuHistogram.sampleCount();
+}
+
+qreal RenderJournal::missRate() const
+{
+    if (!m_presentationCount) {
+        return 0;
+    }
+    return qreal(m_missCount) / m_presentationCount;
+}
+
 } // namespace KWin
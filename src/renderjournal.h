@@ -11,12 +11,56 @@
 #include <QElapsedTimer>
 #include <QQueue>
 
+#include <array>
+
 namespace KWin
 {
 
+/**
+ * The RenderTimeHistogram class keeps a histogram of the most recent render time samples,
+ * which allows querying percentiles without sorting the samples.
+ */
+class KWIN_EXPORT RenderTimeHistogram
+{
+public:
+    /**
+     * Adds the given @a sample to the histogram. If the histogram is full, the oldest
+     * sample is discarded.
+     */
+    void add(std::chrono::nanoseconds sample);
+
+    /**
+     * Returns the smallest render time that is greater than or equal to the given
+     * @a percentile of the samples, e.g. 0.99 corresponds to the 99th percentile.
+     */
+    std::chrono::nanoseconds percentile(qreal percentile) const;
+
+    bool isEmpty() const;
+
+    /**
+     * Returns the number of samples in the histogram.
+     */
+    int sampleCount() const;
+
+    static constexpr std::chrono::nanoseconds bucketWidth = std::chrono::microseconds(50);
+
+private:
+    static constexpr int s_bucketCount = 512;
+    static constexpr int s_sampleCount = 256;
+
+    std::array<quint16, s_bucketCount> m_buckets = {};
+    std::array<quint16, s_sampleCount> m_samples = {};
+    int m_head = 0;
+    int m_count = 0;
+};
+
 /**
  * The RenderJournal class measures how long it takes to render frames and estimates how
  * long it will take to render the next frame.
+ *
+ * The time spent on the CPU and the time it takes for the GPU to complete the frame are
+ * tracked separately. The GPU completion time is measured from the moment the compositor
+ * started submitting rendering commands.
  */
 class KWIN_EXPORT RenderJournal
 {
@@ -33,6 +77,17 @@ public:
      */
     void endFrame();
 
+    /**
+     * Records how long it took the GPU to complete a frame. The GPU completion time is
+     * usually known only some time after endFrame() has been called.
+     */
+    void addGpuCompletionTime(std::chrono::nanoseconds duration);
+
+    /**
+     * Records whether the last presented frame has missed its deadline.
+     */
+    void addPresentation(bool missed);
+
     /**
      * Returns the maximum estimated amount of time that it takes to render a single frame.
      */
@@ -48,10 +103,43 @@ public:
      */
     std::chrono::nanoseconds average() const;
 
+    /**
+     * Returns the estimated amount of time that is enough to render the given @a percentile
+     * of frames, taking both the CPU and the GPU time into account.
+     */
+    std::chrono::nanoseconds percentile(qreal percentile) const;
+
+    /**
+     * Returns the given @a percentile of the time spent on the CPU rendering frames.
+     */
+    std::chrono::nanoseconds cpuPercentile(qreal percentile) const;
+
+    /**
+     * Returns the given @a percentile of the GPU completion time, or zero if the GPU
+     * completion time is not known.
+     */
+    std::chrono::nanoseconds gpuPercentile(qreal percentile) const;
+
+    /**
+     * Returns the number of recent frames whose CPU render time has been measured.
+     */
+    int sampleCount() const;
+
+    /**
+     * Returns the fraction of recently presented frames that have missed their deadline.
+     */
+    qreal missRate() const;
+
 private:
     QElapsedTimer m_timer;
     QQueue<std::chrono::nanoseconds> m_log;
     int m_size = 15;
+    RenderTimeHistogram m_cpuHistogram;
+    RenderTimeHistogram m_gpuHistogram;
+    std::array<bool, 256> m_presentations = {};
+    int m_presentationHead = 0;
+    int m_presentationCount = 0;
+    int m_missCount = 0;
 };
 
 } // namespace KWin
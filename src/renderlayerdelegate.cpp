@@ -29,6 +29,11 @@ QRegion RenderLayerDelegate::repaints() const
     return QRegion();
 }
 
+QRegion RenderLayerDelegate::opaque() const
+{
+    return QRegion();
+}
+
 void RenderLayerDelegate::prePaint()
 {
 }
@@ -36,6 +36,12 @@ public:
      */
     virtual QRegion repaints() const;
 
+    /**
+     * Returns the region of the render layer that is fully opaque, in the layer-local
+     * coordinates. The compositor uses it to drop the damage of the layers underneath.
+     */
+    virtual QRegion opaque() const;
+
     /**
      * This function is called by the compositor before starting compositing. Reimplement
      * this function to do frame initialization.
@@ -26,12 +26,16 @@ RenderLoopPrivate *RenderLoopPrivate::get(RenderLoop *loop)
 RenderLoopPrivate::RenderLoopPrivate(RenderLoop *q)
     : q(q)
 {
-    compositeTimer.setSingleShot(true);
-    QObject::connect(&compositeTimer, &QTimer::timeout, q, [this]() {
+    QObject::connect(&compositeTimer, &MonotonicTimer::timeout, q, [this]() {
+        const std::chrono::nanoseconds currentTime(std::chrono::steady_clock::now().time_since_epoch());
+        recordWakeupLatency(currentTime - compositeTimer.deadline());
         dispatch();
     });
 }
 
+// The number of frames that have to be measured before the adaptive estimator is used.
+static const int s_minimumAdaptiveSampleCount = 100;
+
 void RenderLoopPrivate::scheduleRepaint()
 {
     if (kwinApp()->isTerminating() || compositeTimer.isActive()) {
@@ -53,37 +57,52 @@ void RenderLoopPrivate::scheduleRepaint()
     }
 
     // Estimate when it's a good time to perform the next compositing cycle.
-    const std::chrono::nanoseconds safetyMargin = std::chrono::milliseconds(3);
+    std::chrono::nanoseconds safetyMargin = std::chrono::milliseconds(3);
 
-    std::chrono::nanoseconds renderTime;
-    switch (q->latencyPolicy()) {
-    case LatencyExtremelyLow:
-        renderTime = std::chrono::nanoseconds(long(vblankInterval.count() * 0.1));
-        break;
-    case LatencyLow:
-        renderTime = std::chrono::nanoseconds(long(vblankInterval.count() * 0.25));
-        break;
-    case LatencyMedium:
-        renderTime = std::chrono::nanoseconds(long(vblankInterval.count() * 0.5));
-        break;
-    case LatencyHigh:
-        renderTime = std::chrono::nanoseconds(long(vblankInterval.count() * 0.75));
-        break;
-    case LatencyExtremelyHigh:
-        renderTime = std::chrono::nanoseconds(long(vblankInterval.count() * 0.9));
-        break;
-    }
+    // The percentiles are meaningless until enough frames have been measured, the fixed
+    // estimate based on the latency policy is used until then.
+    const qreal targetMissRate = options->renderTimeTargetMissRate();
+    const bool adaptive = options->renderTimeEstimator() == RenderTimeEstimatorAdaptive
+        && renderJournal.sampleCount() >= s_minimumAdaptiveSampleCount;
 
-    switch (options->renderTimeEstimator()) {
-    case RenderTimeEstimatorMinimum:
-        renderTime = std::max(renderTime, renderJournal.minimum());
-        break;
-    case RenderTimeEstimatorMaximum:
-        renderTime = std::max(renderTime, renderJournal.maximum());
-        break;
-    case RenderTimeEstimatorAverage:
-        renderTime = std::max(renderTime, renderJournal.average());
-        break;
+    std::chrono::nanoseconds renderTime;
+    if (adaptive) {
+        // Aim for the configured fraction of frames that are allowed to miss the deadline.
+        // The safety margin is tuned based on the frames that actually missed it.
+        renderTime = renderJournal.percentile(1.0 - targetMissRate);
+        safetyMargin = adaptiveSafetyMargin;
+    } else {
+        switch (q->latencyPolicy()) {
+        case LatencyExtremelyLow:
+            renderTime = std::chrono::nanoseconds(long(vblankInterval.count() * 0.1));
+            break;
+        case LatencyLow:
+            renderTime = std::chrono::nanoseconds(long(vblankInterval.count() * 0.25));
+            break;
+        case LatencyMedium:
+            renderTime = std::chrono::nanoseconds(long(vblankInterval.count() * 0.5));
+            break;
+        case LatencyHigh:
+            renderTime = std::chrono::nanoseconds(long(vblankInterval.count() * 0.75));
+            break;
+        case LatencyExtremelyHigh:
+            renderTime = std::chrono::nanoseconds(long(vblankInterval.count() * 0.9));
+            break;
+        }
+
+        switch (options->renderTimeEstimator()) {
+        case RenderTimeEstimatorMinimum:
+            renderTime = std::max(renderTime, renderJournal.minimum());
+            break;
+        case RenderTimeEstimatorMaximum:
+            renderTime = std::max(renderTime, renderJournal.maximum());
+            break;
+        case RenderTimeEstimatorAverage:
+            renderTime = std::max(renderTime, renderJournal.average());
+            break;
+        case RenderTimeEstimatorAdaptive:
+            break;
+        }
     }
 
     std::chrono::nanoseconds nextRenderTimestamp = nextPresentationTimestamp - renderTime - safetyMargin;
@@ -93,8 +112,7 @@ void RenderLoopPrivate::scheduleRepaint()
         nextRenderTimestamp = currentTime;
     }
 
-    const std::chrono::nanoseconds waitInterval = nextRenderTimestamp - currentTime;
-    compositeTimer.start(std::chrono::duration_cast<std::chrono::milliseconds>(waitInterval));
+    compositeTimer.start(nextRenderTimestamp);
 }
 
 void RenderLoopPrivate::delayScheduleRepaint()
@@ -120,11 +138,35 @@ void RenderLoopPrivate::notifyFrameFailed()
     }
 }
 
+void RenderLoopPrivate::updateAdaptiveSafetyMargin(std::chrono::nanoseconds timestamp)
+{
+    if (presentMode != SyncMode::Fixed || lastPresentationTimestamp == std::chrono::nanoseconds::zero()) {
+        return;
+    }
+
+    const std::chrono::nanoseconds vblankInterval(1'000'000'000'000ull / refreshRate);
+    const bool missed = timestamp > nextPresentationTimestamp + vblankInterval / 2;
+    renderJournal.addPresentation(missed);
+
+    if (options->renderTimeEstimator() != RenderTimeEstimatorAdaptive) {
+        return;
+    }
+
+    const qreal targetMissRate = options->renderTimeTargetMissRate();
+    if (missed && renderJournal.missRate() > targetMissRate) {
+        adaptiveSafetyMargin = std::min(adaptiveSafetyMargin + std::chrono::microseconds(250), std::chrono::nanoseconds(vblankInterval / 2));
+    } else if (!missed && renderJournal.missRate() <= targetMissRate) {
+        adaptiveSafetyMargin = std::max(adaptiveSafetyMargin - std::chrono::microseconds(10), std::chrono::nanoseconds(std::chrono::microseconds(250)));
+    }
+}
+
 void RenderLoopPrivate::notifyFrameCompleted(std::chrono::nanoseconds timestamp)
 {
     Q_ASSERT(pendingFrameCount > 0);
     pendingFrameCount--;
 
+    updateAdaptiveSafetyMargin(timestamp);
+
     if (lastPresentationTimestamp <= timestamp) {
         lastPresentationTimestamp = timestamp;
     } else {
@@ -155,6 +197,13 @@ void RenderLoopPrivate::dispatch()
     pendingRepaint = false;
 }
 
+void RenderLoopPrivate::recordWakeupLatency(std::chrono::nanoseconds latency)
+{
+    wakeupLatencies[wakeupLatencyHead] = std::max(latency, std::chrono::nanoseconds::zero());
+    wakeupLatencyHead = (wakeupLatencyHead + 1) % wakeupLatencies.size();
+    wakeupLatencyCount = std::min<int>(wakeupLatencyCount + 1, wakeupLatencies.size());
+}
+
 void RenderLoopPrivate::invalidate()
 {
     pendingReschedule = false;
@@ -202,6 +251,22 @@ void RenderLoop::endFrame()
     d->renderJournal.endFrame();
 }
 
+void RenderLoop::addGpuCompletionTime(std::chrono::nanoseconds duration)
+{
+    d->renderJournal.addGpuCompletionTime(duration);
+}
+
+QVector<std::chrono::nanoseconds> RenderLoop::wakeupLatencies() const
+{
+    QVector<std::chrono::nanoseconds> latencies;
+    latencies.reserve(d->wakeupLatencyCount);
+    const int first = d->wakeupLatencyHead - d->wakeupLatencyCount + d->wakeupLatencies.size();
+    for (int i = 0; i < d->wakeupLatencyCount; ++i) {
+        latencies.append(d->wakeupLatencies[(first + i) % d->wakeupLatencies.size()]);
+    }
+    return latencies;
+}
+
 int RenderLoop::refreshRate() const
 {
     return d->refreshRate;
@@ -10,6 +10,7 @@
 #include "options.h"
 
 #include <QObject>
+#include <QVector>
 
 namespace KWin
 {
@@ -59,6 +60,19 @@ public:
      */
     void endFrame();
 
+    /**
+     * Reports how long it took the GPU to complete a previously rendered frame, measured
+     * from the moment the Compositor started submitting rendering commands. It's used to
+     * estimate the render time of the next frame.
+     */
+    void addGpuCompletionTime(std::chrono::nanoseconds duration);
+
+    /**
+     * Returns how late the most recent compositing cycles have been started compared to
+     * the scheduled time, oldest first. It can be used to diagnose scheduling jitter.
+     */
+    QVector<std::chrono::nanoseconds> wakeupLatencies() const;
+
     /**
      * Returns the refresh rate at which the output is being updated, in millihertz.
      */
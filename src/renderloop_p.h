@@ -8,9 +8,9 @@
 
 #include "renderjournal.h"
 #include "renderloop.h"
+#include "utils/monotonictimer.h"
 
-#include <QTimer>
-
+#include <array>
 #include <optional>
 
 namespace KWin
@@ -29,14 +29,20 @@ public:
     void scheduleRepaint();
     void maybeScheduleRepaint();
 
+    void updateAdaptiveSafetyMargin(std::chrono::nanoseconds timestamp);
     void notifyFrameFailed();
     void notifyFrameCompleted(std::chrono::nanoseconds timestamp);
+    void recordWakeupLatency(std::chrono::nanoseconds latency);
 
     RenderLoop *q;
     std::chrono::nanoseconds lastPresentationTimestamp = std::chrono::nanoseconds::zero();
     std::chrono::nanoseconds nextPresentationTimestamp = std::chrono::nanoseconds::zero();
-    QTimer compositeTimer;
+    MonotonicTimer compositeTimer;
     RenderJournal renderJournal;
+    std::array<std::chrono::nanoseconds, 128> wakeupLatencies = {};
+    int wakeupLatencyHead = 0;
+    int wakeupLatencyCount = 0;
+    std::chrono::nanoseconds adaptiveSafetyMargin = std::chrono::milliseconds(1);
     int refreshRate = 60000;
     int pendingFrameCount = 0;
     int inhibitCount = 0;
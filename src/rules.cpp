@@ -18,6 +18,8 @@
 #include <QTemporaryFile>
 #include <kconfig.h>
 
+#include <algorithm>
+
 #ifndef KCMRULES
 #include "client_machine.h"
 #include "main.h"
@@ -126,6 +128,10 @@ void Rules::readFromSettings(const RuleSettings *settings)
     READ_MATCH_STRING(windowrole, .toLower().toLatin1());
     READ_MATCH_STRING(title, );
     READ_MATCH_STRING(clientmachine, .toLower().toLatin1());
+    wmclassregexp = compileRegExp(wmclassmatch, QString::fromUtf8(wmclass));
+    windowroleregexp = compileRegExp(windowrolematch, QString::fromUtf8(windowrole));
+    titleregexp = compileRegExp(titlematch, title);
+    clientmachineregexp = compileRegExp(clientmachinematch, QString::fromUtf8(clientmachine));
     types = NET::WindowTypeMask(settings->types());
     READ_FORCE_RULE(placement, );
     READ_SET_RULE(position);
@@ -323,6 +329,16 @@ QString Rules::getDecoColor(const QString &themeName)
                                   QLatin1String("color-schemes/") + themeName + QLatin1String(".colors"));
 }
 
+QRegularExpression Rules::compileRegExp(StringMatch match, const QString &pattern)
+{
+    if (match != RegExpMatch) {
+        return QRegularExpression();
+    }
+    QRegularExpression expression(pattern);
+    expression.optimize();
+    return expression;
+}
+
 bool Rules::matchType(NET::WindowType match_type) const
 {
     if (types != NET::AllTypesMask) {
@@ -343,7 +359,7 @@ bool Rules::matchWMClass(const QByteArray &match_class, const QByteArray &match_
         QByteArray cwmclass = wmclasscomplete
             ? match_name + ' ' + match_class
             : match_class;
-        if (wmclassmatch == RegExpMatch && !QRegularExpression(QString::fromUtf8(wmclass)).match(QString::fromUtf8(cwmclass)).hasMatch()) {
+        if (wmclassmatch == RegExpMatch && !wmclassregexp.match(QString::fromUtf8(cwmclass)).hasMatch()) {
             return false;
         }
         if (wmclassmatch == ExactMatch && wmclass != cwmclass) {
@@ -359,7 +375,7 @@ bool Rules::matchWMClass(const QByteArray &match_class, const QByteArray &match_
 bool Rules::matchRole(const QByteArray &match_role) const
 {
     if (windowrolematch != UnimportantMatch) {
-        if (windowrolematch == RegExpMatch && !QRegularExpression(QString::fromUtf8(windowrole)).match(QString::fromUtf8(match_role)).hasMatch()) {
+        if (windowrolematch == RegExpMatch && !windowroleregexp.match(QString::fromUtf8(match_role)).hasMatch()) {
             return false;
         }
         if (windowrolematch == ExactMatch && windowrole != match_role) {
@@ -375,7 +391,7 @@ bool Rules::matchRole(const QByteArray &match_role) const
 bool Rules::matchTitle(const QString &match_title) const
 {
     if (titlematch != UnimportantMatch) {
-        if (titlematch == RegExpMatch && !QRegularExpression(title).match(match_title).hasMatch()) {
+        if (titlematch == RegExpMatch && !titleregexp.match(match_title).hasMatch()) {
             return false;
         }
         if (titlematch == ExactMatch && title != match_title) {
@@ -397,7 +413,7 @@ bool Rules::matchClientMachine(const QByteArray &match_machine, bool local) cons
             return true;
         }
         if (clientmachinematch == RegExpMatch
-            && !QRegularExpression(QString::fromUtf8(clientmachine)).match(QString::fromUtf8(match_machine)).hasMatch()) {
+            && !clientmachineregexp.match(QString::fromUtf8(match_machine)).hasMatch()) {
             return false;
         }
         if (clientmachinematch == ExactMatch
@@ -413,7 +429,7 @@ bool Rules::matchClientMachine(const QByteArray &match_machine, bool local) cons
 }
 
 #ifndef KCMRULES
-bool Rules::match(const Window *c) const
+bool Rules::matchIgnoringTitle(const Window *c) const
 {
     if (!matchType(c->windowType(true))) {
         return false;
@@ -427,8 +443,16 @@ bool Rules::match(const Window *c) const
     if (!matchClientMachine(c->clientMachine()->hostName(), c->clientMachine()->isLocal())) {
         return false;
     }
+    return true;
+}
+
+bool Rules::match(const Window *c) const
+{
+    if (!matchIgnoringTitle(c)) {
+        return false;
+    }
     if (titlematch != UnimportantMatch) { // track title changes to rematch rules
-        QObject::connect(c, &Window::captionChanged, c, &Window::evaluateWindowRules,
+        QObject::connect(c, &Window::captionChanged, c, &Window::evaluateTitleRules,
                          // QueuedConnection, because title may change before
                          // the client is ready (could segfault!)
                          static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::UniqueConnection));
@@ -917,33 +941,94 @@ void RuleBook::deleteAll()
 {
     qDeleteAll(m_rules);
     m_rules.clear();
+    m_indexDirty = true;
+}
+
+void RuleBook::updateIndex()
+{
+    m_rulesByClass.clear();
+    m_rulesByCompleteClass.clear();
+    m_unindexedRules.clear();
+
+    for (int i = 0; i < m_rules.count(); ++i) {
+        const Rules *rule = m_rules[i];
+        if (rule->wmclassmatch != Rules::ExactMatch) {
+            m_unindexedRules.append(i);
+        } else if (rule->wmclasscomplete) {
+            m_rulesByCompleteClass[rule->wmclass].append(i);
+        } else {
+            m_rulesByClass[rule->wmclass].append(i);
+        }
+    }
+
+    m_indexDirty = false;
+}
+
+QVector<int> RuleBook::candidateRules(const Window *c)
+{
+    if (m_indexDirty) {
+        updateIndex();
+    }
+
+    const QVector<int> byClass = m_rulesByClass.value(c->resourceClass());
+    const QVector<int> byCompleteClass = m_rulesByCompleteClass.value(c->resourceName() + ' ' + c->resourceClass());
+    if (byClass.isEmpty() && byCompleteClass.isEmpty()) {
+        return m_unindexedRules;
+    }
+
+    // Keep the order of the rule book, the rules that come first have higher priority.
+    QVector<int> indexed;
+    indexed.reserve(byClass.count() + byCompleteClass.count());
+    std::merge(byClass.cbegin(), byClass.cend(), byCompleteClass.cbegin(), byCompleteClass.cend(), std::back_inserter(indexed));
+
+    QVector<int> candidates;
+    candidates.reserve(indexed.count() + m_unindexedRules.count());
+    std::merge(indexed.cbegin(), indexed.cend(), m_unindexedRules.cbegin(), m_unindexedRules.cend(), std::back_inserter(candidates));
+    return candidates;
 }
 
 WindowRules RuleBook::find(const Window *c, bool ignore_temporary)
 {
     QVector<Rules *> ret;
-    for (QList<Rules *>::Iterator it = m_rules.begin();
-         it != m_rules.end();) {
-        if (ignore_temporary && (*it)->isTemporary()) {
-            ++it;
+    bool consumedTemporary = false;
+    const QVector<int> candidates = candidateRules(c);
+    for (int index : candidates) {
+        Rules *rule = m_rules[index];
+        if (ignore_temporary && rule->isTemporary()) {
             continue;
         }
-        if ((*it)->match(c)) {
-            Rules *rule = *it;
+        if (rule->match(c)) {
             qCDebug(KWIN_CORE) << "Rule found:" << rule << ":" << c;
             if (rule->isTemporary()) {
-                it = m_rules.erase(it);
-            } else {
-                ++it;
+                m_rules[index] = nullptr;
+                consumedTemporary = true;
             }
             ret.append(rule);
-            continue;
         }
-        ++it;
+    }
+    if (consumedTemporary) {
+        m_rules.removeAll(nullptr);
+        m_indexDirty = true;
     }
     return WindowRules(ret);
 }
 
+bool RuleBook::titleRulesChanged(const Window *c)
+{
+    const QVector<int> candidates = candidateRules(c);
+    for (int index : candidates) {
+        const Rules *rule = m_rules[index];
+        if (rule->titlematch == Rules::UnimportantMatch || rule->isTemporary()) {
+            continue;
+        }
+        const bool matches = rule->matchIgnoringTitle(c) && rule->matchTitle(c->captionNormal());
+        if (matches != c->rules()->contains(rule)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void RuleBook::edit(Window *c, bool whole_app)
 {
     save();
@@ -978,6 +1063,7 @@ void RuleBook::load()
     RuleBookSettings book(m_config);
     book.load();
     m_rules = book.rules().toList();
+    m_indexDirty = true;
 }
 
 void RuleBook::save()
@@ -1010,6 +1096,7 @@ void RuleBook::temporaryRulesMessage(const QString &message)
     }
     Rules *rule = new Rules(message, true);
     m_rules.prepend(rule); // highest priority first
+    m_indexDirty = true;
     if (!was_temporary) {
         QTimer::singleShot(60000, this, &RuleBook::cleanupTemporaryRules);
     }
@@ -1022,6 +1109,7 @@ void RuleBook::cleanupTemporaryRules()
          it != m_rules.end();) {
         if ((*it)->discardTemporary(false)) { // deletes (*it)
             it = m_rules.erase(it);
+            m_indexDirty = true;
         } else {
             if ((*it)->isTemporary()) {
                 has_temporary = true;
@@ -1047,6 +1135,7 @@ void RuleBook::discardUsed(Window *c, bool withdrawn)
                 c->removeRule(*it);
                 Rules *r = *it;
                 it = m_rules.erase(it);
+                m_indexDirty = true;
                 delete r;
                 continue;
             }
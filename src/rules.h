@@ -10,7 +10,9 @@
 #ifndef KWIN_RULES_H
 #define KWIN_RULES_H
 
+#include <QHash>
 #include <QRectF>
+#include <QRegularExpression>
 #include <QVector>
 #include <netwm_def.h>
 
@@ -197,12 +199,16 @@ private:
     bool matchRole(const QByteArray &match_role) const;
     bool matchTitle(const QString &match_title) const;
     bool matchClientMachine(const QByteArray &match_machine, bool local) const;
+#ifndef KCMRULES
+    bool matchIgnoringTitle(const Window *c) const;
+#endif
 #ifdef KCMRULES
 private:
 #endif
     void readFromSettings(const RuleSettings *settings);
     static ForceRule convertForceRule(int v);
     static QString getDecoColor(const QString &themeName);
+    static QRegularExpression compileRegExp(StringMatch match, const QString &pattern);
 #ifndef KCMRULES
     static bool checkSetRule(SetRule rule, bool init);
     static bool checkForceRule(ForceRule rule);
@@ -220,6 +226,11 @@ private:
     StringMatch titlematch;
     QByteArray clientmachine;
     StringMatch clientmachinematch;
+    // Compiled once when the rule is read, only valid for RegExpMatch
+    QRegularExpression wmclassregexp;
+    QRegularExpression windowroleregexp;
+    QRegularExpression titleregexp;
+    QRegularExpression clientmachineregexp;
     NET::WindowTypes types; // types for matching
     Placement::Policy placement;
     ForceRule placementrule;
@@ -294,6 +305,7 @@ private:
     QString desktopfile;
     SetRule desktopfilerule;
     friend QDebug &operator<<(QDebug &stream, const Rules *);
+    friend class RuleBook;
 };
 
 #ifndef KCMRULES
@@ -304,6 +316,11 @@ public:
     explicit RuleBook();
     ~RuleBook() override;
     WindowRules find(const Window *, bool);
+    /**
+     * Returns @c true if the caption of the window @p c affects whether a rule that depends
+     * on the window title matches the window, and the rules have to be evaluated again.
+     */
+    bool titleRulesChanged(const Window *c);
     void discardUsed(Window *c, bool withdraw);
     void setUpdatesDisabled(bool disable);
     bool areUpdatesDisabled() const;
@@ -325,9 +342,17 @@ private:
     void deleteAll();
     void initializeX11();
     void cleanupX11();
+    void updateIndex();
+    QVector<int> candidateRules(const Window *c);
     QTimer *m_updateTimer;
     bool m_updatesDisabled;
     QList<Rules *> m_rules;
+    // Positions in m_rules of the rules that can match a window, the rules that match an
+    // exact window class are bucketed by the class.
+    QHash<QByteArray, QVector<int>> m_rulesByClass;
+    QHash<QByteArray, QVector<int>> m_rulesByCompleteClass;
+    QVector<int> m_unindexedRules;
+    bool m_indexDirty = true;
     std::unique_ptr<KXMessages> m_temporaryRulesMessages;
     KSharedConfig::Ptr m_config;
 };
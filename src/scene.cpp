@@ -131,7 +131,11 @@ QRect SceneDelegate::viewport() const
 // Scene
 //****************************************
 
-Scene::Scene() = default;
+Scene::Scene()
+{
+    m_occludedFrameCallbackTimer.setSingleShot(true);
+    connect(&m_occludedFrameCallbackTimer, &QTimer::timeout, this, &Scene::sendOccludedFrameCallbacks);
+}
 
 Scene::~Scene()
 {
@@ -331,6 +335,9 @@ void Scene::preparePaintGenericScreen()
         data.mask = m_paintContext.mask;
         data.paint = infiniteRegion(); // no clipping, so doesn't really matter
 
+        // Effects can paint windows anywhere, so assume that all of them are visible.
+        windowItem->setOcclusion(painted_screen, WindowOcclusion::Visible);
+
         effects->prePaintWindow(windowItem->window()->effectWindow(), data, m_expectedPresentTimestamp);
         m_paintContext.phase2Data.append(Phase2Data{
             .item = windowItem,
@@ -378,6 +385,22 @@ void Scene::preparePaintSimpleScreen()
     for (int i = m_paintContext.phase2Data.size() - 1; i >= 0; --i) {
         const auto &paintData = m_paintContext.phase2Data.at(i);
         m_paintContext.damage += paintData.region - opaque;
+
+        // The windows above have been accumulated, classify how much of this window is visible.
+        if (paintData.mask & PAINT_WINDOW_TRANSFORMED) {
+            paintData.item->setOcclusion(painted_screen, WindowOcclusion::Visible);
+        } else {
+            const QRect geometry = paintData.item->window()->frameGeometry().toAlignedRect() & renderTargetRect();
+            const QRegion visible = QRegion(geometry) - opaque;
+            if (visible.isEmpty()) {
+                paintData.item->setOcclusion(painted_screen, WindowOcclusion::Occluded);
+            } else if (visible == geometry) {
+                paintData.item->setOcclusion(painted_screen, WindowOcclusion::Visible);
+            } else {
+                paintData.item->setOcclusion(painted_screen, WindowOcclusion::PartiallyVisible);
+            }
+        }
+
         if (!(paintData.mask & (PAINT_WINDOW_TRANSLUCENT | PAINT_WINDOW_TRANSFORMED))) {
             opaque += paintData.opaque;
         }
@@ -401,15 +424,42 @@ void Scene::postPaint()
             if (!window->isOnOutput(painted_screen)) {
                 continue;
             }
-            if (auto surface = window->surface()) {
-                surface->frameRendered(frameTime.count());
+            auto surface = window->surface();
+            if (!surface) {
+                continue;
             }
+            // Clients that are completely covered don't need to render at the refresh rate,
+            // unless they are captured by a screencast or shown in a thumbnail.
+            if (window->frameCallbacksThrottled()) {
+                if (!m_occludedFrameCallbackTimer.isActive()) {
+                    m_occludedFrameCallbackTimer.start(options->occludedFrameCallbackInterval());
+                }
+                continue;
+            }
+            surface->frameRendered(frameTime.count());
         }
     }
 
     clearStackingOrder();
 }
 
+void Scene::sendOccludedFrameCallbacks()
+{
+    const std::chrono::milliseconds frameTime =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch());
+
+    const auto windows = workspace()->stackingOrder();
+    for (Window *window : windows) {
+        WindowItem *windowItem = window->windowItem();
+        if (!windowItem || !windowItem->isVisible() || !window->frameCallbacksThrottled()) {
+            continue;
+        }
+        if (auto surface = window->surface()) {
+            surface->frameRendered(frameTime.count());
+        }
+    }
+}
+
 static QMatrix4x4 createProjectionMatrix(const QRect &rect)
 {
     // Create a perspective projection with a 60° field-of-view,
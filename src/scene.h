@@ -19,6 +19,7 @@
 
 #include <QElapsedTimer>
 #include <QMatrix4x4>
+#include <QTimer>
 
 namespace KWin
 {
@@ -230,6 +231,8 @@ protected:
     QVector<WindowItem *> stacking_order;
 
 private:
+    void sendOccludedFrameCallbacks();
+
     std::chrono::milliseconds m_expectedPresentTimestamp = std::chrono::milliseconds::zero();
     QList<SceneDelegate *> m_delegates;
     QRect m_geometry;
@@ -239,6 +242,8 @@ private:
     // how many times finalPaintScreen() has been called
     int m_paintScreenCount = 0;
     PaintContext m_paintContext;
+    // sends frame callbacks to occluded windows at a reduced rate
+    QTimer m_occludedFrameCallbackTimer;
 };
 
 } // namespace
@@ -0,0 +1,88 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "decorationatlas.h"
+
+#include "kwingltexture.h"
+#include "kwinglutils.h"
+
+#include <algorithm>
+
+namespace KWin
+{
+
+static int align(int value, int align)
+{
+    return (value + align - 1) & ~(align - 1);
+}
+
+DecorationAtlas::DecorationAtlas()
+{
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    m_maxTextureSize = maxTextureSize;
+
+    // Wide enough for the decorations of maximized windows on most screens, and tall enough
+    // for a handful of shelves.
+    m_pageSize = QSize(std::min(4096, m_maxTextureSize), std::min(256, m_maxTextureSize));
+}
+
+DecorationAtlas::~DecorationAtlas() = default;
+
+DecorationAtlas::Slot DecorationAtlas::allocate(const QSize &size)
+{
+    if (size.isEmpty() || size.width() > m_maxTextureSize || size.height() > m_maxTextureSize) {
+        return Slot();
+    }
+
+    // Leave some room in the slot for the decoration to grow during interactive resizes. The
+    // height of decorations rarely changes, it only has to be rounded so shelves can be shared.
+    const QSize slotSize(std::clamp(align(size.width() + size.width() / 4, 128), size.width(), m_maxTextureSize),
+                         std::clamp(align(size.height(), 8), size.height(), m_maxTextureSize));
+
+    for (const auto &page : m_pages) {
+        if (const auto rect = page->allocator->allocate(slotSize)) {
+            return Slot{page->texture.get(), *rect};
+        }
+    }
+
+    // Decorations that don't fit in a regular page get a page of their own.
+    const QSize pageSize = m_pageSize.expandedTo(slotSize);
+    auto page = std::make_unique<Page>();
+    page->texture = std::make_unique<GLTexture>(GL_RGBA8, pageSize.width(), pageSize.height());
+    if (page->texture->isNull()) {
+        return Slot();
+    }
+    page->texture->setYInverted(true);
+    page->texture->setWrapMode(GL_CLAMP_TO_EDGE);
+    page->texture->clear();
+    page->allocator = std::make_unique<ShelfAllocator>(pageSize);
+
+    const auto rect = page->allocator->allocate(slotSize);
+    Q_ASSERT(rect);
+    m_pages.push_back(std::move(page));
+    return Slot{m_pages.back()->texture.get(), *rect};
+}
+
+void DecorationAtlas::release(const Slot &slot)
+{
+    if (!slot.isValid()) {
+        return;
+    }
+
+    auto pageIt = std::find_if(m_pages.begin(), m_pages.end(), [&slot](const auto &page) {
+        return page->texture.get() == slot.texture;
+    });
+    Q_ASSERT(pageIt != m_pages.end());
+    Page *page = pageIt->get();
+
+    page->allocator->release(slot.rect);
+    if (page->allocator->isEmpty()) {
+        m_pages.erase(pageIt);
+    }
+}
+
+} // namespace KWin
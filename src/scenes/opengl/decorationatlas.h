@@ -0,0 +1,63 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "shelfallocator.h"
+
+#include <memory>
+#include <vector>
+
+namespace KWin
+{
+
+class GLTexture;
+
+/**
+ * The DecorationAtlas class packs the textures of server-side decorations into a few
+ * large textures instead of allocating one texture per window.
+ *
+ * The atlas textures are split in shelves by a ShelfAllocator. Slots are larger than
+ * requested so that a decoration can grow a little during an interactive resize without
+ * having to move to another slot.
+ */
+class DecorationAtlas
+{
+public:
+    struct Slot
+    {
+        GLTexture *texture = nullptr;
+        QRect rect;
+
+        bool isValid() const
+        {
+            return texture;
+        }
+    };
+
+    DecorationAtlas();
+    ~DecorationAtlas();
+
+    /**
+     * Allocates a slot that is at least as large as @p size. Returns an invalid slot if the
+     * size is empty or it exceeds the maximum texture size.
+     */
+    Slot allocate(const QSize &size);
+    void release(const Slot &slot);
+
+private:
+    struct Page
+    {
+        std::unique_ptr<GLTexture> texture;
+        std::unique_ptr<ShelfAllocator> allocator;
+    };
+
+    std::vector<std::unique_ptr<Page>> m_pages;
+    QSize m_pageSize;
+    int m_maxTextureSize;
+};
+
+} // namespace KWin
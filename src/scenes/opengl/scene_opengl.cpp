@@ -22,6 +22,8 @@
 #include "effects.h"
 #include "main.h"
 #include "output.h"
+#include "renderloop.h"
+#include "rendertarget.h"
 #include "shadowitem.h"
 #include "surfaceitem.h"
 #include "utils/common.h"
@@ -30,6 +32,7 @@
 
 #include <cmath>
 #include <cstddef>
+#include <vector>
 
 #include <QMatrix4x4>
 #include <QPainter>
@@ -85,10 +88,51 @@ bool SceneOpenGL::initFailed() const
 
 void SceneOpenGL::paint(RenderTarget *renderTarget, const QRegion &region)
 {
-    Q_UNUSED(renderTarget)
+    m_releasedTimerQueries.clear();
+
+    const RenderTarget::NativeHandle nativeHandle = renderTarget->nativeHandle();
+    if (std::holds_alternative<GLFramebuffer *>(nativeHandle)) {
+        m_renderTargetFramebuffer = std::get<GLFramebuffer *>(nativeHandle);
+    }
+
+    GLTimerQuery *timerQuery = renderTimeQuery(painted_screen->renderLoop());
+    if (timerQuery) {
+        if (timerQuery->fetchResult()) {
+            painted_screen->renderLoop()->addGpuCompletionTime(timerQuery->completionTime());
+        }
+        timerQuery->begin();
+    }
+
     GLVertexBuffer::streamingBuffer()->beginFrame();
     paintScreen(region);
     GLVertexBuffer::streamingBuffer()->endOfFrame();
+
+    if (timerQuery) {
+        timerQuery->end();
+    }
+
+    m_renderTargetFramebuffer = nullptr;
+}
+
+GLTimerQuery *SceneOpenGL::renderTimeQuery(RenderLoop *renderLoop)
+{
+    if (!GLTimerQuery::supported()) {
+        return nullptr;
+    }
+
+    auto it = m_renderTimeQueries.find(renderLoop);
+    if (it == m_renderTimeQueries.end()) {
+        connect(renderLoop, &RenderLoop::destroyed, this, [this, renderLoop]() {
+            auto it = m_renderTimeQueries.find(renderLoop);
+            if (it != m_renderTimeQueries.end()) {
+                // The OpenGL context may be not current at this moment, release the query later.
+                m_releasedTimerQueries.push_back(std::move(it->second));
+                m_renderTimeQueries.erase(it);
+            }
+        });
+        it = m_renderTimeQueries.emplace(renderLoop, std::make_unique<GLTimerQuery>()).first;
+    }
+    return it->second.get();
 }
 
 void SceneOpenGL::paintBackground(const QRegion &region)
@@ -168,7 +212,10 @@ Shadow *SceneOpenGL::createShadow(Window *window)
 
 DecorationRenderer *SceneOpenGL::createDecorationRenderer(Decoration::DecoratedClientImpl *impl)
 {
-    return new SceneOpenGLDecorationRenderer(impl);
+    if (!m_decorationAtlas) {
+        m_decorationAtlas = std::make_shared<DecorationAtlas>();
+    }
+    return new SceneOpenGLDecorationRenderer(impl, m_decorationAtlas);
 }
 
 bool SceneOpenGL::animationsSupported() const
@@ -284,10 +331,19 @@ static GLTexture *bindSurfaceTexture(SurfaceItem *surfaceItem)
     return platformSurfaceTexture->texture();
 }
 
+// Regions with at most this many rects are clipped with the scissor test rather than by
+// splitting quads, which allows to reuse the vertex data of items across frames.
+static const int s_maxScissorRectCount = 8;
+
+static bool needsSoftwareClipping(const SceneOpenGL::RenderContext *context)
+{
+    return context->clip != infiniteRegion() && !context->hardwareClipping;
+}
+
 static WindowQuadList clipQuads(const Item *item, const SceneOpenGL::RenderContext *context)
 {
     const WindowQuadList quads = item->quads();
-    if (context->clip != infiniteRegion() && !context->hardwareClipping) {
+    if (needsSoftwareClipping(context)) {
         const QPoint offset = context->transformStack.top().map(QPoint(0, 0));
 
         WindowQuadList ret;
@@ -336,12 +392,14 @@ void SceneOpenGL::createRenderNode(Item *item, RenderContext *context)
     }
 
     item->preprocess();
+    const bool softwareClipped = needsSoftwareClipping(context);
     if (auto shadowItem = qobject_cast<ShadowItem *>(item)) {
         WindowQuadList quads = clipQuads(item, context);
         if (!quads.isEmpty()) {
             SceneOpenGLShadow *shadow = static_cast<SceneOpenGLShadow *>(shadowItem->shadow());
             context->renderNodes.append(RenderNode{
                 .texture = shadow->shadowTexture(),
+                .item = softwareClipped ? nullptr : item,
                 .quads = quads,
                 .transformMatrix = context->transformStack.top(),
                 .opacity = context->opacityStack.top(),
@@ -355,6 +413,7 @@ void SceneOpenGL::createRenderNode(Item *item, RenderContext *context)
             auto renderer = static_cast<const SceneOpenGLDecorationRenderer *>(decorationItem->renderer());
             context->renderNodes.append(RenderNode{
                 .texture = renderer->texture(),
+                .item = softwareClipped ? nullptr : item,
                 .quads = quads,
                 .transformMatrix = context->transformStack.top(),
                 .opacity = context->opacityStack.top(),
@@ -371,6 +430,7 @@ void SceneOpenGL::createRenderNode(Item *item, RenderContext *context)
                 bool hasAlpha = pixmap->hasAlphaChannel() && !surfaceItem->shape().subtracted(surfaceItem->opaque()).isEmpty();
                 context->renderNodes.append(RenderNode{
                     .texture = bindSurfaceTexture(surfaceItem),
+                    .item = softwareClipped ? nullptr : item,
                     .quads = quads,
                     .transformMatrix = context->transformStack.top(),
                     .opacity = context->opacityStack.top(),
@@ -409,15 +469,84 @@ QMatrix4x4 SceneOpenGL::modelViewProjectionMatrix(const WindowPaintData &data) c
     }
 }
 
+GLVertexBuffer *SceneOpenGL::cachedVertexBuffer(RenderNode *node, GLenum primitiveType, int verticesPerQuad)
+{
+    auto it = m_vertexBufferCache.find(node->item);
+    if (it == m_vertexBufferCache.end()) {
+        Item *item = node->item;
+        connect(item, &Item::quadsChanged, this, [this, item]() {
+            if (auto it = m_vertexBufferCache.find(item); it != m_vertexBufferCache.end()) {
+                it->second.valid = false;
+            }
+        });
+        connect(item, &Item::destroyed, this, [this, item]() {
+            discardCachedVertexBuffer(item);
+        });
+
+        CachedVertexBuffer cache;
+        cache.vbo = std::make_unique<GLVertexBuffer>(GLVertexBuffer::Dynamic);
+        const GLVertexAttrib attribs[] = {
+            {VA_Position, 2, GL_FLOAT, offsetof(GLVertex2D, position)},
+            {VA_TexCoord, 2, GL_FLOAT, offsetof(GLVertex2D, texcoord)},
+        };
+        cache.vbo->setAttribLayout(attribs, 2, sizeof(GLVertex2D));
+        it = m_vertexBufferCache.emplace(item, std::move(cache)).first;
+    }
+
+    CachedVertexBuffer &cache = it->second;
+    const QMatrix4x4 textureMatrix = node->texture->matrix(node->coordinateType);
+    if (!cache.valid || cache.primitiveType != primitiveType || cache.textureMatrix != textureMatrix) {
+        cache.vertexCount = node->quads.count() * verticesPerQuad;
+        cache.textureMatrix = textureMatrix;
+        cache.primitiveType = primitiveType;
+
+        GLVertex2D *map = static_cast<GLVertex2D *>(cache.vbo->map(cache.vertexCount * sizeof(GLVertex2D)));
+        node->quads.makeInterleavedArrays(primitiveType, map, textureMatrix);
+        cache.vbo->unmap();
+        cache.valid = true;
+    }
+
+    node->firstVertex = 0;
+    node->vertexCount = cache.vertexCount;
+    return cache.vbo.get();
+}
+
+void SceneOpenGL::discardCachedVertexBuffer(Item *item)
+{
+    auto it = m_vertexBufferCache.find(item);
+    if (it != m_vertexBufferCache.end()) {
+        // The OpenGL context may be not current at this moment, release the buffer later.
+        m_releasedVertexBuffers.push_back(std::move(it->second.vbo));
+        m_vertexBufferCache.erase(it);
+    }
+}
+
+bool SceneOpenGL::canUseScissorClipping() const
+{
+    // Scissor rects are in whole device pixels, so the clip region can be mapped to them
+    // exactly only with an integer scale. Effects may redirect painting into their own
+    // framebuffers, whose coordinate system doesn't match the one of the output.
+    return m_renderTargetFramebuffer
+        && GLFramebuffer::currentFramebuffer() == m_renderTargetFramebuffer
+        && qFuzzyCompare(renderTargetScale(), std::round(renderTargetScale()));
+}
+
 void SceneOpenGL::render(Item *item, int mask, const QRegion &region, const WindowPaintData &data)
 {
     if (region.isEmpty()) {
         return;
     }
 
+    m_releasedVertexBuffers.clear();
+
+    // Prefer scissor clipping if the region is simple enough so the cached vertex data
+    // can be used as is. This is only possible if the item is painted on the output.
+    const bool transformed = (mask & Scene::PAINT_WINDOW_TRANSFORMED) || (mask & Scene::PAINT_SCREEN_TRANSFORMED);
+    const bool scissorable = data.projectionMatrix().isIdentity() && region.rectCount() <= s_maxScissorRectCount && canUseScissorClipping();
+
     RenderContext renderContext{
         .clip = region,
-        .hardwareClipping = region != infiniteRegion() && ((mask & Scene::PAINT_WINDOW_TRANSFORMED) || (mask & Scene::PAINT_SCREEN_TRANSFORMED)),
+        .hardwareClipping = region != infiniteRegion() && (transformed || scissorable),
     };
 
     renderContext.transformStack.push(QMatrix4x4());
@@ -428,8 +557,12 @@ void SceneOpenGL::render(Item *item, int mask, const QRegion &region, const Wind
     createRenderNode(item, &renderContext);
 
     int quadCount = 0;
+    int streamingQuadCount = 0;
     for (const RenderNode &node : qAsConst(renderContext.renderNodes)) {
         quadCount += node.quads.count();
+        if (!node.item) {
+            streamingQuadCount += node.quads.count();
+        }
     }
     if (!quadCount) {
         return;
@@ -438,7 +571,7 @@ void SceneOpenGL::render(Item *item, int mask, const QRegion &region, const Wind
     const bool indexedQuads = GLVertexBuffer::supportsIndexedQuads();
     const GLenum primitiveType = indexedQuads ? GL_QUADS : GL_TRIANGLES;
     const int verticesPerQuad = indexedQuads ? 4 : 6;
-    const size_t size = verticesPerQuad * quadCount * sizeof(GLVertex2D);
+    const size_t size = verticesPerQuad * streamingQuadCount * sizeof(GLVertex2D);
 
     ShaderTraits shaderTraits = ShaderTrait::MapTexture;
 
@@ -455,10 +588,12 @@ void SceneOpenGL::render(Item *item, int mask, const QRegion &region, const Wind
     };
 
     GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
-    vbo->reset();
-    vbo->setAttribLayout(attribs, 2, sizeof(GLVertex2D));
-
-    GLVertex2D *map = (GLVertex2D *)vbo->map(size);
+    GLVertex2D *map = nullptr;
+    if (streamingQuadCount) {
+        vbo->reset();
+        vbo->setAttribLayout(attribs, 2, sizeof(GLVertex2D));
+        map = (GLVertex2D *)vbo->map(size);
+    }
 
     for (int i = 0, v = 0; i < renderContext.renderNodes.count(); i++) {
         RenderNode &renderNode = renderContext.renderNodes[i];
@@ -470,6 +605,12 @@ void SceneOpenGL::render(Item *item, int mask, const QRegion &region, const Wind
             shaderTraits |= ShaderTrait::Modulate;
         }
 
+        if (renderNode.item) {
+            renderNode.vertexBuffer = cachedVertexBuffer(&renderNode, primitiveType, verticesPerQuad);
+            continue;
+        }
+
+        renderNode.vertexBuffer = vbo;
         renderNode.firstVertex = v;
         renderNode.vertexCount = renderNode.quads.count() * verticesPerQuad;
 
@@ -479,8 +620,9 @@ void SceneOpenGL::render(Item *item, int mask, const QRegion &region, const Wind
         v += renderNode.quads.count() * verticesPerQuad;
     }
 
-    vbo->unmap();
-    vbo->bindArrays();
+    if (streamingQuadCount) {
+        vbo->unmap();
+    }
 
     GLShader *shader = data.shader;
     if (!shader) {
@@ -504,12 +646,21 @@ void SceneOpenGL::render(Item *item, int mask, const QRegion &region, const Wind
     }
 
     const QMatrix4x4 projectionMatrix = modelViewProjectionMatrix(data);
+    GLVertexBuffer *boundVertexBuffer = nullptr;
     for (int i = 0; i < renderContext.renderNodes.count(); i++) {
         const RenderNode &renderNode = renderContext.renderNodes[i];
         if (renderNode.vertexCount == 0) {
             continue;
         }
 
+        if (boundVertexBuffer != renderNode.vertexBuffer) {
+            if (boundVertexBuffer) {
+                boundVertexBuffer->unbindArrays();
+            }
+            boundVertexBuffer = renderNode.vertexBuffer;
+            boundVertexBuffer->bindArrays();
+        }
+
         setBlendEnabled(renderNode.hasAlpha || renderNode.opacity < 1.0);
 
         shader->setUniform(GLShader::ModelViewProjectionMatrix, projectionMatrix * renderNode.transformMatrix);
@@ -523,11 +674,13 @@ void SceneOpenGL::render(Item *item, int mask, const QRegion &region, const Wind
         renderNode.texture->setWrapMode(GL_CLAMP_TO_EDGE);
         renderNode.texture->bind();
 
-        vbo->draw(scissorRegion, primitiveType, renderNode.firstVertex,
-                  renderNode.vertexCount, renderContext.hardwareClipping);
+        boundVertexBuffer->draw(scissorRegion, primitiveType, renderNode.firstVertex,
+                                renderNode.vertexCount, renderContext.hardwareClipping);
     }
 
-    vbo->unbindArrays();
+    if (boundVertexBuffer) {
+        boundVertexBuffer->unbindArrays();
+    }
 
     setBlendEnabled(false);
 
@@ -715,9 +868,9 @@ bool SceneOpenGLShadow::prepareBackend()
     return true;
 }
 
-SceneOpenGLDecorationRenderer::SceneOpenGLDecorationRenderer(Decoration::DecoratedClientImpl *client)
+SceneOpenGLDecorationRenderer::SceneOpenGLDecorationRenderer(Decoration::DecoratedClientImpl *client, const std::shared_ptr<DecorationAtlas> &atlas)
     : DecorationRenderer(client)
-    , m_texture()
+    , m_atlas(atlas)
 {
 }
 
@@ -726,6 +879,20 @@ SceneOpenGLDecorationRenderer::~SceneOpenGLDecorationRenderer()
     if (Scene *scene = Compositor::self()->scene()) {
         scene->makeOpenGLContextCurrent();
     }
+    m_atlas->release(m_slot);
+}
+
+static QImage scratchImage(const QSize &size)
+{
+    // Decoration parts are rasterized into a buffer that is reused between renders, rather
+    // than into a freshly allocated image every time. The rows are tightly packed because
+    // GLTexture::update() can't pass the stride to GLES without GL_EXT_unpack_subimage.
+    static thread_local std::vector<uint32_t> scratch;
+    const size_t pixelCount = size_t(size.width()) * size.height();
+    if (scratch.size() < pixelCount) {
+        scratch.resize(pixelCount);
+    }
+    return QImage(reinterpret_cast<uchar *>(scratch.data()), size.width(), size.height(), size.width() * 4, QImage::Format_ARGB32_Premultiplied);
 }
 
 static void clamp_row(int left, int width, int right, const uint32_t *src, uint32_t *dest)
@@ -785,7 +952,7 @@ void SceneOpenGLDecorationRenderer::render(const QRegion &region)
         resetImageSizesDirty();
     }
 
-    if (!m_texture) {
+    if (!m_slot.isValid()) {
         // for invalid sizes we get no texture, see BUG 361551
         return;
     }
@@ -833,7 +1000,7 @@ void SceneOpenGLDecorationRenderer::renderPart(const QRect &rect, const QRect &p
     QSize paddedImageSize = imageSize;
     paddedImageSize.rheight() += verticalPadding;
     paddedImageSize.rwidth() += horizontalPadding;
-    QImage image(paddedImageSize, QImage::Format_ARGB32_Premultiplied);
+    QImage image = scratchImage(paddedImageSize);
     image.setDevicePixelRatio(devicePixelRatio);
     image.fill(Qt::transparent);
 
@@ -863,7 +1030,7 @@ void SceneOpenGLDecorationRenderer::renderPart(const QRect &rect, const QRect &p
     if (padding.left() == 0) {
         dirtyOffset.rx() += TexturePad;
     }
-    m_texture->update(image, textureOffset + dirtyOffset);
+    m_slot.texture->update(image, m_slot.rect.topLeft() + textureOffset + dirtyOffset, image.rect());
 }
 
 const QMargins SceneOpenGLDecorationRenderer::texturePadForPart(
@@ -885,11 +1052,6 @@ const QMargins SceneOpenGLDecorationRenderer::texturePadForPart(
     return result;
 }
 
-static int align(int value, int align)
-{
-    return (value + align - 1) & ~(align - 1);
-}
-
 void SceneOpenGLDecorationRenderer::resizeTexture()
 {
     QRectF left, top, right, bottom;
@@ -902,20 +1064,17 @@ void SceneOpenGLDecorationRenderer::resizeTexture()
 
     size.rheight() += 4 * (2 * TexturePad);
     size.rwidth() += 2 * TexturePad;
-    size.rwidth() = align(size.width(), 128);
 
-    if (m_texture && m_texture->size() == size) {
+    // Keep the current slot as long as the decoration fits in it, unless it shrank so much
+    // that most of the slot would be wasted.
+    if (m_slot.isValid() && m_slot.rect.width() >= size.width() && m_slot.rect.height() >= size.height()
+        && size.width() * 2 >= m_slot.rect.width()) {
         return;
     }
 
-    if (!size.isEmpty()) {
-        m_texture.reset(new GLTexture(GL_RGBA8, size.width(), size.height()));
-        m_texture->setYInverted(true);
-        m_texture->setWrapMode(GL_CLAMP_TO_EDGE);
-        m_texture->clear();
-    } else {
-        m_texture.reset();
-    }
+    m_atlas->release(m_slot);
+    m_slot = m_atlas->allocate(size);
+    setTextureOffset(m_slot.rect.topLeft());
 }
 
 int SceneOpenGLDecorationRenderer::toNativeSize(int size) const
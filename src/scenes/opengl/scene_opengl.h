@@ -13,15 +13,19 @@
 
 #include "openglbackend.h"
 
+#include "decorationatlas.h"
 #include "decorationitem.h"
 #include "scene.h"
 #include "shadow.h"
 
 #include "kwinglutils.h"
 
+#include <unordered_map>
+
 namespace KWin
 {
 class OpenGLBackend;
+class RenderLoop;
 
 class KWIN_EXPORT SceneOpenGL
     : public Scene
@@ -31,6 +35,8 @@ public:
     struct RenderNode
     {
         GLTexture *texture = nullptr;
+        Item *item = nullptr;
+        GLVertexBuffer *vertexBuffer = nullptr;
         WindowQuadList quads;
         QMatrix4x4 transformMatrix;
         int firstVertex = 0;
@@ -85,11 +91,35 @@ private:
     QVector4D modulate(float opacity, float brightness) const;
     void setBlendEnabled(bool enabled);
     void createRenderNode(Item *item, RenderContext *context);
+    GLVertexBuffer *cachedVertexBuffer(RenderNode *node, GLenum primitiveType, int verticesPerQuad);
+    void discardCachedVertexBuffer(Item *item);
+    bool canUseScissorClipping() const;
+    GLTimerQuery *renderTimeQuery(RenderLoop *renderLoop);
+
+    /**
+     * The CachedVertexBuffer struct holds the vertex data of an item across frames, so
+     * items whose quads haven't changed don't need to be re-uploaded.
+     */
+    struct CachedVertexBuffer
+    {
+        std::unique_ptr<GLVertexBuffer> vbo;
+        QMatrix4x4 textureMatrix;
+        GLenum primitiveType = GL_TRIANGLES;
+        int vertexCount = 0;
+        bool valid = false;
+    };
 
     bool init_ok = true;
     OpenGLBackend *m_backend;
     GLuint vao = 0;
     bool m_blendingEnabled = false;
+    // the framebuffer of the output that is being painted
+    GLFramebuffer *m_renderTargetFramebuffer = nullptr;
+    std::unordered_map<Item *, CachedVertexBuffer> m_vertexBufferCache;
+    std::vector<std::unique_ptr<GLVertexBuffer>> m_releasedVertexBuffers;
+    std::unordered_map<RenderLoop *, std::unique_ptr<GLTimerQuery>> m_renderTimeQueries;
+    std::vector<std::unique_ptr<GLTimerQuery>> m_releasedTimerQueries;
+    std::shared_ptr<DecorationAtlas> m_decorationAtlas;
 };
 
 /**
@@ -128,18 +158,18 @@ public:
         Bottom,
         Count
     };
-    explicit SceneOpenGLDecorationRenderer(Decoration::DecoratedClientImpl *client);
+    SceneOpenGLDecorationRenderer(Decoration::DecoratedClientImpl *client, const std::shared_ptr<DecorationAtlas> &atlas);
     ~SceneOpenGLDecorationRenderer() override;
 
     void render(const QRegion &region) override;
 
-    GLTexture *texture()
-    {
-        return m_texture.get();
-    }
+    /**
+     * Returns the atlas texture that contains the decoration, the decoration occupies the area
+     * at textureOffset() in it.
+     */
     GLTexture *texture() const
     {
-        return m_texture.get();
+        return m_slot.texture;
     }
 
 private:
@@ -147,7 +177,8 @@ private:
     static const QMargins texturePadForPart(const QRect &rect, const QRect &partRect);
     void resizeTexture();
     int toNativeSize(int size) const;
-    std::unique_ptr<GLTexture> m_texture;
+    std::shared_ptr<DecorationAtlas> m_atlas;
+    DecorationAtlas::Slot m_slot;
 };
 
 } // namespace
@@ -0,0 +1,104 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "shelfallocator.h"
+
+#include <algorithm>
+
+namespace KWin
+{
+
+ShelfAllocator::ShelfAllocator(const QSize &size)
+    : m_size(size)
+{
+}
+
+bool ShelfAllocator::isEmpty() const
+{
+    return m_slotCount == 0;
+}
+
+std::optional<QRect> ShelfAllocator::allocate(const QSize &size)
+{
+    for (Shelf &shelf : m_shelves) {
+        // Don't waste tall shelves on short decorations.
+        if (shelf.height < size.height() || shelf.height > size.height() + size.height() / 2) {
+            continue;
+        }
+        for (int i = 0; i < shelf.freeSlots.count(); ++i) {
+            QRect &freeSlot = shelf.freeSlots[i];
+            if (freeSlot.width() < size.width()) {
+                continue;
+            }
+            const QRect rect(freeSlot.x(), shelf.y, size.width(), shelf.height);
+            if (freeSlot.width() == size.width()) {
+                shelf.freeSlots.removeAt(i);
+            } else {
+                freeSlot.setLeft(freeSlot.left() + size.width());
+            }
+            m_slotCount++;
+            return rect;
+        }
+        if (m_size.width() - shelf.used >= size.width()) {
+            const QRect rect(shelf.used, shelf.y, size.width(), shelf.height);
+            shelf.used += size.width();
+            m_slotCount++;
+            return rect;
+        }
+    }
+
+    const int bottom = m_shelves.empty() ? 0 : m_shelves.back().y + m_shelves.back().height;
+    if (m_size.height() - bottom < size.height() || m_size.width() < size.width()) {
+        return std::nullopt;
+    }
+
+    m_shelves.push_back(Shelf{
+        .y = bottom,
+        .height = size.height(),
+        .used = size.width(),
+    });
+    m_slotCount++;
+    return QRect(0, bottom, size.width(), size.height());
+}
+
+void ShelfAllocator::release(const QRect &rect)
+{
+    auto shelfIt = std::find_if(m_shelves.begin(), m_shelves.end(), [&rect](const Shelf &shelf) {
+        return shelf.y == rect.y();
+    });
+    Q_ASSERT(shelfIt != m_shelves.end());
+    Shelf &shelf = *shelfIt;
+
+    shelf.freeSlots.append(rect);
+    std::sort(shelf.freeSlots.begin(), shelf.freeSlots.end(), [](const QRect &a, const QRect &b) {
+        return a.x() < b.x();
+    });
+
+    // Merge adjacent free slots, so larger decorations can use them.
+    QVector<QRect> merged;
+    for (const QRect &freeSlot : std::as_const(shelf.freeSlots)) {
+        if (!merged.isEmpty() && merged.last().x() + merged.last().width() == freeSlot.x()) {
+            merged.last().setWidth(merged.last().width() + freeSlot.width());
+        } else {
+            merged.append(freeSlot);
+        }
+    }
+    shelf.freeSlots = merged;
+
+    // Give the space at the end of the shelf back.
+    if (!shelf.freeSlots.isEmpty() && shelf.freeSlots.last().x() + shelf.freeSlots.last().width() == shelf.used) {
+        shelf.used = shelf.freeSlots.takeLast().x();
+    }
+
+    // Empty shelves at the bottom of the page can be reused for decorations of another height.
+    while (!m_shelves.empty() && m_shelves.back().used == 0) {
+        m_shelves.pop_back();
+    }
+
+    m_slotCount--;
+}
+
+} // namespace KWin
@@ -0,0 +1,51 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwin_export.h>
+
+#include <QRect>
+#include <QVector>
+
+#include <optional>
+#include <vector>
+
+namespace KWin
+{
+
+/**
+ * The ShelfAllocator class hands out rectangles of a page of the DecorationAtlas. The page
+ * is split in shelves, i.e. rows of slots with the same height.
+ */
+class KWIN_EXPORT ShelfAllocator
+{
+public:
+    explicit ShelfAllocator(const QSize &size);
+
+    /**
+     * Returns whether no slot is allocated in the page.
+     */
+    bool isEmpty() const;
+
+    std::optional<QRect> allocate(const QSize &size);
+    void release(const QRect &rect);
+
+private:
+    struct Shelf
+    {
+        int y = 0;
+        int height = 0;
+        int used = 0;
+        QVector<QRect> freeSlots;
+    };
+
+    QSize m_size;
+    std::vector<Shelf> m_shelves;
+    int m_slotCount = 0;
+};
+
+} // namespace KWin
@@ -0,0 +1,121 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "qpaintertilerasterizer.h"
+
+#include <QPainter>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+// Smaller areas are not worth the cost of dispatching the work to other threads.
+static const int s_minParallelArea = 512 * 512;
+static const int s_minStripHeight = 64;
+
+void QPainterTileRasterizer::begin(QImage *image, const QRect &window, const QRegion &region)
+{
+    m_image = image;
+    m_bits = image->bits();
+    m_window = window;
+
+    const QTransform windowTransform = QTransform::fromTranslate(-window.x(), -window.y())
+        * QTransform::fromScale(qreal(image->width()) / window.width(), qreal(image->height()) / window.height());
+    m_bounds = windowTransform.mapRect(QRectF(region.boundingRect())).toAlignedRect() & image->rect();
+}
+
+void QPainterTileRasterizer::end()
+{
+    flush();
+    m_image = nullptr;
+    m_bits = nullptr;
+}
+
+void QPainterTileRasterizer::fillRect(const QRect &rect, const QColor &color)
+{
+    m_commands.push_back(Command{
+        .target = rect,
+        .color = color,
+    });
+}
+
+void QPainterTileRasterizer::drawImage(const QTransform &transform, const QRegion &clip, qreal opacity,
+                                       const QRectF &target, const QImage &image, const QRectF &source)
+{
+    m_commands.push_back(Command{
+        .transform = transform,
+        .clip = clip,
+        .opacity = opacity,
+        .target = target,
+        .image = image,
+        .source = source,
+    });
+}
+
+void QPainterTileRasterizer::flush()
+{
+    if (m_commands.empty()) {
+        return;
+    }
+    if (!m_image || m_bounds.isEmpty()) {
+        m_commands.clear();
+        return;
+    }
+
+    int stripCount = 1;
+    if (m_bounds.width() * m_bounds.height() >= s_minParallelArea) {
+        stripCount = std::clamp(m_bounds.height() / s_minStripHeight, 1, QThreadPool::globalInstance()->maxThreadCount());
+    }
+
+    if (stripCount == 1) {
+        rasterize(m_bounds);
+    } else {
+        QVector<QRect> strips;
+        strips.reserve(stripCount);
+        for (int i = 0; i < stripCount; ++i) {
+            const int top = m_bounds.y() + m_bounds.height() * i / stripCount;
+            const int bottom = m_bounds.y() + m_bounds.height() * (i + 1) / stripCount;
+            strips.append(QRect(m_bounds.x(), top, m_bounds.width(), bottom - top));
+        }
+        QtConcurrent::blockingMap(strips, [this](const QRect &strip) {
+            rasterize(strip);
+        });
+    }
+
+    m_commands.clear();
+}
+
+void QPainterTileRasterizer::rasterize(const QRect &strip) const
+{
+    // Every strip gets its own image that shares the memory of the target image, the strips
+    // don't overlap so they can be painted at the same time.
+    QImage image(m_bits + strip.y() * m_image->bytesPerLine(), m_image->width(), strip.height(),
+                 m_image->bytesPerLine(), m_image->format());
+
+    QPainter painter(&image);
+    painter.setViewport(0, -strip.y(), m_image->width(), m_image->height());
+    painter.setWindow(m_window);
+
+    // Don't paint outside the damaged area, it is specified in logical coordinates like the commands.
+    const QRect deviceStrip = strip.translated(0, -strip.y());
+    const QRegion stripClip = painter.deviceTransform().inverted().mapRect(QRectF(deviceStrip)).toAlignedRect();
+    for (const Command &command : m_commands) {
+        painter.setWorldTransform(QTransform());
+        painter.setClipRegion(command.clip.isEmpty() ? stripClip : command.clip & stripClip);
+        painter.setWorldTransform(command.transform);
+        painter.setOpacity(command.opacity);
+        if (command.image.isNull()) {
+            painter.fillRect(command.target, command.color);
+        } else {
+            painter.drawImage(command.target, command.image, command.source);
+        }
+    }
+}
+
+} // namespace KWin
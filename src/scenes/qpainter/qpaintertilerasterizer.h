@@ -0,0 +1,69 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QColor>
+#include <QImage>
+#include <QRegion>
+#include <QTransform>
+
+#include <vector>
+
+namespace KWin
+{
+
+/**
+ * The QPainterTileRasterizer class records the draw operations of the QPainter scene and
+ * replays them later, splitting the damaged area of large outputs in horizontal strips that
+ * are rasterized in parallel.
+ *
+ * The recorded operations must be flushed before anything paints into the image directly,
+ * so that the painting order is preserved.
+ */
+class QPainterTileRasterizer
+{
+public:
+    /**
+     * Starts recording the operations that paint @p region of @p image. The logical
+     * coordinates of the operations are mapped to the image using @p window.
+     */
+    void begin(QImage *image, const QRect &window, const QRegion &region);
+    /**
+     * Rasterizes the remaining operations and stops recording.
+     */
+    void end();
+    /**
+     * Rasterizes the recorded operations.
+     */
+    void flush();
+
+    void fillRect(const QRect &rect, const QColor &color);
+    void drawImage(const QTransform &transform, const QRegion &clip, qreal opacity,
+                   const QRectF &target, const QImage &image, const QRectF &source);
+
+private:
+    struct Command
+    {
+        QTransform transform;
+        QRegion clip; // no clipping if empty
+        qreal opacity = 1.0;
+        QRectF target;
+        QImage image; // fill the target with color if null
+        QRectF source;
+        QColor color;
+    };
+
+    void rasterize(const QRect &strip) const;
+
+    QImage *m_image = nullptr;
+    uchar *m_bits = nullptr;
+    QRect m_window;
+    QRect m_bounds; // the damaged area, in device pixels
+    std::vector<Command> m_commands;
+};
+
+} // namespace KWin
@@ -38,6 +38,7 @@ std::unique_ptr<SceneQPainter> SceneQPainter::createScene(QPainterBackend *backe
 SceneQPainter::SceneQPainter(QPainterBackend *backend)
     : m_backend(backend)
     , m_painter(new QPainter())
+    , m_rasterizer(std::make_unique<QPainterTileRasterizer>())
 {
 }
 
@@ -54,31 +55,38 @@ void SceneQPainter::paint(RenderTarget *target, const QRegion &region)
 {
     QImage *buffer = std::get<QImage *>(target->nativeHandle());
     if (buffer && !buffer->isNull()) {
+        // The windows are recorded and rasterized at the end of the frame, possibly in
+        // parallel, the painter is only used by effects that paint on their own.
+        m_rasterizer->begin(buffer, painted_screen->geometry(), region);
         m_painter->begin(buffer);
         m_painter->setWindow(painted_screen->geometry());
         paintScreen(region);
+        m_rasterizer->end();
         m_painter->end();
     }
 }
 
+QPainter *SceneQPainter::scenePainter() const
+{
+    // Whatever is painted directly has to end up above the recorded operations.
+    m_rasterizer->flush();
+    return m_painter.get();
+}
+
 void SceneQPainter::paintBackground(const QRegion &region)
 {
     for (const QRect &rect : region) {
-        m_painter->fillRect(rect, Qt::black);
+        m_rasterizer->fillRect(rect, Qt::black);
     }
 }
 
 void SceneQPainter::paintOffscreenQuickView(OffscreenQuickView *w)
 {
-    QPainter *painter = effects->scenePainter();
     const QImage buffer = w->bufferAsImage();
     if (buffer.isNull()) {
         return;
     }
-    painter->save();
-    painter->setOpacity(w->opacity());
-    painter->drawImage(w->geometry(), buffer);
-    painter->restore();
+    m_rasterizer->drawImage(QTransform(), QRegion(), w->opacity(), w->geometry(), buffer, buffer.rect());
 }
 
 Shadow *SceneQPainter::createShadow(Window *window)
@@ -99,44 +107,36 @@ void SceneQPainter::render(Item *item, int mask, const QRegion &_region, const W
         return;
     }
 
-    QPainter *painter = scenePainter();
-    painter->save();
-    painter->setClipRegion(region);
-    painter->setClipping(true);
-    painter->setOpacity(data.opacity());
-
+    QTransform transform;
     if (mask & Scene::PAINT_WINDOW_TRANSFORMED) {
-        painter->translate(data.xTranslation(), data.yTranslation());
-        painter->scale(data.xScale(), data.yScale());
+        transform.translate(data.xTranslation(), data.yTranslation());
+        transform.scale(data.xScale(), data.yScale());
     }
 
-    renderItem(painter, item);
-
-    painter->restore();
+    renderItem(item, transform, data.opacity(), region);
 }
 
-void SceneQPainter::renderItem(QPainter *painter, Item *item) const
+void SceneQPainter::renderItem(Item *item, QTransform transform, qreal opacity, const QRegion &clip)
 {
     const QList<Item *> sortedChildItems = item->sortedChildItems();
 
-    painter->save();
-    painter->translate(item->position());
-    painter->setOpacity(painter->opacity() * item->opacity());
+    transform.translate(item->position().x(), item->position().y());
+    opacity *= item->opacity();
 
     for (Item *childItem : sortedChildItems) {
         if (childItem->z() >= 0) {
             break;
         }
         if (childItem->explicitVisible()) {
-            renderItem(painter, childItem);
+            renderItem(childItem, transform, opacity, clip);
         }
     }
 
     item->preprocess();
     if (auto surfaceItem = qobject_cast<SurfaceItem *>(item)) {
-        renderSurfaceItem(painter, surfaceItem);
+        renderSurfaceItem(surfaceItem, transform, opacity, clip);
     } else if (auto decorationItem = qobject_cast<DecorationItem *>(item)) {
-        renderDecorationItem(painter, decorationItem);
+        renderDecorationItem(decorationItem, transform, opacity, clip);
     }
 
     for (Item *childItem : sortedChildItems) {
@@ -144,14 +144,12 @@ void SceneQPainter::renderItem(QPainter *painter, Item *item) const
             continue;
         }
         if (childItem->explicitVisible()) {
-            renderItem(painter, childItem);
+            renderItem(childItem, transform, opacity, clip);
         }
     }
-
-    painter->restore();
 }
 
-void SceneQPainter::renderSurfaceItem(QPainter *painter, SurfaceItem *surfaceItem) const
+void SceneQPainter::renderSurfaceItem(SurfaceItem *surfaceItem, const QTransform &transform, qreal opacity, const QRegion &clip)
 {
     const SurfacePixmap *surfaceTexture = surfaceItem->pixmap();
     if (!surfaceTexture || !surfaceTexture->isValid()) {
@@ -173,21 +171,25 @@ void SceneQPainter::renderSurfaceItem(QPainter *painter, SurfaceItem *surfaceIte
         const QPointF bufferTopLeft = matrix.map(rect.topLeft());
         const QPointF bufferBottomRight = matrix.map(rect.bottomRight());
 
-        painter->drawImage(rect, platformSurfaceTexture->image(),
-                           QRectF(bufferTopLeft, bufferBottomRight));
+        m_rasterizer->drawImage(transform, clip, opacity, rect, platformSurfaceTexture->image(),
+                                QRectF(bufferTopLeft, bufferBottomRight));
     }
 }
 
-void SceneQPainter::renderDecorationItem(QPainter *painter, DecorationItem *decorationItem) const
+void SceneQPainter::renderDecorationItem(DecorationItem *decorationItem, const QTransform &transform, qreal opacity, const QRegion &clip)
 {
     const auto renderer = static_cast<const SceneQPainterDecorationRenderer *>(decorationItem->renderer());
     QRectF dtr, dlr, drr, dbr;
     decorationItem->window()->layoutDecorationRects(dlr, dtr, drr, dbr);
 
-    painter->drawImage(dtr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Top));
-    painter->drawImage(dlr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Left));
-    painter->drawImage(drr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Right));
-    painter->drawImage(dbr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Bottom));
+    const auto drawPart = [&](const QRectF &rect, SceneQPainterDecorationRenderer::DecorationPart part) {
+        const QImage image = renderer->image(part);
+        m_rasterizer->drawImage(transform, clip, opacity, rect, image, image.rect());
+    };
+    drawPart(dtr, SceneQPainterDecorationRenderer::DecorationPart::Top);
+    drawPart(dlr, SceneQPainterDecorationRenderer::DecorationPart::Left);
+    drawPart(drr, SceneQPainterDecorationRenderer::DecorationPart::Right);
+    drawPart(dbr, SceneQPainterDecorationRenderer::DecorationPart::Bottom);
 }
 
 DecorationRenderer *SceneQPainter::createDecorationRenderer(Decoration::DecoratedClientImpl *impl)
@@ -10,6 +10,7 @@
 #define KWIN_SCENE_QPAINTER_H
 
 #include "qpainterbackend.h"
+#include "qpaintertilerasterizer.h"
 
 #include "decorationitem.h"
 #include "scene.h"
@@ -53,12 +54,13 @@ protected:
 private:
     explicit SceneQPainter(QPainterBackend *backend);
 
-    void renderSurfaceItem(QPainter *painter, SurfaceItem *surfaceItem) const;
-    void renderDecorationItem(QPainter *painter, DecorationItem *decorationItem) const;
-    void renderItem(QPainter *painter, Item *item) const;
+    void renderSurfaceItem(SurfaceItem *surfaceItem, const QTransform &transform, qreal opacity, const QRegion &clip);
+    void renderDecorationItem(DecorationItem *decorationItem, const QTransform &transform, qreal opacity, const QRegion &clip);
+    void renderItem(Item *item, QTransform transform, qreal opacity, const QRegion &clip);
 
     QPainterBackend *m_backend;
     std::unique_ptr<QPainter> m_painter;
+    std::unique_ptr<QPainterTileRasterizer> m_rasterizer;
 };
 
 class SceneQPainterShadow : public Shadow
@@ -93,11 +95,6 @@ private:
     QImage m_images[int(DecorationPart::Count)];
 };
 
-inline QPainter *SceneQPainter::scenePainter() const
-{
-    return m_painter.get();
-}
-
 } // KWin
 
 #endif // KWIN_SCENEQPAINTER_H
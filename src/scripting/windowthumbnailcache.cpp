@@ -0,0 +1,241 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "windowthumbnailcache.h"
+#include "composite.h"
+#include "effects.h"
+#include "scene.h"
+#include "window.h"
+#include "windowitem.h"
+
+#include <kwinglplatform.h>
+#include <kwingltexture.h>
+#include <kwinglutils.h>
+
+#include <QPointer>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+// The thumbnails are not released while they are within the budget, it is measured in bytes.
+static const qint64 s_budget = 128 * 1024 * 1024;
+
+static QPointer<WindowThumbnailCache> s_cache;
+
+static bool isPowerOfTwo(int value)
+{
+    return value > 0 && (value & (value - 1)) == 0;
+}
+
+static int mipLevelCount(const QSize &size)
+{
+    // OpenGL ES 2.0 can't generate mipmaps for textures whose size isn't a power of two.
+    if (GLPlatform::instance()->isGLES() && !hasGLVersion(3, 0) && !hasGLExtension(QByteArrayLiteral("GL_OES_texture_npot"))) {
+        if (!isPowerOfTwo(size.width()) || !isPowerOfTwo(size.height())) {
+            return 1;
+        }
+    }
+
+    int levels = 1;
+    for (int extent = std::max(size.width(), size.height()); extent > 1; extent >>= 1) {
+        ++levels;
+    }
+    return levels;
+}
+
+static QSize bucketSize(const QSize &fullSize, int bucket)
+{
+    const int divisor = 1 << bucket;
+    return QSize(std::max(1, (fullSize.width() + divisor - 1) / divisor),
+                 std::max(1, (fullSize.height() + divisor - 1) / divisor));
+}
+
+WindowThumbnailCache::WindowThumbnailCache(QObject *parent)
+    : QObject(parent)
+{
+    connect(Compositor::self(), &Compositor::aboutToToggleCompositing, this, &WindowThumbnailCache::clear);
+}
+
+WindowThumbnailCache::~WindowThumbnailCache()
+{
+    clear();
+}
+
+WindowThumbnailCache *WindowThumbnailCache::self()
+{
+    if (!s_cache) {
+        s_cache = new WindowThumbnailCache(Compositor::self());
+    }
+    return s_cache;
+}
+
+std::shared_ptr<GLTexture> WindowThumbnailCache::acquire(Window *window, const QSize &size, qreal scale)
+{
+    const QSize fullSize = window->visibleGeometry().toAlignedRect().size() * scale;
+    if (fullSize.isEmpty()) {
+        return nullptr;
+    }
+    const QSize requestedSize = size * scale;
+
+    // Pick the smallest bucket that is still large enough to be scaled down.
+    int bucket = 0;
+    while (bucket + 1 < s_bucketCount) {
+        const QSize smaller = bucketSize(fullSize, bucket + 1);
+        if (smaller.width() < requestedSize.width() || smaller.height() < requestedSize.height()) {
+            break;
+        }
+        ++bucket;
+    }
+
+    const auto first = m_thumbnails.lower_bound(Key(window, 0));
+    const bool known = first != m_thumbnails.end() && first->first.first == window;
+    auto it = m_thumbnails.find(Key(window, scale));
+    if (it == m_thumbnails.end()) {
+        it = m_thumbnails.emplace(Key(window, scale), Thumbnails()).first;
+    }
+    if (!known) {
+        connect(window, &Window::damaged, this, &WindowThumbnailCache::invalidate);
+        connect(window, &Window::frameGeometryChanged, this, &WindowThumbnailCache::invalidate);
+        connect(window, &Window::windowClosed, this, &WindowThumbnailCache::remove);
+        connect(window, &QObject::destroyed, this, [this, window]() {
+            remove(window);
+        });
+    }
+
+    Thumbnail &thumbnail = it->second[bucket];
+    thumbnail.lastUsed = ++m_serial;
+    if (thumbnail.dirty || !thumbnail.texture || thumbnail.texture->size() != bucketSize(fullSize, bucket)) {
+        render(window, thumbnail, bucketSize(fullSize, bucket));
+        evict(&thumbnail);
+    }
+    return thumbnail.texture;
+}
+
+bool WindowThumbnailCache::hasMipmaps(const GLTexture *texture)
+{
+    return mipLevelCount(texture->size()) > 1;
+}
+
+void WindowThumbnailCache::render(Window *window, Thumbnail &thumbnail, const QSize &size)
+{
+    const int levels = mipLevelCount(size);
+    if (!thumbnail.texture || thumbnail.texture->size() != size) {
+        release(thumbnail);
+        thumbnail.texture = std::make_shared<GLTexture>(GL_RGBA8, size, levels);
+        thumbnail.texture->setFilter(levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        thumbnail.texture->setWrapMode(GL_CLAMP_TO_EDGE);
+        thumbnail.framebuffer = std::make_unique<GLFramebuffer>(thumbnail.texture.get());
+        thumbnail.bytes = qint64(size.width()) * size.height() * 4;
+        if (levels > 1) {
+            // The mipmaps take a third of the size of the base level.
+            thumbnail.bytes = thumbnail.bytes * 4 / 3;
+        }
+        m_usedBytes += thumbnail.bytes;
+    }
+
+    const QRectF geometry = window->visibleGeometry();
+
+    GLFramebuffer::pushFramebuffer(thumbnail.framebuffer.get());
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    QMatrix4x4 projectionMatrix;
+    projectionMatrix.ortho(geometry.x(), geometry.x() + geometry.width(),
+                           geometry.y(), geometry.y() + geometry.height(), -1, 1);
+
+    WindowPaintData data;
+    data.setProjectionMatrix(projectionMatrix);
+
+    // The thumbnail must be rendered using kwin's opengl context as VAOs are not
+    // shared across contexts. Unfortunately, this also introduces a latency of 1
+    // frame, which is not ideal, but it is acceptable for things such as thumbnails.
+    const int mask = Scene::PAINT_WINDOW_TRANSFORMED;
+    Compositor::self()->scene()->render(window->windowItem(), mask, infiniteRegion(), data);
+    GLFramebuffer::popFramebuffer();
+
+    if (levels > 1) {
+        thumbnail.texture->bind();
+        thumbnail.texture->generateMipmaps();
+        thumbnail.texture->unbind();
+    }
+
+    thumbnail.dirty = false;
+}
+
+void WindowThumbnailCache::release(Thumbnail &thumbnail)
+{
+    m_usedBytes -= thumbnail.bytes;
+    thumbnail.bytes = 0;
+    thumbnail.framebuffer.reset();
+    thumbnail.texture.reset();
+    thumbnail.dirty = true;
+}
+
+void WindowThumbnailCache::evict(const Thumbnail *keep)
+{
+    while (m_usedBytes > s_budget) {
+        Thumbnail *oldest = nullptr;
+        for (auto &[key, thumbnails] : m_thumbnails) {
+            for (Thumbnail &thumbnail : thumbnails) {
+                if (thumbnail.texture && &thumbnail != keep && (!oldest || thumbnail.lastUsed < oldest->lastUsed)) {
+                    oldest = &thumbnail;
+                }
+            }
+        }
+        if (!oldest) {
+            break;
+        }
+        // The thumbnail items that still show the texture keep it alive.
+        release(*oldest);
+    }
+}
+
+void WindowThumbnailCache::invalidate(Window *window)
+{
+    for (auto it = m_thumbnails.lower_bound(Key(window, 0)); it != m_thumbnails.end() && it->first.first == window; ++it) {
+        for (Thumbnail &thumbnail : it->second) {
+            thumbnail.dirty = true;
+        }
+    }
+}
+
+void WindowThumbnailCache::remove(Window *window)
+{
+    const auto first = m_thumbnails.lower_bound(Key(window, 0));
+    auto last = first;
+    while (last != m_thumbnails.end() && last->first.first == window) {
+        ++last;
+    }
+    if (first == last) {
+        return;
+    }
+    disconnect(window, nullptr, this, nullptr);
+
+    Scene *scene = Compositor::self()->scene();
+    if (scene) {
+        scene->makeOpenGLContextCurrent();
+    }
+    for (auto it = first; it != last; ++it) {
+        for (Thumbnail &thumbnail : it->second) {
+            release(thumbnail);
+        }
+    }
+    if (scene) {
+        scene->doneOpenGLContextCurrent();
+    }
+    m_thumbnails.erase(first, last);
+}
+
+void WindowThumbnailCache::clear()
+{
+    while (!m_thumbnails.empty()) {
+        remove(m_thumbnails.begin()->first.first);
+    }
+}
+
+} // namespace KWin
@@ -0,0 +1,90 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwin_export.h"
+
+#include <QObject>
+#include <QSize>
+
+#include <array>
+#include <map>
+#include <memory>
+
+namespace KWin
+{
+class Window;
+class GLFramebuffer;
+class GLTexture;
+
+/**
+ * The WindowThumbnailCache class renders the thumbnails of windows on behalf of all
+ * WindowThumbnailItems, so a window that is shown in several thumbnails, e.g. in the
+ * pager and in the overview, is rendered only once every time it changes.
+ *
+ * The thumbnails are rendered in a few discrete sizes for every device pixel ratio, the full
+ * size of the window and its halves, and they have mipmaps so they can be scaled down smoothly.
+ * The least recently used thumbnails are released when they use more video memory than the
+ * budget allows.
+ */
+class KWIN_EXPORT WindowThumbnailCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~WindowThumbnailCache() override;
+
+    static WindowThumbnailCache *self();
+
+    /**
+     * Returns a texture with the contents of @p window that is at least @p size large, unless
+     * it is larger than the window, with the device pixel ratio @p scale. The window is
+     * rendered again only if it has changed since the texture was last rendered.
+     *
+     * The OpenGL context of the compositor must be current.
+     */
+    std::shared_ptr<GLTexture> acquire(Window *window, const QSize &size, qreal scale);
+
+    /**
+     * Returns @c true if the @p texture returned by acquire() has mipmaps. Without support for
+     * non power of two textures, OpenGL ES 2.0 can't have mipmaps for every size.
+     */
+    static bool hasMipmaps(const GLTexture *texture);
+
+private:
+    explicit WindowThumbnailCache(QObject *parent);
+
+    static constexpr int s_bucketCount = 4;
+
+    struct Thumbnail
+    {
+        std::shared_ptr<GLTexture> texture;
+        std::unique_ptr<GLFramebuffer> framebuffer;
+        qint64 bytes = 0;
+        quint64 lastUsed = 0;
+        bool dirty = true;
+    };
+
+    using Thumbnails = std::array<Thumbnail, s_bucketCount>;
+
+    using Key = std::pair<Window *, qreal>;
+
+    void render(Window *window, Thumbnail &thumbnail, const QSize &size);
+    void release(Thumbnail &thumbnail);
+    void evict(const Thumbnail *keep);
+    void invalidate(Window *window);
+    void remove(Window *window);
+    void clear();
+
+    // the thumbnails of a window are kept per device pixel ratio, so thumbnails that are shown
+    // on outputs with different scales don't replace each other
+    std::map<Key, Thumbnails> m_thumbnails;
+    qint64 m_usedBytes = 0;
+    quint64 m_serial = 0;
+};
+
+} // namespace KWin
@@ -8,13 +8,12 @@
 
 #include "windowthumbnailitem.h"
 #include "composite.h"
-#include "effects.h"
 #include "renderbackend.h"
 #include "scene.h"
 #include "scripting_logging.h"
 #include "virtualdesktops.h"
 #include "window.h"
-#include "windowitem.h"
+#include "windowthumbnailcache.h"
 #include "workspace.h"
 
 #include <kwingltexture.h>
@@ -33,7 +32,7 @@ public:
     explicit ThumbnailTextureProvider(QQuickWindow *window);
 
     QSGTexture *texture() const override;
-    void setTexture(const std::shared_ptr<GLTexture> &nativeTexture);
+    void setTexture(const std::shared_ptr<GLTexture> &nativeTexture, bool hasMipmaps);
     void setTexture(QSGTexture *texture);
 
 private:
@@ -52,22 +51,27 @@ QSGTexture *ThumbnailTextureProvider::texture() const
     return m_texture.get();
 }
 
-void ThumbnailTextureProvider::setTexture(const std::shared_ptr<GLTexture> &nativeTexture)
+void ThumbnailTextureProvider::setTexture(const std::shared_ptr<GLTexture> &nativeTexture, bool hasMipmaps)
 {
     if (m_nativeTexture != nativeTexture) {
         const GLuint textureId = nativeTexture->texture();
         m_nativeTexture = nativeTexture;
+        QQuickWindow::CreateTextureOptions options = QQuickWindow::TextureHasAlphaChannel;
+        if (hasMipmaps) {
+            options |= QQuickWindow::TextureHasMipmaps;
+        }
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
         m_texture.reset(m_window->createTextureFromNativeObject(QQuickWindow::NativeObjectTexture,
                                                                 &textureId, 0,
                                                                 nativeTexture->size(),
-                                                                QQuickWindow::TextureHasAlphaChannel));
+                                                                options));
 #else
         m_texture.reset(QNativeInterface::QSGOpenGLTexture::fromNative(textureId, m_window,
                                                                        nativeTexture->size(),
-                                                                       QQuickWindow::TextureHasAlphaChannel));
+                                                                       options));
 #endif
         m_texture->setFiltering(QSGTexture::Linear);
+        m_texture->setMipmapFiltering(hasMipmaps ? QSGTexture::Linear : QSGTexture::None);
         m_texture->setHorizontalWrapMode(QSGTexture::ClampToEdge);
         m_texture->setVerticalWrapMode(QSGTexture::ClampToEdge);
     }
@@ -112,12 +116,20 @@ WindowThumbnailItem::WindowThumbnailItem(QQuickItem *parent)
             this, &WindowThumbnailItem::updateFrameRenderingConnection);
     connect(this, &QQuickItem::windowChanged,
             this, &WindowThumbnailItem::updateFrameRenderingConnection);
+    connect(this, &QQuickItem::widthChanged,
+            this, &WindowThumbnailItem::invalidateOffscreenTexture);
+    connect(this, &QQuickItem::heightChanged,
+            this, &WindowThumbnailItem::invalidateOffscreenTexture);
 }
 
 WindowThumbnailItem::~WindowThumbnailItem()
 {
     destroyOffscreenTexture();
 
+    if (m_client) {
+        m_client->unrefOffscreenRendering();
+    }
+
     if (m_provider) {
         if (window()) {
             window()->scheduleRenderJob(new ThumbnailTextureProviderCleanupJob(m_provider),
@@ -195,7 +207,6 @@ void WindowThumbnailItem::destroyOffscreenTexture()
     if (m_offscreenTexture) {
         Scene *scene = Compositor::self()->scene();
         scene->makeOpenGLContextCurrent();
-        m_offscreenTarget.reset();
         m_offscreenTexture.reset();
 
         if (m_acquireFence) {
@@ -223,8 +234,11 @@ QSGNode *WindowThumbnailItem::updatePaintNode(QSGNode *oldNode, QQuickItem::Upda
         m_provider = new ThumbnailTextureProvider(window());
     }
 
+    // OpenGL ES 2.0 can't have mipmaps for some sizes, sampling such a texture with
+    // mipmap filtering would produce a black thumbnail.
+    const bool hasMipmaps = m_offscreenTexture && WindowThumbnailCache::hasMipmaps(m_offscreenTexture.get());
     if (m_offscreenTexture) {
-        m_provider->setTexture(m_offscreenTexture);
+        m_provider->setTexture(m_offscreenTexture, hasMipmaps);
     } else {
         const QImage placeholderImage = fallbackImage();
         m_provider->setTexture(window()->createTextureFromImage(placeholderImage));
@@ -236,6 +250,7 @@ QSGNode *WindowThumbnailItem::updatePaintNode(QSGNode *oldNode, QQuickItem::Upda
         node = window()->createImageNode();
         node->setFiltering(QSGTexture::Linear);
     }
+    node->setMipmapFiltering(hasMipmaps ? QSGTexture::Linear : QSGTexture::None);
     node->setTexture(m_provider->texture());
 
     if (m_offscreenTexture && m_offscreenTexture->isYInverted()) {
@@ -295,10 +310,8 @@ void WindowThumbnailItem::setWId(const QUuid &wId)
     m_wId = wId;
     if (!m_wId.isNull()) {
         setClient(workspace()->findToplevel(wId));
-    } else if (m_client) {
-        m_client = nullptr;
-        updateImplicitSize();
-        Q_EMIT clientChanged();
+    } else {
+        setClient(nullptr);
     }
     Q_EMIT wIdChanged();
 }
@@ -320,6 +333,7 @@ void WindowThumbnailItem::setClient(Window *client)
                    this, &WindowThumbnailItem::invalidateOffscreenTexture);
         disconnect(m_client, &Window::frameGeometryChanged,
                    this, &WindowThumbnailItem::updateImplicitSize);
+        m_client->unrefOffscreenRendering();
     }
     m_client = client;
     if (m_client) {
@@ -329,6 +343,7 @@ void WindowThumbnailItem::setClient(Window *client)
                 this, &WindowThumbnailItem::invalidateOffscreenTexture);
         connect(m_client, &Window::frameGeometryChanged,
                 this, &WindowThumbnailItem::updateImplicitSize);
+        m_client->refOffscreenRendering();
         setWId(m_client->internalId());
     } else {
         setWId(QUuid());
@@ -404,8 +419,9 @@ void WindowThumbnailItem::updateOffscreenTexture()
     }
     Q_ASSERT(window());
 
-    const QRectF geometry = m_client->visibleGeometry();
-    QSize textureSize = geometry.toAlignedRect().size();
+    // Render the thumbnail only as large as it is shown, unless a size is requested.
+    const QSizeF geometrySize = m_client->visibleGeometry().size();
+    QSize textureSize = size().isEmpty() ? geometrySize.toSize() : geometrySize.scaled(size(), Qt::KeepAspectRatio).toSize();
     if (sourceSize().width() > 0) {
         textureSize.setWidth(sourceSize().width());
     }
@@ -414,32 +430,13 @@ void WindowThumbnailItem::updateOffscreenTexture()
     }
 
     m_devicePixelRatio = window()->devicePixelRatio();
-    textureSize *= m_devicePixelRatio;
 
-    if (!m_offscreenTexture || m_offscreenTexture->size() != textureSize) {
-        m_offscreenTexture.reset(new GLTexture(GL_RGBA8, textureSize));
-        m_offscreenTexture->setFilter(GL_LINEAR);
-        m_offscreenTexture->setWrapMode(GL_CLAMP_TO_EDGE);
-        m_offscreenTarget.reset(new GLFramebuffer(m_offscreenTexture.get()));
+    // The cache renders the window only if it has changed since another thumbnail used it.
+    std::shared_ptr<GLTexture> texture = WindowThumbnailCache::self()->acquire(m_client, textureSize, m_devicePixelRatio);
+    if (!texture) {
+        return;
     }
-
-    GLFramebuffer::pushFramebuffer(m_offscreenTarget.get());
-    glClearColor(0.0, 0.0, 0.0, 0.0);
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    QMatrix4x4 projectionMatrix;
-    projectionMatrix.ortho(geometry.x(), geometry.x() + geometry.width(),
-                           geometry.y(), geometry.y() + geometry.height(), -1, 1);
-
-    WindowPaintData data;
-    data.setProjectionMatrix(projectionMatrix);
-
-    // The thumbnail must be rendered using kwin's opengl context as VAOs are not
-    // shared across contexts. Unfortunately, this also introduces a latency of 1
-    // frame, which is not ideal, but it is acceptable for things such as thumbnails.
-    const int mask = Scene::PAINT_WINDOW_TRANSFORMED;
-    Compositor::self()->scene()->render(m_client->windowItem(), mask, infiniteRegion(), data);
-    GLFramebuffer::popFramebuffer();
+    m_offscreenTexture = texture;
 
     // The fence is needed to avoid the case where qtquick renderer starts using
     // the texture while all rendering commands to it haven't completed yet.
@@ -15,7 +15,6 @@
 namespace KWin
 {
 class Window;
-class GLFramebuffer;
 class GLTexture;
 class ThumbnailTextureProvider;
 
@@ -95,7 +94,6 @@ private:
 
     mutable ThumbnailTextureProvider *m_provider = nullptr;
     std::shared_ptr<GLTexture> m_offscreenTexture;
-    std::unique_ptr<GLFramebuffer> m_offscreenTarget;
     GLsync m_acquireFence = 0;
     qreal m_devicePixelRatio = 1;
 
@@ -51,6 +51,16 @@ enum Layer {
 };
 Q_ENUM_NS(Layer)
 
+/**
+ * How much of a window was visible the last time the outputs it is on were painted.
+ */
+enum class WindowOcclusion {
+    Visible,
+    PartiallyVisible,
+    Occluded,
+};
+Q_ENUM_NS(WindowOcclusion)
+
 enum StrutArea {
     StrutAreaInvalid = 0, // Null
     StrutAreaTop = 1 << 0,
@@ -0,0 +1,123 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "utils/monotonictimer.h"
+#include "utils/common.h"
+
+#include <QSocketNotifier>
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <sys/timerfd.h>
+#endif
+
+namespace KWin
+{
+
+MonotonicTimer::MonotonicTimer(QObject *parent)
+    : QObject(parent)
+{
+#if defined(Q_OS_LINUX)
+    m_fd = FileDescriptor(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK));
+    if (m_fd.isValid()) {
+        m_notifier = std::make_unique<QSocketNotifier>(m_fd.get(), QSocketNotifier::Read);
+        connect(m_notifier.get(), &QSocketNotifier::activated, this, &MonotonicTimer::handleTimeout);
+        return;
+    }
+    qCWarning(KWIN_CORE, "Failed to create a timerfd: %s", strerror(errno));
+#endif
+
+    m_fallbackTimer.setSingleShot(true);
+    m_fallbackTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_fallbackTimer, &QTimer::timeout, this, &MonotonicTimer::handleTimeout);
+}
+
+MonotonicTimer::~MonotonicTimer()
+{
+}
+
+void MonotonicTimer::start(std::chrono::nanoseconds deadline)
+{
+    m_deadline = deadline;
+    m_active = true;
+
+#if defined(Q_OS_LINUX)
+    if (m_fd.isValid()) {
+        // A zero value disarms the timer, so make sure that it's armed even for past deadlines.
+        const std::chrono::nanoseconds value = std::max(deadline, std::chrono::nanoseconds(1));
+        itimerspec spec = {};
+        spec.it_value.tv_sec = std::chrono::duration_cast<std::chrono::seconds>(value).count();
+        spec.it_value.tv_nsec = (value % std::chrono::seconds(1)).count();
+        if (timerfd_settime(m_fd.get(), TFD_TIMER_ABSTIME, &spec, nullptr) == -1) {
+            qCWarning(KWIN_CORE, "Failed to arm a timerfd: %s", strerror(errno));
+        }
+        return;
+    }
+#endif
+
+    const std::chrono::nanoseconds currentTime(std::chrono::steady_clock::now().time_since_epoch());
+    const std::chrono::nanoseconds interval = std::max(deadline - currentTime, std::chrono::nanoseconds::zero());
+    m_fallbackTimer.start(std::chrono::ceil<std::chrono::milliseconds>(interval));
+}
+
+void MonotonicTimer::stop()
+{
+    if (!m_active) {
+        return;
+    }
+    m_active = false;
+
+#if defined(Q_OS_LINUX)
+    if (m_fd.isValid()) {
+        const itimerspec spec = {};
+        timerfd_settime(m_fd.get(), TFD_TIMER_ABSTIME, &spec, nullptr);
+
+        // Drain the expiration counter in case the timer has fired but hasn't been handled yet.
+        // If it hasn't fired, the read fails with EAGAIN as the timerfd is non-blocking.
+        uint64_t expirationCount;
+        if (read(m_fd.get(), &expirationCount, sizeof(expirationCount)) != sizeof(expirationCount) && errno != EAGAIN) {
+            qCWarning(KWIN_CORE, "Failed to drain the timerfd: %s", strerror(errno));
+        }
+        return;
+    }
+#endif
+
+    m_fallbackTimer.stop();
+}
+
+bool MonotonicTimer::isActive() const
+{
+    return m_active;
+}
+
+std::chrono::nanoseconds MonotonicTimer::deadline() const
+{
+    return m_deadline;
+}
+
+void MonotonicTimer::handleTimeout()
+{
+#if defined(Q_OS_LINUX)
+    if (m_fd.isValid()) {
+        uint64_t expirationCount;
+        if (read(m_fd.get(), &expirationCount, sizeof(expirationCount)) != sizeof(expirationCount)) {
+            return;
+        }
+    }
+#endif
+
+    if (!m_active) {
+        return;
+    }
+    m_active = false;
+    Q_EMIT timeout();
+}
+
+} // namespace KWin
@@ -0,0 +1,66 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwin_export.h"
+#include "utils/filedescriptor.h"
+
+#include <QObject>
+#include <QTimer>
+
+#include <chrono>
+#include <memory>
+
+class QSocketNotifier;
+
+namespace KWin
+{
+
+/**
+ * The MonotonicTimer class provides a single-shot timer that fires at an absolute deadline
+ * on the monotonic clock, i.e. the clock used by std::chrono::steady_clock.
+ *
+ * Unlike QTimer, the MonotonicTimer is not limited to millisecond granularity. On Linux,
+ * it's backed by a timerfd. On other platforms, it falls back to a precise QTimer.
+ */
+class KWIN_EXPORT MonotonicTimer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MonotonicTimer(QObject *parent = nullptr);
+    ~MonotonicTimer() override;
+
+    /**
+     * Starts or restarts the timer. The timeout() signal will be emitted once the monotonic
+     * clock reaches the given @a deadline. If the deadline is in the past, the timer fires
+     * as soon as possible.
+     */
+    void start(std::chrono::nanoseconds deadline);
+    void stop();
+
+    bool isActive() const;
+
+    /**
+     * Returns the deadline of the last started timer.
+     */
+    std::chrono::nanoseconds deadline() const;
+
+Q_SIGNALS:
+    void timeout();
+
+private:
+    void handleTimeout();
+
+    FileDescriptor m_fd;
+    std::unique_ptr<QSocketNotifier> m_notifier;
+    QTimer m_fallbackTimer;
+    std::chrono::nanoseconds m_deadline = std::chrono::nanoseconds::zero();
+    bool m_active = false;
+};
+
+} // namespace KWin
@@ -53,6 +53,7 @@ private Q_SLOTS:
     void testRequestShowingDesktop();
     void testParentWindow();
     void testGeometry();
+    void testCoalescedUpdates();
     void testIcon();
     void testPid();
     void testApplicationMenu();
@@ -563,6 +564,38 @@ void TestWindowManagement::testGeometry()
     QCOMPARE(window->geometry(), QRect(0, 0, 35, 45));
 }
 
+void TestWindowManagement::testCoalescedUpdates()
+{
+    using namespace KWayland::Client;
+    QVERIFY(m_window);
+    QSignalSpy titleChangedSpy(m_window, &PlasmaWindow::titleChanged);
+    QVERIFY(titleChangedSpy.isValid());
+    QSignalSpy windowGeometryChangedSpy(m_window, &PlasmaWindow::geometryChanged);
+    QVERIFY(windowGeometryChangedSpy.isValid());
+
+    // changes made before returning to the event loop are sent once with the latest value
+    m_windowInterface->setTitle(QStringLiteral("foo"));
+    m_windowInterface->setTitle(QStringLiteral("bar"));
+    QVERIFY(titleChangedSpy.wait());
+    QVERIFY(!titleChangedSpy.wait(10));
+    QCOMPARE(titleChangedSpy.count(), 1);
+    QCOMPARE(m_window->title(), QStringLiteral("bar"));
+
+    // geometry changes are rate limited
+    m_windowManagementInterface->setGeometryUpdateInterval(std::chrono::milliseconds(500));
+    m_windowInterface->setGeometry(QRect(0, 0, 10, 10));
+    QVERIFY(windowGeometryChangedSpy.wait());
+    QCOMPARE(m_window->geometry(), QRect(0, 0, 10, 10));
+
+    m_windowInterface->setGeometry(QRect(10, 0, 10, 10));
+    QVERIFY(!windowGeometryChangedSpy.wait(100));
+    m_windowInterface->setGeometry(QRect(20, 0, 10, 10));
+    QVERIFY(windowGeometryChangedSpy.wait());
+    QCOMPARE(windowGeometryChangedSpy.count(), 2);
+    QCOMPARE(m_window->geometry(), QRect(20, 0, 10, 10));
+    m_windowManagementInterface->setGeometryUpdateInterval(std::chrono::milliseconds::zero());
+}
+
 void TestWindowManagement::testIcon()
 {
     using namespace KWayland::Client;
@@ -9,11 +9,13 @@
 #include "surface_interface.h"
 #include "utils/common.h"
 
+#include <QElapsedTimer>
 #include <QFile>
 #include <QHash>
 #include <QIcon>
 #include <QList>
 #include <QRect>
+#include <QTimer>
 #include <QUuid>
 #include <QVector>
 #include <QtConcurrentRun>
@@ -42,6 +44,7 @@ public:
     quint32 windowIdCounter = 0;
     QVector<quint32> stackingOrder;
     QVector<QString> stackingOrderUuids;
+    std::chrono::milliseconds geometryUpdateInterval = std::chrono::milliseconds::zero();
     PlasmaWindowManagementInterface *q;
 
 protected:
@@ -70,6 +73,16 @@ public:
     void setResourceName(const QString &resourceName);
     wl_resource *resourceForParent(PlasmaWindowInterface *parent, Resource *child) const;
 
+    enum class DirtyProperty {
+        Title = 0x1,
+        State = 0x2,
+        Geometry = 0x4,
+    };
+    Q_DECLARE_FLAGS(DirtyProperties, DirtyProperty)
+
+    void scheduleFlush(DirtyProperty property);
+    void flush();
+
     quint32 windowId = 0;
     QHash<SurfaceInterface *, QRect> minimizedGeometries;
     PlasmaWindowManagementInterface *wm;
@@ -92,6 +105,11 @@ public:
     QString uuid;
     QString m_resourceName;
 
+    // The properties whose latest value hasn't been sent to the clients yet
+    DirtyProperties dirtyProperties;
+    QTimer flushTimer;
+    QElapsedTimer lastGeometryFlush;
+
 protected:
     void org_kde_plasma_window_bind_resource(Resource *resource) override;
     void org_kde_plasma_window_set_state(Resource *resource, uint32_t flags, uint32_t state) override;
@@ -111,6 +129,8 @@ protected:
     void org_kde_plasma_window_send_to_output(Resource *resource, struct wl_resource *output) override;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(PlasmaWindowInterfacePrivate::DirtyProperties)
+
 PlasmaWindowManagementInterfacePrivate::PlasmaWindowManagementInterfacePrivate(PlasmaWindowManagementInterface *_q, Display *display)
     : QtWaylandServer::org_kde_plasma_window_management(*display, s_version)
     , q(_q)
@@ -319,12 +339,26 @@ PlasmaVirtualDesktopManagementInterface *PlasmaWindowManagementInterface::plasma
     return d->plasmaVirtualDesktopManagementInterface;
 }
 
+void PlasmaWindowManagementInterface::setGeometryUpdateInterval(std::chrono::milliseconds interval)
+{
+    d->geometryUpdateInterval = std::max(interval, std::chrono::milliseconds::zero());
+}
+
+std::chrono::milliseconds PlasmaWindowManagementInterface::geometryUpdateInterval() const
+{
+    return d->geometryUpdateInterval;
+}
+
 //////PlasmaWindow
 PlasmaWindowInterfacePrivate::PlasmaWindowInterfacePrivate(PlasmaWindowManagementInterface *wm, PlasmaWindowInterface *q)
     : QtWaylandServer::org_kde_plasma_window()
     , wm(wm)
     , q(q)
 {
+    flushTimer.setSingleShot(true);
+    QObject::connect(&flushTimer, &QTimer::timeout, q, [this]() {
+        flush();
+    });
 }
 
 PlasmaWindowInterfacePrivate::~PlasmaWindowInterfacePrivate()
@@ -508,11 +542,7 @@ void PlasmaWindowInterfacePrivate::setTitle(const QString &title)
         return;
     }
     m_title = title;
-    const auto clientResources = resourceMap();
-
-    for (auto resource : clientResources) {
-        send_title_changed(resource->handle, m_title);
-    }
+    scheduleFlush(DirtyProperty::Title);
 }
 
 void PlasmaWindowInterfacePrivate::unmap()
@@ -521,6 +551,11 @@ void PlasmaWindowInterfacePrivate::unmap()
         return;
     }
     unmapped = true;
+
+    // The clients are going to destroy the window, there is no point in sending pending changes.
+    flushTimer.stop();
+    dirtyProperties = DirtyProperties();
+
     const auto clientResources = resourceMap();
 
     for (auto resource : clientResources) {
@@ -540,10 +575,51 @@ void PlasmaWindowInterfacePrivate::setState(org_kde_plasma_window_management_sta
         return;
     }
     m_state = newState;
-    const auto clientResources = resourceMap();
+    scheduleFlush(DirtyProperty::State);
+}
 
+void PlasmaWindowInterfacePrivate::scheduleFlush(DirtyProperty property)
+{
+    if (unmapped) {
+        return;
+    }
+    dirtyProperties |= property;
+
+    std::chrono::milliseconds delay = std::chrono::milliseconds::zero();
+    if (dirtyProperties == DirtyProperties(DirtyProperty::Geometry) && lastGeometryFlush.isValid()) {
+        // Other changes flush the geometry early, there is no need to hold them back.
+        const std::chrono::milliseconds elapsed(lastGeometryFlush.elapsed());
+        delay = std::max(wm->geometryUpdateInterval() - elapsed, std::chrono::milliseconds::zero());
+    }
+
+    if (!flushTimer.isActive() || std::chrono::milliseconds(flushTimer.remainingTime()) > delay) {
+        flushTimer.start(delay);
+    }
+}
+
+void PlasmaWindowInterfacePrivate::flush()
+{
+    DirtyProperties properties = dirtyProperties;
+    dirtyProperties = DirtyProperties();
+    if (properties.testFlag(DirtyProperty::Geometry)) {
+        lastGeometryFlush.start();
+        // The geometry could have been made invalid after the flush was scheduled.
+        if (!geometry.isValid()) {
+            properties &= ~DirtyProperties(DirtyProperty::Geometry);
+        }
+    }
+
+    const auto clientResources = resourceMap();
     for (auto resource : clientResources) {
-        send_state_changed(resource->handle, m_state);
+        if (properties.testFlag(DirtyProperty::Title)) {
+            send_title_changed(resource->handle, m_title);
+        }
+        if (properties.testFlag(DirtyProperty::State)) {
+            send_state_changed(resource->handle, m_state);
+        }
+        if (properties.testFlag(DirtyProperty::Geometry) && resource->version() >= ORG_KDE_PLASMA_WINDOW_GEOMETRY_SINCE_VERSION) {
+            send_geometry(resource->handle, geometry.x(), geometry.y(), geometry.width(), geometry.height());
+        }
     }
 }
 
@@ -596,14 +672,7 @@ void PlasmaWindowInterfacePrivate::setGeometry(const QRect &geo)
     if (!geometry.isValid()) {
         return;
     }
-
-    const auto clientResources = resourceMap();
-    for (auto resource : clientResources) {
-        if (resource->version() < ORG_KDE_PLASMA_WINDOW_GEOMETRY_SINCE_VERSION) {
-            continue;
-        }
-        send_geometry(resource->handle, geometry.x(), geometry.y(), geometry.width(), geometry.height());
-    }
+    scheduleFlush(DirtyProperty::Geometry);
 }
 
 void PlasmaWindowInterfacePrivate::setApplicationMenuPaths(const QString &service, const QString &object)
@@ -8,6 +8,7 @@
 #include "kwin_export.h"
 
 #include <QObject>
+#include <chrono>
 #include <memory>
 
 class QSize;
@@ -93,6 +94,16 @@ public:
 
     void setStackingOrderUuids(const QVector<QString> &stackingOrderUuids);
 
+    /**
+     * Changes of the title, the state and the geometry of the windows are not sent right away,
+     * they are accumulated and sent together when control returns to the event loop. Geometry
+     * changes are additionally sent at most once per @p interval, which avoids waking up all
+     * shell clients on every step of an interactive move or resize. The default is @c 0, i.e.
+     * geometry changes are not rate limited.
+     */
+    void setGeometryUpdateInterval(std::chrono::milliseconds interval);
+    std::chrono::milliseconds geometryUpdateInterval() const;
+
 Q_SIGNALS:
     void requestChangeShowingDesktop(ShowingDesktopState requestedState);
 
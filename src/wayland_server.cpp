@@ -16,6 +16,7 @@
 #include "keyboard_input.h"
 #include "layershellv1integration.h"
 #include "main.h"
+#include "options.h"
 #include "output.h"
 #include "platform.h"
 #include "scene.h"
@@ -531,6 +532,12 @@ void WaylandServer::initWorkspace()
             f();
             connect(workspace(), &Workspace::stackingOrderChanged, this, f);
         });
+
+        auto updateGeometryInterval = [this]() {
+            m_windowManagement->setGeometryUpdateInterval(std::chrono::milliseconds(options->windowGeometryBroadcastInterval()));
+        };
+        updateGeometryInterval();
+        connect(options, &Options::windowGeometryBroadcastIntervalChanged, this, updateGeometryInterval);
     }
 
     connect(kwinApp()->platform(), &Platform::primaryOutputChanged, this, [this](Output *primaryOutput) {
@@ -879,6 +879,35 @@ Layer Window::layer() const
     return m_layer;
 }
 
+WindowOcclusion Window::occlusion() const
+{
+    if (!m_windowItem) {
+        return WindowOcclusion::Visible;
+    }
+    return m_windowItem->occlusion();
+}
+
+bool Window::frameCallbacksThrottled() const
+{
+    return options->occludedFrameCallbackInterval() > 0 && occlusion() == WindowOcclusion::Occluded && !isOffscreenRendering();
+}
+
+void Window::refOffscreenRendering()
+{
+    ++m_offscreenRenderCount;
+}
+
+void Window::unrefOffscreenRendering()
+{
+    Q_ASSERT(m_offscreenRenderCount > 0);
+    --m_offscreenRenderCount;
+}
+
+bool Window::isOffscreenRendering() const
+{
+    return m_offscreenRenderCount > 0;
+}
+
 void Window::updateLayer()
 {
     if (layer() == belongsToLayer()) {
@@ -3441,6 +3470,13 @@ void Window::evaluateWindowRules()
     applyWindowRules();
 }
 
+void Window::evaluateTitleRules()
+{
+    if (workspace()->rulebook()->titleRulesChanged(this)) {
+        evaluateWindowRules();
+    }
+}
+
 /**
  * Returns the list of activities the window window is on.
  * if it's on all activities, the list will be empty.
@@ -4438,7 +4474,7 @@ void Window::cleanTabBox()
 
 void Window::setupWindowRules(bool ignore_temporary)
 {
-    disconnect(this, &Window::captionChanged, this, &Window::evaluateWindowRules);
+    disconnect(this, &Window::captionChanged, this, &Window::evaluateTitleRules);
     m_rules = workspace()->rulebook()->find(this, ignore_temporary);
     // check only after getting the rules, because there may be a rule forcing window type
 }
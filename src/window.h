@@ -593,6 +593,16 @@ class KWIN_EXPORT Window : public QObject
      */
     Q_PROPERTY(bool hidden READ isHiddenInternal NOTIFY hiddenChanged)
 
+    /**
+     * How much of this window was visible the last time the outputs it is on were painted.
+     */
+    Q_PROPERTY(KWin::WindowOcclusion occlusion READ occlusion)
+
+    /**
+     * Whether frame callbacks for this window are sent at a reduced rate because it's occluded.
+     */
+    Q_PROPERTY(bool frameCallbacksThrottled READ frameCallbacksThrottled)
+
 public:
     ~Window() override;
 
@@ -1083,6 +1093,11 @@ public:
     void removeRule(Rules *r);
     void setupWindowRules(bool ignore_temporary);
     void evaluateWindowRules();
+    /**
+     * Re-evaluates the window rules after the caption has changed, but only if the caption
+     * change affects which rules match the window.
+     */
+    void evaluateTitleRules();
     virtual void applyWindowRules();
     virtual bool takeFocus() = 0;
     virtual bool wantsInput() const = 0;
@@ -1136,6 +1151,18 @@ public:
     virtual Layer layer() const;
     void updateLayer();
 
+    WindowOcclusion occlusion() const;
+    bool frameCallbacksThrottled() const;
+
+    /**
+     * Increments the number of consumers that render this window off-screen, e.g. screencasts
+     * and thumbnails. Such windows keep receiving frame callbacks at the full rate even if
+     * they are occluded.
+     */
+    void refOffscreenRendering();
+    void unrefOffscreenRendering();
+    bool isOffscreenRendering() const;
+
     void move(const QPointF &point);
     void resize(const QSizeF &size);
     void moveResize(const QRectF &rect);
@@ -1894,6 +1921,7 @@ private:
     bool is_shape;
     EffectWindowImpl *m_effectWindow;
     WindowItem *m_windowItem = nullptr;
+    int m_offscreenRenderCount = 0;
     Shadow *m_shadow = nullptr;
     QByteArray resource_name;
     QByteArray resource_class;
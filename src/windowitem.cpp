@@ -8,6 +8,7 @@
 #include "decorationitem.h"
 #include "deleted.h"
 #include "internalwindow.h"
+#include "output.h"
 #include "shadowitem.h"
 #include "surfaceitem_internal.h"
 #include "surfaceitem_wayland.h"
@@ -46,6 +47,8 @@ WindowItem::WindowItem(Window *window, Item *parent)
     connect(window, &Window::opacityChanged, this, &WindowItem::updateOpacity);
     updateOpacity();
 
+    connect(workspace(), &Workspace::outputRemoved, this, &WindowItem::removeOcclusion);
+
     connect(window, &Window::windowClosed, this, &WindowItem::handleWindowClosed);
 }
 
@@ -73,6 +76,28 @@ Window *WindowItem::window() const
     return m_window;
 }
 
+WindowOcclusion WindowItem::occlusion() const
+{
+    WindowOcclusion occlusion = WindowOcclusion::Occluded;
+    const auto outputs = workspace()->outputs();
+    for (Output *output : outputs) {
+        if (m_window->isOnOutput(output)) {
+            occlusion = std::min(occlusion, m_occlusion.value(output, WindowOcclusion::Visible));
+        }
+    }
+    return occlusion;
+}
+
+void WindowItem::setOcclusion(Output *output, WindowOcclusion occlusion)
+{
+    m_occlusion[output] = occlusion;
+}
+
+void WindowItem::removeOcclusion(Output *output)
+{
+    m_occlusion.remove(output);
+}
+
 void WindowItem::refVisible(int reason)
 {
     if (reason & PAINT_DISABLED_BY_HIDDEN) {
@@ -7,6 +7,9 @@
 #pragma once
 
 #include "item.h"
+#include "utils/common.h"
+
+#include <QHash>
 
 namespace KDecoration2
 {
@@ -19,6 +22,7 @@ class Window;
 class DecorationItem;
 class Deleted;
 class InternalWindow;
+class Output;
 class Shadow;
 class ShadowItem;
 class SurfaceItem;
@@ -52,6 +56,13 @@ public:
     void refVisible(int reason);
     void unrefVisible(int reason);
 
+    /**
+     * Returns how much of the window was visible the last time the outputs it is on were
+     * painted. The window counts as occluded only if it is occluded on all of them.
+     */
+    WindowOcclusion occlusion() const;
+    void setOcclusion(Output *output, WindowOcclusion occlusion);
+
 protected:
     explicit WindowItem(Window *window, Item *parent = nullptr);
     void updateSurfaceItem(SurfaceItem *surfaceItem);
@@ -64,6 +75,7 @@ private Q_SLOTS:
     void updateSurfaceVisibility();
     void updatePosition();
     void updateOpacity();
+    void removeOcclusion(Output *output);
 
 private:
     bool computeVisibility() const;
@@ -78,6 +90,7 @@ private:
     int m_forceVisibleByDesktopCount = 0;
     int m_forceVisibleByMinimizeCount = 0;
     int m_forceVisibleByActivityCount = 0;
+    QHash<Output *, WindowOcclusion> m_occlusion;
 };
 
 /**
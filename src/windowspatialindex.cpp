@@ -0,0 +1,233 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "windowspatialindex.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace KWin
+{
+
+static quint64 cellKey(int x, int y)
+{
+    return (quint64(quint32(x)) << 32) | quint32(y);
+}
+
+// Marks the elements of @p values that form their longest strictly increasing subsequence.
+static QVector<bool> longestIncreasingSubsequence(const QVector<int> &values)
+{
+    // The indices of the smallest last elements of the increasing subsequences of every length.
+    QVector<int> tails;
+    QVector<int> predecessors(values.size(), -1);
+    for (int i = 0; i < values.size(); ++i) {
+        const auto it = std::lower_bound(tails.begin(), tails.end(), values[i], [&values](int index, int value) {
+            return values[index] < value;
+        });
+        if (it != tails.begin()) {
+            predecessors[i] = *(it - 1);
+        }
+        if (it == tails.end()) {
+            tails.append(i);
+        } else {
+            *it = i;
+        }
+    }
+
+    QVector<bool> marks(values.size(), false);
+    for (int i = tails.isEmpty() ? -1 : tails.last(); i != -1; i = predecessors[i]) {
+        marks[i] = true;
+    }
+    return marks;
+}
+
+WindowSpatialIndex::WindowSpatialIndex(QObject *parent)
+    : QObject(parent)
+{
+    connect(workspace(), &Workspace::stackingOrderChanged, this, &WindowSpatialIndex::restack);
+    connect(workspace(), &Workspace::currentDesktopChanged, this, &WindowSpatialIndex::reindex);
+    connect(workspace(), &Workspace::currentActivityChanged, this, &WindowSpatialIndex::reindex);
+    connect(workspace(), &Workspace::geometryChanged, this, &WindowSpatialIndex::reindex);
+    m_bounds = workspace()->geometry();
+    restack();
+}
+
+WindowSpatialIndex::~WindowSpatialIndex()
+{
+}
+
+QVector<Window *> WindowSpatialIndex::windowsAt(const QPointF &pos) const
+{
+    const auto it = m_cells.find(cellKey(int(std::floor(pos.x() / s_cellSize)), int(std::floor(pos.y() / s_cellSize))));
+    if (it == m_cells.end()) {
+        return QVector<Window *>();
+    }
+    return it->second;
+}
+
+void WindowSpatialIndex::restack()
+{
+    const QList<Window *> stackingOrder = workspace()->stackingOrder();
+
+    QHash<Window *, int> stackingPositions;
+    stackingPositions.reserve(stackingOrder.count());
+    for (int i = 0; i < stackingOrder.count(); ++i) {
+        Window *window = stackingOrder[i];
+        // a deleted window doesn't get mouse events
+        if (!window->isDeleted()) {
+            stackingPositions.insert(window, i);
+        }
+    }
+
+    for (auto it = m_windows.begin(); it != m_windows.end();) {
+        if (stackingPositions.contains(it.key())) {
+            ++it;
+        } else {
+            untrackWindow(it.key());
+            it = m_windows.erase(it);
+        }
+    }
+
+    // The windows that keep their order relative to each other stay where they are in the
+    // cells, only the windows that have been restacked past them are indexed again. Usually
+    // that's just the window that has been raised or lowered.
+    QVector<Window *> known;
+    QVector<int> previousPositions;
+    known.reserve(m_windows.count());
+    previousPositions.reserve(m_windows.count());
+    for (Window *window : stackingOrder) {
+        const auto it = m_windows.constFind(window);
+        if (it != m_windows.constEnd()) {
+            known.append(window);
+            previousPositions.append(it->stackingPosition);
+        }
+    }
+
+    QVector<Window *> moved;
+    const QVector<bool> stable = longestIncreasingSubsequence(previousPositions);
+    for (int i = 0; i < known.count(); ++i) {
+        if (!stable[i]) {
+            removeWindow(known[i]);
+            moved.append(known[i]);
+        }
+    }
+
+    for (auto it = stackingPositions.constBegin(); it != stackingPositions.constEnd(); ++it) {
+        auto record = m_windows.find(it.key());
+        if (record == m_windows.end()) {
+            trackWindow(it.key());
+            record = m_windows.insert(it.key(), Record());
+            moved.append(it.key());
+        }
+        record->stackingPosition = it.value();
+    }
+
+    for (Window *window : std::as_const(moved)) {
+        insertWindow(window);
+    }
+}
+
+void WindowSpatialIndex::reindex()
+{
+    m_bounds = workspace()->geometry();
+    m_cells.clear();
+    for (auto it = m_windows.begin(); it != m_windows.end(); ++it) {
+        it->indexed = false;
+    }
+    for (auto it = m_windows.constBegin(); it != m_windows.constEnd(); ++it) {
+        insertWindow(it.key());
+    }
+}
+
+void WindowSpatialIndex::trackWindow(Window *window)
+{
+    const auto update = [this, window]() {
+        updateWindow(window);
+    };
+    connect(window, &Window::frameGeometryChanged, this, update);
+    connect(window, &Window::visibleGeometryChanged, this, update);
+    connect(window, &Window::desktopChanged, this, update);
+    connect(window, &Window::activitiesChanged, this, update);
+    connect(window, &Window::minimizedChanged, this, update);
+    connect(window, &Window::hiddenChanged, this, update);
+    connect(window, &Window::destroyed, this, [this, window]() {
+        removeWindow(window);
+        m_windows.remove(window);
+    });
+}
+
+void WindowSpatialIndex::untrackWindow(Window *window)
+{
+    disconnect(window, nullptr, this, nullptr);
+    removeWindow(window);
+}
+
+void WindowSpatialIndex::updateWindow(Window *window)
+{
+    removeWindow(window);
+    insertWindow(window);
+}
+
+void WindowSpatialIndex::insertWindow(Window *window)
+{
+    const auto record = m_windows.find(window);
+    if (record == m_windows.end()) {
+        return;
+    }
+    if (!window->isOnCurrentActivity() || !window->isOnCurrentDesktop() || window->isMinimized() || window->isHiddenInternal()) {
+        return;
+    }
+
+    // The pointer can't leave the screens, so the parts of the window outside the workspace
+    // don't need to be indexed. This also keeps the number of cells bounded.
+    const QRect rect = window->inputGeometry().united(window->visibleGeometry()).toAlignedRect().intersected(m_bounds);
+    if (rect.isEmpty()) {
+        return;
+    }
+
+    const QRect cellRange(QPoint(int(std::floor(qreal(rect.left()) / s_cellSize)), int(std::floor(qreal(rect.top()) / s_cellSize))),
+                          QPoint(int(std::floor(qreal(rect.right()) / s_cellSize)), int(std::floor(qreal(rect.bottom()) / s_cellSize))));
+    record->cellRange = cellRange;
+    record->indexed = true;
+
+    const int stackingPosition = record->stackingPosition;
+    const auto isAbove = [this](Window *other, int stackingPosition) {
+        return m_windows.value(other).stackingPosition > stackingPosition;
+    };
+    for (int y = cellRange.top(); y <= cellRange.bottom(); ++y) {
+        for (int x = cellRange.left(); x <= cellRange.right(); ++x) {
+            QVector<Window *> &cell = m_cells[cellKey(x, y)];
+            cell.insert(std::lower_bound(cell.begin(), cell.end(), stackingPosition, isAbove), window);
+        }
+    }
+}
+
+void WindowSpatialIndex::removeWindow(Window *window)
+{
+    const auto record = m_windows.find(window);
+    if (record == m_windows.end() || !record->indexed) {
+        return;
+    }
+
+    const QRect cellRange = record->cellRange;
+    record->indexed = false;
+    for (int y = cellRange.top(); y <= cellRange.bottom(); ++y) {
+        for (int x = cellRange.left(); x <= cellRange.right(); ++x) {
+            auto cell = m_cells.find(cellKey(x, y));
+            if (cell == m_cells.end()) {
+                continue;
+            }
+            cell->second.removeOne(window);
+            if (cell->second.isEmpty()) {
+                m_cells.erase(cell);
+            }
+        }
+    }
+}
+
+} // namespace KWin
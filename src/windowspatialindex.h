@@ -0,0 +1,70 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwin_export.h>
+
+#include <QHash>
+#include <QObject>
+#include <QRect>
+#include <QVector>
+
+#include <unordered_map>
+
+namespace KWin
+{
+
+class Window;
+
+/**
+ * The WindowSpatialIndex class keeps track of the windows that can receive input in a uniform
+ * grid, which allows finding the windows at a given position without walking the whole
+ * stacking order.
+ *
+ * Only windows that are on the current virtual desktop and activity and are neither minimized
+ * nor hidden are indexed. Every window is stored in all cells that intersect its input area
+ * and its visible area, so the index never misses a window that passes Window::hitTest().
+ */
+class KWIN_EXPORT WindowSpatialIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WindowSpatialIndex(QObject *parent = nullptr);
+    ~WindowSpatialIndex() override;
+
+    /**
+     * Returns the windows that may accept input at the given position @a pos, ordered from
+     * the topmost to the bottommost window. The caller still has to hit test the windows.
+     */
+    QVector<Window *> windowsAt(const QPointF &pos) const;
+
+private:
+    struct Record
+    {
+        int stackingPosition = 0;
+        QRect cellRange;
+        bool indexed = false;
+    };
+
+    void restack();
+    void reindex();
+    void updateWindow(Window *window);
+    void insertWindow(Window *window);
+    void removeWindow(Window *window);
+    void trackWindow(Window *window);
+    void untrackWindow(Window *window);
+
+    static constexpr int s_cellSize = 256;
+
+    QRect m_bounds;
+    QHash<Window *, Record> m_windows;
+    // every cell lists its windows from the topmost to the bottommost one
+    std::unordered_map<quint64, QVector<Window *>> m_cells;
+};
+
+} // namespace KWin
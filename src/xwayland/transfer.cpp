@@ -23,7 +23,10 @@
 #include <xcb/xfixes.h>
 
 #include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
 #include <unistd.h>
+#include <vector>
 
 #include <xwayland_logging.h>
 
@@ -32,8 +35,45 @@ namespace KWin
 namespace Xwl
 {
 
-// in Bytes: equals 64KB
-static const uint32_t s_incrChunkSize = 63 * 1024;
+// in Bytes: the smallest and largest chunk sent to X clients in one property
+static const uint32_t s_minIncrChunkSize = 63 * 1024;
+static const uint32_t s_maxIncrChunkSize = 1024 * 1024;
+
+// number of chunks that are read ahead of the side that consumes them
+static const int s_maxPendingChunks = 4;
+
+/* Buffers of chunks that have been sent are kept for the next chunks,
+ * so large transfers don't allocate and free memory for every chunk.
+ * The pool is released when no transfer from Wayland to X is running.
+ */
+static std::vector<QByteArray> s_bufferPool;
+static int s_transfersWltoX = 0;
+
+static QByteArray acquireBuffer(int size)
+{
+    while (!s_bufferPool.empty()) {
+        QByteArray buffer = std::move(s_bufferPool.back());
+        s_bufferPool.pop_back();
+        if (buffer.size() == size) {
+            return buffer;
+        }
+    }
+    return QByteArray(size, Qt::Uninitialized);
+}
+
+static void releaseBuffer(QByteArray &&buffer)
+{
+    if (s_bufferPool.size() < size_t(s_maxPendingChunks)) {
+        s_bufferPool.push_back(std::move(buffer));
+    }
+}
+
+static uint32_t incrChunkSize()
+{
+    // every chunk costs a round trip, use the largest one that fits into a single request
+    const uint32_t maximumRequestLength = xcb_get_maximum_request_length(kwinApp()->x11Connection()) * 4;
+    return std::clamp(maximumRequestLength - 1024, s_minIncrChunkSize, s_maxIncrChunkSize);
+}
 
 Transfer::Transfer(xcb_atom_t selection, qint32 fd, xcb_timestamp_t timestamp, QObject *parent)
     : QObject(parent)
@@ -41,6 +81,12 @@ Transfer::Transfer(xcb_atom_t selection, qint32 fd, xcb_timestamp_t timestamp, Q
     , m_fd(fd)
     , m_timestamp(timestamp)
 {
+    // the fd is only accessed when the socket notifier reports it's ready, a slow
+    // Wayland client must not block the compositor when more data is read or written
+    const int flags = fcntl(m_fd, F_GETFL);
+    if (flags != -1) {
+        fcntl(m_fd, F_SETFL, flags | O_NONBLOCK);
+    }
 }
 
 void Transfer::createSocketNotifier(QSocketNotifier::Type type)
@@ -83,13 +129,22 @@ TransferWltoX::TransferWltoX(xcb_atom_t selection, xcb_selection_request_event_t
                              qint32 fd, QObject *parent)
     : Transfer(selection, fd, 0, parent)
     , m_request(request)
+    , m_chunkSize(incrChunkSize())
 {
+    s_transfersWltoX++;
 }
 
 TransferWltoX::~TransferWltoX()
 {
     delete m_request;
     m_request = nullptr;
+
+    for (Chunk &chunk : m_chunks) {
+        releaseBuffer(std::move(chunk.data));
+    }
+    if (--s_transfersWltoX == 0) {
+        s_bufferPool.clear();
+    }
 }
 
 void TransferWltoX::startTransferFromSource()
@@ -103,24 +158,34 @@ void TransferWltoX::startTransferFromSource()
 
 int TransferWltoX::flushSourceData()
 {
-    Q_ASSERT(!m_chunks.isEmpty());
+    // only the end of a non-incremental transfer can be empty, incremental
+    // transfers are ended in sendNextChunk()
+    Q_ASSERT(!m_chunks.isEmpty() || !incr());
     xcb_connection_t *xcbConn = kwinApp()->x11Connection();
 
+    Chunk chunk = m_chunks.isEmpty() ? Chunk() : m_chunks.takeFirst();
     xcb_change_property(xcbConn,
                         XCB_PROP_MODE_REPLACE,
                         m_request->requestor,
                         m_request->property,
                         m_request->target,
                         8,
-                        m_chunks.first().first.size(),
-                        m_chunks.first().first.data());
+                        chunk.size,
+                        chunk.data.constData());
+    // the request has been written after the flush, the buffer can be reused
     xcb_flush(xcbConn);
+    if (!chunk.data.isNull()) {
+        releaseBuffer(std::move(chunk.data));
+    }
 
     m_propertyIsSet = true;
     resetTimeout();
 
-    const auto rm = m_chunks.takeFirst();
-    return rm.first.size();
+    if (socketNotifier()) {
+        // there is room for reading ahead again
+        socketNotifier()->setEnabled(true);
+    }
+    return chunk.size;
 }
 
 void TransferWltoX::startIncr()
@@ -135,7 +200,7 @@ void TransferWltoX::startIncr()
                                  XCB_CW_EVENT_MASK, mask);
 
     // spec says to make the available space larger
-    const uint32_t chunkSpace = 1024 + s_incrChunkSize;
+    const uint32_t chunkSpace = 1024 + m_chunkSize;
     xcb_change_property(xcbConn,
                         XCB_PROP_MODE_REPLACE,
                         m_request->requestor,
@@ -147,64 +212,87 @@ void TransferWltoX::startIncr()
     setIncr(true);
     // first data will be flushed after the property has been deleted
     // again by the requestor
-    m_flushPropertyOnDelete = true;
     m_propertyIsSet = true;
     Q_EMIT selectionNotify(m_request, true);
 }
 
 void TransferWltoX::readWlSource()
 {
-    if (m_chunks.size() == 0 || m_chunks.last().second == s_incrChunkSize) {
-        // append new chunk
-        auto next = QPair<QByteArray, int>();
-        next.first.resize(s_incrChunkSize);
-        next.second = 0;
-        m_chunks.append(next);
-    }
-
-    const auto oldLen = m_chunks.last().second;
-    const auto avail = s_incrChunkSize - m_chunks.last().second;
-    Q_ASSERT(avail > 0);
+    // read until the source has no more data available right now, or enough
+    // chunks are waiting for the requestor
+    while (true) {
+        const bool appendChunk = m_chunks.isEmpty() || m_chunks.last().size == int(m_chunkSize);
+        if (appendChunk && m_chunks.size() >= s_maxPendingChunks) {
+            // continue once the requestor has taken the next chunk
+            socketNotifier()->setEnabled(false);
+            break;
+        }
 
-    ssize_t readLen = read(fd(), m_chunks.last().first.data() + oldLen, avail);
-    if (readLen == -1) {
-        qCWarning(KWIN_XWL) << "Error reading in Wl data.";
+        // A new chunk is queued only once data has been read into it, the
+        // requestor would take an empty chunk for the end of the transfer.
+        QByteArray buffer;
+        char *target;
+        int avail;
+        if (appendChunk) {
+            buffer = acquireBuffer(m_chunkSize);
+            target = buffer.data();
+            avail = m_chunkSize;
+        } else {
+            Chunk &chunk = m_chunks.last();
+            target = chunk.data.data() + chunk.size;
+            avail = m_chunkSize - chunk.size;
+        }
 
-        // TODO: cleanup X side?
-        endTransfer();
-        return;
-    }
-    m_chunks.last().second = oldLen + readLen;
+        const ssize_t readLen = read(fd(), target, avail);
+        if (readLen <= 0 && appendChunk) {
+            releaseBuffer(std::move(buffer));
+        }
+        if (readLen == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            qCWarning(KWIN_XWL) << "Error reading in Wl data.";
 
-    if (readLen == 0) {
-        // at the fd end - complete transfer now
-        m_chunks.last().first.resize(m_chunks.last().second);
+            // TODO: cleanup X side?
+            endTransfer();
+            return;
+        }
 
-        if (incr()) {
-            // incremental transfer is to be completed now
-            m_flushPropertyOnDelete = true;
-            if (!m_propertyIsSet) {
-                // flush if target's property is not set at the moment
+        if (readLen == 0) {
+            // at the fd end - complete transfer now
+            if (incr()) {
+                // incremental transfer is to be completed now
+                clearSocketNotifier();
+                if (!m_propertyIsSet) {
+                    // the requestor is waiting for the next chunk already
+                    sendNextChunk();
+                }
+            } else {
+                // non incremental transfer is to be completed now,
+                // data can be transferred to X client via a single property set
                 flushSourceData();
+                Q_EMIT selectionNotify(m_request, true);
+                endTransfer();
             }
-            clearSocketNotifier();
+            return;
+        }
+
+        if (appendChunk) {
+            m_chunks.append(Chunk{std::move(buffer), int(readLen)});
         } else {
-            // non incremental transfer is to be completed now,
-            // data can be transferred to X client via a single property set
-            flushSourceData();
-            Q_EMIT selectionNotify(m_request, true);
-            endTransfer();
+            m_chunks.last().size += readLen;
         }
-    } else if (m_chunks.last().second == s_incrChunkSize) {
-        // first chunk full, but not yet at fd end -> go incremental
+
         if (incr()) {
-            m_flushPropertyOnDelete = true;
             if (!m_propertyIsSet) {
-                // flush if target's property is not set at the moment
-                flushSourceData();
+                // the requestor is waiting for the next chunk already
+                sendNextChunk();
             }
-        } else {
-            // starting incremental transfer
+        } else if (m_chunks.last().size == int(m_chunkSize)) {
+            // first chunk full, but not yet at fd end -> go incremental
             startIncr();
         }
     }
@@ -229,30 +317,34 @@ void TransferWltoX::handlePropertyDelete()
         return;
     }
     m_propertyIsSet = false;
+    sendNextChunk();
+}
 
-    if (m_flushPropertyOnDelete) {
-        if (!socketNotifier() && m_chunks.isEmpty()) {
-            // transfer complete
-            xcb_connection_t *xcbConn = kwinApp()->x11Connection();
-
-            uint32_t mask[] = {0};
-            xcb_change_window_attributes(xcbConn,
-                                         m_request->requestor,
-                                         XCB_CW_EVENT_MASK, mask);
-
-            xcb_change_property(xcbConn,
-                                XCB_PROP_MODE_REPLACE,
-                                m_request->requestor,
-                                m_request->property,
-                                m_request->target,
-                                8, 0, nullptr);
-            xcb_flush(xcbConn);
-            m_flushPropertyOnDelete = false;
-            endTransfer();
-        } else if (!m_chunks.isEmpty()) {
-            flushSourceData();
-        }
+void TransferWltoX::sendNextChunk()
+{
+    Q_ASSERT(!m_propertyIsSet);
+
+    if (!m_chunks.isEmpty()) {
+        flushSourceData();
+    } else if (!socketNotifier()) {
+        // transfer complete
+        xcb_connection_t *xcbConn = kwinApp()->x11Connection();
+
+        uint32_t mask[] = {0};
+        xcb_change_window_attributes(xcbConn,
+                                     m_request->requestor,
+                                     XCB_CW_EVENT_MASK, mask);
+
+        xcb_change_property(xcbConn,
+                            XCB_PROP_MODE_REPLACE,
+                            m_request->requestor,
+                            m_request->property,
+                            m_request->target,
+                            8, 0, nullptr);
+        xcb_flush(xcbConn);
+        endTransfer();
     }
+    // otherwise the next chunk is sent once data has been read from the source
 }
 
 TransferXtoWl::TransferXtoWl(xcb_atom_t selection, xcb_atom_t target, qint32 fd,
@@ -380,10 +472,29 @@ void TransferXtoWl::getIncrChunk()
         // receive mechanism has not yet been setup
         return;
     }
+    if (!fetchIncrChunk()) {
+        return;
+    }
+    if (!socketNotifier()) {
+        // otherwise the queued chunks are written once the fd is writable
+        dataSourceWrite();
+    }
+}
+
+bool TransferXtoWl::fetchIncrChunk()
+{
+    if (m_receiver->pendingChunks() >= s_maxPendingChunks) {
+        // fetched once the Wayland client has caught up
+        m_chunkAvailable = true;
+        return true;
+    }
+    m_chunkAvailable = false;
     xcb_connection_t *xcbConn = kwinApp()->x11Connection();
 
+    // Deleting the property right away lets the source send the next chunk
+    // while this one is still being written to the Wayland client.
     auto cookie = xcb_get_property(xcbConn,
-                                   0,
+                                   1,
                                    m_window,
                                    atoms->wl_selection,
                                    XCB_GET_PROPERTY_TYPE_ANY,
@@ -394,32 +505,30 @@ void TransferXtoWl::getIncrChunk()
     if (!reply) {
         qCWarning(KWIN_XWL) << "Can't get selection property.";
         endTransfer();
-        return;
+        return false;
     }
 
     if (xcb_get_property_value_length(reply) > 0) {
         // reply's ownership is transferred
         m_receiver->transferFromProperty(reply);
-        dataSourceWrite();
     } else {
-        // Transfer complete
+        // transfer complete once the queued chunks are written
         free(reply);
-        endTransfer();
+        m_incrFinished = true;
     }
+    return true;
 }
 
 DataReceiver::~DataReceiver()
 {
-    if (m_propertyReply) {
-        free(m_propertyReply);
-        m_propertyReply = nullptr;
+    for (const Chunk &chunk : m_chunks) {
+        free(chunk.propertyReply);
     }
 }
 
 void DataReceiver::transferFromProperty(xcb_get_property_reply_t *reply)
 {
-    m_propertyStart = 0;
-    m_propertyReply = reply;
+    m_chunks.push_back(Chunk{reply});
 
     setData(static_cast<char *>(xcb_get_property_value(reply)),
             xcb_get_property_value_length(reply));
@@ -428,22 +537,23 @@ void DataReceiver::transferFromProperty(xcb_get_property_reply_t *reply)
 void DataReceiver::setData(const char *value, int length)
 {
     // simply set data without copy
-    m_data = QByteArray::fromRawData(value, length);
+    m_chunks.back().data = QByteArray::fromRawData(value, length);
 }
 
 QByteArray DataReceiver::data() const
 {
-    return QByteArray::fromRawData(m_data.data() + m_propertyStart,
-                                   m_data.size() - m_propertyStart);
+    const Chunk &chunk = m_chunks.front();
+    return QByteArray::fromRawData(chunk.data.data() + chunk.propertyStart,
+                                   chunk.data.size() - chunk.propertyStart);
 }
 
 void DataReceiver::partRead(int length)
 {
-    m_propertyStart += length;
-    if (m_propertyStart == m_data.size()) {
-        Q_ASSERT(m_propertyReply);
-        free(m_propertyReply);
-        m_propertyReply = nullptr;
+    Chunk &chunk = m_chunks.front();
+    chunk.propertyStart += length;
+    if (chunk.propertyStart == chunk.data.size()) {
+        free(chunk.propertyReply);
+        m_chunks.pop_front();
     }
 }
 
@@ -530,38 +640,48 @@ void MozUrlReceiver::setData(const char *value, int length)
 
 void TransferXtoWl::dataSourceWrite()
 {
-    QByteArray property = m_receiver->data();
+    while (!m_receiver->isEmpty()) {
+        QByteArray property = m_receiver->data();
 
-    ssize_t len = write(fd(), property.constData(), property.size());
-    if (len == -1) {
-        qCWarning(KWIN_XWL) << "X11 to Wayland write error on fd:" << fd();
-        endTransfer();
-        return;
-    }
+        ssize_t len = write(fd(), property.constData(), property.size());
+        if (len == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                qCWarning(KWIN_XWL) << "X11 to Wayland write error on fd:" << fd();
+                endTransfer();
+                return;
+            }
+            len = 0;
+        }
 
-    m_receiver->partRead(len);
-    if (len == property.size()) {
-        // property completely transferred
-        if (incr()) {
-            clearSocketNotifier();
-            xcb_connection_t *xcbConn = kwinApp()->x11Connection();
-            xcb_delete_property(xcbConn,
-                                m_window,
-                                atoms->wl_selection);
-            xcb_flush(xcbConn);
-        } else {
-            // transfer complete
-            endTransfer();
+        m_receiver->partRead(len);
+        if (len < property.size()) {
+            // wait until the Wayland client can take more data
+            if (!socketNotifier()) {
+                createSocketNotifier(QSocketNotifier::Write);
+                connect(socketNotifier(), &QSocketNotifier::activated, this, [this](int socket) {
+                    Q_UNUSED(socket);
+                    dataSourceWrite();
+                });
+            }
+            resetTimeout();
+            return;
         }
-    } else {
-        if (!socketNotifier()) {
-            createSocketNotifier(QSocketNotifier::Write);
-            connect(socketNotifier(), &QSocketNotifier::activated, this, [this](int socket) {
-                Q_UNUSED(socket);
-                dataSourceWrite();
-            });
+
+        // property completely transferred
+        if (m_chunkAvailable && !fetchIncrChunk()) {
+            return;
         }
     }
+
+    clearSocketNotifier();
+    if (!incr() || m_incrFinished) {
+        // transfer complete
+        endTransfer();
+        return;
+    }
     resetTimeout();
 }
 
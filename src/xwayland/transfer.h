@@ -15,6 +15,8 @@
 
 #include <xcb/xcb.h>
 
+#include <deque>
+
 namespace KWayland
 {
 namespace Client
@@ -127,26 +129,36 @@ Q_SIGNALS:
     void selectionNotify(xcb_selection_request_event_t *event, bool success);
 
 private:
+    struct Chunk
+    {
+        QByteArray data; // a pooled buffer of m_chunkSize bytes
+        int size = 0; // the number of bytes that have been read into the buffer
+    };
+
     void startIncr();
     void readWlSource();
     int flushSourceData();
     void handlePropertyDelete();
+    void sendNextChunk();
 
     xcb_selection_request_event_t *m_request = nullptr;
 
-    /* contains all received data portioned in chunks
-     * TODO: explain second QPair component
+    /* contains the received data that has not been sent to the requestor yet,
+     * at most a few chunks are read ahead
      */
-    QVector<QPair<QByteArray, int>> m_chunks;
+    QVector<Chunk> m_chunks;
+    uint32_t m_chunkSize;
 
     bool m_propertyIsSet = false;
-    bool m_flushPropertyOnDelete = false;
 
     Q_DISABLE_COPY(TransferWltoX)
 };
 
 /**
  * Helper class for X to Wl transfers.
+ *
+ * Queues the chunks of an incremental transfer that have been received
+ * but not written to the Wayland client yet.
  */
 class DataReceiver
 {
@@ -156,20 +168,36 @@ public:
     void transferFromProperty(xcb_get_property_reply_t *reply);
 
     virtual void setData(const char *value, int length);
+    /**
+     * The remaining data of the oldest chunk.
+     */
     QByteArray data() const;
 
     void partRead(int length);
 
+    bool isEmpty() const
+    {
+        return m_chunks.empty();
+    }
+    int pendingChunks() const
+    {
+        return int(m_chunks.size());
+    }
+
 protected:
     void setDataInternal(QByteArray data)
     {
-        m_data = data;
+        m_chunks.back().data = data;
     }
 
 private:
-    xcb_get_property_reply_t *m_propertyReply = nullptr;
-    int m_propertyStart = 0;
-    QByteArray m_data;
+    struct Chunk
+    {
+        xcb_get_property_reply_t *propertyReply;
+        int propertyStart = 0;
+        QByteArray data;
+    };
+    std::deque<Chunk> m_chunks;
 };
 
 /**
@@ -214,10 +242,16 @@ private:
     void dataSourceWrite();
     void startTransfer();
     void getIncrChunk();
+    bool fetchIncrChunk();
 
     xcb_window_t m_window;
     DataReceiver *m_receiver = nullptr;
 
+    // the source has sent a chunk that is not fetched until the queued chunks are written
+    bool m_chunkAvailable = false;
+    // the source has sent the last chunk
+    bool m_incrFinished = false;
+
     Q_DISABLE_COPY(TransferXtoWl)
 };
 